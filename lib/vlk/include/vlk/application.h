@@ -19,45 +19,172 @@
 // ================================================================================================
 #pragma once
 
+#include <vlk/async_compute.h>
+#include <vlk/barrier_batch.h>
+#include <vlk/command_pools.h>
+#include <vlk/debug_messenger.h>
+#include <vlk/descriptor_allocator.h>
 #include <vlk/export.h>
+#include <vlk/frame_stats.h>
+#include <vlk/gpu_profiler.h>
+#include <vlk/job_system.h>
+#include <vlk/memory_allocator.h>
+#include <vlk/memory_defragmenter.h>
 #include <vlk/phys_device.h>
+#include <vlk/pipeline_cache.h>
+#include <vlk/pipeline_compiler.h>
+#include <vlk/present_policy.h>
+#include <vlk/release_queue.h>
+#include <vlk/shader_cache.h>
+#include <vlk/upload_ring.h>
+#include <vlk/upload_scheduler.h>
 
 #include <vulkan/vulkan.h>
 #include <GLFW/glfw3.h>
 #include <glm/vec2.hpp>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#define VLK_DEFAULT_FRAMES_IN_FLIGHT    2U
+
 namespace vlk {
 
     using extension_list = std::vector<VkExtensionProperties>;
     using layer_list = std::vector<VkLayerProperties>;
 
+    //! Settings that configure an application object before run() is called.
+    struct VLK_EXPORT application_settings
+    {
+        std::string app_name{};
+        uint32_t window_width{800U};
+        uint32_t window_height{600U};
+
+        //! Number of frames the CPU may record ahead of the GPU. Each frame in flight owns its own
+        //! command buffer, fence and semaphores.
+        uint32_t frames_in_flight{VLK_DEFAULT_FRAMES_IN_FLIGHT};
+
+        //! Runs without GLFW window and surface. Frames are rendered into a ring of device-local images
+        //! instead of a swap chain, e.g. for benchmarks and batch rendering on display-less machines.
+        bool headless{false};
+
+        //! run() returns after this number of frames, 0 means no limit.
+        uint64_t max_frames{0};
+
+        //! Measures GPU time of each frame and of the scoped zones opened via profiler().
+        bool gpu_profiling{true};
+
+        //! Moves resources registered at defragmenter() at the beginning of each frame within this budget.
+        bool defragmentation{true};
+        vlk::memory_defragmenter::budget defrag_budget{};
+
+        //! Size of each frame's partition of the upload ring.
+        VkDeviceSize upload_ring_size{8ULL * 1024ULL * 1024ULL};
+
+        //! Worker threads of jobs(), 0 means one per hardware thread besides the main thread.
+        uint32_t worker_threads{0};
+
+        //! File the pipeline cache is loaded from after device creation and saved to at the end of run(), e.g.
+        //! "pipeline.cache". Empty by default, which keeps the cache in memory only.
+        std::string pipeline_cache_file{};
+
+        //! The default device selection runs probe_copy_bandwidth() on every suitable device and adds the result
+        //! to its score. Costs a temporary logical device per GPU at startup.
+        bool device_probe{false};
+
+        //! Present mode and swap chain depth chosen by the default det_swap_chain_properties(), can be changed
+        //! while running with set_present_policy().
+        vlk::present_policy present_policy{vlk::present_policy::balanced};
+
+        //! Enables the validation layer and a VK_EXT_debug_utils messenger. Without the layer installed the
+        //! application runs without validation. Ignored when the library is built without
+        //! VLK_VULKAN_VALIDATAION_LAYER (CMake option VLK_VALIDATION): validation and object names compile to nothing.
+        bool validation{true};
+
+        //! Deduplication of validation messages by message id, see debug_message_filter.
+        vlk::debug_message_limits validation_limits{};
+    };
+
     class application
     {
     public:
-        application();
+        //! Wall clock time of one step of run()'s initialisation.
+        struct startup_phase
+        {
+            std::string name;
+            std::chrono::nanoseconds duration;
+            bool overlapped;    //!< ran on a worker concurrently to the phase before it
+        };
+
+        explicit application(application_settings const& settings = application_settings{});
         ~application();
 
         void run();
 
-        //! Sends a debug report message via the Vulkan validation layer.
+        //! Requests run() to return after the current frame. Can be called from any thread.
+        void stop();
+
+        //! CPU timing statistics of the render loop, reset at the start of each run().
+        frame_stats const& stats() const { return _frame_stats; }
+
+        //! Initialisation phases of the last run() in execution order, the last one is "first_frame": the time from
+        //! the end of on_init_run() until the first frame was submitted.
+        std::vector<startup_phase> const& startup_phases() const { return _startup_phases; }
+
+        //! Switches the present policy, the swap chain is re-created after the current frame. Can be called from
+        //! any thread. In headless mode the policy only decides the number of offscreen images, they are re-created.
+        void set_present_policy(vlk::present_policy policy);
+        vlk::present_policy get_present_policy() const { return _present_policy.load(); }
+
+        //! Intervals between consecutive presents while policy was active, reset at the start of each run().
+        histogram const& present_intervals(vlk::present_policy policy) const;
+
+        //! Sends a message through the debug utils messenger, e.g. to mark a position in the validation output.
+        //! The messenger receives warning and error severities only, messages with info or verbose severity are
+        //! dropped by the layer and never reach on_vk_debug_msg().
         //! \throws vlk::app_exception   Thrown when either no Vulkan instance created (e.g. outside run()) or when
         //!                             Vulkan debug validation layer is not active.
-        //! \see vkDebugReportMessageEXT
-        void vk_debug_report_msg(VkDebugReportFlagsEXT flags,
-                                 VkDebugReportObjectTypeEXT objectType,
-                                 uint64_t object,
-                                 size_t location,
-                                 int32_t messageCode,
-                                 std::string const& pLayerPrefix,
-                                 std::string const& pMessage);
+        //! \see vkSubmitDebugUtilsMessageEXT
+        void vk_debug_msg(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types,
+                          std::string const& message);
+
+        //! Whether the validation layer and the debug utils messenger are active, valid inside run().
+        bool validation_enabled() const { return nullptr != _debug_messenger; }
+
+        //! Names a device object in validation messages and debuggers. Does nothing without validation.
+        template<typename T>
+        void set_object_name([[maybe_unused]] VkObjectType type, [[maybe_unused]] T handle,
+                             [[maybe_unused]] char const* name) const
+        {
+#ifdef VLK_VULKAN_VALIDATAION_LAYER
+            if (nullptr == _debug_messenger) {
+                return;
+            }
+            if constexpr (std::is_pointer_v<T>) {
+                name_object(type, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(handle)), name);
+            }
+            else {
+                name_object(type, static_cast<uint64_t>(handle), name);
+            }
+#endif
+        }
 
     protected:
+        //! Called on a worker thread while the window is created.
         virtual void det_instance_requirements(std::vector<std::string>& required_extensions,
                                                std::vector<std::string>& required_layers);
 
+        //! The default selection scores every suitable device with score_device() (and probe_copy_bandwidth() when
+        //! device_probe is set) and selects the best one. Suitable are devices with a graphics queue family and a
+        //! family presenting on surface, unless headless.
         virtual phys_device_selection det_physical_device_queue(std::vector<vlk::phys_device> const& available_devices,
                 VkSurfaceKHR surface);
 
@@ -66,54 +193,227 @@ namespace vlk {
                                                                     std::vector<VkPresentModeKHR> const& surface_present_modes,
                                                                     glm::uvec2 window_size);
 
-        virtual void on_vk_debug_msg(VkDebugReportFlagsEXT flags,
-                VkDebugReportObjectTypeEXT object_type,
-                uint64_t object,
-                size_t location,
-                int32_t message_code,
-                const char* p_layer_prefix,
-                const char* p_message);
+        //! Called for the validation messages passing the validation_limits, from any thread using the Vulkan API.
+        //! suppressed is the number of messages of the same id dropped since the last one passed. The default
+        //! implementation logs errors and warnings with their severity, other messages at debug level.
+        virtual void on_vk_debug_msg(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                                     VkDebugUtilsMessageTypeFlagsEXT types,
+                                     VkDebugUtilsMessengerCallbackDataEXT const& data,
+                                     uint64_t suppressed);
+
+        //! Called once at the end of run() initialisation when device and swap chain are available.
+        //! Subclasses create their device resources (pipelines, buffers, ...) here.
+        virtual void on_init_run();
 
+        //! Called before the device is destroyed. The device is idle at this point.
+        virtual void on_cleanup_run();
+
+        //! Whether the application records async compute work, record_compute() is only called when it returns
+        //! true. The default implementation returns false.
+        virtual bool has_compute() const;
+
+        //! Records the async compute work of the current frame into cmd. cmd is submitted to the compute queue
+        //! before the frame's graphics command buffer, which waits for it at the returned pipeline stage.
+        //! Returning 0 means nothing was recorded. Resources shared with the graphics queue family must use
+        //! VK_SHARING_MODE_CONCURRENT. The default implementation records nothing.
+        virtual VkPipelineStageFlags record_compute(VkCommandBuffer cmd);
+
+        //! Records the commands of one frame into cmd. The command buffer is already in recording state
+        //! and will be submitted after return. image_index identifies the swap chain image that will be
+        //! presented. Its layout is tracked by barriers(): transitions of the image have to be made there (or
+        //! declared with barriers().track()), after return the application transitions it to frame_final_layout().
+        //! The default implementation records nothing.
+        virtual void record_frame(VkCommandBuffer cmd, uint32_t image_index);
+
+        //! Called after the swap chain has been re-created (e.g. window resize, VK_ERROR_OUT_OF_DATE_KHR or a new
+        //! present policy), in headless mode after the offscreen images have been re-created.
+        //! Subclasses re-create here their resources depending on swap chain images, views or extent. Frames
+        //! recorded before may still be in flight, so old dependent resources must be released via defer_release().
+        virtual void on_swap_chain_recreated();
+
+        //! Defers the call of fn until all frames currently in flight, including the one being recorded, have been
+        //! finished by the GPU.
+        //! Pending functors are invoked at the latest in run()'s cleanup while the device is idle.
+        void defer_release(std::function<void()> fn);
+
+        VkDevice vk_device() const { return _vk_device; }
+
+        //! The physical device selected by det_physical_device_queue(), valid inside run().
+        vlk::phys_device const& phys_device() const;
+
+        //! Device memory allocator, valid inside run(). Resources allocated from it have to be released
+        //! in on_cleanup_run() at the latest.
+        vlk::memory_allocator& allocator();
+
+        //! Defragmenter of allocator()'s blocks, valid inside run(). Resources registered here are moved at the
+        //! beginning of a frame, i.e. relocation callbacks are invoked before record_frame() and the moves are
+        //! executed before the copies queued at uploads().
+        vlk::memory_defragmenter& defragmenter();
+
+        //! Streaming upload ring of the current frame, valid inside run(). Copies queued in record_frame() are
+        //! executed before the frame's command buffer.
+        vlk::upload_ring& uploads();
+
+        //! Asynchronous uploads on the transfer queue, valid inside run(). Tickets become ready at the beginning
+        //! of a frame, before record_frame().
+        vlk::upload_scheduler& async_uploads();
+
+        //! Queues created for compute_queue_priorities of the device selection, valid inside run(). The first one
+        //! executes record_compute().
+        std::vector<VkQueue> const& compute_queues() const { return _vk_queues_compute; }
+
+        //! Per-thread command pools of the graphics queue family for the current frame, valid inside run().
+        //! In record_frame() scenes are recorded on several threads with cmd_pools().record_parallel().
+        vlk::command_pools& cmd_pools();
+
+        //! Pipeline cache of the device, valid inside run(). Pass it to every vkCreate*Pipelines call.
+        VkPipelineCache vk_pipeline_cache() const;
+
+        //! Creates pipelines concurrently on jobs() with vk_pipeline_cache(), valid inside run(). Pipelines taken
+        //! from it are owned by the subclass, the others are destroyed after on_cleanup_run(). All requests are
+        //! finished before on_cleanup_run() is called.
+        vlk::pipeline_compiler& pipelines();
+
+        //! Shader modules and reflected pipeline layouts of the device, valid inside run(). Modules and layouts
+        //! are owned by the cache and destroyed after on_cleanup_run().
+        vlk::shader_cache& shaders();
+
+        //! Barrier batch of the graphics queue with layout tracking of the swap chain (or offscreen) images, valid
+        //! inside run(). Only to be used by the thread recording the frame's command buffer.
+        vlk::barrier_batch& barriers();
+
+        //! Descriptor sets of the current frame, valid inside run(). Sets are valid until the frame slot is reused,
+        //! identical sets requested with descriptors().get() within a frame are allocated and written only once.
+        vlk::descriptor_allocator& descriptors();
+
+        //! Job system shared by the application and its subsystems, valid for the lifetime of the application.
+        //! Jobs queued with run_on_main() are executed once per frame before draw_frame(), GLFW functions
+        //! restricted to the main thread must be called this way.
+        vlk::job_system& jobs() { return *_jobs; }
+
+        //! GPU profiler of the graphics queue, valid inside run(). Zones must only be opened in record_frame().
+        //! When profiling is disabled in the settings the profiler exists but does nothing.
+        vlk::gpu_profiler& profiler();
+        bool headless() const { return _headless; }
+
+        //! Layout the application transitions the frame's image to after record_frame() returned:
+        //! VK_IMAGE_LAYOUT_PRESENT_SRC_KHR for swap chain images, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL for headless
+        //! offscreen images. record_frame() leaves the image in any layout tracked by barriers().
+        VkImageLayout frame_final_layout() const;
+        VkExtent2D surface_extent() const { return _vk_surface_extent; }
+        VkSurfaceFormatKHR surface_format() const { return _vk_surface_format; }
+        std::vector<VkImage> const& swap_chain_images() const { return _vk_swap_chain_images; }
+        std::vector<VkImageView> const& swap_chain_image_views() const { return _vk_swap_chain_img_views; }
+
+        //! Number of frame slots used by the render loop.
+        uint32_t frames_in_flight() const { return static_cast<uint32_t>(_frames.size()); }
+
+        //! Index of the frame slot currently recorded - in range [0, frames_in_flight()).
+        uint32_t frame_index() const { return _frame_idx; }
 
     private:
+        //! Per-frame resources of a frame in flight.
+        struct frame_slot
+        {
+            VkCommandBuffer cmd{VK_NULL_HANDLE};
+            VkCommandBuffer upload_cmd{VK_NULL_HANDLE};     //!< defragmentation and upload ring copies, before cmd
+            VkFence in_flight{VK_NULL_HANDLE};
+            VkSemaphore image_available{VK_NULL_HANDLE};
+            VkSemaphore render_finished{VK_NULL_HANDLE};
+        };
+
         void init_run();
         void cleanup_run() noexcept;
+        bool should_stop() const;
+        void draw_frame();
+        void recreate_swap_chain();
+        void recreate_offscreen_images();
 
         void create_window();
         void create_vk_instance();
-        void install_validation_report_cbk();
+        void install_debug_messenger();
+        void log_validation_stats() const;
+        void name_object(VkObjectType type, uint64_t handle, char const* name) const;
         void create_surface();
         void create_device();
-        void create_swap_chain();
+        void create_swap_chain(VkSwapchainKHR old_swap_chain = VK_NULL_HANDLE);
+        void create_offscreen_images();
         void create_image_views();
+        void create_command_pool();
+        void create_frame_slots();
+        void timed_phase(char const* name, std::function<void()> const& fn);
+        void log_startup_phases() const;
 
-        static VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_report_cbk(VkDebugReportFlagsEXT, VkDebugReportObjectTypeEXT,
-            uint64_t, size_t, int32_t, const char*, const char*, void*);
+        static void glfw_framebuffer_resize_cbk(GLFWwindow* window, int width, int height);
 
         std::vector<vlk::phys_device> get_list_phys_devices();
 
 
         bool _vk_enable_validation{true};
+        char const* _vk_validation_layer{nullptr};     //!< layer found by create_vk_instance()
+        vlk::debug_message_limits _validation_limits{};
         std::string _app_name{};
         uint32_t _window_width{800U};
         uint32_t _window_height{600U};
+        uint32_t _frames_in_flight{VLK_DEFAULT_FRAMES_IN_FLIGHT};
+        bool _headless{false};
+        uint64_t _max_frames{0};
+        std::atomic<bool> _stop_requested{false};
+        bool _user_initialised{false};
         GLFWwindow *_window{nullptr};
 
         VkInstance _vk_instance{VK_NULL_HANDLE};
-        VkDebugReportCallbackEXT _vk_dbg_cbk{VK_NULL_HANDLE};
+        std::unique_ptr<vlk::debug_messenger> _debug_messenger{};
         VkSurfaceKHR _vk_surface{VK_NULL_HANDLE};
 
         vlk::phys_device_selection _phys_dev_selected{};
+        std::unique_ptr<vlk::phys_device> _phys_dev{};
+        bool _gpu_profiling{true};
+        std::unique_ptr<vlk::gpu_profiler> _gpu_profiler{};
         VkDevice _vk_device{VK_NULL_HANDLE};
+        std::unique_ptr<vlk::memory_allocator> _allocator{};
+        bool _defragmentation{true};
+        bool _device_probe{false};
+        std::atomic<vlk::present_policy> _present_policy{vlk::present_policy::balanced};
+        vlk::present_policy _swap_chain_policy{vlk::present_policy::balanced};   //!< policy of the swap chain
+        std::array<histogram, static_cast<size_t>(vlk::present_policy::count)> _present_intervals{};
+        std::chrono::steady_clock::time_point _last_present{};
+        vlk::memory_defragmenter::budget _defrag_budget{};
+        std::unique_ptr<vlk::memory_defragmenter> _defragmenter{};
+        VkDeviceSize _upload_ring_size{0};
+        std::unique_ptr<vlk::upload_ring> _upload_ring{};
+        std::unique_ptr<vlk::upload_scheduler> _upload_scheduler{};
+        std::unique_ptr<vlk::async_compute> _async_compute{};
+        std::unique_ptr<vlk::job_system> _jobs{};
+        std::string _pipeline_cache_file{};
+        std::unique_ptr<vlk::pipeline_cache> _pipeline_cache{};
+        std::unique_ptr<vlk::pipeline_compiler> _pipeline_compiler{};
+        std::unique_ptr<vlk::shader_cache> _shaders{};
+        std::unique_ptr<vlk::command_pools> _cmd_pools{};
+        std::unique_ptr<vlk::descriptor_allocator> _descriptors{};
+        std::unique_ptr<vlk::barrier_batch> _barriers{};
         VkQueue _vk_queue_gfx{VK_NULL_HANDLE};
         VkQueue _vk_queue_pres{VK_NULL_HANDLE};
+        VkQueue _vk_queue_transfer{VK_NULL_HANDLE};
+        std::vector<VkQueue> _vk_queues_compute{};
 
         VkSwapchainKHR  _vk_swap_chain{VK_NULL_HANDLE};
         std::vector<VkImage> _vk_swap_chain_images{};
         VkSurfaceFormatKHR _vk_surface_format{};
         VkExtent2D _vk_surface_extent{};
         std::vector<VkImageView> _vk_swap_chain_img_views{};
+        std::vector<vlk::memory_allocation> _offscreen_memory{};
 
+        VkCommandPool _vk_cmd_pool{VK_NULL_HANDLE};
+        std::vector<frame_slot> _frames{};
+        std::vector<VkFence> _images_in_flight{};
+        uint32_t _frame_idx{0};
+        uint64_t _frame_counter{0};
+        vlk::frame_stats _frame_stats{};
+        std::chrono::steady_clock::time_point _last_frame_start{};
+        bool _framebuffer_resized{false};
+        vlk::release_queue _deferred_releases;
+        std::vector<startup_phase> _startup_phases{};
 
     };
 
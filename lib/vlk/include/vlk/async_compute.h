@@ -0,0 +1,71 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief Per-frame compute submissions on a compute queue overlapping with the graphics work.
+    //! Each frame in flight owns a command buffer and a semaphore. The semaphore is signaled by the compute
+    //! submission and has to be waited for by exactly one later submission - usually the frame's graphics submission
+    //! at the first stage consuming the compute results. Everything the graphics queue executes before that stage
+    //! overlaps with the compute work.
+    //! Resources used by both queue families must be created with VK_SHARING_MODE_CONCURRENT.
+    class VLK_EXPORT async_compute
+    {
+    public:
+        async_compute(VkDevice device, uint32_t queue_family_index, VkQueue queue, uint32_t frames_in_flight);
+        ~async_compute();
+
+        async_compute(async_compute const&) = delete;
+        async_compute& operator=(async_compute const&) = delete;
+
+        //! Resets and begins the command buffer of frame slot frame_index. The slot's previous submission (and the
+        //! submission waiting for it) must be finished.
+        VkCommandBuffer begin(uint32_t frame_index);
+
+        //! Ends and submits the command buffer of frame slot frame_index. Returns the semaphore signaled on completion.
+        VkSemaphore submit(uint32_t frame_index);
+
+        uint32_t queue_family_index() const { return _qfi; }
+        VkQueue queue() const { return _queue; }
+
+    private:
+        struct slot
+        {
+            VkCommandBuffer cmd{VK_NULL_HANDLE};
+            VkSemaphore finished{VK_NULL_HANDLE};
+        };
+
+        void release() noexcept;
+
+        VkDevice _device;
+        uint32_t _qfi;
+        VkQueue _queue;
+        VkCommandPool _pool{VK_NULL_HANDLE};
+        std::vector<slot> _slots{};
+    };
+
+} // namespace vlk
@@ -0,0 +1,135 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief Collects image and buffer barriers and records them with one call.
+    //! The batch tracks the last access of every resource it has seen: image() and buffer() describe the next use
+    //! of a resource and add a barrier only when needed - a write or a layout change waits for the previous reads
+    //! and writes, a read waits for the last write unless an earlier barrier already made it visible to the same
+    //! stages and accesses. Read after read in the same layout needs no barrier at all.
+    //! Requests for the same resource before flush() are merged into one barrier: the last request describes the
+    //! use after flush(), reads in the same layout accumulate and the source scope is the union of all requests.
+    //! Different ranges of one image widen the pending barrier to cover both.
+    //! flush() records all pending barriers with one vkCmdPipelineBarrier2KHR when VK_KHR_synchronization2 is
+    //! enabled - keeping the stage masks per barrier -, otherwise with one vkCmdPipelineBarrier using the union of
+    //! all stage masks.
+    //! Image state is tracked per image, not per subresource. Not thread-safe, one batch per command buffer
+    //! timeline (i.e. per queue).
+    class VLK_EXPORT barrier_batch
+    {
+    public:
+        struct state
+        {
+            VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+            VkPipelineStageFlags write_stages{0};       //!< last write, including layout transitions
+            VkAccessFlags write_access{0};
+            VkPipelineStageFlags read_stages{0};        //!< reads since the last write
+            VkPipelineStageFlags visible_stages{0};     //!< the last write is visible to these stages and accesses
+            VkAccessFlags visible_access{0};
+        };
+
+        //! synchronization2 requires the extension and feature to be enabled on device.
+        barrier_batch(VkDevice device, bool synchronization2);
+
+        //! Records with cmd_pipeline_barrier instead of vkCmdPipelineBarrier, without synchronization2. E.g. to
+        //! inspect the barriers in tests.
+        explicit barrier_batch(PFN_vkCmdPipelineBarrier cmd_pipeline_barrier);
+
+        //! Next use of range of image in layout. discard transitions from VK_IMAGE_LAYOUT_UNDEFINED, i.e. the
+        //! content is not preserved.
+        void image(VkImage image, VkImageSubresourceRange const& range, VkPipelineStageFlags stages,
+                   VkAccessFlags access, VkImageLayout layout, bool discard = false);
+
+        //! Next use of buffer.
+        void buffer(VkBuffer buffer, VkPipelineStageFlags stages, VkAccessFlags access);
+
+        //! Records the pending barriers into cmd.
+        void flush(VkCommandBuffer cmd);
+
+        bool empty() const { return _images.empty() && _buffers.empty(); }
+
+        //! Declares the last use of a resource recorded without this batch, e.g. after creation or when a semaphore
+        //! wait at stages covers the previous use.
+        void track(VkImage image, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access);
+        void track(VkBuffer buffer, VkPipelineStageFlags stages, VkAccessFlags access);
+
+        //! Stops tracking a destroyed resource.
+        void forget(VkImage image);
+        void forget(VkBuffer buffer);
+
+        //! Tracked state, default state for unknown resources.
+        state image_state(VkImage image) const;
+        state buffer_state(VkBuffer buffer) const;
+
+        bool uses_synchronization2() const;
+
+    private:
+        struct barrier
+        {
+            VkPipelineStageFlags src_stages;
+            VkAccessFlags src_access;
+            VkPipelineStageFlags dst_stages;
+            VkAccessFlags dst_access;
+            VkImageLayout old_layout;
+            VkImageLayout new_layout;
+        };
+
+        struct image_barrier
+        {
+            VkImage image;
+            VkImageSubresourceRange range;
+            barrier b;
+        };
+
+        struct buffer_barrier
+        {
+            VkBuffer buffer;
+            barrier b;
+        };
+
+        //! Updates s for the next use, returns false when no barrier is required.
+        static bool next_use(state& s, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout,
+                             barrier& b);
+        static void merge(barrier& pending, barrier const& b);
+        void flush_v1(VkCommandBuffer cmd);
+        void flush_v2(VkCommandBuffer cmd);
+
+        std::unordered_map<VkImage, state> _image_states{};
+        std::unordered_map<VkBuffer, state> _buffer_states{};
+        std::vector<image_barrier> _images{};
+        std::vector<buffer_barrier> _buffers{};
+        std::unordered_map<VkImage, size_t> _pending_images{};      //!< index into _images
+        std::unordered_map<VkBuffer, size_t> _pending_buffers{};    //!< index into _buffers
+        PFN_vkCmdPipelineBarrier _cmd_pipeline_barrier{nullptr};
+#ifdef VK_KHR_synchronization2
+        PFN_vkCmdPipelineBarrier2KHR _cmd_pipeline_barrier2{nullptr};
+#endif
+    };
+
+} // namespace vlk
@@ -0,0 +1,85 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+#include <vlk/job_system.h>
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief Command pools per recording thread and frame in flight.
+    //! Command pools are externally synchronized, so every recording thread gets its own pool per frame slot.
+    //! begin_frame() resets all pools of a slot at once with vkResetCommandPool - the command buffers stay allocated
+    //! and are handed out again by allocate(), no buffer is freed or reset individually.
+    //! record_parallel() distributes the recording of secondary command buffers over the threads of the job system
+    //! and executes them in order in a primary command buffer.
+    class VLK_EXPORT command_pools
+    {
+    public:
+        //! Records items [begin, end) into a secondary command buffer.
+        using record_fn = std::function<void(VkCommandBuffer cmd, uint32_t begin, uint32_t end)>;
+
+        //! One pool per thread of jobs and frame in flight.
+        command_pools(VkDevice device, uint32_t queue_family_index, uint32_t frames_in_flight, job_system& jobs);
+        ~command_pools();
+
+        command_pools(command_pools const&) = delete;
+        command_pools& operator=(command_pools const&) = delete;
+
+        //! Makes frame_index the current frame slot and resets its pools. The slot's submissions must be finished.
+        void begin_frame(uint32_t frame_index);
+
+        //! Command buffer in initial state from thread_index's pool of the current frame slot. A thread index must
+        //! only be used by one thread at a time.
+        VkCommandBuffer allocate(uint32_t thread_index, VkCommandBufferLevel level);
+
+        //! Records item_count items into secondary command buffers in up to thread_count() jobs and executes them
+        //! in primary. Chunks have at least min_items_per_chunk items. inheritance describes the render pass instance
+        //! of primary the secondaries are executed in (renderPass VK_NULL_HANDLE when executed outside of one).
+        //! fn is called concurrently from different threads. Returns after all secondaries are recorded.
+        void record_parallel(VkCommandBuffer primary, VkCommandBufferInheritanceInfo const& inheritance,
+                             uint32_t item_count, record_fn const& fn, uint32_t min_items_per_chunk = 256U);
+
+        uint32_t thread_count() const { return _thread_count; }
+
+    private:
+        struct pool
+        {
+            VkCommandPool pool{VK_NULL_HANDLE};
+            std::vector<VkCommandBuffer> buffers[2]{};      //!< per level: primary, secondary
+            size_t used[2]{0, 0};
+        };
+
+        void release() noexcept;
+        pool& thread_pool(uint32_t thread_index) { return _pools[_frame_idx * _thread_count + thread_index]; }
+
+        VkDevice _device;
+        job_system& _jobs;
+        uint32_t _thread_count;
+        uint32_t _frame_idx{0};
+        std::vector<pool> _pools{};     //!< frame slot major
+    };
+
+} // namespace vlk
@@ -0,0 +1,151 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vlk {
+
+    //! The first burst messages of an id pass the debug_message_filter, afterwards at most one per interval.
+    struct debug_message_limits
+    {
+        uint32_t burst{3U};
+        std::chrono::milliseconds interval{1000};
+    };
+
+    //! \brief Deduplication and rate limiting of validation messages by message id.
+    //! A passing message reports how many of its id were suppressed since the last one passed. Thread-safe, the
+    //! layers call back from any thread using the API.
+    class VLK_EXPORT debug_message_filter
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        //! Counters of one message id.
+        struct id_stats
+        {
+            int32_t id;
+            std::string name;
+            uint64_t count;         //!< all messages of the id
+            uint64_t suppressed;    //!< messages not passed
+        };
+
+        struct verdict
+        {
+            bool pass;
+            uint64_t suppressed;    //!< since the last passed message of the id, only set when passing
+        };
+
+        explicit debug_message_filter(debug_message_limits l = debug_message_limits{})
+            : _limits{l}
+        {}
+
+        //! id_name may be nullptr, messages with id 0 are told apart by id_name.
+        verdict filter(int32_t id, char const* id_name, clock::time_point now);
+
+        //! Counters of all ids seen, most frequent first.
+        std::vector<id_stats> stats() const;
+
+    private:
+        struct entry
+        {
+            int32_t id;
+            std::string name;
+            uint64_t count;
+            uint64_t suppressed;
+            uint64_t suppressed_since_pass;
+            clock::time_point last_pass;
+        };
+
+        debug_message_limits _limits;
+        mutable std::mutex _mutex{};
+        std::unordered_map<uint64_t, entry> _entries{};
+    };
+
+    //! \brief VK_EXT_debug_utils messenger of an instance filtered by a debug_message_filter.
+    //! Handlers are only called for messages passing the filter. Created before the instance, instance_create_info()
+    //! chained into VkInstanceCreateInfo::pNext reports the messages of vkCreateInstance() and vkDestroyInstance() as
+    //! well: attach() the messenger to the created instance, detach() it before vkDestroyInstance() and destroy the
+    //! object only afterwards.
+    class VLK_EXPORT debug_messenger
+    {
+    public:
+        using handler = std::function<void(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                                           VkDebugUtilsMessageTypeFlagsEXT types,
+                                           VkDebugUtilsMessengerCallbackDataEXT const& data,
+                                           uint64_t suppressed)>;
+
+        //! Not attached to an instance yet.
+        debug_messenger(VkDebugUtilsMessageSeverityFlagsEXT severities, VkDebugUtilsMessageTypeFlagsEXT types,
+                        handler fn, debug_message_limits l = debug_message_limits{});
+
+        //! Attached to instance.
+        //! \throws vlk::vulkan_exception  See attach().
+        debug_messenger(VkInstance instance, VkDebugUtilsMessageSeverityFlagsEXT severities,
+                        VkDebugUtilsMessageTypeFlagsEXT types, handler fn,
+                        debug_message_limits l = debug_message_limits{});
+        ~debug_messenger();
+
+        debug_messenger(debug_messenger const&) = delete;
+        debug_messenger& operator=(debug_messenger const&) = delete;
+
+        //! For VkInstanceCreateInfo::pNext, the messenger has to outlive the instance.
+        VkDebugUtilsMessengerCreateInfoEXT const* instance_create_info() const { return &_create_info; }
+
+        //! Creates the messenger of instance.
+        //! \throws vlk::vulkan_exception  Thrown when the messenger cannot be created, e.g. the instance was created
+        //!                                without VK_EXT_debug_utils.
+        void attach(VkInstance instance);
+
+        //! Destroys the messenger, must be called before the instance is destroyed.
+        void detach() noexcept;
+
+        //! Names an object of device in validation messages and debuggers. Must be attached.
+        void set_object_name(VkDevice device, VkObjectType type, uint64_t handle, char const* name) const;
+
+        //! Injects a message into the messenger chain, e.g. to mark a position in the validation output. Must be
+        //! attached.
+        void submit(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types,
+                    char const* message) const;
+
+        debug_message_filter const& filter() const { return _filter; }
+
+    private:
+        static VKAPI_ATTR VkBool32 VKAPI_CALL callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                VkDebugUtilsMessageTypeFlagsEXT types, VkDebugUtilsMessengerCallbackDataEXT const* data,
+                void* user_data);
+
+        VkInstance _instance{VK_NULL_HANDLE};
+        handler _handler;
+        debug_message_filter _filter;
+        VkDebugUtilsMessengerCreateInfoEXT _create_info{};
+        VkDebugUtilsMessengerEXT _messenger{VK_NULL_HANDLE};
+    };
+
+} // namespace vlk
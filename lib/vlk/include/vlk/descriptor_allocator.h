@@ -0,0 +1,144 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief Contents of a descriptor set: one descriptor per binding.
+    //! Used as key of descriptor_allocator's set cache - equal contents mean an equal set.
+    class VLK_EXPORT descriptor_set_desc
+    {
+    public:
+        descriptor_set_desc& buffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset = 0,
+                                    VkDeviceSize range = VK_WHOLE_SIZE);
+        descriptor_set_desc& image(uint32_t binding, VkDescriptorType type, VkImageView view, VkImageLayout layout,
+                                   VkSampler sampler = VK_NULL_HANDLE);
+        descriptor_set_desc& texel_buffer(uint32_t binding, VkDescriptorType type, VkBufferView view);
+
+        size_t hash() const { return _hash; }
+        bool operator==(descriptor_set_desc const& other) const;
+
+        //! Writes all bindings to set.
+        void write(VkDevice device, VkDescriptorSet set) const;
+
+    private:
+        struct entry
+        {
+            uint32_t binding;
+            VkDescriptorType type;
+            VkDescriptorBufferInfo buffer_info;
+            VkDescriptorImageInfo image_info;
+            VkBufferView texel_view;
+        };
+
+        descriptor_set_desc& add(entry const& e);
+
+        std::vector<entry> _entries{};
+        size_t _hash{0};
+    };
+
+    //! \brief Descriptor sets allocated from per-frame pools, with a per-frame cache of identical sets.
+    //! Each frame slot owns a list of descriptor pools which begin_frame() resets wholesale with
+    //! vkResetDescriptorPool - sets are never freed individually. When a pool is exhausted
+    //! (VK_ERROR_OUT_OF_POOL_MEMORY or VK_ERROR_FRAGMENTED_POOL) the next pool of the slot is used, a new one with
+    //! twice the capacity is created when the slot has no further pool. After a few frames every slot owns enough
+    //! pools and allocation never creates a pool again.
+    //! get() hashes the layout and the set's contents: draws binding the same resources within a frame share one set,
+    //! which is allocated and written only once. All functions are thread-safe.
+    class VLK_EXPORT descriptor_allocator
+    {
+    public:
+        //! Descriptors of each type per set in a pool, e.g. {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f} reserves two
+        //! uniform buffers per set.
+        using pool_ratios = std::vector<std::pair<VkDescriptorType, float>>;
+
+        struct stats
+        {
+            uint64_t allocated{0};      //!< sets allocated
+            uint64_t cache_hits{0};     //!< get() calls served by the cache
+            uint32_t pools{0};
+        };
+
+        static pool_ratios default_ratios();
+
+        descriptor_allocator(VkDevice device, uint32_t frames_in_flight, pool_ratios ratios = default_ratios(),
+                             uint32_t initial_sets_per_pool = 64U);
+        ~descriptor_allocator();
+
+        descriptor_allocator(descriptor_allocator const&) = delete;
+        descriptor_allocator& operator=(descriptor_allocator const&) = delete;
+
+        //! Makes frame_index the current frame slot, resets its pools and clears its set cache. The slot's
+        //! submissions must be finished.
+        void begin_frame(uint32_t frame_index);
+
+        //! Uninitialised set of layout, valid until the current frame slot begins again.
+        VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+        //! Set of layout with the contents desc, allocated and written on first use in the current frame.
+        VkDescriptorSet get(VkDescriptorSetLayout layout, descriptor_set_desc const& desc);
+
+        stats get_stats() const;
+
+    private:
+        struct cache_key
+        {
+            VkDescriptorSetLayout layout;
+            descriptor_set_desc desc;
+
+            bool operator==(cache_key const& other) const { return layout == other.layout && desc == other.desc; }
+        };
+
+        struct cache_key_hash
+        {
+            size_t operator()(cache_key const& k) const;
+        };
+
+        struct frame
+        {
+            std::vector<VkDescriptorPool> pools{};
+            size_t current{0};      //!< pool allocated from
+            std::unordered_map<cache_key, VkDescriptorSet, cache_key_hash> cache{};
+        };
+
+        VkDescriptorSet allocate_locked(VkDescriptorSetLayout layout);
+        VkDescriptorPool create_pool();
+        void release() noexcept;
+
+        VkDevice _device;
+        pool_ratios _ratios;
+        uint32_t _sets_per_pool;        //!< of the last pool created
+        mutable std::mutex _mutex{};
+        std::vector<frame> _frames{};
+        uint32_t _frame_idx{0};
+        stats _stats{};
+    };
+
+} // namespace vlk
@@ -0,0 +1,150 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <string_view>
+
+namespace vlk {
+
+    namespace detail {
+
+        template<typename E>
+        struct enum_name
+        {
+            E value;
+            std::string_view name;
+        };
+
+#define VLK_ENUM_NAME(e) enum_name<decltype(e)>{e, #e}
+
+        constexpr std::array result_names{
+            VLK_ENUM_NAME(VK_SUCCESS),
+            VLK_ENUM_NAME(VK_NOT_READY),
+            VLK_ENUM_NAME(VK_TIMEOUT),
+            VLK_ENUM_NAME(VK_EVENT_SET),
+            VLK_ENUM_NAME(VK_EVENT_RESET),
+            VLK_ENUM_NAME(VK_INCOMPLETE),
+            VLK_ENUM_NAME(VK_ERROR_OUT_OF_HOST_MEMORY),
+            VLK_ENUM_NAME(VK_ERROR_OUT_OF_DEVICE_MEMORY),
+            VLK_ENUM_NAME(VK_ERROR_INITIALIZATION_FAILED),
+            VLK_ENUM_NAME(VK_ERROR_DEVICE_LOST),
+            VLK_ENUM_NAME(VK_ERROR_MEMORY_MAP_FAILED),
+            VLK_ENUM_NAME(VK_ERROR_LAYER_NOT_PRESENT),
+            VLK_ENUM_NAME(VK_ERROR_EXTENSION_NOT_PRESENT),
+            VLK_ENUM_NAME(VK_ERROR_FEATURE_NOT_PRESENT),
+            VLK_ENUM_NAME(VK_ERROR_INCOMPATIBLE_DRIVER),
+            VLK_ENUM_NAME(VK_ERROR_TOO_MANY_OBJECTS),
+            VLK_ENUM_NAME(VK_ERROR_FORMAT_NOT_SUPPORTED),
+            VLK_ENUM_NAME(VK_ERROR_FRAGMENTED_POOL),
+            VLK_ENUM_NAME(VK_ERROR_OUT_OF_POOL_MEMORY),
+            VLK_ENUM_NAME(VK_ERROR_INVALID_EXTERNAL_HANDLE),
+            VLK_ENUM_NAME(VK_ERROR_SURFACE_LOST_KHR),
+            VLK_ENUM_NAME(VK_ERROR_NATIVE_WINDOW_IN_USE_KHR),
+            VLK_ENUM_NAME(VK_SUBOPTIMAL_KHR),
+            VLK_ENUM_NAME(VK_ERROR_OUT_OF_DATE_KHR),
+            VLK_ENUM_NAME(VK_ERROR_INCOMPATIBLE_DISPLAY_KHR),
+            VLK_ENUM_NAME(VK_ERROR_VALIDATION_FAILED_EXT),
+            VLK_ENUM_NAME(VK_ERROR_INVALID_SHADER_NV),
+            VLK_ENUM_NAME(VK_ERROR_INVALID_DRM_FORMAT_MODIFIER_PLANE_LAYOUT_EXT),
+            VLK_ENUM_NAME(VK_ERROR_FRAGMENTATION_EXT),
+            VLK_ENUM_NAME(VK_ERROR_NOT_PERMITTED_EXT),
+            VLK_ENUM_NAME(VK_ERROR_INVALID_DEVICE_ADDRESS_EXT),
+            VLK_ENUM_NAME(VK_ERROR_FULL_SCREEN_EXCLUSIVE_MODE_LOST_EXT),
+            VLK_ENUM_NAME(VK_RESULT_MAX_ENUM),     // thrown for errors without a Vulkan result
+        };
+
+        constexpr std::array physical_device_type_names{
+            VLK_ENUM_NAME(VK_PHYSICAL_DEVICE_TYPE_OTHER),
+            VLK_ENUM_NAME(VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU),
+            VLK_ENUM_NAME(VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU),
+            VLK_ENUM_NAME(VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU),
+            VLK_ENUM_NAME(VK_PHYSICAL_DEVICE_TYPE_CPU),
+        };
+
+        constexpr std::array color_space_names{
+            VLK_ENUM_NAME(VK_COLOR_SPACE_SRGB_NONLINEAR_KHR),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_DISPLAY_P3_NONLINEAR_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_DCI_P3_LINEAR_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_DCI_P3_NONLINEAR_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_BT709_LINEAR_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_BT709_NONLINEAR_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_BT2020_LINEAR_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_HDR10_ST2084_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_DOLBYVISION_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_HDR10_HLG_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_ADOBERGB_LINEAR_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_ADOBERGB_NONLINEAR_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_PASS_THROUGH_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_EXTENDED_SRGB_NONLINEAR_EXT),
+            VLK_ENUM_NAME(VK_COLOR_SPACE_DISPLAY_NATIVE_AMD),
+        };
+
+        constexpr std::array present_mode_names{
+            VLK_ENUM_NAME(VK_PRESENT_MODE_IMMEDIATE_KHR),
+            VLK_ENUM_NAME(VK_PRESENT_MODE_MAILBOX_KHR),
+            VLK_ENUM_NAME(VK_PRESENT_MODE_FIFO_KHR),
+            VLK_ENUM_NAME(VK_PRESENT_MODE_FIFO_RELAXED_KHR),
+            VLK_ENUM_NAME(VK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR),
+            VLK_ENUM_NAME(VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR),
+        };
+
+#undef VLK_ENUM_NAME
+
+        //! The tables are short, a linear search beats a hash for them.
+        template<typename E, size_t N>
+        constexpr std::string_view find_enum_name(std::array<enum_name<E>, N> const& table, E value)
+        {
+            for (auto const& e : table) {
+                if (e.value == value) {
+                    return e.name;
+                }
+            }
+            return "<unknown>";
+        }
+
+    } // namespace detail
+
+    //! Translate VkResult enumeration values to string. Results of newer Vulkan versions are "<unknown>", log sites
+    //! print the number as well.
+    constexpr std::string_view to_string(VkResult r)
+    {
+        return detail::find_enum_name(detail::result_names, r);
+    }
+
+    //! Translate VkPhyiscalDeviceType value to string.
+    constexpr std::string_view to_string(VkPhysicalDeviceType dt)
+    {
+        return detail::find_enum_name(detail::physical_device_type_names, dt);
+    }
+
+    constexpr std::string_view to_string(VkColorSpaceKHR cs)
+    {
+        return detail::find_enum_name(detail::color_space_names, cs);
+    }
+
+    constexpr std::string_view to_string(VkPresentModeKHR pm)
+    {
+        return detail::find_enum_name(detail::present_mode_names, pm);
+    }
+
+} // namespace vlk
@@ -66,7 +66,7 @@ namespace vlk {
     {
     public:
         explicit vulkan_exception(std::string const& msg, VkResult vulkan_error)
-            : app_exception{msg, vulkan_error, vlk::to_string(vulkan_error)}
+            : app_exception{msg, vulkan_error, std::string{vlk::to_string(vulkan_error)}}
         {}
     };
 
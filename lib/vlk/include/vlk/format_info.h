@@ -0,0 +1,390 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace vlk {
+
+    enum class format_compression : uint8_t
+    {
+        none,
+        bc,
+        etc2,
+        eac,
+        astc,
+        pvrtc,
+    };
+
+    //! Properties of a VkFormat as listed in the format compatibility classes of the Vulkan specification.
+    struct format_info
+    {
+        VkFormat format;
+        std::string_view name;
+        uint8_t block_size;     //!< bytes per texel block, 0 for multi-planar formats: they are copied per plane
+        uint8_t block_width;    //!< texel block extent, 1x1 for uncompressed formats besides the 422 ones
+        uint8_t block_height;
+        uint8_t planes;
+        uint8_t red_bits;       //!< component bits are 0 for block compressed formats
+        uint8_t green_bits;
+        uint8_t blue_bits;
+        uint8_t alpha_bits;
+        uint8_t depth_bits;
+        uint8_t stencil_bits;
+        VkImageAspectFlags aspect;
+        format_compression compression;
+
+        constexpr bool compressed() const { return format_compression::none != compression; }
+        constexpr bool has_depth() const { return 0 != depth_bits; }
+        constexpr bool has_stencil() const { return 0 != stencil_bits; }
+    };
+
+    namespace detail {
+
+        constexpr VkImageAspectFlags format_aspect_0{0};
+        constexpr VkImageAspectFlags format_aspect_C{VK_IMAGE_ASPECT_COLOR_BIT};
+        constexpr VkImageAspectFlags format_aspect_D{VK_IMAGE_ASPECT_DEPTH_BIT};
+        constexpr VkImageAspectFlags format_aspect_S{VK_IMAGE_ASPECT_STENCIL_BIT};
+        constexpr VkImageAspectFlags format_aspect_DS{VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT};
+
+// format, block size, block width, block height, planes, r, g, b, a, depth, stencil bits, aspect, compression
+#define VLK_FORMAT(f, size, bw, bh, planes, r, g, b, a, d, s, aspect, compression) \
+        format_info{f, #f, size, bw, bh, planes, r, g, b, a, d, s, format_aspect_##aspect, \
+                    format_compression::compression}
+
+        //! Ordered by value: the core formats, then the ranges of VK_KHR_sampler_ycbcr_conversion and
+        //! VK_IMG_format_pvrtc.
+        constexpr std::array format_table{
+        VLK_FORMAT(VK_FORMAT_UNDEFINED, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, none),
+        VLK_FORMAT(VK_FORMAT_R4G4_UNORM_PACK8, 1, 1, 1, 1, 4, 4, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R4G4B4A4_UNORM_PACK16, 2, 1, 1, 1, 4, 4, 4, 4, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B4G4R4A4_UNORM_PACK16, 2, 1, 1, 1, 4, 4, 4, 4, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R5G6B5_UNORM_PACK16, 2, 1, 1, 1, 5, 6, 5, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B5G6R5_UNORM_PACK16, 2, 1, 1, 1, 5, 6, 5, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R5G5B5A1_UNORM_PACK16, 2, 1, 1, 1, 5, 5, 5, 1, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B5G5R5A1_UNORM_PACK16, 2, 1, 1, 1, 5, 5, 5, 1, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A1R5G5B5_UNORM_PACK16, 2, 1, 1, 1, 5, 5, 5, 1, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8_UNORM, 1, 1, 1, 1, 8, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8_SNORM, 1, 1, 1, 1, 8, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8_USCALED, 1, 1, 1, 1, 8, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8_SSCALED, 1, 1, 1, 1, 8, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8_UINT, 1, 1, 1, 1, 8, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8_SINT, 1, 1, 1, 1, 8, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8_SRGB, 1, 1, 1, 1, 8, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8_UNORM, 2, 1, 1, 1, 8, 8, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8_SNORM, 2, 1, 1, 1, 8, 8, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8_USCALED, 2, 1, 1, 1, 8, 8, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8_SSCALED, 2, 1, 1, 1, 8, 8, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8_UINT, 2, 1, 1, 1, 8, 8, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8_SINT, 2, 1, 1, 1, 8, 8, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8_SRGB, 2, 1, 1, 1, 8, 8, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8_UNORM, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8_SNORM, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8_USCALED, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8_SSCALED, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8_UINT, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8_SINT, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8_SRGB, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8_UNORM, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8_SNORM, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8_USCALED, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8_SSCALED, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8_UINT, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8_SINT, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8_SRGB, 3, 1, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8A8_UNORM, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8A8_SNORM, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8A8_USCALED, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8A8_SSCALED, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8A8_UINT, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8A8_SINT, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R8G8B8A8_SRGB, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8A8_UNORM, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8A8_SNORM, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8A8_USCALED, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8A8_SSCALED, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8A8_UINT, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8A8_SINT, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8A8_SRGB, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A8B8G8R8_UNORM_PACK32, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A8B8G8R8_SNORM_PACK32, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A8B8G8R8_USCALED_PACK32, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A8B8G8R8_SSCALED_PACK32, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A8B8G8R8_UINT_PACK32, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A8B8G8R8_SINT_PACK32, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A8B8G8R8_SRGB_PACK32, 4, 1, 1, 1, 8, 8, 8, 8, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A2R10G10B10_UNORM_PACK32, 4, 1, 1, 1, 10, 10, 10, 2, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A2R10G10B10_SNORM_PACK32, 4, 1, 1, 1, 10, 10, 10, 2, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A2R10G10B10_USCALED_PACK32, 4, 1, 1, 1, 10, 10, 10, 2, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A2R10G10B10_SSCALED_PACK32, 4, 1, 1, 1, 10, 10, 10, 2, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A2R10G10B10_UINT_PACK32, 4, 1, 1, 1, 10, 10, 10, 2, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A2R10G10B10_SINT_PACK32, 4, 1, 1, 1, 10, 10, 10, 2, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A2B10G10R10_UNORM_PACK32, 4, 1, 1, 1, 10, 10, 10, 2, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A2B10G10R10_SNORM_PACK32, 4, 1, 1, 1, 10, 10, 10, 2, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A2B10G10R10_USCALED_PACK32, 4, 1, 1, 1, 10, 10, 10, 2, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A2B10G10R10_SSCALED_PACK32, 4, 1, 1, 1, 10, 10, 10, 2, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A2B10G10R10_UINT_PACK32, 4, 1, 1, 1, 10, 10, 10, 2, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_A2B10G10R10_SINT_PACK32, 4, 1, 1, 1, 10, 10, 10, 2, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16_UNORM, 2, 1, 1, 1, 16, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16_SNORM, 2, 1, 1, 1, 16, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16_USCALED, 2, 1, 1, 1, 16, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16_SSCALED, 2, 1, 1, 1, 16, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16_UINT, 2, 1, 1, 1, 16, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16_SINT, 2, 1, 1, 1, 16, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16_SFLOAT, 2, 1, 1, 1, 16, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16_UNORM, 4, 1, 1, 1, 16, 16, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16_SNORM, 4, 1, 1, 1, 16, 16, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16_USCALED, 4, 1, 1, 1, 16, 16, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16_SSCALED, 4, 1, 1, 1, 16, 16, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16_UINT, 4, 1, 1, 1, 16, 16, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16_SINT, 4, 1, 1, 1, 16, 16, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16_SFLOAT, 4, 1, 1, 1, 16, 16, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16_UNORM, 6, 1, 1, 1, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16_SNORM, 6, 1, 1, 1, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16_USCALED, 6, 1, 1, 1, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16_SSCALED, 6, 1, 1, 1, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16_UINT, 6, 1, 1, 1, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16_SINT, 6, 1, 1, 1, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16_SFLOAT, 6, 1, 1, 1, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16A16_UNORM, 8, 1, 1, 1, 16, 16, 16, 16, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16A16_SNORM, 8, 1, 1, 1, 16, 16, 16, 16, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16A16_USCALED, 8, 1, 1, 1, 16, 16, 16, 16, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16A16_SSCALED, 8, 1, 1, 1, 16, 16, 16, 16, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16A16_UINT, 8, 1, 1, 1, 16, 16, 16, 16, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16A16_SINT, 8, 1, 1, 1, 16, 16, 16, 16, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R16G16B16A16_SFLOAT, 8, 1, 1, 1, 16, 16, 16, 16, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R32_UINT, 4, 1, 1, 1, 32, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R32_SINT, 4, 1, 1, 1, 32, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R32_SFLOAT, 4, 1, 1, 1, 32, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R32G32_UINT, 8, 1, 1, 1, 32, 32, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R32G32_SINT, 8, 1, 1, 1, 32, 32, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R32G32_SFLOAT, 8, 1, 1, 1, 32, 32, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R32G32B32_UINT, 12, 1, 1, 1, 32, 32, 32, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R32G32B32_SINT, 12, 1, 1, 1, 32, 32, 32, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R32G32B32_SFLOAT, 12, 1, 1, 1, 32, 32, 32, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R32G32B32A32_UINT, 16, 1, 1, 1, 32, 32, 32, 32, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R32G32B32A32_SINT, 16, 1, 1, 1, 32, 32, 32, 32, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R32G32B32A32_SFLOAT, 16, 1, 1, 1, 32, 32, 32, 32, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R64_UINT, 8, 1, 1, 1, 64, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R64_SINT, 8, 1, 1, 1, 64, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R64_SFLOAT, 8, 1, 1, 1, 64, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R64G64_UINT, 16, 1, 1, 1, 64, 64, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R64G64_SINT, 16, 1, 1, 1, 64, 64, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R64G64_SFLOAT, 16, 1, 1, 1, 64, 64, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R64G64B64_UINT, 24, 1, 1, 1, 64, 64, 64, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R64G64B64_SINT, 24, 1, 1, 1, 64, 64, 64, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R64G64B64_SFLOAT, 24, 1, 1, 1, 64, 64, 64, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R64G64B64A64_UINT, 32, 1, 1, 1, 64, 64, 64, 64, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R64G64B64A64_SINT, 32, 1, 1, 1, 64, 64, 64, 64, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R64G64B64A64_SFLOAT, 32, 1, 1, 1, 64, 64, 64, 64, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B10G11R11_UFLOAT_PACK32, 4, 1, 1, 1, 11, 11, 10, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_E5B9G9R9_UFLOAT_PACK32, 4, 1, 1, 1, 9, 9, 9, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_D16_UNORM, 2, 1, 1, 1, 0, 0, 0, 0, 16, 0, D, none),
+        VLK_FORMAT(VK_FORMAT_X8_D24_UNORM_PACK32, 4, 1, 1, 1, 0, 0, 0, 0, 24, 0, D, none),
+        VLK_FORMAT(VK_FORMAT_D32_SFLOAT, 4, 1, 1, 1, 0, 0, 0, 0, 32, 0, D, none),
+        VLK_FORMAT(VK_FORMAT_S8_UINT, 1, 1, 1, 1, 0, 0, 0, 0, 0, 8, S, none),
+        VLK_FORMAT(VK_FORMAT_D16_UNORM_S8_UINT, 3, 1, 1, 1, 0, 0, 0, 0, 16, 8, DS, none),
+        VLK_FORMAT(VK_FORMAT_D24_UNORM_S8_UINT, 4, 1, 1, 1, 0, 0, 0, 0, 24, 8, DS, none),
+        VLK_FORMAT(VK_FORMAT_D32_SFLOAT_S8_UINT, 5, 1, 1, 1, 0, 0, 0, 0, 32, 8, DS, none),
+        VLK_FORMAT(VK_FORMAT_BC1_RGB_UNORM_BLOCK, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC1_RGB_SRGB_BLOCK, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC2_UNORM_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC2_SRGB_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC3_UNORM_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC3_SRGB_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC4_UNORM_BLOCK, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC4_SNORM_BLOCK, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC5_UNORM_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC5_SNORM_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC6H_UFLOAT_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC6H_SFLOAT_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC7_UNORM_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_BC7_SRGB_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, bc),
+        VLK_FORMAT(VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, etc2),
+        VLK_FORMAT(VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, etc2),
+        VLK_FORMAT(VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, etc2),
+        VLK_FORMAT(VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, etc2),
+        VLK_FORMAT(VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, etc2),
+        VLK_FORMAT(VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, etc2),
+        VLK_FORMAT(VK_FORMAT_EAC_R11_UNORM_BLOCK, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, eac),
+        VLK_FORMAT(VK_FORMAT_EAC_R11_SNORM_BLOCK, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, eac),
+        VLK_FORMAT(VK_FORMAT_EAC_R11G11_UNORM_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, eac),
+        VLK_FORMAT(VK_FORMAT_EAC_R11G11_SNORM_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, eac),
+        VLK_FORMAT(VK_FORMAT_ASTC_4x4_UNORM_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_4x4_SRGB_BLOCK, 16, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_5x4_UNORM_BLOCK, 16, 5, 4, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_5x4_SRGB_BLOCK, 16, 5, 4, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_5x5_UNORM_BLOCK, 16, 5, 5, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_5x5_SRGB_BLOCK, 16, 5, 5, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_6x5_UNORM_BLOCK, 16, 6, 5, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_6x5_SRGB_BLOCK, 16, 6, 5, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_6x6_UNORM_BLOCK, 16, 6, 6, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_6x6_SRGB_BLOCK, 16, 6, 6, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_8x5_UNORM_BLOCK, 16, 8, 5, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_8x5_SRGB_BLOCK, 16, 8, 5, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_8x6_UNORM_BLOCK, 16, 8, 6, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_8x6_SRGB_BLOCK, 16, 8, 6, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_8x8_UNORM_BLOCK, 16, 8, 8, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_8x8_SRGB_BLOCK, 16, 8, 8, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_10x5_UNORM_BLOCK, 16, 10, 5, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_10x5_SRGB_BLOCK, 16, 10, 5, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_10x6_UNORM_BLOCK, 16, 10, 6, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_10x6_SRGB_BLOCK, 16, 10, 6, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_10x8_UNORM_BLOCK, 16, 10, 8, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_10x8_SRGB_BLOCK, 16, 10, 8, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_10x10_UNORM_BLOCK, 16, 10, 10, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_10x10_SRGB_BLOCK, 16, 10, 10, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_12x10_UNORM_BLOCK, 16, 12, 10, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_12x10_SRGB_BLOCK, 16, 12, 10, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_12x12_UNORM_BLOCK, 16, 12, 12, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_ASTC_12x12_SRGB_BLOCK, 16, 12, 12, 1, 0, 0, 0, 0, 0, 0, C, astc),
+        VLK_FORMAT(VK_FORMAT_G8B8G8R8_422_UNORM, 4, 2, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B8G8R8G8_422_UNORM, 4, 2, 1, 1, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM, 0, 1, 1, 3, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G8_B8R8_2PLANE_420_UNORM, 0, 1, 1, 2, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G8_B8_R8_3PLANE_422_UNORM, 0, 1, 1, 3, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G8_B8R8_2PLANE_422_UNORM, 0, 1, 1, 2, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G8_B8_R8_3PLANE_444_UNORM, 0, 1, 1, 3, 8, 8, 8, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R10X6_UNORM_PACK16, 2, 1, 1, 1, 10, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R10X6G10X6_UNORM_2PACK16, 4, 1, 1, 1, 10, 10, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R10X6G10X6B10X6A10X6_UNORM_4PACK16, 8, 1, 1, 1, 10, 10, 10, 10, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G10X6B10X6G10X6R10X6_422_UNORM_4PACK16, 8, 2, 1, 1, 10, 10, 10, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B10X6G10X6R10X6G10X6_422_UNORM_4PACK16, 8, 2, 1, 1, 10, 10, 10, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G10X6_B10X6_R10X6_3PLANE_420_UNORM_3PACK16, 0, 1, 1, 3, 10, 10, 10, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G10X6_B10X6R10X6_2PLANE_420_UNORM_3PACK16, 0, 1, 1, 2, 10, 10, 10, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G10X6_B10X6_R10X6_3PLANE_422_UNORM_3PACK16, 0, 1, 1, 3, 10, 10, 10, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G10X6_B10X6R10X6_2PLANE_422_UNORM_3PACK16, 0, 1, 1, 2, 10, 10, 10, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G10X6_B10X6_R10X6_3PLANE_444_UNORM_3PACK16, 0, 1, 1, 3, 10, 10, 10, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R12X4_UNORM_PACK16, 2, 1, 1, 1, 12, 0, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R12X4G12X4_UNORM_2PACK16, 4, 1, 1, 1, 12, 12, 0, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_R12X4G12X4B12X4A12X4_UNORM_4PACK16, 8, 1, 1, 1, 12, 12, 12, 12, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G12X4B12X4G12X4R12X4_422_UNORM_4PACK16, 8, 2, 1, 1, 12, 12, 12, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B12X4G12X4R12X4G12X4_422_UNORM_4PACK16, 8, 2, 1, 1, 12, 12, 12, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G12X4_B12X4_R12X4_3PLANE_420_UNORM_3PACK16, 0, 1, 1, 3, 12, 12, 12, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G12X4_B12X4R12X4_2PLANE_420_UNORM_3PACK16, 0, 1, 1, 2, 12, 12, 12, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G12X4_B12X4_R12X4_3PLANE_422_UNORM_3PACK16, 0, 1, 1, 3, 12, 12, 12, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G12X4_B12X4R12X4_2PLANE_422_UNORM_3PACK16, 0, 1, 1, 2, 12, 12, 12, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G12X4_B12X4_R12X4_3PLANE_444_UNORM_3PACK16, 0, 1, 1, 3, 12, 12, 12, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G16B16G16R16_422_UNORM, 8, 2, 1, 1, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_B16G16R16G16_422_UNORM, 8, 2, 1, 1, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G16_B16_R16_3PLANE_420_UNORM, 0, 1, 1, 3, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G16_B16R16_2PLANE_420_UNORM, 0, 1, 1, 2, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G16_B16_R16_3PLANE_422_UNORM, 0, 1, 1, 3, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G16_B16R16_2PLANE_422_UNORM, 0, 1, 1, 2, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_G16_B16_R16_3PLANE_444_UNORM, 0, 1, 1, 3, 16, 16, 16, 0, 0, 0, C, none),
+        VLK_FORMAT(VK_FORMAT_PVRTC1_2BPP_UNORM_BLOCK_IMG, 8, 8, 4, 1, 0, 0, 0, 0, 0, 0, C, pvrtc),
+        VLK_FORMAT(VK_FORMAT_PVRTC1_4BPP_UNORM_BLOCK_IMG, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, pvrtc),
+        VLK_FORMAT(VK_FORMAT_PVRTC2_2BPP_UNORM_BLOCK_IMG, 8, 8, 4, 1, 0, 0, 0, 0, 0, 0, C, pvrtc),
+        VLK_FORMAT(VK_FORMAT_PVRTC2_4BPP_UNORM_BLOCK_IMG, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, pvrtc),
+        VLK_FORMAT(VK_FORMAT_PVRTC1_2BPP_SRGB_BLOCK_IMG, 8, 8, 4, 1, 0, 0, 0, 0, 0, 0, C, pvrtc),
+        VLK_FORMAT(VK_FORMAT_PVRTC1_4BPP_SRGB_BLOCK_IMG, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, pvrtc),
+        VLK_FORMAT(VK_FORMAT_PVRTC2_2BPP_SRGB_BLOCK_IMG, 8, 8, 4, 1, 0, 0, 0, 0, 0, 0, C, pvrtc),
+        VLK_FORMAT(VK_FORMAT_PVRTC2_4BPP_SRGB_BLOCK_IMG, 8, 4, 4, 1, 0, 0, 0, 0, 0, 0, C, pvrtc),
+        };
+
+#undef VLK_FORMAT
+
+        constexpr size_t format_core_count{185U};
+        constexpr size_t format_ycbcr_count{34U};
+        constexpr size_t format_pvrtc_count{8U};
+        constexpr int64_t format_ycbcr_first{VK_FORMAT_G8B8G8R8_422_UNORM};
+        constexpr int64_t format_pvrtc_first{VK_FORMAT_PVRTC1_2BPP_UNORM_BLOCK_IMG};
+
+        constexpr format_info unknown_format{VK_FORMAT_UNDEFINED, "<unknown VkFormat>", 0, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+                                             0, format_compression::none};
+
+        constexpr size_t format_index(int64_t v)
+        {
+            if (v >= 0 && v < static_cast<int64_t>(format_core_count)) {
+                return static_cast<size_t>(v);
+            }
+            if (v >= format_ycbcr_first && v < format_ycbcr_first + static_cast<int64_t>(format_ycbcr_count)) {
+                return format_core_count + static_cast<size_t>(v - format_ycbcr_first);
+            }
+            if (v >= format_pvrtc_first && v < format_pvrtc_first + static_cast<int64_t>(format_pvrtc_count)) {
+                return format_core_count + format_ycbcr_count + static_cast<size_t>(v - format_pvrtc_first);
+            }
+            return format_table.size();
+        }
+
+        constexpr bool format_table_is_ordered()
+        {
+            for (size_t i = 0; i < format_table.size(); ++i) {
+                if (format_index(format_table[i].format) != i) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        static_assert(format_core_count + format_ycbcr_count + format_pvrtc_count == format_table.size());
+        static_assert(format_table_is_ordered(), "format_table must be ordered by the VkFormat values");
+
+        constexpr VkDeviceSize div_up(VkDeviceSize v, VkDeviceSize d) { return (v + d - 1U) / d; }
+
+    } // namespace detail
+
+    //! O(1), formats not in the table get an entry named "<unknown VkFormat>" with format VK_FORMAT_UNDEFINED.
+    constexpr format_info const& get_format_info(VkFormat f)
+    {
+        auto const i = detail::format_index(f);
+        return i < detail::format_table.size() ? detail::format_table[i] : detail::unknown_format;
+    }
+
+    constexpr std::string_view to_string(VkFormat f)
+    {
+        return get_format_info(f).name;
+    }
+
+    //! Bytes of buffer memory read or written by a copy of region between a buffer and an image of format f,
+    //! starting at bufferOffset. Takes bufferRowLength, bufferImageHeight and the block extent of compressed
+    //! formats into account, a single aspect of a depth/stencil format is copied tightly packed. 0 for multi-planar
+    //! and unknown formats.
+    constexpr VkDeviceSize image_copy_size(VkFormat f, VkBufferImageCopy const& region)
+    {
+        auto const& fi = get_format_info(f);
+        VkDeviceSize block_size{fi.block_size};
+        if (fi.has_depth() && fi.has_stencil()) {
+            // D24 is copied as 32 bit values
+            block_size = VK_IMAGE_ASPECT_STENCIL_BIT == region.imageSubresource.aspectMask
+                       ? 1U : (16U == fi.depth_bits ? 2U : 4U);
+        }
+        auto const& extent = region.imageExtent;
+        if (0 == block_size || 0 == extent.width || 0 == extent.height || 0 == extent.depth) {
+            return 0;
+        }
+        auto const row_texels = 0 != region.bufferRowLength ? region.bufferRowLength : extent.width;
+        auto const image_rows = 0 != region.bufferImageHeight ? region.bufferImageHeight : extent.height;
+        auto const row_blocks = detail::div_up(row_texels, fi.block_width);
+        auto const image_block_rows = detail::div_up(image_rows, fi.block_height);
+        auto const slices = VkDeviceSize{extent.depth} * region.imageSubresource.layerCount;
+        // the last row of the last slice ends with the copied width, not with the row length
+        auto const last_block = ((slices - 1U) * image_block_rows + detail::div_up(extent.height, fi.block_height) - 1U)
+                                * row_blocks + detail::div_up(extent.width, fi.block_width);
+        return last_block * block_size;
+    }
+
+} // namespace vlk
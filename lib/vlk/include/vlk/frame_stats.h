@@ -0,0 +1,118 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace vlk {
+
+    //! \brief Lock-free histogram of durations with logarithmic buckets.
+    //! Each power of two range of nanoseconds is split into 2^sub_bucket_bits linear sub-buckets, so every recorded
+    //! value is represented with a relative error below 1/2^sub_bucket_bits. Recording is wait-free apart from the
+    //! CAS loops for min/max/sum of squares and can be done from any thread; readers get a consistent snapshot only
+    //! when no writer is active.
+    class VLK_EXPORT histogram
+    {
+    public:
+        static constexpr uint32_t sub_bucket_bits = 3U;
+        static constexpr uint32_t sub_bucket_count = 1U << sub_bucket_bits;
+        //! Values at or above 2^max_value_bits ns (~18 minutes) are counted in the last bucket.
+        static constexpr uint32_t max_value_bits = 40U;
+        static constexpr uint32_t bucket_count = (max_value_bits - sub_bucket_bits + 1U) * sub_bucket_count;
+
+        histogram() = default;
+        histogram(histogram const&) = delete;
+        histogram& operator=(histogram const&) = delete;
+
+        void record(std::chrono::nanoseconds duration);
+        void reset();
+
+        uint64_t count() const;
+
+        //! Returns the duration in milliseconds that p percent of all recorded values do not exceed, p in [0, 100].
+        double percentile_ms(double p) const;
+        double p50_ms() const { return percentile_ms(50.0); }
+        double p95_ms() const { return percentile_ms(95.0); }
+        double p99_ms() const { return percentile_ms(99.0); }
+        double min_ms() const;
+        double max_ms() const;
+        double mean_ms() const;
+
+        //! Sample variance of the recorded values in ms^2.
+        double variance_ms2() const;
+        double stddev_ms() const;
+
+        static uint32_t bucket_index(uint64_t ns);
+        static uint64_t bucket_upper_bound(uint32_t idx);
+
+    private:
+        std::array<std::atomic<uint64_t>, bucket_count> _buckets{};
+        std::atomic<uint64_t> _count{0};
+        std::atomic<uint64_t> _sum_ns{0};
+        std::atomic<double> _sum_sq_ms2{0.0};
+        std::atomic<uint64_t> _min_ns{UINT64_MAX};
+        std::atomic<uint64_t> _max_ns{0};
+    };
+
+    //! Phases of a frame measured on the CPU by the render loop.
+    enum class frame_phase : uint32_t
+    {
+        acquire = 0,    //!< waiting for the frame slot's fence and acquiring the next image
+        record,         //!< recording the frame's command buffer(s)
+        submit,         //!< vkQueueSubmit
+        present,        //!< vkQueuePresentKHR
+        frame,          //!< start of one frame to start of the next frame
+        count
+    };
+
+    char const* to_string(frame_phase fp);
+
+    //! \brief Per-frame CPU timing statistics of the render loop.
+    //! Besides the histograms per phase the mean absolute difference of consecutive frame times is tracked, a
+    //! measure for micro-stutter that variance alone doesn't show (alternating 10/20 ms frames have the same variance
+    //! as a slow drift but are perceived as stutter).
+    class VLK_EXPORT frame_stats
+    {
+    public:
+        void record(frame_phase phase, std::chrono::nanoseconds duration);
+        void reset();
+
+        histogram const& phase(frame_phase phase) const;
+
+        //! Mean absolute difference of consecutive frame times in ms.
+        double jitter_ms() const;
+
+        //! Logs a summary line per phase.
+        void log(std::string const& prefix = {}) const;
+
+    private:
+        std::array<histogram, static_cast<size_t>(frame_phase::count)> _phases{};
+        std::atomic<uint64_t> _last_frame_ns{0};
+        std::atomic<uint64_t> _delta_sum_ns{0};
+        std::atomic<uint64_t> _delta_count{0};
+    };
+
+} // namespace vlk
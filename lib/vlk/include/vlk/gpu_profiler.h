@@ -0,0 +1,168 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+#include <vlk/phys_device.h>
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief The zones of one frame of the gpu_profiler, without any Vulkan calls.
+    //! Zone i owns the timestamp queries 2 * i (begin) and 2 * i + 1 (end). Only the queries of closed zones are
+    //! written, the end timestamp of a zone never closed is missing.
+    class VLK_EXPORT gpu_zone_list
+    {
+    public:
+        static constexpr uint32_t invalid_zone{UINT32_MAX};
+
+        struct zone
+        {
+            char const* name;
+            uint32_t depth;
+            bool closed;
+        };
+
+        explicit gpu_zone_list(uint32_t max_zones);
+
+        //! Opens a zone nested into the zones currently open, invalid_zone when max_zones is reached.
+        uint32_t open(char const* name);
+        //! Closes a zone returned by open(), invalid_zone is ignored.
+        void close(uint32_t zone_idx);
+
+        //! Removes all zones.
+        void clear();
+
+        //! Number of zones opened but not closed.
+        uint32_t depth() const { return _depth; }
+        //! First zone opened but not closed, nullptr if there is none.
+        zone const* first_open() const;
+
+        std::vector<zone> const& zones() const { return _zones; }
+
+        //! Calls fn(first_zone, count) for each run of consecutive closed zones, i.e. for the query ranges whose
+        //! results are available.
+        template<typename Fn>
+        void for_each_closed_run(Fn&& fn) const
+        {
+            uint32_t first{0};
+            for (uint32_t i = 0; i <= _zones.size(); ++i) {
+                if (i < _zones.size() && _zones[i].closed) {
+                    continue;
+                }
+                if (i > first) {
+                    fn(first, i - first);
+                }
+                first = i + 1U;
+            }
+        }
+
+    private:
+        uint32_t _max_zones;
+        uint32_t _depth{0};
+        std::vector<zone> _zones{};
+    };
+
+    //! \brief GPU timing of command buffer sections via timestamp queries.
+    //! The profiler owns one timestamp query pool per frame in flight. A frame slot's pool is read back when the slot
+    //! is reused by begin_frame() - at that point the slot's fence has been waited for, so reading never stalls.
+    //! Sections are measured with scoped_zone objects:
+    //! \code{C++}
+    //! {
+    //!     vlk::gpu_profiler::scoped_zone zone{profiler, cmd, "shadow pass"};
+    //!     ... record commands ...
+    //! }
+    //! \endcode
+    //! When the queue family doesn't support timestamps (timestampValidBits == 0) all calls are no-ops. Zones not
+    //! closed until the next begin_frame() are left out of the results and logged.
+    class VLK_EXPORT gpu_profiler
+    {
+    public:
+        struct zone_result
+        {
+            char const* name;       //!< name passed to scoped_zone
+            uint32_t depth;         //!< nesting depth, 0 for top level zones
+            double duration_ms;
+        };
+
+        //! RAII zone writing a timestamp when constructed and one when destroyed.
+        //! name has to be valid until the results are read back (string literals).
+        class VLK_EXPORT scoped_zone
+        {
+        public:
+            scoped_zone(gpu_profiler& profiler, VkCommandBuffer cmd, char const* name);
+            ~scoped_zone();
+
+            scoped_zone(scoped_zone const&) = delete;
+            scoped_zone& operator=(scoped_zone const&) = delete;
+
+        private:
+            gpu_profiler& _profiler;
+            VkCommandBuffer _cmd;
+            uint32_t _zone;
+        };
+
+        gpu_profiler(VkDevice device, vlk::phys_device const& pd, uint32_t queue_family_index,
+                     uint32_t frames_in_flight, uint32_t max_zones_per_frame = 256U);
+        ~gpu_profiler();
+
+        gpu_profiler(gpu_profiler const&) = delete;
+        gpu_profiler& operator=(gpu_profiler const&) = delete;
+
+        //! False when the queue family has no timestamp support or the profiler was created without frames.
+        bool enabled() const { return !_pools.empty(); }
+
+        //! Starts recording zones for frame slot frame_index into cmd. Collects the results of the slot's
+        //! previous frame first, therefore the slot's previous submission must be finished.
+        void begin_frame(uint32_t frame_index, VkCommandBuffer cmd);
+
+        //! Zones of the most recently completed frame in the order they were opened.
+        std::vector<zone_result> const& results() const { return _results; }
+
+        //! Number of zones dropped since construction because max_zones_per_frame was exceeded.
+        uint64_t dropped_zones() const { return _dropped_zones; }
+
+    private:
+        struct frame_pool
+        {
+            VkQueryPool pool{VK_NULL_HANDLE};
+            gpu_zone_list zones;
+            bool pending{false};
+        };
+
+        uint32_t begin_zone(VkCommandBuffer cmd, char const* name);
+        void end_zone(VkCommandBuffer cmd, uint32_t zone_idx);
+        void collect(frame_pool& fp);
+
+        VkDevice _device;
+        uint32_t _valid_bits;
+        double _ns_per_tick;
+        uint32_t _max_zones;
+        std::vector<frame_pool> _pools{};
+        frame_pool* _current{nullptr};
+        std::vector<zone_result> _results{};
+        std::vector<uint64_t> _timestamps{};
+        uint64_t _dropped_zones{0};
+    };
+
+} // namespace vlk
@@ -0,0 +1,136 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief Work-stealing job scheduler shared by all engine subsystems.
+    //! Every worker thread owns a deque: it pushes and pops its own jobs at the back (LIFO, cache friendly), idle
+    //! workers steal from the front of the other deques. The thread creating the job system is the main thread, it
+    //! has a deque as well and executes jobs while it waits for a counter.
+    //! Dependencies are expressed with counters: a job started with a counter increments it, the counter is done
+    //! when all its jobs have finished. Jobs can be waited for (wait() executes other jobs meanwhile) or chained
+    //! with run_after(). Jobs which have to run on the main thread - e.g. GLFW calls - are queued with run_on_main()
+    //! and executed by run_main_thread_jobs().
+    class VLK_EXPORT job_system
+    {
+    public:
+        using job = std::function<void()>;
+        static constexpr uint32_t invalid_thread_index{UINT32_MAX};
+
+        //! Number of unfinished jobs started with it. The first exception thrown by one of them is rethrown by
+        //! wait(). A counter must outlive the jobs started with it.
+        class VLK_EXPORT counter
+        {
+        public:
+            counter() = default;
+            counter(counter const&) = delete;
+            counter& operator=(counter const&) = delete;
+
+            bool done() const { return 0 == _pending.load(std::memory_order_acquire); }
+
+        private:
+            friend class job_system;
+            std::atomic<uint32_t> _pending{0};
+            std::exception_ptr _error{};
+        };
+
+        //! worker_count 0 starts one worker per hardware thread besides the main thread.
+        explicit job_system(uint32_t worker_count = 0);
+
+        //! Stops the workers, jobs not started yet are discarded.
+        ~job_system();
+
+        job_system(job_system const&) = delete;
+        job_system& operator=(job_system const&) = delete;
+
+        //! Starts j on any thread.
+        void run(job j, counter* c = nullptr);
+
+        //! Starts j when dependency is done.
+        void run_after(counter& dependency, job j, counter* c = nullptr);
+
+        //! Queues j for the main thread.
+        void run_on_main(job j, counter* c = nullptr);
+
+        //! Executes the jobs queued for the main thread, must be called by the main thread.
+        void run_main_thread_jobs();
+
+        //! Executes jobs until c is done, rethrows the first exception of c's jobs.
+        void wait(counter& c);
+
+        //! Calls fn(begin, end) for chunks of [0, count) of at least min_chunk items in parallel and waits.
+        void parallel_for(uint32_t count, uint32_t min_chunk, std::function<void(uint32_t, uint32_t)> const& fn);
+
+        uint32_t worker_count() const { return static_cast<uint32_t>(_threads.size()); }
+
+        //! Number of threads executing jobs (workers and main thread).
+        uint32_t thread_count() const { return worker_count() + 1U; }
+
+        //! 0 for the main thread, 1..worker_count() for the workers, invalid_thread_index for other threads.
+        uint32_t thread_index() const;
+
+        bool is_main_thread() const { return 0 == thread_index(); }
+
+    private:
+        struct queue
+        {
+            std::mutex mutex{};
+            std::deque<job> jobs{};
+        };
+
+        job wrap(job j, counter* c);
+        void finish(counter* c, std::exception_ptr error);
+        void push(job j);
+        bool try_run_one(uint32_t self);
+        bool run_one_main_job();
+        void worker_loop(uint32_t index);
+
+        std::vector<std::unique_ptr<queue>> _queues{};     //!< 0: main thread, 1..n: workers
+        std::vector<std::thread> _threads{};
+        std::atomic<uint32_t> _next_queue{0};
+
+        std::mutex _main_mutex{};
+        std::deque<job> _main_jobs{};
+
+        std::mutex _sleep_mutex{};
+        std::condition_variable _wake{};
+        std::atomic<uint32_t> _queued{0};
+        std::atomic<bool> _stop{false};
+
+        std::mutex _continuation_mutex{};
+        std::unordered_map<counter*, std::vector<job>> _continuations{};
+    };
+
+} // namespace vlk
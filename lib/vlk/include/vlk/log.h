@@ -22,29 +22,272 @@
 #include <boost/log/trivial.hpp>
 
 #include <vlk/export.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Compile time minimum severity: statements below it are compiled (so they stay valid) but never executed, their
+// arguments are not evaluated. Set via the CMake cache variable VLK_LOG_LEVEL.
+#define VLK_LOG_LEVEL_TRACE     0
+#define VLK_LOG_LEVEL_DEBUG     1
+#define VLK_LOG_LEVEL_INFO      2
+#define VLK_LOG_LEVEL_WARNING   3
+#define VLK_LOG_LEVEL_ERROR     4
+#define VLK_LOG_LEVEL_FATAL     5
+
+#ifndef VLK_LOG_LEVEL
+#define VLK_LOG_LEVEL VLK_LOG_LEVEL_TRACE
+#endif
 
 namespace vlk {
 
     using log_level = boost::log::trivial::severity_level;
     extern void VLK_EXPORT set_global_log_level(log_level lv);
 
+    //! Writes all messages logged so far, e.g. before the process is terminated deliberately.
+    extern void VLK_EXPORT flush_log();
+
+    //! Installs handlers for SIGSEGV, SIGBUS, SIGILL, SIGFPE and SIGABRT that write the messages not yet written
+    //! and then continue with the handlers installed before. Not done by the library on its own: the application
+    //! decides who owns these signals, so call it after installing own handlers.
+    extern void VLK_EXPORT install_crash_log_flush();
+
+    //! Writes all messages in binary form to path instead of formatting them to stderr, vlk-logdecode turns the
+    //! file into text. Arguments of VLK_LOGF_* statements are stored as they are, the format strings once per
+    //! statement. An empty path switches back to stderr.
+    //! \throws vlk::app_exception  Thrown when the file cannot be created, error code is errno.
+    extern void VLK_EXPORT set_binary_log(std::string const& path);
+
+    namespace detail {
+
+        extern VLK_EXPORT std::atomic<int> global_log_level;
+
+        inline bool log_enabled(log_level lv)
+        {
+            return static_cast<int>(lv) >= global_log_level.load(std::memory_order_relaxed);
+        }
+
+        //! \brief One message of the VLK_LOG_* macros.
+        //! The message is formatted into a per-thread buffer and handed to the thread's ring buffer when the record
+        //! is destroyed at the end of the log statement. A background thread drains the rings of all threads and
+        //! writes the messages to stderr, the logging thread only takes a lock to wake it when it is idle.
+        class VLK_EXPORT log_record
+        {
+        public:
+            explicit log_record(log_level lv);
+            ~log_record();
+
+            log_record(log_record const&) = delete;
+            log_record& operator=(log_record const&) = delete;
+
+            std::ostream& stream() { return *_stream; }
+
+        private:
+            log_level _level;
+            std::ostream* _stream{nullptr};
+            std::unique_ptr<std::ostringstream> _nested{};  //!< for messages logged while formatting a message
+        };
+
+        //! Type tags of VLK_LOGF_* arguments in the binary stream.
+        enum class log_arg : uint8_t
+        {
+            i64 = 1,
+            u64,
+            f64,
+            boolean,
+            pointer,
+            string,     //!< followed by a 16 bit length and the characters
+        };
+
+        constexpr uint32_t invalid_log_site{UINT32_MAX};
+
+        //! Registers the format site of a VLK_LOGF_* statement, called once per statement.
+        uint32_t VLK_EXPORT register_log_site(log_level lv, char const* file, uint32_t line, char const* format);
+
+        //! Hands the encoded arguments of a VLK_LOGF_* statement to the thread's ring.
+        void VLK_EXPORT push_log_args(uint32_t site, uint8_t const* args, size_t size);
+
+        //! Replaces the {} of format by the encoded arguments, surplus arguments are appended. Writes at most
+        //! capacity characters to out (no terminating zero) and returns their number. Does not allocate.
+        size_t VLK_EXPORT format_log_args(char* out, size_t capacity, char const* format, uint8_t const* args,
+                                          size_t size);
+
+        //! Raw arguments of one VLK_LOGF_* statement, arguments not fitting are dropped.
+        class log_args
+        {
+        public:
+            static constexpr size_t capacity{512U};
+
+            template<typename Tp>
+            void add(Tp const& v)
+            {
+                using T = std::decay_t<Tp>;
+                if constexpr (std::is_same_v<T, bool>) {
+                    put_tagged(log_arg::boolean, static_cast<uint8_t>(v ? 1U : 0U));
+                }
+                else if constexpr (std::is_same_v<T, char>) {
+                    add_string(&v, 1U);
+                }
+                else if constexpr (std::is_enum_v<T>) {
+                    add(static_cast<std::underlying_type_t<T>>(v));
+                }
+                else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+                    put_tagged(log_arg::i64, static_cast<int64_t>(v));
+                }
+                else if constexpr (std::is_integral_v<T>) {
+                    put_tagged(log_arg::u64, static_cast<uint64_t>(v));
+                }
+                else if constexpr (std::is_floating_point_v<T>) {
+                    put_tagged(log_arg::f64, static_cast<double>(v));
+                }
+                else if constexpr (std::is_array_v<Tp>
+                                   && std::is_same_v<std::remove_cv_t<std::remove_extent_t<Tp>>, char>) {
+                    // string literals and char buffers, the latter not necessarily terminated
+                    add_string(v, static_cast<size_t>(std::find(v, v + std::extent_v<Tp>, '\0') - v));
+                }
+                else if constexpr (std::is_same_v<T, char const*> || std::is_same_v<T, char*>) {
+                    if (nullptr == v) {
+                        add_string("(null)", 6U);
+                    }
+                    else {
+                        add_string(v, std::strlen(v));
+                    }
+                }
+                else if constexpr (std::is_convertible_v<T const&, std::string_view>) {
+                    std::string_view const sv{v};
+                    add_string(sv.data(), sv.size());
+                }
+                else if constexpr (std::is_pointer_v<T>) {
+                    put_tagged(log_arg::pointer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(v)));
+                }
+                else {
+                    static_assert(std::is_pointer_v<T>, "VLK_LOGF_* supports numbers, strings, enums and pointers");
+                }
+            }
+
+            uint8_t const* data() const { return _data.data(); }
+            size_t size() const { return _size; }
+
+        private:
+            template<typename Tv>
+            void put_tagged(log_arg tag, Tv v)
+            {
+                if (_size + 1U + sizeof(Tv) <= capacity) {
+                    _data[_size] = static_cast<uint8_t>(tag);
+                    std::memcpy(_data.data() + _size + 1U, &v, sizeof(Tv));
+                    _size += 1U + sizeof(Tv);
+                }
+            }
+
+            void add_string(char const* s, size_t length)
+            {
+                if (_size + 3U > capacity) {
+                    return;
+                }
+                auto const n = static_cast<uint16_t>(std::min(length, capacity - _size - 3U));
+                _data[_size] = static_cast<uint8_t>(log_arg::string);
+                std::memcpy(_data.data() + _size + 1U, &n, sizeof(n));
+                std::memcpy(_data.data() + _size + 3U, s, n);
+                _size += 3U + n;
+            }
+
+            std::array<uint8_t, capacity> _data;
+            size_t _size{0};
+        };
+
+        //! format is only passed to keep the macros free of empty __VA_ARGS__, it was registered with the site.
+        template<typename... Args>
+        void log_formatted(uint32_t site, [[maybe_unused]] char const* format, Args const&... args)
+        {
+            if (invalid_log_site == site) {
+                return;
+            }
+            log_args a;
+            (a.add(args), ...);
+            push_log_args(site, a.data(), a.size());
+        }
+
+    } // namespace detail
+
 } // namespace vlk
 
-#define VLK_LOG_TRACE() \
-    BOOST_LOG_TRIVIAL(trace)
+// a loop instead of if-else: no dangling else warnings when used as the body of an if without braces
+#define VLK_LOG_IMPL(lv) \
+    for (bool vlk_log_enabled = vlk::detail::log_enabled(lv); vlk_log_enabled; vlk_log_enabled = false) \
+        vlk::detail::log_record{lv}.stream()
+
+#define VLK_LOG_STRIPPED(lv) \
+    while (false) \
+        vlk::detail::log_record{lv}.stream()
+
+// Deferred formatting: only the raw arguments and the id of the statement are stored, the writer thread (or
+// vlk-logdecode) formats them. fmt is a string literal with {} placeholders.
+#define VLK_LOGF_IMPL(lv, ...) \
+    do { \
+        if (vlk::detail::log_enabled(lv)) { \
+            static uint32_t const vlk_log_site{vlk::detail::register_log_site(lv, __FILE__, __LINE__, \
+                    VLK_LOGF_FORMAT(__VA_ARGS__, ""))}; \
+            vlk::detail::log_formatted(vlk_log_site, __VA_ARGS__); \
+        } \
+    } while (false)
+
+#define VLK_LOGF_STRIPPED(lv, ...) \
+    do { \
+        if (false) { \
+            vlk::detail::log_formatted(vlk::detail::invalid_log_site, __VA_ARGS__); \
+        } \
+    } while (false)
+
+#define VLK_LOGF_FORMAT(fmt, ...) fmt
+
+#if VLK_LOG_LEVEL <= VLK_LOG_LEVEL_TRACE
+#define VLK_LOG_TRACE() VLK_LOG_IMPL(vlk::log_level::trace)
+#define VLK_LOGF_TRACE(...) VLK_LOGF_IMPL(vlk::log_level::trace, __VA_ARGS__)
+#else
+#define VLK_LOG_TRACE() VLK_LOG_STRIPPED(vlk::log_level::trace)
+#define VLK_LOGF_TRACE(...) VLK_LOGF_STRIPPED(vlk::log_level::trace, __VA_ARGS__)
+#endif
 
-#define VLK_LOG_DEBUG() \
-    BOOST_LOG_TRIVIAL(debug)
+#if VLK_LOG_LEVEL <= VLK_LOG_LEVEL_DEBUG
+#define VLK_LOG_DEBUG() VLK_LOG_IMPL(vlk::log_level::debug)
+#define VLK_LOGF_DEBUG(...) VLK_LOGF_IMPL(vlk::log_level::debug, __VA_ARGS__)
+#else
+#define VLK_LOG_DEBUG() VLK_LOG_STRIPPED(vlk::log_level::debug)
+#define VLK_LOGF_DEBUG(...) VLK_LOGF_STRIPPED(vlk::log_level::debug, __VA_ARGS__)
+#endif
 
-#define VLK_LOG_INFO() \
-    BOOST_LOG_TRIVIAL(info)
+#if VLK_LOG_LEVEL <= VLK_LOG_LEVEL_INFO
+#define VLK_LOG_INFO() VLK_LOG_IMPL(vlk::log_level::info)
+#define VLK_LOGF_INFO(...) VLK_LOGF_IMPL(vlk::log_level::info, __VA_ARGS__)
+#else
+#define VLK_LOG_INFO() VLK_LOG_STRIPPED(vlk::log_level::info)
+#define VLK_LOGF_INFO(...) VLK_LOGF_STRIPPED(vlk::log_level::info, __VA_ARGS__)
+#endif
 
-#define VLK_LOG_WARNING() \
-    BOOST_LOG_TRIVIAL(warning)
+#if VLK_LOG_LEVEL <= VLK_LOG_LEVEL_WARNING
+#define VLK_LOG_WARNING() VLK_LOG_IMPL(vlk::log_level::warning)
+#define VLK_LOGF_WARNING(...) VLK_LOGF_IMPL(vlk::log_level::warning, __VA_ARGS__)
+#else
+#define VLK_LOG_WARNING() VLK_LOG_STRIPPED(vlk::log_level::warning)
+#define VLK_LOGF_WARNING(...) VLK_LOGF_STRIPPED(vlk::log_level::warning, __VA_ARGS__)
+#endif
 
-#define VLK_LOG_ERROR() \
-    BOOST_LOG_TRIVIAL(error)
+#if VLK_LOG_LEVEL <= VLK_LOG_LEVEL_ERROR
+#define VLK_LOG_ERROR() VLK_LOG_IMPL(vlk::log_level::error)
+#define VLK_LOGF_ERROR(...) VLK_LOGF_IMPL(vlk::log_level::error, __VA_ARGS__)
+#else
+#define VLK_LOG_ERROR() VLK_LOG_STRIPPED(vlk::log_level::error)
+#define VLK_LOGF_ERROR(...) VLK_LOGF_STRIPPED(vlk::log_level::error, __VA_ARGS__)
+#endif
 
-#define VLK_LOG_FATAL() \
-    BOOST_LOG_TRIVIAL(fatal)
+// fatal messages are never stripped
+#define VLK_LOG_FATAL() VLK_LOG_IMPL(vlk::log_level::fatal)
+#define VLK_LOGF_FATAL(...) VLK_LOGF_IMPL(vlk::log_level::fatal, __VA_ARGS__)
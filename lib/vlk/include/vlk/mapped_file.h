@@ -0,0 +1,64 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vlk {
+
+    //! \brief Read-only memory mapping of a whole file.
+    //! The pages are loaded on demand by the OS, no copy into a heap buffer is made. Empty files are valid and
+    //! have no mapping. On platforms without POSIX file APIs the file is read into a heap buffer instead.
+    class VLK_EXPORT mapped_file
+    {
+    public:
+        mapped_file() = default;
+
+        //! \throws vlk::app_exception  Thrown when the file cannot be opened or mapped, error code is errno.
+        explicit mapped_file(std::string const& path);
+        ~mapped_file();
+
+        mapped_file(mapped_file&& other) noexcept;
+        mapped_file& operator=(mapped_file&& other) noexcept;
+        mapped_file(mapped_file const&) = delete;
+        mapped_file& operator=(mapped_file const&) = delete;
+
+        uint8_t const* data() const { return _data; }
+        size_t size() const { return _size; }
+        bool empty() const { return 0 == _size; }
+
+    private:
+        void release() noexcept;
+
+        uint8_t const* _data{nullptr};
+        size_t _size{0};
+    };
+
+    //! Replaces the file at path by data atomically: data is written to a temporary file in the same directory
+    //! which is renamed to path afterwards, readers see either the old or the new content. Only with POSIX file
+    //! APIs the content is synced to disk before the rename.
+    //! \throws vlk::app_exception  Thrown when writing or renaming fails, error code is errno.
+    void VLK_EXPORT write_file_atomic(std::string const& path, void const* data, size_t size);
+
+} // namespace vlk
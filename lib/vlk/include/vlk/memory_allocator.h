@@ -0,0 +1,194 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+#include <vlk/phys_device.h>
+#include <vlk/tlsf.h>
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace vlk {
+
+    //! Intended access pattern of an allocation - determines the memory type.
+    enum class memory_usage
+    {
+        gpu_only,       //!< device local, not mappable
+        cpu_to_gpu,     //!< host visible (coherent if possible) - staging and per-frame uniform data
+        gpu_to_cpu      //!< host visible, cached if possible - read back
+    };
+
+    //! A range of device memory handed out by the memory_allocator.
+    struct VLK_EXPORT memory_allocation
+    {
+        VkDeviceMemory memory{VK_NULL_HANDLE};
+        VkDeviceSize offset{0};
+        VkDeviceSize size{0};
+        void* mapped{nullptr};                      //!< persistently mapped pointer (host visible memory only)
+        uint32_t memory_type{UINT32_MAX};
+        uint32_t block{UINT32_MAX};                 //!< owning block, UINT32_MAX for dedicated allocations
+        tlsf::handle range{tlsf::invalid_handle};   //!< range within the block
+
+        bool dedicated() const { return UINT32_MAX == block; }
+        explicit operator bool() const { return VK_NULL_HANDLE != memory; }
+    };
+
+    struct VLK_EXPORT allocated_buffer
+    {
+        VkBuffer buffer{VK_NULL_HANDLE};
+        memory_allocation memory{};
+    };
+
+    struct VLK_EXPORT allocated_image
+    {
+        VkImage image{VK_NULL_HANDLE};
+        memory_allocation memory{};
+    };
+
+    //! Usage statistics of one memory heap.
+    struct VLK_EXPORT memory_heap_stats
+    {
+        VkDeviceSize block_bytes{0};        //!< bytes of device memory allocated for blocks
+        VkDeviceSize used_bytes{0};         //!< bytes sub-allocated from the blocks
+        VkDeviceSize dedicated_bytes{0};
+        uint32_t block_count{0};
+        uint32_t allocation_count{0};       //!< sub-allocations
+        uint32_t dedicated_count{0};
+        uint32_t free_range_count{0};       //!< number of free ranges in all blocks of the heap
+        VkDeviceSize largest_free_range{0}; //!< largest free range of any block
+        VkDeviceSize scattered_free_bytes{0};   //!< free bytes outside the largest free range of their block
+
+        //! Adds the free ranges of a block to the statistics.
+        void add_free_ranges(tlsf const& ranges);
+
+        //! Share of the free bytes outside the largest free range of their block: 0 when the free space of each
+        //! block is one contiguous range, approaching 1 the more it is scattered. Free space spread over several
+        //! blocks doesn't count, compacting can't join it.
+        double fragmentation() const
+        {
+            auto const free_bytes = block_bytes - used_bytes;
+            return 0 == free_bytes ? 0.0
+                                   : std::min(1.0, static_cast<double>(scattered_free_bytes)
+                                                   / static_cast<double>(free_bytes));
+        }
+    };
+
+    //! \brief Sub-allocator for device memory.
+    //! Vulkan limits the number of device memory objects (maxMemoryAllocationCount, often 4096) and vkAllocateMemory
+    //! is slow, so buffers and images are placed into large blocks which are managed by a tlsf allocator. Blocks are
+    //! kept per memory type and per resource kind (linear - buffers and linear images, optimal - images with optimal
+    //! tiling) which makes bufferImageGranularity conflicts impossible. Resources the driver prefers to have a
+    //! dedicated allocation for (VK_KHR_dedicated_allocation, core in Vulkan 1.1) and resources larger than half
+    //! a block get their own device memory object.
+    //! Host visible blocks are mapped once on creation and stay mapped until they are released.
+    //! All methods are thread safe.
+    class VLK_EXPORT memory_allocator
+    {
+    public:
+        static constexpr VkDeviceSize default_block_size{256ULL * 1024ULL * 1024ULL};
+
+        memory_allocator(VkDevice device, vlk::phys_device const& pd, VkDeviceSize block_size = default_block_size);
+        //! Only the limits and memory types of the device are used.
+        memory_allocator(VkDevice device, VkPhysicalDeviceProperties const& properties,
+                         VkPhysicalDeviceMemoryProperties const& memory_properties,
+                         VkDeviceSize block_size = default_block_size);
+        ~memory_allocator();
+
+        memory_allocator(memory_allocator const&) = delete;
+        memory_allocator& operator=(memory_allocator const&) = delete;
+
+        //! Allocates memory satisfying requirements. linear has to be false for images with optimal tiling.
+        memory_allocation allocate(VkMemoryRequirements const& requirements, memory_usage usage, bool linear);
+        void free(memory_allocation& allocation);
+
+        //! Creates a buffer and binds memory to it.
+        allocated_buffer create_buffer(VkBufferCreateInfo const& ci, memory_usage usage);
+        void destroy(allocated_buffer& buffer);
+
+        //! Creates an image and binds memory to it.
+        allocated_image create_image(VkImageCreateInfo const& ci, memory_usage usage);
+        void destroy(allocated_image& image);
+
+        //! Make host writes visible to the device - only required for memory types without HOST_COHERENT.
+        void flush(memory_allocation const& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+        //! Make device writes visible to the host - only required for memory types without HOST_COHERENT.
+        void invalidate(memory_allocation const& allocation, VkDeviceSize offset = 0,
+                        VkDeviceSize size = VK_WHOLE_SIZE);
+
+        //! Memory type for usage among type_bits, throws a vulkan_exception if there is none.
+        uint32_t find_memory_type(uint32_t type_bits, memory_usage usage) const;
+        bool is_coherent(uint32_t memory_type) const;
+
+        VkPhysicalDeviceMemoryProperties const& memory_properties() const { return _mem_props; }
+        std::vector<memory_heap_stats> heap_stats() const;
+
+        //! Fill level of a block in [0, 1].
+        double block_usage(uint32_t block_idx) const;
+
+        //! Defragmentation support: allocates requirements in another, fuller block of allocation's pool.
+        //! Never creates blocks, returns an empty allocation when there is no space.
+        memory_allocation allocate_compacting(VkMemoryRequirements const& requirements,
+                                              memory_allocation const& allocation);
+
+    private:
+        struct block
+        {
+            VkDeviceMemory memory;
+            uint32_t memory_type;
+            bool linear;
+            tlsf ranges;
+            void* mapped;
+        };
+
+        memory_allocation allocate_for(VkMemoryRequirements const& requirements, memory_usage usage, bool linear,
+                                       bool prefer_dedicated, VkBuffer buffer, VkImage image);
+        memory_allocation sub_allocate(uint32_t block_idx, VkMemoryRequirements const& requirements);
+        memory_allocation allocate_dedicated(VkMemoryRequirements const& requirements, uint32_t memory_type,
+                                             VkBuffer buffer, VkImage image);
+        memory_allocation allocate_from_blocks(VkMemoryRequirements const& requirements, uint32_t memory_type,
+                                               bool linear);
+        VkDeviceMemory allocate_device_memory(VkDeviceSize size, uint32_t memory_type, void const* next,
+                                              void** mapped);
+        void free_device_memory(VkDeviceMemory memory, bool mapped);
+        VkDeviceSize block_size_for(uint32_t memory_type) const;
+        bool is_host_visible(uint32_t memory_type) const;
+        void mapped_range(memory_allocation const& allocation, VkDeviceSize offset, VkDeviceSize size,
+                          VkMappedMemoryRange& range) const;
+
+        VkDevice _device;
+        VkPhysicalDeviceMemoryProperties _mem_props;
+        VkDeviceSize _block_size;
+        VkDeviceSize _non_coherent_atom_size;
+        bool _separate_linear;      //!< false when bufferImageGranularity is 1
+        uint32_t _max_allocations;
+        uint32_t _device_allocations{0};
+
+        mutable std::mutex _mutex{};
+        std::vector<std::unique_ptr<block>> _blocks{};
+        std::vector<memory_heap_stats> _heap_stats{};
+    };
+
+} // namespace vlk
@@ -0,0 +1,121 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+#include <vlk/memory_allocator.h>
+
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief Incremental defragmentation of the memory_allocator's blocks.
+    //! Resources which may be moved are registered together with their create info and a relocation callback.
+    //! Each step() evacuates the emptiest blocks into fuller ones within a time and byte budget: a new resource is
+    //! created in the target block, the content copied with commands recorded into the given command buffer and the
+    //! relocation callback invoked, so the owner can patch descriptors and bindings before recording further commands.
+    //! The old resource is released through the supplied defer function once the GPU doesn't use it anymore.
+    //! Dedicated allocations are never moved. Images have to be in their registered layout between frames.
+    class VLK_EXPORT memory_defragmenter
+    {
+    public:
+        using resource_id = uint64_t;
+        using buffer_relocation = std::function<void(allocated_buffer const& moved)>;
+        using image_relocation = std::function<void(allocated_image const& moved)>;
+        using defer_fn = std::function<void(std::function<void()>)>;
+
+        struct budget
+        {
+            std::chrono::microseconds cpu_time{500};                //!< CPU time spent per step
+            VkDeviceSize bytes{16ULL * 1024ULL * 1024ULL};          //!< bytes copied per step, bounds the GPU time
+        };
+
+        struct statistics
+        {
+            uint64_t moves{0};
+            VkDeviceSize bytes_moved{0};
+            uint64_t steps{0};
+        };
+
+        explicit memory_defragmenter(VkDevice device, memory_allocator& allocator);
+
+        memory_defragmenter(memory_defragmenter const&) = delete;
+        memory_defragmenter& operator=(memory_defragmenter const&) = delete;
+
+        //! Registers a movable buffer, ci's pNext chain is not retained. ci needs VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+        //! and VK_BUFFER_USAGE_TRANSFER_DST_BIT.
+        resource_id register_buffer(allocated_buffer const& buffer, VkBufferCreateInfo const& ci,
+                                    buffer_relocation on_move);
+
+        //! Registers a movable image with all mip levels and layers in layout between frames. ci needs
+        //! VK_IMAGE_USAGE_TRANSFER_SRC_BIT and VK_IMAGE_USAGE_TRANSFER_DST_BIT.
+        resource_id register_image(allocated_image const& image, VkImageCreateInfo const& ci, VkImageLayout layout,
+                                   VkImageAspectFlags aspect, image_relocation on_move);
+
+        //! Must be called before a registered resource is destroyed by its owner.
+        void unregister(resource_id id);
+
+        //! Records at most budget's worth of moves into cmd which must be executed before any command using the moved
+        //! resources. Returns the number of resources moved.
+        uint32_t step(VkCommandBuffer cmd, defer_fn const& defer, budget const& b);
+
+        statistics const& stats() const { return _stats; }
+
+    private:
+        struct entry
+        {
+            bool is_image;
+            allocated_buffer buffer;
+            VkBufferCreateInfo buffer_ci;
+            buffer_relocation on_buffer_move;
+            allocated_image image;
+            VkImageCreateInfo image_ci;
+            VkImageLayout layout;
+            VkImageAspectFlags aspect;
+            image_relocation on_image_move;
+            VkMemoryRequirements requirements;
+            std::vector<uint32_t> queue_families;
+
+            memory_allocation const& memory() const { return is_image ? image.memory : buffer.memory; }
+        };
+
+        struct move
+        {
+            resource_id id;
+            allocated_buffer buffer;
+            allocated_image image;
+        };
+
+        bool prepare_move(entry& e, move& m);
+        void record(VkCommandBuffer cmd, std::vector<move> const& moves) const;
+
+        VkDevice _device;
+        memory_allocator& _allocator;
+        resource_id _next_id{1};
+        std::unordered_map<resource_id, entry> _entries{};
+        statistics _stats{};
+    };
+
+} // namespace vlk
@@ -40,11 +40,17 @@ namespace vlk {
         VkPhysicalDevice device;
         VkPhysicalDeviceProperties properties;
         VkPhysicalDeviceFeatures features;
+        VkPhysicalDeviceMemoryProperties memory_properties;
         std::vector<VkQueueFamilyProperties> queue_family_properties;
         std::vector<VkExtensionProperties> extensions;
+        bool synchronization2{false};       //!< VK_KHR_synchronization2 extension and feature supported
 
         bool can_present_on_surface(uint32_t queue_family_idx, VkSurfaceKHR surface) const;
         bool supports_extension(std::string const& extension_name) const;
+
+        //! Index of the first queue family supporting all of required and none of excluded, VLK_INVALID_QF_IDX if
+        //! there is none.
+        uint32_t find_queue_family(VkQueueFlags required, VkQueueFlags excluded = 0) const;
     };
 
     struct VLK_EXPORT phys_device_selection
@@ -53,9 +59,57 @@ namespace vlk {
         VkPhysicalDeviceFeatures features{};
         uint32_t qfi_graphics{VLK_INVALID_QF_IDX};
         uint32_t qfi_presentation{VLK_INVALID_QF_IDX};
+        uint32_t qfi_transfer{VLK_INVALID_QF_IDX};      //!< optional family for async uploads, without graphics
+        uint32_t qfi_compute{VLK_INVALID_QF_IDX};       //!< optional family for async compute
+
+        //! Priorities of the queues created for each role, the number of entries is the number of queues.
+        //! Roles sharing a queue family get consecutive queues of the family as long as it provides enough.
+        std::vector<float> graphics_queue_priorities{1.0f};
+        std::vector<float> compute_queue_priorities{1.0f};
+        std::vector<float> transfer_queue_priorities{1.0f};
         std::vector<std::string> required_extensions{};
+
+        //! Enables VK_KHR_synchronization2 for barrier_batch, the device must support it.
+        bool synchronization2{false};
     };
 
+    //! \brief Ranking of a physical device for rendering, higher is better.
+    //! The parts are weighted so that the device type dominates (a discrete GPU beats an integrated one unless the
+    //! discrete one is very weak), the other parts decide between devices of the same type:
+    //! - type: discrete 1000, integrated 500, virtual 250, CPU 50
+    //! - memory: 25 per GiB of the largest device local heap, at most 200
+    //! - queues: 100 for a compute family without graphics (async compute), 50 for a transfer-only family (DMA),
+    //!   25 for a graphics family with more than one queue
+    //! - limits: up to 100 for maxImageDimension2D (16384), 50 for maxComputeSharedMemorySize (48 KiB) and 50 for
+    //!   maxPushConstantsSize (256 bytes)
+    //! - probe: measured copy bandwidth in GB/s, at most 500, 0 when not probed
+    struct VLK_EXPORT device_score
+    {
+        double type{0.0};
+        double memory{0.0};
+        double queues{0.0};
+        double limits{0.0};
+        double probe{0.0};
+
+        double total() const { return type + memory + queues + limits + probe; }
+    };
+
+    //! Scores a device from its properties, probe_gb_s is the result of probe_copy_bandwidth() or 0.
+    device_score VLK_EXPORT score_device(VkPhysicalDeviceProperties const& properties,
+                                         VkPhysicalDeviceMemoryProperties const& memory_properties,
+                                         std::vector<VkQueueFamilyProperties> const& queue_families,
+                                         double probe_gb_s = 0.0);
+
+    inline device_score score_device(phys_device const& pd, double probe_gb_s = 0.0)
+    {
+        return score_device(pd.properties, pd.memory_properties, pd.queue_family_properties, probe_gb_s);
+    }
+
+    //! Measures the device local copy bandwidth of a device in GB/s: a temporary logical device copies a 64 MiB
+    //! buffer several times on a queue of queue_family_idx. Takes a few milliseconds on a GPU, returns 0 when the
+    //! probe cannot be run (e.g. out of memory).
+    double VLK_EXPORT probe_copy_bandwidth(phys_device const& pd, uint32_t queue_family_idx);
+
     struct VLK_EXPORT swap_properties_selection
     {
         VkSurfaceFormatKHR surface_format{VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
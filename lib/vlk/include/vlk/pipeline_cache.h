@@ -0,0 +1,78 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+#include <vlk/phys_device.h>
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vlk {
+
+    //! \brief VkPipelineCache persisted in a file.
+    //! The file starts with a header identifying the device and driver the data was created by
+    //! (pipelineCacheUUID, vendorID, deviceID, driverVersion) and a checksum of the data. On creation the file is
+    //! memory-mapped and handed to the driver only when the header matches the physical device, otherwise the cache
+    //! starts empty. save() replaces the file atomically, so a crash never leaves a truncated cache behind.
+    class VLK_EXPORT pipeline_cache
+    {
+    public:
+        //! An empty path creates a cache which is never loaded nor saved.
+        //! \throws vlk::vulkan_exception  Thrown when the pipeline cache cannot be created.
+        pipeline_cache(VkDevice device, phys_device const& pd, std::string path);
+        ~pipeline_cache();
+
+        pipeline_cache(pipeline_cache const&) = delete;
+        pipeline_cache& operator=(pipeline_cache const&) = delete;
+
+        //! Writes the cache data to the file, skipped when unchanged since loading.
+        //! \throws vlk::app_exception     Thrown when the file cannot be written, error code is errno.
+        //! \throws vlk::vulkan_exception  Thrown when the cache data cannot be retrieved.
+        void save();
+
+        VkPipelineCache handle() const { return _cache; }
+
+        //! Whether the cache was initialised from the file.
+        bool loaded() const { return _loaded; }
+
+        //! Whether file content of size bytes has a valid header and checksum for the device with properties props.
+        static bool is_valid(void const* file, size_t size, VkPhysicalDeviceProperties const& props);
+
+        //! Writes the header to the beginning of file content of size bytes, the cache data follows it.
+        //! \return  Checksum of the cache data.
+        static uint64_t write_header(void* file, size_t size, VkPhysicalDeviceProperties const& props);
+
+        //! Bytes of the file header preceding the cache data.
+        static size_t header_size();
+
+    private:
+        VkDevice _device;
+        VkPhysicalDeviceProperties _props;
+        std::string _path;
+        VkPipelineCache _cache{VK_NULL_HANDLE};
+        bool _loaded{false};
+        uint64_t _checksum{0};      //!< of the data loaded or saved last
+        size_t _data_size{0};
+    };
+
+} // namespace vlk
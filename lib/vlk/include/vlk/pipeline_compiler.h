@@ -0,0 +1,122 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+#include <vlk/job_system.h>
+
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief Concurrent creation of graphics and compute pipelines on the job system.
+    //! Every queued pipeline is created by its own vkCreate*Pipelines call on a worker thread, all calls share one
+    //! VkPipelineCache (pipeline caches are internally synchronized). Requests with a higher priority are created
+    //! first, requests of the same priority in queue order - e.g. the pipelines of the first frame get a higher
+    //! priority than the rest of the shader set. Each request returns a ticket: take() waits for the pipeline and
+    //! hands its ownership to the caller. While waiting the calling thread creates pending pipelines itself.
+    //! Everything referenced by a create info (shader modules, layouts, render passes, state structs) must stay
+    //! valid until the pipeline is ready.
+    class VLK_EXPORT pipeline_compiler
+    {
+    public:
+        using ticket = uint64_t;
+
+        struct stats
+        {
+            uint64_t created{0};
+            uint64_t failed{0};
+            std::chrono::nanoseconds cpu_time{0};   //!< sum of all vkCreate*Pipelines calls
+        };
+
+        pipeline_compiler(VkDevice device, VkPipelineCache cache, job_system& jobs);
+
+        //! Waits for all requests, pipelines not taken are destroyed.
+        ~pipeline_compiler();
+
+        pipeline_compiler(pipeline_compiler const&) = delete;
+        pipeline_compiler& operator=(pipeline_compiler const&) = delete;
+
+        ticket compile(VkGraphicsPipelineCreateInfo const& ci, int priority = 0);
+        ticket compile(VkComputePipelineCreateInfo const& ci, int priority = 0);
+        std::vector<ticket> compile(std::vector<VkGraphicsPipelineCreateInfo> const& cis, int priority = 0);
+        std::vector<ticket> compile(std::vector<VkComputePipelineCreateInfo> const& cis, int priority = 0);
+
+        //! Whether the pipeline of t is created (or failed), i.e. take() does not block.
+        bool is_ready(ticket t) const;
+
+        //! Waits for the pipeline of t and transfers its ownership to the caller. t becomes invalid.
+        //! \throws vlk::vulkan_exception  Thrown when the pipeline creation failed.
+        VkPipeline take(ticket t);
+
+        //! Waits for all requests queued so far.
+        void wait_idle();
+
+        stats get_stats() const;
+
+    private:
+        struct request
+        {
+            bool is_compute{false};
+            VkGraphicsPipelineCreateInfo graphics{};
+            VkComputePipelineCreateInfo compute{};
+            int priority{0};
+            bool done{false};
+            VkPipeline pipeline{VK_NULL_HANDLE};
+            VkResult result{VK_SUCCESS};
+        };
+
+        struct queued
+        {
+            int priority;
+            ticket t;
+
+            bool operator<(queued const& other) const
+            {
+                // priority_queue pops the largest: higher priority, then lower ticket
+                return priority != other.priority ? priority < other.priority : t > other.t;
+            }
+        };
+
+        ticket enqueue(request r);
+        bool compile_next();
+        void compile(request& r);
+
+        VkDevice _device;
+        VkPipelineCache _cache;
+        job_system& _jobs;
+        job_system::counter _outstanding{};
+
+        mutable std::mutex _mutex{};
+        std::condition_variable _done{};
+        std::priority_queue<queued> _queue{};
+        std::unordered_map<ticket, request> _requests{};
+        ticket _next{1};
+        stats _stats{};
+    };
+
+} // namespace vlk
@@ -0,0 +1,49 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+namespace vlk {
+
+    //! Trade-off between latency and throughput of the swap chain.
+    enum class present_policy : uint32_t
+    {
+        balanced = 0,       //!< MAILBOX (or FIFO) with one image more than the minimum, never tears
+        low_latency,        //!< MAILBOX (or IMMEDIATE) with the minimum number of images, newest frame wins
+        throughput,         //!< FIFO with two images more than the minimum, deep queue absorbs frame time spikes
+        power_saver,        //!< FIFO_RELAXED (or FIFO) with one image more than the minimum
+        count
+    };
+
+    //! Name of the policy, e.g. for logs.
+    VLK_EXPORT char const* to_string(present_policy pp);
+
+    //! Present mode of the policy among the supported modes, falls back to FIFO which every surface supports.
+    VkPresentModeKHR VLK_EXPORT select_present_mode(present_policy policy, std::vector<VkPresentModeKHR> const& modes);
+
+    //! Swap chain image count of the policy within the surface limits, maxImageCount 0 means no upper limit.
+    uint32_t VLK_EXPORT select_image_count(present_policy policy, VkSurfaceCapabilitiesKHR const& capabilities);
+
+} // namespace vlk
@@ -0,0 +1,60 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief Functors releasing resources once the GPU finished all frames using them.
+    //! Frame k is recorded into frame slot k % N and the slot's fence is waited for before frame k + N is recorded,
+    //! so when frame f is about to be recorded all frames up to f - N are complete. Not thread-safe.
+    class VLK_EXPORT release_queue
+    {
+    public:
+        explicit release_queue(uint32_t frames_in_flight);
+
+        //! Queues fn until all frames before frame unused_from are complete. Resources released while frame f is
+        //! recorded are used by it, unused_from is f + 1 then.
+        void push(uint64_t unused_from, std::function<void()> fn);
+
+        //! Invokes the functors that are due once the fence of frame's slot has been waited for.
+        //! \param frame  number of the frame about to be recorded
+        void run(uint64_t frame) noexcept;
+
+        //! Invokes all pending functors, the device has to be idle.
+        void run_all() noexcept;
+
+        size_t size() const { return _pending.size(); }
+
+    private:
+        void run_if(std::function<bool(uint64_t)> const& due) noexcept;
+
+        uint32_t _frames_in_flight;
+        std::vector<std::pair<uint64_t, std::function<void()>>> _pending{};
+    };
+
+} // namespace vlk
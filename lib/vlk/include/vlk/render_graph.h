@@ -0,0 +1,208 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/barrier_batch.h>
+#include <vlk/export.h>
+#include <vlk/memory_allocator.h>
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief Frame graph of passes with automatic barriers and aliased transient images.
+    //! Passes are added in submission order and declare the resources they read and write. Resources are either
+    //! imported (swap chain image, persistent buffers - rebound every frame with set_image()/set_buffer()) or
+    //! transient images created by the graph, which live for one frame only.
+    //! compile()
+    //! - culls passes whose results are never used: a pass is kept when it has a side effect, writes an imported
+    //!   resource or writes a resource read by a later kept pass,
+    //! - orders the passes by dependency level: passes of a level do not depend on each other, so the barriers of a
+    //!   whole level are recorded with one barrier_batch::flush(),
+    //! - creates the transient images and aliases their memory: images whose level ranges do not overlap share one
+    //!   allocation.
+    //! execute() records the levels into a command buffer, the barriers come from a barrier_batch tracking the
+    //! resources across frames (e.g. application::barriers()). Compile again when passes or transient descriptions
+    //! change, e.g. after the swap chain was re-created.
+    class VLK_EXPORT render_graph
+    {
+    public:
+        using resource_id = uint32_t;
+        using execute_fn = std::function<void(VkCommandBuffer cmd)>;
+
+        struct image_desc
+        {
+            VkFormat format{VK_FORMAT_UNDEFINED};
+            VkExtent2D extent{0, 0};
+            VkImageAspectFlags aspect{0};      //!< 0: the aspects of format
+            VkImageUsageFlags usage{0};         //!< in addition to the usage derived from the passes' accesses
+            uint32_t mip_levels{1U};
+            uint32_t array_layers{1U};
+            VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+        };
+
+        struct stats
+        {
+            uint32_t passes{0};
+            uint32_t culled_passes{0};
+            uint32_t levels{0};
+            uint32_t transient_images{0};
+            VkDeviceSize transient_bytes{0};    //!< sum of the transient images' sizes
+            VkDeviceSize allocated_bytes{0};    //!< memory allocated for them after aliasing
+        };
+
+        //! Declares the resource accesses of a pass, returned by add_pass().
+        class VLK_EXPORT pass_builder
+        {
+        public:
+            //! For buffers layout is ignored. Several accesses of one resource in a pass are merged into one.
+            //! \throws vlk::app_exception  Thrown for an unknown resource or when the pass already uses the image in
+            //!                             another layout.
+            pass_builder& read(resource_id id, VkPipelineStageFlags stages, VkAccessFlags access,
+                               VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+            pass_builder& write(resource_id id, VkPipelineStageFlags stages, VkAccessFlags access,
+                                VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+
+            //! The pass is never culled.
+            pass_builder& side_effect();
+
+        private:
+            friend class render_graph;
+            pass_builder(render_graph& graph, uint32_t pass) : _graph{graph}, _pass{pass} {}
+            pass_builder& add(resource_id id, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout,
+                              bool write);
+
+            render_graph& _graph;
+            uint32_t _pass;
+        };
+
+        render_graph(VkDevice device, memory_allocator& allocator);
+        ~render_graph();
+
+        render_graph(render_graph const&) = delete;
+        render_graph& operator=(render_graph const&) = delete;
+
+        resource_id import_image(std::string name, VkImage image, VkImageView view,
+                                 VkImageSubresourceRange const& range);
+        resource_id import_buffer(std::string name, VkBuffer buffer);
+        resource_id create_image(std::string name, image_desc const& desc);
+
+        //! Rebinds an imported resource, e.g. to the swap chain image of the current frame.
+        void set_image(resource_id id, VkImage image, VkImageView view);
+        void set_buffer(resource_id id, VkBuffer buffer);
+
+        pass_builder add_pass(std::string name, execute_fn fn);
+
+        //! Culls, orders and creates the transient images. Passes using an image in different layouts are ordered
+        //! into different levels, i.e. there are no layout conflicts between passes.
+        //! \throws vlk::vulkan_exception  Thrown when a transient image can't be created.
+        void compile();
+
+        //! Records all passes into cmd. Must be compiled.
+        void execute(VkCommandBuffer cmd, barrier_batch& barriers);
+
+        //! Removes all passes and resources, releases the transient images.
+        void clear();
+
+        VkImage image(resource_id id) const;
+        VkImageView view(resource_id id) const;
+        VkBuffer buffer(resource_id id) const;
+
+        //! Names of the compiled passes in execution order.
+        std::vector<std::string> execution_order() const;
+        stats const& get_stats() const { return _stats; }
+
+    private:
+        static constexpr uint32_t no_slot{UINT32_MAX};
+
+        struct resource
+        {
+            std::string name;
+            bool imported{false};
+            bool is_buffer{false};
+            image_desc desc{};
+            VkImage image{VK_NULL_HANDLE};
+            VkImageView view{VK_NULL_HANDLE};
+            VkBuffer buffer{VK_NULL_HANDLE};
+            VkImageSubresourceRange range{};
+
+            // compile results
+            bool used{false};
+            uint32_t first_level{0};
+            uint32_t last_level{0};
+            VkPipelineStageFlags all_stages{0};
+            VkAccessFlags all_access{0};
+            VkImageUsageFlags usage{0};
+            VkMemoryRequirements requirements{};
+            uint32_t slot{no_slot};
+        };
+
+        struct pass_access
+        {
+            resource_id id;
+            VkPipelineStageFlags stages;
+            VkAccessFlags access;
+            VkImageLayout layout;
+            bool write;
+        };
+
+        struct pass
+        {
+            std::string name;
+            execute_fn fn;
+            std::vector<pass_access> accesses{};
+            bool side_effect{false};
+            bool alive{false};
+            uint32_t level{0};
+        };
+
+        //! Memory shared by transient images with disjoint level ranges.
+        struct slot
+        {
+            std::vector<resource_id> images{};
+            VkMemoryRequirements requirements{};
+            memory_allocation memory{};
+            VkPipelineStageFlags last_stages{0};    //!< of the image used last, at runtime
+            VkAccessFlags last_access{0};
+        };
+
+        resource& get(resource_id id);
+        resource const& get(resource_id id) const;
+        void cull();
+        void schedule();
+        void create_transients();
+        void release_transients() noexcept;
+
+        VkDevice _device;
+        memory_allocator& _allocator;
+        std::vector<resource> _resources{};
+        std::vector<pass> _passes{};
+        std::vector<uint32_t> _order{};             //!< kept passes sorted by level
+        std::vector<uint32_t> _level_begin{};       //!< index into _order, one past the last level at the end
+        std::vector<slot> _slots{};
+        bool _compiled{false};
+        stats _stats{};
+    };
+
+} // namespace vlk
@@ -0,0 +1,112 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+#include <vlk/spirv_reflection.h>
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief Shader modules of a device, deduplicated by content, with reflected pipeline layouts.
+    //! load() maps the .spv file instead of reading it into a heap buffer, the mapping is released once the module
+    //! is created. Modules are looked up by a 64 bit hash of their code and the code is compared on a hit: loading
+    //! the same code again (from the same or another file) returns the module created first. Modules, descriptor
+    //! set layouts and pipeline layouts are owned by the cache and destroyed with it. All functions are thread safe.
+    class VLK_EXPORT shader_cache
+    {
+    public:
+        struct shader
+        {
+            VkShaderModule module{VK_NULL_HANDLE};
+            uint64_t hash{0};
+            uint64_t id{0};                 //!< unique within the cache, unlike hash
+            std::vector<uint32_t> code{};   //!< compared when the hashes of two modules are equal
+            spirv_reflection reflection{};
+
+            //! Stage create info for the first entry point.
+            VkPipelineShaderStageCreateInfo stage_info() const;
+        };
+
+        struct layout
+        {
+            VkPipelineLayout pipeline_layout{VK_NULL_HANDLE};
+            std::vector<VkDescriptorSetLayout> set_layouts{};   //!< index is the set number
+        };
+
+        struct stats
+        {
+            uint64_t loads{0};      //!< load() and create() calls
+            uint64_t modules{0};    //!< modules created
+            uint64_t layouts{0};    //!< pipeline layouts created
+        };
+
+        explicit shader_cache(VkDevice device);
+        ~shader_cache();
+
+        shader_cache(shader_cache const&) = delete;
+        shader_cache& operator=(shader_cache const&) = delete;
+
+        //! \throws vlk::app_exception     Thrown when the file cannot be mapped or holds no valid SPIR-V module.
+        //! \throws vlk::vulkan_exception  Thrown when the module cannot be created.
+        shader const& load(std::string const& path);
+
+        //! \param size  size of code in bytes
+        shader const& create(uint32_t const* code, size_t size);
+
+        //! Pipeline layout of the given shader stages as merged by vlk::merge_reflections(), sets without bindings
+        //! below the highest set get an empty set layout. Equal descriptor set layouts are shared between pipeline
+        //! layouts.
+        //! \throws vlk::app_exception  Thrown when stages declare a binding with different types or use runtime
+        //!                             sized arrays.
+        layout const& pipeline_layout(std::vector<shader const*> const& stages);
+
+        stats get_stats() const;
+
+    private:
+        struct binding_key_less
+        {
+            bool operator()(std::vector<VkDescriptorSetLayoutBinding> const& a,
+                            std::vector<VkDescriptorSetLayoutBinding> const& b) const;
+        };
+
+        //! The cached module with code of size bytes, nullptr if none. _mutex has to be held.
+        shader const* find(uint64_t hash, uint32_t const* code, size_t size) const;
+        VkDescriptorSetLayout set_layout(std::vector<VkDescriptorSetLayoutBinding> const& bindings);
+        void release() noexcept;
+
+        VkDevice _device{VK_NULL_HANDLE};
+        mutable std::mutex _mutex{};
+        std::unordered_multimap<uint64_t, std::unique_ptr<shader>> _shaders{};
+        std::map<std::vector<VkDescriptorSetLayoutBinding>, VkDescriptorSetLayout, binding_key_less> _set_layouts{};
+        std::map<std::vector<uint64_t>, std::unique_ptr<layout>> _layouts{};
+        stats _stats{};
+    };
+
+} // namespace vlk
@@ -0,0 +1,73 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vlk {
+
+    //! Descriptor binding used by a shader module.
+    struct spirv_binding
+    {
+        uint32_t set{0};
+        uint32_t binding{0};
+        VkDescriptorType type{VK_DESCRIPTOR_TYPE_MAX_ENUM};
+        uint32_t count{1U};         //!< 0 for runtime sized arrays
+        VkShaderStageFlags stages{0};
+    };
+
+    //! Interface of a shader module as far as pipeline layouts are concerned.
+    struct spirv_reflection
+    {
+        VkShaderStageFlags stages{0};       //!< stages of all entry points
+        std::string entry_point{};          //!< name of the first entry point
+        std::vector<spirv_binding> bindings{};  //!< sorted by set and binding
+        VkPushConstantRange push_constants{0, 0, 0};    //!< size 0 when the module has no push constant block
+    };
+
+    //! Reflects the descriptor bindings and the push constant block of a SPIR-V module.
+    //! Uniform buffers and storage buffers are reported as non-dynamic descriptors, the block size of push
+    //! constants follows the Offset, ArrayStride and MatrixStride decorations.
+    //! \param code         SPIR-V words (host endianness)
+    //! \param word_count   number of words
+    //! \throws vlk::app_exception  Thrown when code is no valid SPIR-V module.
+    spirv_reflection VLK_EXPORT reflect_spirv(uint32_t const* code, size_t word_count);
+
+    //! Descriptor set layouts and push constant range of a pipeline layout.
+    struct spirv_layout
+    {
+        //! Index is the set number, sets without bindings below the highest set are empty. Sorted by binding.
+        std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets{};
+        VkPushConstantRange push_constants{0, 0, 0};    //!< size 0 when no stage has push constants
+    };
+
+    //! Layout of a pipeline with the given stages: bindings used by several stages are merged (the largest array
+    //! size wins), push constants become one range for all stages using them.
+    //! \throws vlk::app_exception  Thrown when stages declare a binding with different types or use runtime
+    //!                             sized arrays.
+    spirv_layout VLK_EXPORT merge_reflections(std::vector<spirv_reflection const*> const& stages);
+
+} // namespace vlk
@@ -0,0 +1,124 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief Two-level segregated fit (TLSF) allocator for a linear address range [0, size).
+    //! The allocator only manages offsets, its bookkeeping lives outside the managed range which makes it usable
+    //! for device memory. Allocation and release are O(1) apart from the alignment padding: free blocks are kept in
+    //! 2^sl_bits segregated lists per power of two, adjacent free blocks are coalesced immediately.
+    class VLK_EXPORT tlsf
+    {
+    public:
+        using handle = uint32_t;
+        static constexpr handle invalid_handle{UINT32_MAX};
+
+        struct allocation
+        {
+            handle id;
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        explicit tlsf(uint64_t size);
+
+        //! Allocates size bytes with offset aligned to alignment (power of two). Returns nothing when no free
+        //! block is large enough.
+        std::optional<allocation> allocate(uint64_t size, uint64_t alignment = 1U);
+
+        //! Releases an allocation returned by allocate().
+        void free(handle id);
+
+        uint64_t size() const { return _size; }
+        uint64_t used() const { return _used; }
+        uint64_t free_size() const { return _size - _used; }
+        uint32_t allocation_count() const { return _allocation_count; }
+        bool empty() const { return 0 == _allocation_count; }
+
+        //! Size of the largest free block.
+        uint64_t largest_free() const;
+
+        //! Number of free blocks - 1 means no fragmentation.
+        uint32_t free_block_count() const { return _free_block_count; }
+
+        uint64_t offset(handle id) const { return _nodes[id].offset; }
+        uint64_t size(handle id) const { return _nodes[id].size; }
+
+        //! Calls f(handle, offset, size) for each allocation in address order.
+        template<typename F>
+        void for_each_allocation(F f) const;
+
+    private:
+        static constexpr uint32_t sl_bits{4U};
+        static constexpr uint32_t sl_count{1U << sl_bits};
+        static constexpr uint32_t fl_count{64U - sl_bits + 1U};
+        static constexpr uint32_t null_node{UINT32_MAX};
+
+        struct node
+        {
+            uint64_t offset;
+            uint64_t size;
+            uint32_t prev_phys;
+            uint32_t next_phys;
+            uint32_t prev_free;
+            uint32_t next_free;
+            bool free;
+        };
+
+        static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+        uint32_t find_free(uint64_t size) const;
+        uint32_t new_node(uint64_t offset, uint64_t size);
+        void release_node(uint32_t idx);
+        void insert_free(uint32_t idx);
+        void remove_free(uint32_t idx);
+        uint32_t split(uint32_t idx, uint64_t size);
+
+        uint64_t _size;
+        uint64_t _used{0};
+        uint32_t _allocation_count{0};
+        uint32_t _free_block_count{0};
+        uint32_t _first{null_node};
+        uint64_t _fl_bitmap{0};
+        std::array<uint32_t, fl_count> _sl_bitmap{};
+        std::array<std::array<uint32_t, sl_count>, fl_count> _heads{};
+        std::vector<node> _nodes{};
+        std::vector<uint32_t> _unused_nodes{};
+    };
+
+} // namespace vlk
+
+template<typename F>
+void vlk::tlsf::for_each_allocation(F f) const
+{
+    for (auto idx = _first; null_node != idx; idx = _nodes[idx].next_phys) {
+        auto const& n = _nodes[idx];
+        if (!n.free) {
+            f(idx, n.offset, n.size);
+        }
+    }
+}
@@ -0,0 +1,123 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+#include <vlk/memory_allocator.h>
+#include <vlk/phys_device.h>
+
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief Persistently mapped ring buffer for streaming data to the GPU.
+    //! The buffer is split into one partition per frame in flight. Ranges are handed out of the current frame's
+    //! partition by bumping an atomic head - allocate() never locks and may be called from several threads. The
+    //! partition is reclaimed as a whole by begin_frame(), which must only be called after the frame slot's fence
+    //! has been waited for.
+    //! Ranges can be used directly (vertex, index and uniform data) or copied into device local resources with
+    //! copy_to_buffer()/copy_to_image(). Copies are batched per destination and emitted by record().
+    class VLK_EXPORT upload_ring
+    {
+    public:
+        struct range
+        {
+            void* data{nullptr};            //!< mapped pointer to write the data to
+            VkBuffer buffer{VK_NULL_HANDLE};
+            VkDeviceSize offset{0};         //!< offset within buffer
+            VkDeviceSize size{0};
+
+            explicit operator bool() const { return nullptr != data; }
+        };
+
+        upload_ring(VkDevice device, memory_allocator& allocator, vlk::phys_device const& pd,
+                    uint32_t frames_in_flight, VkDeviceSize bytes_per_frame);
+        ~upload_ring();
+
+        upload_ring(upload_ring const&) = delete;
+        upload_ring& operator=(upload_ring const&) = delete;
+
+        //! Makes frame_index the current partition and discards its previous content.
+        void begin_frame(uint32_t frame_index);
+
+        //! Allocates size bytes from the current partition. alignment 0 uses an alignment suitable for uniform
+        //! buffers and copies. Returns an empty range when the partition is exhausted.
+        range allocate(VkDeviceSize size, VkDeviceSize alignment = 0);
+
+        //! allocate() and copy size bytes of data into the range.
+        range upload(void const* data, VkDeviceSize size, VkDeviceSize alignment = 0);
+
+        //! Allocates the source range of a copy of region (bufferOffset ignored) into an image of format: sized by
+        //! image_copy_size() and aligned to the format's texel block size, as vkCmdCopyBufferToImage requires.
+        range allocate_image(VkFormat format, VkBufferImageCopy const& region);
+
+        //! Queues a copy of src into dst. Copies must be queued from the thread recording the frame.
+        void copy_to_buffer(range const& src, VkBuffer dst, VkDeviceSize dst_offset);
+
+        //! Queues a copy of src into the image subresource described by region (bufferOffset is relative to src).
+        //! The previous content of the subresource is discarded, it is in final_layout afterwards.
+        void copy_to_image(range const& src, VkImage dst, VkBufferImageCopy const& region, VkImageLayout final_layout);
+
+        bool has_pending_copies() const { return !_buffer_copies.empty() || !_image_copies.empty(); }
+
+        //! Flushes the ranges allocated in the current frame and records its queued copies into cmd, between a
+        //! barrier waiting for earlier accesses of the destinations and one making the copies visible to all
+        //! subsequent commands of the queue. Has to be called every frame before the submission.
+        void record(VkCommandBuffer cmd);
+
+        VkBuffer buffer() const { return _buffer.buffer; }
+        VkDeviceSize frame_capacity() const { return _frame_capacity; }
+        VkDeviceSize frame_used() const { return _head.load(std::memory_order_relaxed); }
+
+        //! Highest frame_used() seen so far - for sizing the ring.
+        VkDeviceSize peak_used() const { return _peak; }
+
+    private:
+        struct buffer_copy
+        {
+            VkBuffer dst;
+            VkBufferCopy region;
+        };
+
+        struct image_copy
+        {
+            VkImage dst;
+            VkBufferImageCopy region;
+            VkImageLayout final_layout;
+        };
+
+        VkDevice _device;
+        memory_allocator& _allocator;
+        VkDeviceSize _alignment;
+        VkDeviceSize _frame_capacity;
+        uint32_t _frames;
+        allocated_buffer _buffer{};
+
+        VkDeviceSize _base{0};
+        std::atomic<VkDeviceSize> _head{0};
+        VkDeviceSize _peak{0};
+        std::vector<buffer_copy> _buffer_copies{};
+        std::vector<image_copy> _image_copies{};
+    };
+
+} // namespace vlk
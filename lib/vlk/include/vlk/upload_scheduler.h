@@ -0,0 +1,129 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#pragma once
+
+#include <vlk/export.h>
+#include <vlk/memory_allocator.h>
+
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace vlk {
+
+    //! \brief Asynchronous uploads of buffer and image data on the transfer queue.
+    //! Uploads may be queued from any thread. Once per frame update() - called from the thread submitting to the
+    //! graphics queue - submits everything queued so far as one batch to the transfer queue and checks the batches
+    //! submitted before. Every upload returns the ticket of the batch it belongs to. Tickets increase monotonically
+    //! like the values of a timeline semaphore: when is_ready(t) the destination resources of ticket t and all
+    //! tickets before can be used by graphics commands recorded after update().
+    //! With a separate transfer queue family, destination resources must use VK_SHARING_MODE_EXCLUSIVE, the queue
+    //! family ownership transfer to the graphics family is done here: the release barrier is recorded on the transfer
+    //! queue, the acquire barrier by update() into the graphics command buffer once the batch has finished.
+    //! In the graphics family transfer_queue has to be the graphics queue itself, the copies are made visible by a
+    //! barrier which orders them only before later submissions to the same queue.
+    //! Completion is determined by polling fences, so the graphics queue never waits for a running transfer.
+    class VLK_EXPORT upload_scheduler
+    {
+    public:
+        using ticket = uint64_t;
+
+        upload_scheduler(VkDevice device, memory_allocator& allocator, uint32_t qfi_transfer, VkQueue transfer_queue,
+                         uint32_t qfi_graphics);
+        ~upload_scheduler();
+
+        upload_scheduler(upload_scheduler const&) = delete;
+        upload_scheduler& operator=(upload_scheduler const&) = delete;
+
+        //! Copies size bytes of data to dst at dst_offset.
+        ticket upload_buffer(void const* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dst_offset);
+
+        //! Copies size bytes of data to the image subresource described by region (bufferOffset is relative to data).
+        //! The previous content of the subresource is discarded, it is in final_layout afterwards.
+        ticket upload_image(void const* data, VkDeviceSize size, VkImage dst, VkBufferImageCopy const& region,
+                            VkImageLayout final_layout);
+
+        //! Submits the uploads queued since the last call and records the acquire barriers of finished batches into
+        //! graphics_cmd. Must be called by the thread submitting to the graphics queue, before graphics_cmd records
+        //! any command using uploaded resources.
+        //! When the submission fails the uploads stay queued for the next update(), their tickets don't get ready
+        //! before they have been submitted and executed.
+        void update(VkCommandBuffer graphics_cmd);
+
+        //! True when all uploads of t are finished and acquired by the graphics queue.
+        bool is_ready(ticket t) const { return t <= _ready.load(std::memory_order_acquire); }
+        ticket ready_ticket() const { return _ready.load(std::memory_order_acquire); }
+
+        //! Blocks until all batches submitted so far have finished on the transfer queue - is_ready() still
+        //! requires the next update().
+        void wait_idle();
+
+        //! True when the uploads are executed on a transfer-only queue family.
+        bool dedicated_queue() const { return _qfi_transfer != _qfi_graphics; }
+
+    private:
+        struct upload
+        {
+            allocated_buffer staging;
+            bool is_image;
+            VkBuffer dst_buffer;
+            VkBufferCopy buffer_region;
+            VkImage dst_image;
+            VkBufferImageCopy image_region;
+            VkImageLayout final_layout;
+        };
+
+        struct batch
+        {
+            ticket id;
+            VkCommandBuffer cmd;
+            VkFence fence;
+            std::vector<upload> uploads;
+        };
+
+        allocated_buffer create_staging(void const* data, VkDeviceSize size);
+        //! A batch of _free_batches or a new one, without uploads.
+        batch take_batch();
+        void submit(batch& b);
+        void acquire(VkCommandBuffer graphics_cmd, batch const& b) const;
+        VkImageMemoryBarrier image_barrier(upload const& u, VkImageLayout old_layout, VkImageLayout new_layout,
+                                           VkAccessFlags src, VkAccessFlags dst, bool ownership) const;
+        VkBufferMemoryBarrier buffer_barrier(upload const& u, VkAccessFlags src, VkAccessFlags dst) const;
+
+        VkDevice _device;
+        memory_allocator& _allocator;
+        uint32_t _qfi_transfer;
+        VkQueue _queue;
+        uint32_t _qfi_graphics;
+        VkCommandPool _pool{VK_NULL_HANDLE};
+
+        std::mutex _mutex{};
+        std::vector<upload> _pending{};
+        ticket _next{1};                    //!< ticket of the batch currently collecting uploads
+        std::atomic<ticket> _ready{0};
+
+        std::deque<batch> _in_flight{};
+        std::vector<batch> _free_batches{};
+    };
+
+} // namespace vlk
@@ -19,7 +19,9 @@
 // ================================================================================================
 #pragma once
 
+#include <vlk/enum_names.h>
 #include <vlk/export.h>
+#include <vlk/format_info.h>
 #include <vlk/phys_device.h>
 
 #include <vulkan/vulkan.h>
@@ -28,18 +30,9 @@
 
 namespace vlk {
 
-    //! Translate VkResult enumeration values to string.
-    std::string VLK_EXPORT to_string(VkResult r);
-
-    //! Translate VkPhyiscalDeviceType value to string.
-    std::string VLK_EXPORT to_string(VkPhysicalDeviceType dt);
-
-    std::string VLK_EXPORT to_string(VkFormat f);
-    std::string VLK_EXPORT to_string(VkColorSpaceKHR cs);
-    std::string VLK_EXPORT to_string(VkPresentModeKHR pm);
-
-    //! Logs the properties of a physical device from VULKAN.
-    void VLK_EXPORT log_phys_device(vlk::phys_device const& pd, VkSurfaceKHR surface, std::string const& prefix = {});
+    //! Logs the properties of a physical device from VULKAN, with the parts of its score if given.
+    void VLK_EXPORT log_phys_device(vlk::phys_device const& pd, VkSurfaceKHR surface, std::string const& prefix = {},
+                                    vlk::device_score const* score = nullptr);
 
     void VLK_EXPORT log(vlk::swap_properties_selection const& sps, std::string const& prefix = {});
 
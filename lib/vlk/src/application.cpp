@@ -25,17 +25,53 @@
 #include <vlk/log.h>
 #include <vlk/util.h>
 
-#include "vulkan-bindings.h"
-
 #include <GLFW/glfw3.h>
 #include <vulkan/vulkan.h>
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstring>
+#include <limits>
+#include <sstream>
 
+#define VLK_VK_LAYER_KHRONOS_VALIDATION_NAME          "VK_LAYER_KHRONOS_validation"
 #define VLK_VK_LAYER_LUNARG_STANDARD_VALIDATION_NAME  "VK_LAYER_LUNARG_standard_validation"
 
 namespace {
 
+    //! The Khronos layer of current SDKs first, the LunarG meta layer of older ones.
+    constexpr std::array<char const*, 2> validation_layers{VLK_VK_LAYER_KHRONOS_VALIDATION_NAME,
+                                                           VLK_VK_LAYER_LUNARG_STANDARD_VALIDATION_NAME};
+
+    char const* find_validation_layer()
+    {
+        uint32_t count{0};
+        vkEnumerateInstanceLayerProperties(&count, nullptr);
+        std::vector<VkLayerProperties> layers{count};
+        vkEnumerateInstanceLayerProperties(&count, layers.data());
+        for (auto const* name : validation_layers) {
+            auto const found = std::any_of(layers.begin(), layers.end(), [name](VkLayerProperties const& l) {
+                return 0 == std::strcmp(l.layerName, name);
+            });
+            if (found) {
+                return name;
+            }
+        }
+        return nullptr;
+    }
+
+    //! Whether the loader (layer nullptr) or layer provide the instance extension.
+    bool has_instance_extension(char const* layer, char const* extension)
+    {
+        uint32_t count{0};
+        vkEnumerateInstanceExtensionProperties(layer, &count, nullptr);
+        std::vector<VkExtensionProperties> extensions{count};
+        vkEnumerateInstanceExtensionProperties(layer, &count, extensions.data());
+        return std::any_of(extensions.begin(), extensions.end(), [extension](VkExtensionProperties const& e) {
+            return 0 == std::strcmp(e.extensionName, extension);
+        });
+    }
+
     void stringvec_2_charvec(std::vector<char const*>& target, std::vector<std::string> const& src)
     {
         for (auto const& str : src) {
@@ -64,12 +100,40 @@ namespace {
         qci.pQueuePriorities = priority;
     }
 
+    using frame_clock = std::chrono::steady_clock;
+
 }
 
 using namespace vlk;
 
-application::application()
+application::application(application_settings const& settings)
+    : _vk_enable_validation{settings.validation}
+    , _validation_limits{settings.validation_limits}
+    , _app_name{settings.app_name}
+    , _window_width{settings.window_width}
+    , _window_height{settings.window_height}
+    , _frames_in_flight{settings.frames_in_flight}
+    , _headless{settings.headless}
+    , _max_frames{settings.max_frames}
+    , _gpu_profiling{settings.gpu_profiling}
+    , _defragmentation{settings.defragmentation}
+    , _device_probe{settings.device_probe}
+    , _present_policy{settings.present_policy}
+    , _defrag_budget{settings.defrag_budget}
+    , _upload_ring_size{settings.upload_ring_size}
+    , _jobs{std::make_unique<vlk::job_system>(settings.worker_threads)}
+    , _pipeline_cache_file{settings.pipeline_cache_file}
+    , _deferred_releases{settings.frames_in_flight}
 {
+    if (0 == _frames_in_flight) {
+        throw vlk::app_exception{"at least one frame in flight required"};
+    }
+#ifndef VLK_VULKAN_VALIDATAION_LAYER
+    _vk_enable_validation = false;
+#endif
+    if (_headless) {
+        return;
+    }
     if (GLFW_TRUE != glfwInit()) {
         throw vlk::glfw_exception("GLFW init failed");
     }
@@ -78,46 +142,291 @@ application::application()
 
 application::~application()
 {
-    glfwTerminate();
+    if (!_headless) {
+        glfwTerminate();
+    }
 }
 
 void application::run()
 {
     vlk::final fin{[this](){this->cleanup_run();}};
+    _stop_requested = false;
+    _frame_stats.reset();
+    _last_frame_start = frame_clock::time_point{};
+    for (auto& h : _present_intervals) {
+        h.reset();
+    }
+    _last_present = frame_clock::time_point{};
     init_run();
-    while(!glfwWindowShouldClose(_window)) {
-        glfwPollEvents();
+    auto const first_frame_begin = std::chrono::steady_clock::now();
+    while(!should_stop()) {
+        if (!_headless) {
+            glfwPollEvents();
+        }
+        _jobs->run_main_thread_jobs();
+        draw_frame();
+        if (1U == _frame_counter && "first_frame" != _startup_phases.back().name) {
+            _startup_phases.push_back(
+                    startup_phase{"first_frame", std::chrono::steady_clock::now() - first_frame_begin, false});
+            log_startup_phases();
+        }
+    }
+    _frame_stats.log("frame stats: ");
+    for (uint32_t i = 0; i < static_cast<uint32_t>(present_policy::count); ++i) {
+        auto const& h = _present_intervals[i];
+        if (0 != h.count()) {
+            VLK_LOG_INFO() << "present intervals " << to_string(static_cast<present_policy>(i)) << ": n=" << h.count()
+                           << " mean=" << h.mean_ms() << "ms p50=" << h.p50_ms() << "ms p95=" << h.p95_ms()
+                           << "ms p99=" << h.p99_ms() << "ms max=" << h.max_ms() << "ms";
+        }
+    }
+    auto const heaps = _allocator->heap_stats();
+    for (size_t i = 0; i < heaps.size(); ++i) {
+        VLK_LOG_INFO() << "memory heap " << i << ": blocks " << heaps[i].block_count << " (" << heaps[i].block_bytes
+                       << " bytes), used " << heaps[i].used_bytes << " bytes, dedicated " << heaps[i].dedicated_count
+                       << " (" << heaps[i].dedicated_bytes << " bytes), free ranges " << heaps[i].free_range_count
+                       << ", fragmentation " << heaps[i].fragmentation();
+    }
+    auto const ps = _pipeline_compiler->get_stats();
+    if (0 != ps.created + ps.failed) {
+        VLK_LOG_INFO() << "pipelines: " << ps.created << " created, " << ps.failed << " failed, "
+                       << std::chrono::duration_cast<std::chrono::milliseconds>(ps.cpu_time).count() << " ms CPU time";
+    }
+    if (0 != _defragmenter->stats().moves) {
+        VLK_LOG_INFO() << "defragmentation: " << _defragmenter->stats().moves << " moves, "
+                       << _defragmenter->stats().bytes_moved << " bytes";
+    }
+}
+
+void application::set_present_policy(vlk::present_policy policy)
+{
+    if (present_policy::count <= policy) {
+        throw vlk::app_exception{"invalid present policy"};
+    }
+    _present_policy = policy;
+}
+
+histogram const& application::present_intervals(vlk::present_policy policy) const
+{
+    if (present_policy::count <= policy) {
+        throw vlk::app_exception{"invalid present policy"};
+    }
+    return _present_intervals[static_cast<size_t>(policy)];
+}
+
+void application::stop()
+{
+    _stop_requested = true;
+}
+
+bool application::should_stop() const
+{
+    if (_stop_requested) {
+        return true;
+    }
+    if (0 != _max_frames && _frame_counter >= _max_frames) {
+        return true;
+    }
+    return !_headless && glfwWindowShouldClose(_window);
+}
+
+vlk::phys_device const& application::phys_device() const
+{
+    if (!_phys_dev) {
+        throw vlk::app_exception{"Illegal operation - no physical device selected"};
+    }
+    return *_phys_dev;
+}
+
+vlk::memory_allocator& application::allocator()
+{
+    if (!_allocator) {
+        throw vlk::app_exception{"Illegal operation - allocator only available inside run()"};
+    }
+    return *_allocator;
+}
+
+vlk::memory_defragmenter& application::defragmenter()
+{
+    if (!_defragmenter) {
+        throw vlk::app_exception{"Illegal operation - defragmenter only available inside run()"};
+    }
+    return *_defragmenter;
+}
+
+vlk::upload_ring& application::uploads()
+{
+    if (!_upload_ring) {
+        throw vlk::app_exception{"Illegal operation - upload ring only available inside run()"};
+    }
+    return *_upload_ring;
+}
+
+vlk::upload_scheduler& application::async_uploads()
+{
+    if (!_upload_scheduler) {
+        throw vlk::app_exception{"Illegal operation - upload scheduler only available inside run()"};
+    }
+    return *_upload_scheduler;
+}
+
+VkPipelineCache application::vk_pipeline_cache() const
+{
+    if (!_pipeline_cache) {
+        throw vlk::app_exception{"Illegal operation - pipeline cache only available inside run()"};
+    }
+    return _pipeline_cache->handle();
+}
+
+vlk::pipeline_compiler& application::pipelines()
+{
+    if (!_pipeline_compiler) {
+        throw vlk::app_exception{"Illegal operation - pipeline compiler only available inside run()"};
+    }
+    return *_pipeline_compiler;
+}
+
+vlk::shader_cache& application::shaders()
+{
+    if (!_shaders) {
+        throw vlk::app_exception{"Illegal operation - shader cache only available inside run()"};
+    }
+    return *_shaders;
+}
+
+vlk::barrier_batch& application::barriers()
+{
+    if (!_barriers) {
+        throw vlk::app_exception{"Illegal operation - barrier batch only available inside run()"};
+    }
+    return *_barriers;
+}
+
+vlk::descriptor_allocator& application::descriptors()
+{
+    if (!_descriptors) {
+        throw vlk::app_exception{"Illegal operation - descriptor allocator only available inside run()"};
     }
+    return *_descriptors;
+}
+
+vlk::command_pools& application::cmd_pools()
+{
+    if (!_cmd_pools) {
+        throw vlk::app_exception{"Illegal operation - command pools only available inside run()"};
+    }
+    return *_cmd_pools;
+}
+
+vlk::gpu_profiler& application::profiler()
+{
+    if (!_gpu_profiler) {
+        throw vlk::app_exception{"Illegal operation - profiler only available inside run()"};
+    }
+    return *_gpu_profiler;
+}
+
+VkImageLayout application::frame_final_layout() const
+{
+    return _headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 }
 
 void application::cleanup_run() noexcept
 {
+    if (VK_NULL_HANDLE != _vk_device) {
+        vkDeviceWaitIdle(_vk_device);
+    }
+    _deferred_releases.run_all();
+    if (_pipeline_compiler) {
+        // create infos reference objects the subclass destroys in on_cleanup_run()
+        _pipeline_compiler->wait_idle();
+    }
+    if (_user_initialised) {
+        _user_initialised = false;
+        on_cleanup_run();
+    }
+    _pipeline_compiler.reset();
+    _shaders.reset();
+    _defragmenter.reset();
+    _upload_ring.reset();
+    _upload_scheduler.reset();
+    _async_compute.reset();
+    _cmd_pools.reset();
+    _descriptors.reset();
+    _barriers.reset();
+    if (_pipeline_cache) {
+        try {
+            _pipeline_cache->save();
+        }
+        catch (std::exception const& e) {
+            VLK_LOG_WARNING() << "Unable to save pipeline cache: " << e.what();
+        }
+        _pipeline_cache.reset();
+    }
+    for (auto const& frame : _frames) {
+        if (VK_NULL_HANDLE != frame.image_available) {
+            vkDestroySemaphore(_vk_device, frame.image_available, nullptr);
+        }
+        if (VK_NULL_HANDLE != frame.render_finished) {
+            vkDestroySemaphore(_vk_device, frame.render_finished, nullptr);
+        }
+        if (VK_NULL_HANDLE != frame.in_flight) {
+            vkDestroyFence(_vk_device, frame.in_flight, nullptr);
+        }
+    }
+    _gpu_profiler.reset();
+    _frames.clear();
+    _images_in_flight.clear();
+    _frame_idx = 0;
+    _frame_counter = 0;
+    if (VK_NULL_HANDLE != _vk_cmd_pool) {
+        // destroying the pool frees all command buffers allocated from it
+        vkDestroyCommandPool(_vk_device, _vk_cmd_pool, nullptr);
+        _vk_cmd_pool = VK_NULL_HANDLE;
+    }
     for (auto const& iv : _vk_swap_chain_img_views) {
         vkDestroyImageView(_vk_device, iv, nullptr);
     }
     _vk_swap_chain_img_views.clear();
+    if (_headless) {
+        // offscreen images are owned by us, swap chain images by the swap chain
+        for (auto const& img : _vk_swap_chain_images) {
+            vkDestroyImage(_vk_device, img, nullptr);
+        }
+        for (auto& mem : _offscreen_memory) {
+            _allocator->free(mem);
+        }
+        _offscreen_memory.clear();
+    }
     _vk_swap_chain_images.clear();
     if (VK_NULL_HANDLE != _vk_swap_chain) {
        vkDestroySwapchainKHR(_vk_device, _vk_swap_chain, nullptr);
        _vk_swap_chain = VK_NULL_HANDLE;
     }
+    _allocator.reset();
     _vk_queue_gfx = VK_NULL_HANDLE;
     _vk_queue_pres = VK_NULL_HANDLE;
+    _vk_queue_transfer = VK_NULL_HANDLE;
+    _vk_queues_compute.clear();
     if (VK_NULL_HANDLE != _vk_device) {
         vkDestroyDevice(_vk_device, nullptr);
+        _vk_device = VK_NULL_HANDLE;
     }
+    _phys_dev.reset();
     if (VK_NULL_HANDLE != _vk_surface) {
         vkDestroySurfaceKHR(_vk_instance, _vk_surface, nullptr);
         _vk_surface = VK_NULL_HANDLE;
     }
-    if (VK_NULL_HANDLE != _vk_dbg_cbk) {
-        vlk::destroyDebugReportCallbackEXT(_vk_instance, _vk_dbg_cbk, nullptr);
-        _vk_dbg_cbk = VK_NULL_HANDLE;
+    if (_debug_messenger) {
+        log_validation_stats();
+        _debug_messenger->detach();
     }
     if (VK_NULL_HANDLE != _vk_instance) {
         vkDestroyInstance(_vk_instance, nullptr);
         _vk_instance = VK_NULL_HANDLE;
     }
+    // chained into the instance create info, reports vkDestroyInstance() as well
+    _debug_messenger.reset();
     if (nullptr != _window) {
         glfwDestroyWindow(_window);
         _window = nullptr;
@@ -126,24 +435,109 @@ void application::cleanup_run() noexcept
 
 void application::init_run()
 {
-    create_window();
-    create_vk_instance();
-    install_validation_report_cbk();
-    create_surface();
-    create_device();
-    create_swap_chain();
-    create_image_views();
+    _startup_phases.clear();
+
+    // the window has to be created by the main thread, the instance does not depend on it
+    vlk::job_system::counter instance_created{};
+    std::chrono::nanoseconds instance_time{0};
+    _jobs->run([this, &instance_time]() {
+        auto const begin = std::chrono::steady_clock::now();
+        create_vk_instance();
+        instance_time = std::chrono::steady_clock::now() - begin;
+    }, &instance_created);
+    try {
+        if (!_headless) {
+            timed_phase("create_window", [this]() { create_window(); });
+        }
+    }
+    catch (...) {
+        // the job writes _vk_instance, cleanup_run() must not see it half done
+        try {
+            _jobs->wait(instance_created);
+        }
+        catch (...) {
+        }
+        throw;
+    }
+    _jobs->wait(instance_created);
+    _startup_phases.push_back(startup_phase{"create_vk_instance", instance_time, !_headless});
+
+    timed_phase("install_debug_messenger", [this]() { install_debug_messenger(); });
+    if (!_headless) {
+        timed_phase("create_surface", [this]() { create_surface(); });
+    }
+    timed_phase("create_device", [this]() { create_device(); });
+    timed_phase("pipeline_cache", [this]() {
+        _pipeline_cache = std::make_unique<vlk::pipeline_cache>(_vk_device, *_phys_dev, _pipeline_cache_file);
+        _pipeline_compiler = std::make_unique<vlk::pipeline_compiler>(_vk_device, _pipeline_cache->handle(), *_jobs);
+        _shaders = std::make_unique<vlk::shader_cache>(_vk_device);
+    });
+    if (_headless) {
+        timed_phase("create_offscreen_images", [this]() { create_offscreen_images(); });
+    }
+    else {
+        timed_phase("create_swap_chain", [this]() { create_swap_chain(); });
+    }
+    timed_phase("create_image_views", [this]() { create_image_views(); });
+    timed_phase("create_frame_slots", [this]() {
+        create_command_pool();
+        create_frame_slots();
+        // a profiler with no frames in flight has no query pools and ignores all zones
+        _gpu_profiler = std::make_unique<vlk::gpu_profiler>(_vk_device, *_phys_dev, _phys_dev_selected.qfi_graphics,
+                _gpu_profiling ? _frames_in_flight : 0U);
+    });
+    timed_phase("on_init_run", [this]() { on_init_run(); });
+    _user_initialised = true;
+}
+
+void application::timed_phase(char const* name, std::function<void()> const& fn)
+{
+    auto const begin = std::chrono::steady_clock::now();
+    fn();
+    _startup_phases.push_back(startup_phase{name, std::chrono::steady_clock::now() - begin, false});
+}
+
+void application::log_startup_phases() const
+{
+    // overlapped phases do not add to the wall clock time
+    std::chrono::nanoseconds total{0};
+    for (auto const& p : _startup_phases) {
+        if (!p.overlapped) {
+            total += p.duration;
+        }
+    }
+    auto ms = [](std::chrono::nanoseconds d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    VLK_LOG_INFO() << "startup: " << ms(total) << " ms until the first frame";
+    for (auto const& p : _startup_phases) {
+        VLK_LOG_INFO() << "  " << p.name << ": " << ms(p.duration) << " ms" << (p.overlapped ? " (overlapped)" : "");
+    }
 }
 
+void application::on_init_run()
+{}
+
+void application::on_cleanup_run()
+{}
+
 void application::create_window()
 {
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
     _window = glfwCreateWindow(static_cast<int>(_window_width), static_cast<int>(_window_height), _app_name.c_str(),
             nullptr, nullptr);
     if (nullptr == _window) {
         throw vlk::glfw_exception{"window creation failed"};
     }
+    glfwSetWindowUserPointer(_window, static_cast<void*>(this));
+    glfwSetFramebufferSizeCallback(_window, &application::glfw_framebuffer_resize_cbk);
+}
+
+void application::glfw_framebuffer_resize_cbk(GLFWwindow* window, [[maybe_unused]] int width,
+                                              [[maybe_unused]] int height)
+{
+    auto app = reinterpret_cast<vlk::application*>(glfwGetWindowUserPointer(window));
+    assert(app);
+    app->_framebuffer_resized = true;
 }
 
 void application::create_vk_instance()
@@ -153,22 +547,34 @@ void application::create_vk_instance()
     det_instance_requirements(required_extensions, required_layers);
 
     std::vector<char const*> rexts{};
-    char const **glfw_required_extensions;
-    uint32_t glfw_extension_count{0};
-    glfw_required_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
-    for (uint32_t i = 0; i < glfw_extension_count; ++i) {
-        append_char_unique(rexts, *(glfw_required_extensions + i));
+    if (!_headless) {
+        char const **glfw_required_extensions;
+        uint32_t glfw_extension_count{0};
+        glfw_required_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+        for (uint32_t i = 0; i < glfw_extension_count; ++i) {
+            append_char_unique(rexts, *(glfw_required_extensions + i));
+        }
     }
+    _vk_validation_layer = nullptr;
     if (_vk_enable_validation) {
-        append_char_unique(rexts, VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
+        auto const* layer = find_validation_layer();
+        if (nullptr != layer && (has_instance_extension(nullptr, VK_EXT_DEBUG_UTILS_EXTENSION_NAME)
+                                 || has_instance_extension(layer, VK_EXT_DEBUG_UTILS_EXTENSION_NAME))) {
+            _vk_validation_layer = layer;
+            append_char_unique(rexts, VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+        else {
+            VLK_LOG_WARNING() << "No validation layer with " << VK_EXT_DEBUG_UTILS_EXTENSION_NAME
+                              << " installed, running without validation";
+        }
     }
     stringvec_2_charvec(rexts, required_extensions);
     DBG_PRINT_CHAR_VEC(Required Extensions, rexts);
 
     std::vector<char const*> rlayr{};
     stringvec_2_charvec(rlayr, required_layers);
-    if (_vk_enable_validation) {
-        append_char_unique(rlayr, VLK_VK_LAYER_LUNARG_STANDARD_VALIDATION_NAME);
+    if (nullptr != _vk_validation_layer) {
+        append_char_unique(rlayr, _vk_validation_layer);
     }
     DBG_PRINT_CHAR_VEC(Required Layers, rlayr);
 
@@ -181,9 +587,22 @@ void application::create_vk_instance()
     ai.engineVersion = VK_MAKE_VERSION(1U, 0U, 0U);
     ai.apiVersion = VK_API_VERSION_1_1;
 
+    if (nullptr != _vk_validation_layer) {
+        _debug_messenger = std::make_unique<vlk::debug_messenger>(
+                VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT,
+                VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT
+                    | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
+                [this](VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types,
+                       VkDebugUtilsMessengerCallbackDataEXT const& data, uint64_t suppressed) {
+                    on_vk_debug_msg(severity, types, data, suppressed);
+                },
+                _validation_limits);
+    }
+
     VkInstanceCreateInfo ci;
     ci.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-    ci.pNext = nullptr;
+    // reports the messages of vkCreateInstance() and vkDestroyInstance()
+    ci.pNext = _debug_messenger ? _debug_messenger->instance_create_info() : nullptr;
     ci.flags = 0;
     ci.pApplicationInfo = &ai;
     ci.enabledLayerCount = static_cast<uint32_t>(rlayr.size());
@@ -201,69 +620,74 @@ void application::det_instance_requirements([[maybe_unused]] std::vector<std::st
                                             [[maybe_unused]] std::vector<std::string>& required_layers)
 {}
 
-void application::install_validation_report_cbk()
+void application::install_debug_messenger()
 {
-    if (_vk_enable_validation) {
-        // this will work only if the layer VK_LAYER_LUNARG_STANDARD_VALIDATION and the extension
-        // VK_EXT_DEBUG_REPORT_EXTENSION_NAME are enabled in the Vulkan instance
-        VkDebugReportCallbackCreateInfoEXT cbk_create_info;
-        cbk_create_info.sType = VK_STRUCTURE_TYPE_DEBUG_REPORT_CREATE_INFO_EXT;
-        cbk_create_info.pNext = nullptr;
-        cbk_create_info.flags = VK_DEBUG_REPORT_ERROR_BIT_EXT |
-                                VK_DEBUG_REPORT_WARNING_BIT_EXT |
-                                VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT;
-        cbk_create_info.pfnCallback = &application::vk_debug_report_cbk;
-        cbk_create_info.pUserData = static_cast<void*>(this);
-
-        auto r = vlk::createDebugReportCallbackEXT(_vk_instance, &cbk_create_info, nullptr, &_vk_dbg_cbk);
-        if (r != VK_SUCCESS) {
-            throw vlk::vulkan_exception{"Unable to register validation layer callback", r};
-        }
-    }
-}
-
-VkBool32 application::vk_debug_report_cbk(VkDebugReportFlagsEXT flags,
-                                          VkDebugReportObjectTypeEXT object_type,
-                                          uint64_t object,
-                                          size_t location,
-                                          int32_t message_code,
-                                          const char* p_layer_prefix,
-                                          const char* p_message,
-                                          void* p_user_data)
-{
-    assert(p_user_data);
-    auto app = reinterpret_cast<vlk::application*>(p_user_data);
-    app->on_vk_debug_msg(flags, object_type, object, location, message_code, p_layer_prefix, p_message);
-    return VK_FALSE;
-}
-
-void application::on_vk_debug_msg([[maybe_unused]] VkDebugReportFlagsEXT flags,
-                                  [[maybe_unused]] VkDebugReportObjectTypeEXT object_type,
-                                  [[maybe_unused]] uint64_t object,
-                                  [[maybe_unused]] size_t location,
-                                  [[maybe_unused]] int32_t message_code,
-                                  [[maybe_unused]] const char* p_layer_prefix,
-                                  [[maybe_unused]] const char* p_message)
-{
-    VLK_LOG_ERROR() << "VULKAN " << p_layer_prefix << " - " << p_message;
-}
-
-void application::vk_debug_report_msg(VkDebugReportFlagsEXT flags,
-                         VkDebugReportObjectTypeEXT objectType,
-                         uint64_t object,
-                         size_t location,
-                         int32_t messageCode,
-                         std::string const& pLayerPrefix,
-                         std::string const& pMessage)
+    if (!_debug_messenger) {
+        return;
+    }
+    _debug_messenger->attach(_vk_instance);
+}
+
+void application::log_validation_stats() const
+{
+    auto const stats = _debug_messenger->filter().stats();
+    for (auto const& s : stats) {
+        if (0 != s.suppressed) {
+            VLK_LOG_INFO() << "VULKAN [" << s.name << "] (" << s.id << ") reported " << s.count << " times, "
+                           << s.suppressed << " suppressed";
+        }
+    }
+}
+
+void application::name_object(VkObjectType type, uint64_t handle, char const* name) const
+{
+    _debug_messenger->set_object_name(_vk_device, type, handle, name);
+}
+
+void application::on_vk_debug_msg(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                                  VkDebugUtilsMessageTypeFlagsEXT types,
+                                  VkDebugUtilsMessengerCallbackDataEXT const& data,
+                                  uint64_t suppressed)
+{
+    std::ostringstream msg;
+    msg << "VULKAN ";
+    if (0 != (types & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT)) {
+        msg << "performance ";
+    }
+    msg << "[" << (data.pMessageIdName ? data.pMessageIdName : "") << "] " << (data.pMessage ? data.pMessage : "");
+    // objects named with set_object_name() are easier to find than their handles
+    char const* separator{" - objects: "};
+    for (uint32_t i = 0; i < data.objectCount; ++i) {
+        if (nullptr != data.pObjects[i].pObjectName) {
+            msg << separator << data.pObjects[i].pObjectName;
+            separator = ", ";
+        }
+    }
+    if (0 != suppressed) {
+        msg << " (" << suppressed << " similar messages suppressed)";
+    }
+    if (0 != (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)) {
+        VLK_LOG_ERROR() << msg.str();
+    }
+    else if (0 != (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)) {
+        VLK_LOG_WARNING() << msg.str();
+    }
+    else {
+        VLK_LOG_DEBUG() << msg.str();
+    }
+}
+
+void application::vk_debug_msg(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                               VkDebugUtilsMessageTypeFlagsEXT types,
+                               std::string const& message)
 {
     if (_vk_instance == VK_NULL_HANDLE) {
         throw vlk::app_exception{"Debug messages not possible when no Vulkan instance available"};
     }
-    if (!_vk_enable_validation) {
+    if (!_debug_messenger) {
         throw vlk::app_exception{"Debug validation layer not activated"};
     }
-    vlk::debugReportMessageEXT(_vk_instance, flags, objectType, object, location, messageCode, pLayerPrefix.c_str(),
-            pMessage.c_str());
+    _debug_messenger->submit(severity, types, message.c_str());
 }
 
 void application::create_surface()
@@ -289,10 +713,17 @@ std::vector<vlk::phys_device> application::get_list_phys_devices()
     std::vector<VkPhysicalDevice> pds{pd_count};
     vkEnumeratePhysicalDevices(_vk_instance, &pd_count, pds.data());
 
+    // each phys_device issues a dozen queries against the driver, the devices are independent of each other
+    std::vector<std::unique_ptr<vlk::phys_device>> queried(pd_count);
+    _jobs->parallel_for(pd_count, 1U, [&pds, &queried](uint32_t begin, uint32_t end) {
+        for (auto i = begin; i < end; ++i) {
+            queried[i] = std::make_unique<vlk::phys_device>(pds[i]);
+        }
+    });
     std::vector<vlk::phys_device> r{};
     r.reserve(pd_count);
-    for (auto const& pd : pds) {
-        r.emplace_back(pd);
+    for (auto& pd : queried) {
+        r.push_back(std::move(*pd));
     }
     return r;
 }
@@ -305,18 +736,72 @@ void application::create_device()
     if (VK_NULL_HANDLE == selected.device) {
         throw app_exception{"no physical device selected"};
     }
+    if (_headless && VLK_INVALID_QF_IDX == selected.qfi_presentation) {
+        // nothing is presented - the 'presentation' queue is just the graphics queue
+        selected.qfi_presentation = selected.qfi_graphics;
+    }
     if (VLK_INVALID_QF_IDX == selected.qfi_graphics || VLK_INVALID_QF_IDX == selected.qfi_presentation) {
         throw app_exception{"no queue family for GFX or presentation found"};
     }
 
-    bool single_queue{selected.qfi_presentation == selected.qfi_graphics};
-    float prio_gfx_queue = 1.0f;
-    float prio_pres_queue = 1.0f;
-    std::vector<VkDeviceQueueCreateInfo> qci{single_queue ? 1U : 2U};
-    setup_queue_create_info(qci[0], selected.qfi_graphics, 1, &prio_gfx_queue);
-    if (!single_queue) {
-        setup_queue_create_info(qci[1], selected.qfi_presentation, 1, &prio_pres_queue);
+    auto const& pd = *std::find_if(avail_phys_devs.begin(), avail_phys_devs.end(),
+            [&selected](vlk::phys_device const& p) { return p.device == selected.device; });
+
+    // queues of all roles are collected per family, request() returns the index of the role's first queue
+    std::vector<std::pair<uint32_t, std::vector<float>>> family_queues{};
+    auto request = [&](uint32_t qfi, std::vector<float> const& priorities) -> uint32_t {
+        if (priorities.empty()) {
+            throw app_exception{"at least one queue per used queue family required"};
+        }
+        auto it = std::find_if(family_queues.begin(), family_queues.end(),
+                [qfi](auto const& fq) { return fq.first == qfi; });
+        if (family_queues.end() == it) {
+            it = family_queues.insert(family_queues.end(), {qfi, {}});
+        }
+        auto const available = static_cast<size_t>(pd.queue_family_properties[qfi].queueCount);
+        auto const first = std::min(it->second.size(), available - 1U);
+        for (auto p : priorities) {
+            if (it->second.size() < available) {
+                it->second.push_back(p);
+            }
+        }
+        return static_cast<uint32_t>(first);
+    };
+    auto const idx_gfx = request(selected.qfi_graphics, selected.graphics_queue_priorities);
+    // presentation shares the graphics queue when possible
+    auto const idx_pres = selected.qfi_presentation == selected.qfi_graphics
+                        ? idx_gfx : request(selected.qfi_presentation, std::vector<float>{1.0f});
+    auto const qfi_compute = VLK_INVALID_QF_IDX != selected.qfi_compute ? selected.qfi_compute : selected.qfi_graphics;
+    auto const idx_compute = request(qfi_compute, selected.compute_queue_priorities);
+    auto const qfi_transfer = VLK_INVALID_QF_IDX != selected.qfi_transfer
+                            ? selected.qfi_transfer : selected.qfi_graphics;
+    // in the graphics family the uploads are submitted to the graphics queue itself: the upload scheduler relies on
+    // the submission order of a single queue then, its barriers don't order work of another queue
+    auto const idx_transfer = qfi_transfer != selected.qfi_graphics
+                            ? request(qfi_transfer, selected.transfer_queue_priorities) : idx_gfx;
+
+    std::vector<VkDeviceQueueCreateInfo> qci{family_queues.size()};
+    for (size_t i = 0; i < family_queues.size(); ++i) {
+        setup_queue_create_info(qci[i], family_queues[i].first, static_cast<uint32_t>(family_queues[i].second.size()),
+                                family_queues[i].second.data());
+    }
+
+    void const* features_chain{nullptr};
+#ifdef VK_KHR_synchronization2
+    VkPhysicalDeviceSynchronization2FeaturesKHR sync2{};
+    sync2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+    sync2.pNext = nullptr;
+    sync2.synchronization2 = VK_TRUE;
+    if (selected.synchronization2) {
+        if (selected.required_extensions.end() == std::find(selected.required_extensions.begin(),
+                selected.required_extensions.end(), VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+            selected.required_extensions.emplace_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+        }
+        features_chain = &sync2;
     }
+#else
+    selected.synchronization2 = false;
+#endif
 
     std::vector<char const*> required_extensions{};
     std::transform(selected.required_extensions.cbegin(), selected.required_extensions.cend(),
@@ -325,7 +810,7 @@ void application::create_device()
 
     VkDeviceCreateInfo ci;
     ci.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    ci.pNext = nullptr;
+    ci.pNext = features_chain;
     ci.pEnabledFeatures = &selected.features;
     ci.flags = 0;
     ci.enabledLayerCount = 0;
@@ -339,44 +824,99 @@ void application::create_device()
         throw vlk::vulkan_exception{"Unable to create logical device", r};
     }
     _phys_dev_selected = selected;
-    vkGetDeviceQueue(_vk_device, _phys_dev_selected.qfi_graphics, 0, &_vk_queue_gfx);
-    vkGetDeviceQueue(_vk_device, _phys_dev_selected.qfi_presentation, 0, &_vk_queue_pres);
+    _phys_dev = std::make_unique<vlk::phys_device>(pd);
+    vkGetDeviceQueue(_vk_device, _phys_dev_selected.qfi_graphics, idx_gfx, &_vk_queue_gfx);
+    vkGetDeviceQueue(_vk_device, _phys_dev_selected.qfi_presentation, idx_pres, &_vk_queue_pres);
     if (VK_NULL_HANDLE == _vk_queue_pres || _vk_queue_gfx == VK_NULL_HANDLE) {
         throw vlk::vulkan_exception{"Failed to get queue handles", VK_RESULT_MAX_ENUM};
     }
+    // a family without enough queues hands out its last queue repeatedly
+    auto const compute_family_queues = static_cast<uint32_t>(std::find_if(family_queues.begin(), family_queues.end(),
+            [qfi_compute](auto const& fq) { return fq.first == qfi_compute; })->second.size());
+    _vk_queues_compute.resize(selected.compute_queue_priorities.size());
+    for (uint32_t i = 0; i < _vk_queues_compute.size(); ++i) {
+        vkGetDeviceQueue(_vk_device, qfi_compute, std::min(idx_compute + i, compute_family_queues - 1U),
+                         &_vk_queues_compute[i]);
+    }
+    vkGetDeviceQueue(_vk_device, qfi_transfer, idx_transfer, &_vk_queue_transfer);
+    _allocator = std::make_unique<vlk::memory_allocator>(_vk_device, *_phys_dev);
+    _defragmenter = std::make_unique<vlk::memory_defragmenter>(_vk_device, *_allocator);
+
+    // without transfer family the uploads go through the graphics queue
+    _upload_scheduler = std::make_unique<vlk::upload_scheduler>(_vk_device, *_allocator, qfi_transfer,
+                                                                _vk_queue_transfer, _phys_dev_selected.qfi_graphics);
+    VLK_LOG_DEBUG() << "Async uploads on queue family " << qfi_transfer
+                    << (_upload_scheduler->dedicated_queue() ? " (dedicated)" : " (graphics)");
+    VLK_LOG_DEBUG() << "Async compute on queue family " << qfi_compute
+                    << (qfi_compute != _phys_dev_selected.qfi_graphics ? " (dedicated)" : " (graphics)");
+    _barriers = std::make_unique<vlk::barrier_batch>(_vk_device, _phys_dev_selected.synchronization2);
+    VLK_LOG_DEBUG() << "Barriers via " << (_barriers->uses_synchronization2() ? "synchronization2" : "Vulkan 1.1");
 }
 
 vlk::phys_device_selection application::det_physical_device_queue(std::vector<vlk::phys_device> const& available_devices,
         VkSurfaceKHR surface)
 {
-    // default selection simply searches for the first possible device and queue families for GFX and presentation
+    // default selection ranks all devices with queue families for GFX and presentation by score_device()
+    // without surface (headless) the graphics queue family also serves as 'presentation' queue family
+    bool const headless{VK_NULL_HANDLE == surface};
+    vlk::phys_device_selection best{};
+    double best_score{-1.0};
     for (auto const& pd : available_devices) {
         vlk::phys_device_selection pds{};
         pds.device = pd.device;
 
-        if (!pd.supports_extension(VK_KHR_SWAPCHAIN_EXTENSION_NAME)) {
-            break;
+        if (!headless) {
+            if (!pd.supports_extension(VK_KHR_SWAPCHAIN_EXTENSION_NAME)) {
+                continue;
+            }
+            pds.required_extensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
         }
-        pds.required_extensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
         uint32_t qfidx{0};
         for (auto const &qfp : pd.queue_family_properties) {
             if (VLK_INVALID_QF_IDX == pds.qfi_graphics && (0 != (qfp.queueFlags & VK_QUEUE_GRAPHICS_BIT))) {
                 pds.qfi_graphics = qfidx;
+                if (headless) {
+                    pds.qfi_presentation = qfidx;
+                }
             }
-            if (VLK_INVALID_QF_IDX == pds.qfi_presentation && pd.can_present_on_surface(qfidx, surface)) {
+            // headless there is no surface, presentation is done by the graphics family
+            if (!headless && VLK_INVALID_QF_IDX == pds.qfi_presentation && pd.can_present_on_surface(qfidx, surface)) {
                 pds.qfi_presentation = qfidx;
             }
             if (VLK_INVALID_QF_IDX != pds.qfi_graphics && VLK_INVALID_QF_IDX != pds.qfi_presentation) {
-                return pds;
+                break;
             }
             ++qfidx;
         }
+        if (VLK_INVALID_QF_IDX == pds.qfi_graphics || VLK_INVALID_QF_IDX == pds.qfi_presentation) {
+            continue;
+        }
+        pds.qfi_compute = pd.find_queue_family(VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT);
+        // uploads prefer a transfer-only family (DMA engine), then any family without graphics
+        pds.qfi_transfer = pd.find_queue_family(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+        if (VLK_INVALID_QF_IDX == pds.qfi_transfer) {
+            pds.qfi_transfer = pd.find_queue_family(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT);
+        }
+        pds.synchronization2 = pd.synchronization2;
+
+        auto const score = vlk::score_device(pd, _device_probe ? vlk::probe_copy_bandwidth(pd, pds.qfi_graphics) : 0.0);
+        vlk::log_phys_device(pd, surface, "candidate ", &score);
+        // ties keep the enumeration order
+        if (score.total() > best_score) {
+            best_score = score.total();
+            best = std::move(pds);
+        }
+    }
+    if (VK_NULL_HANDLE != best.device) {
+        auto const& pd = *std::find_if(available_devices.begin(), available_devices.end(),
+                [&best](vlk::phys_device const& p) { return p.device == best.device; });
+        VLK_LOG_INFO() << "selected physical device " << pd.properties.deviceName << " (score " << best_score << ")";
     }
-    return vlk::phys_device_selection{};  // nothing selected -> will throw in create_device
+    return best;  // nothing selected -> will throw in create_device
 }
 
-void application::create_swap_chain()
+void application::create_swap_chain(VkSwapchainKHR old_swap_chain)
 {
     VkSurfaceCapabilitiesKHR surface_caps{};
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(_phys_dev_selected.device, _vk_surface, &surface_caps);
@@ -404,7 +944,10 @@ void application::create_swap_chain()
     }
 
     int w,h;
-    glfwGetWindowSize(_window, &w, &h);
+    glfwGetFramebufferSize(_window, &w, &h);
+    // presents before and after the re-creation are no interval of one policy
+    _swap_chain_policy = _present_policy.load();
+    _last_present = frame_clock::time_point{};
     auto sps = det_swap_chain_properties(surface_caps, surface_formats, surface_modes, glm::uvec2{w,h});
 
     VkSwapchainCreateInfoKHR ci{};
@@ -420,7 +963,7 @@ void application::create_swap_chain()
     ci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
     ci.presentMode = sps.present_mode;
     ci.clipped = VK_TRUE;
-    ci.oldSwapchain = VK_NULL_HANDLE;
+    ci.oldSwapchain = old_swap_chain;
     ci.preTransform = sps.pre_transform;
     ci.compositeAlpha = sps.composite_alpha;
 
@@ -448,6 +991,67 @@ void application::create_swap_chain()
     vkGetSwapchainImagesKHR(_vk_device, _vk_swap_chain, &img_count, nullptr);
     _vk_swap_chain_images.resize(img_count);
     vkGetSwapchainImagesKHR(_vk_device, _vk_swap_chain, &img_count, _vk_swap_chain_images.data());
+    if (validation_enabled()) {
+        for (uint32_t i = 0; i < img_count; ++i) {
+            set_object_name(VK_OBJECT_TYPE_IMAGE, _vk_swap_chain_images[i],
+                            ("swap chain image " + std::to_string(i)).c_str());
+        }
+    }
+    _vk_surface_format = sps.surface_format;
+    _vk_surface_extent = sps.extend;
+}
+
+void application::create_offscreen_images()
+{
+    // offscreen images stand in for the swap chain - det_swap_chain_properties() gets a surface description that
+    // allows everything a device-local color attachment can do
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(_phys_dev_selected.device, &props);
+
+    VkSurfaceCapabilitiesKHR caps{};
+    caps.minImageCount = 1U;
+    caps.maxImageCount = 0U;
+    caps.currentExtent = VkExtent2D{_window_width, _window_height};
+    caps.minImageExtent = VkExtent2D{1U, 1U};
+    caps.maxImageExtent = VkExtent2D{props.limits.maxImageDimension2D, props.limits.maxImageDimension2D};
+    caps.maxImageArrayLayers = 1U;
+    caps.supportedTransforms = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    caps.currentTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    caps.supportedCompositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    caps.supportedUsageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+    std::vector<VkSurfaceFormatKHR> formats{
+        {VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR},
+        {VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR}
+    };
+    std::vector<VkPresentModeKHR> modes{VK_PRESENT_MODE_FIFO_KHR};
+    // the policy decides the depth of the offscreen ring, nothing is presented
+    _swap_chain_policy = _present_policy.load();
+    auto sps = det_swap_chain_properties(caps, formats, modes, glm::uvec2{_window_width, _window_height});
+    DBG_PRINT_SWAP_CHAIN_PROPERTIES(Offscreen Image Properties:, sps);
+
+    for (uint32_t i = 0; i < sps.image_count; ++i) {
+        VkImageCreateInfo ci{};
+        ci.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        ci.pNext = nullptr;
+        ci.flags = 0;
+        ci.imageType = VK_IMAGE_TYPE_2D;
+        ci.format = sps.surface_format.format;
+        ci.extent = VkExtent3D{sps.extend.width, sps.extend.height, 1U};
+        ci.mipLevels = 1U;
+        ci.arrayLayers = 1U;
+        ci.samples = VK_SAMPLE_COUNT_1_BIT;
+        ci.tiling = VK_IMAGE_TILING_OPTIMAL;
+        ci.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        ci.queueFamilyIndexCount = 0;
+        ci.pQueueFamilyIndices = nullptr;
+        ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        auto img = _allocator->create_image(ci, vlk::memory_usage::gpu_only);
+        _vk_swap_chain_images.push_back(img.image);
+        _offscreen_memory.push_back(img.memory);
+    }
     _vk_surface_format = sps.surface_format;
     _vk_surface_extent = sps.extend;
 }
@@ -482,37 +1086,21 @@ swap_properties_selection application::det_swap_chain_properties(VkSurfaceCapabi
 
     // 2. presentation mode determination
     assert(!surface_present_modes.empty());
-    sps.present_mode = VK_PRESENT_MODE_MAX_ENUM_KHR;
-    for (auto const& pm : surface_present_modes) {
-        if (pm == VK_PRESENT_MODE_MAILBOX_KHR) {
-            sps.present_mode = VK_PRESENT_MODE_MAILBOX_KHR;
-            break;
-        }
-        else if (pm == VK_PRESENT_MODE_FIFO_KHR) {
-            sps.present_mode = VK_PRESENT_MODE_FIFO_KHR;
-            // go on with search - maybe find a better one
-        }
-    }
-    if (sps.present_mode == VK_PRESENT_MODE_MAX_ENUM_KHR) {
-        throw vlk::vulkan_exception{"no suitable presentation mode - not even FIFO", VK_RESULT_MAX_ENUM};
-    }
+    sps.present_mode = select_present_mode(_swap_chain_policy, surface_present_modes);
 
     // 3. swap extent determination
-    if (capabilities.currentExtent.width == VLK_WIDTH_RESERVED) {
-        // special value means: DON'T CHANGE WIDTH/HEIGHT value because the window manager doesn't like it
+    if (capabilities.currentExtent.width != VLK_WIDTH_RESERVED) {
+        // surface size is given by the window system - the swap chain has to match it
         sps.extend = capabilities.currentExtent;
     }
     else {
+        // special value means: surface size is determined by the swap chain extent
         sps.extend.width = clamp_range(window_size.x, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
         sps.extend.height = clamp_range(window_size.y, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
     }
 
     // 4. image count determination
-    sps.image_count = capabilities.minImageCount + 1;
-    if (capabilities.maxImageCount > 0 && sps.image_count > capabilities.maxImageCount) {
-        // maxImageCount == 0 means: no upper limit
-        sps.image_count = capabilities.maxImageCount;
-    }
+    sps.image_count = select_image_count(_swap_chain_policy, capabilities);
 
     // 5. pre-transform, composite-alpha
     sps.pre_transform = capabilities.currentTransform;
@@ -548,6 +1136,359 @@ void application::create_image_views()
             throw vlk::vulkan_exception{"unable to create image view", r};
         }
         _vk_swap_chain_img_views.push_back(img_view);
+        _barriers->track(img, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0);
     }
     VLK_LOG_DEBUG() << "Created swap chain image views: " << _vk_swap_chain_img_views.size();
 }
+
+void application::create_command_pool()
+{
+    VkCommandPoolCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    ci.pNext = nullptr;
+    ci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    ci.queueFamilyIndex = _phys_dev_selected.qfi_graphics;
+
+    auto r = vkCreateCommandPool(_vk_device, &ci, nullptr, &_vk_cmd_pool);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to create command pool", r};
+    }
+}
+
+void application::create_frame_slots()
+{
+    _frames.resize(_frames_in_flight);
+    _images_in_flight.assign(_vk_swap_chain_images.size(), VK_NULL_HANDLE);
+    _frame_idx = 0;
+
+    std::vector<VkCommandBuffer> cmds{2U * _frames_in_flight};
+    VkCommandBufferAllocateInfo ai{};
+    ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    ai.pNext = nullptr;
+    ai.commandPool = _vk_cmd_pool;
+    ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    ai.commandBufferCount = 2U * _frames_in_flight;
+    auto r = vkAllocateCommandBuffers(_vk_device, &ai, cmds.data());
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to allocate frame command buffers", r};
+    }
+
+    VkSemaphoreCreateInfo sci{};
+    sci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    sci.pNext = nullptr;
+    sci.flags = 0;
+
+    // fences start signaled - the first wait on a frame slot must not block
+    VkFenceCreateInfo fci{};
+    fci.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fci.pNext = nullptr;
+    fci.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (uint32_t i = 0; i < _frames_in_flight; ++i) {
+        auto& frame = _frames[i];
+        frame.cmd = cmds[2U * i];
+        frame.upload_cmd = cmds[2U * i + 1U];
+        r = vkCreateSemaphore(_vk_device, &sci, nullptr, &frame.image_available);
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to create semaphore", r};
+        }
+        r = vkCreateSemaphore(_vk_device, &sci, nullptr, &frame.render_finished);
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to create semaphore", r};
+        }
+        r = vkCreateFence(_vk_device, &fci, nullptr, &frame.in_flight);
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to create fence", r};
+        }
+        if (validation_enabled()) {
+            auto const prefix = "frame " + std::to_string(i) + " ";
+            set_object_name(VK_OBJECT_TYPE_COMMAND_BUFFER, frame.cmd, (prefix + "cmd").c_str());
+            set_object_name(VK_OBJECT_TYPE_COMMAND_BUFFER, frame.upload_cmd, (prefix + "upload cmd").c_str());
+            set_object_name(VK_OBJECT_TYPE_SEMAPHORE, frame.image_available, (prefix + "image available").c_str());
+            set_object_name(VK_OBJECT_TYPE_SEMAPHORE, frame.render_finished, (prefix + "render finished").c_str());
+            set_object_name(VK_OBJECT_TYPE_FENCE, frame.in_flight, (prefix + "in flight").c_str());
+        }
+    }
+    auto const qfi_compute = VLK_INVALID_QF_IDX != _phys_dev_selected.qfi_compute
+                           ? _phys_dev_selected.qfi_compute : _phys_dev_selected.qfi_graphics;
+    _async_compute = std::make_unique<vlk::async_compute>(_vk_device, qfi_compute, _vk_queues_compute.front(),
+                                                          _frames_in_flight);
+    _cmd_pools = std::make_unique<vlk::command_pools>(_vk_device, _phys_dev_selected.qfi_graphics, _frames_in_flight,
+                                                      *_jobs);
+    _descriptors = std::make_unique<vlk::descriptor_allocator>(_vk_device, _frames_in_flight);
+    _upload_ring = std::make_unique<vlk::upload_ring>(_vk_device, *_allocator, *_phys_dev, _frames_in_flight,
+                                                      _upload_ring_size);
+    VLK_LOG_DEBUG() << "Created frame slots: " << _frames.size();
+}
+
+void application::draw_frame()
+{
+    auto& frame = _frames[_frame_idx];
+    auto const t_start = frame_clock::now();
+    if (frame_clock::time_point{} != _last_frame_start) {
+        _frame_stats.record(frame_phase::frame, t_start - _last_frame_start);
+    }
+    _last_frame_start = t_start;
+
+    // the frame slot is free again when the GPU finished the submission made N frames ago
+    vkWaitForFences(_vk_device, 1, &frame.in_flight, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    _deferred_releases.run(_frame_counter);
+    _upload_ring->begin_frame(_frame_idx);
+    _cmd_pools->begin_frame(_frame_idx);
+    _descriptors->begin_frame(_frame_idx);
+
+    uint32_t image_idx{0};
+    VkResult r{VK_SUCCESS};
+    if (_headless) {
+        // offscreen images are used round robin
+        image_idx = static_cast<uint32_t>(_frame_counter % _vk_swap_chain_images.size());
+    }
+    else {
+        r = vkAcquireNextImageKHR(_vk_device, _vk_swap_chain, std::numeric_limits<uint64_t>::max(),
+                frame.image_available, VK_NULL_HANDLE, &image_idx);
+    }
+    if (VK_ERROR_OUT_OF_DATE_KHR == r) {
+        // nothing acquired, image_available stays unsignaled and the frame slot's fence untouched
+        recreate_swap_chain();
+        return;
+    }
+    if (VK_SUCCESS != r && VK_SUBOPTIMAL_KHR != r) {
+        throw vlk::vulkan_exception{"unable to acquire swap chain image", r};
+    }
+
+    // with more swap chain images than frames in flight an image may still be used by another frame slot
+    if (VK_NULL_HANDLE != _images_in_flight[image_idx] && frame.in_flight != _images_in_flight[image_idx]) {
+        vkWaitForFences(_vk_device, 1, &_images_in_flight[image_idx], VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
+    _images_in_flight[image_idx] = frame.in_flight;
+    auto const frame_image = _vk_swap_chain_images[image_idx];
+    if (!_headless) {
+        // the submission waits for image_available at this stage, the presentation engine's reads are finished then
+        _barriers->track(frame_image, _barriers->image_state(frame_image).layout,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0);
+    }
+    auto const t_acquired = frame_clock::now();
+    _frame_stats.record(frame_phase::acquire, t_acquired - t_start);
+
+    // compute work is submitted first, the graphics submission waits for it at the stage consuming the results
+    VkPipelineStageFlags compute_wait_stage{0};
+    VkSemaphore compute_finished{VK_NULL_HANDLE};
+    if (has_compute()) {
+        compute_wait_stage = record_compute(_async_compute->begin(_frame_idx));
+        if (0 != compute_wait_stage) {
+            compute_finished = _async_compute->submit(_frame_idx);
+        }
+    }
+
+    VkCommandBufferBeginInfo bi{};
+    bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    bi.pNext = nullptr;
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    bi.pInheritanceInfo = nullptr;
+
+    // defragmentation copies go first into the upload command buffer: the relocation callbacks run before
+    // record_frame(), so copies queued there may target moved resources and have to follow the old -> new copies
+    vkResetCommandBuffer(frame.upload_cmd, 0);
+    r = vkBeginCommandBuffer(frame.upload_cmd, &bi);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to begin upload command buffer", r};
+    }
+    uint32_t moved{0};
+    if (_defragmentation) {
+        moved = _defragmenter->step(frame.upload_cmd,
+                                    [this](std::function<void()> fn) { defer_release(std::move(fn)); },
+                                    _defrag_budget);
+    }
+
+    vkResetCommandBuffer(frame.cmd, 0);
+    r = vkBeginCommandBuffer(frame.cmd, &bi);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to begin frame command buffer", r};
+    }
+    _gpu_profiler->begin_frame(_frame_idx, frame.cmd);
+    _upload_scheduler->update(frame.cmd);
+    {
+        vlk::gpu_profiler::scoped_zone zone{*_gpu_profiler, frame.cmd, "frame"};
+        record_frame(frame.cmd, image_idx);
+    }
+    VkImageSubresourceRange color_range{};
+    color_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    color_range.baseMipLevel = 0U;
+    color_range.levelCount = 1U;
+    color_range.baseArrayLayer = 0U;
+    color_range.layerCount = 1U;
+    _barriers->image(frame_image, color_range, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, frame_final_layout());
+    _barriers->flush(frame.cmd);
+    r = vkEndCommandBuffer(frame.cmd);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to record frame command buffer", r};
+    }
+
+    // copies queued while recording the frame are executed after the defragmentation's copies, whose final
+    // barrier orders them before any later transfer, and before the frame's commands
+    std::array<VkCommandBuffer, 2> cmds{frame.upload_cmd, frame.cmd};
+    auto const has_uploads = 0U != moved || _upload_ring->has_pending_copies();
+    _upload_ring->record(frame.upload_cmd);
+    r = vkEndCommandBuffer(frame.upload_cmd);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to record upload command buffer", r};
+    }
+    auto const t_recorded = frame_clock::now();
+    _frame_stats.record(frame_phase::record, t_recorded - t_acquired);
+
+    std::array<VkSemaphore, 2> wait_semaphores{};
+    std::array<VkPipelineStageFlags, 2> wait_stages{};
+    uint32_t wait_count{0};
+    if (!_headless) {
+        wait_semaphores[wait_count] = frame.image_available;
+        wait_stages[wait_count++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    }
+    if (VK_NULL_HANDLE != compute_finished) {
+        wait_semaphores[wait_count] = compute_finished;
+        wait_stages[wait_count++] = compute_wait_stage;
+    }
+    VkSubmitInfo si{};
+    si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    si.pNext = nullptr;
+    si.waitSemaphoreCount = wait_count;
+    si.pWaitSemaphores = wait_semaphores.data();
+    si.pWaitDstStageMask = wait_stages.data();
+    si.commandBufferCount = has_uploads ? 2U : 1U;
+    si.pCommandBuffers = has_uploads ? cmds.data() : &cmds[1];
+    si.signalSemaphoreCount = _headless ? 0U : 1U;
+    si.pSignalSemaphores = &frame.render_finished;
+
+    // reset only directly before the submit so an exception above doesn't leave an unsignaled fence behind
+    vkResetFences(_vk_device, 1, &frame.in_flight);
+    r = vkQueueSubmit(_vk_queue_gfx, 1, &si, frame.in_flight);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to submit frame command buffer", r};
+    }
+    auto const t_submitted = frame_clock::now();
+    _frame_stats.record(frame_phase::submit, t_submitted - t_recorded);
+
+    if (_headless) {
+        ++_frame_counter;
+        _frame_idx = (_frame_idx + 1) % _frames_in_flight;
+        if (_present_policy.load() != _swap_chain_policy) {
+            recreate_offscreen_images();
+        }
+        return;
+    }
+
+    VkPresentInfoKHR pi{};
+    pi.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    pi.pNext = nullptr;
+    pi.waitSemaphoreCount = 1;
+    pi.pWaitSemaphores = &frame.render_finished;
+    pi.swapchainCount = 1;
+    pi.pSwapchains = &_vk_swap_chain;
+    pi.pImageIndices = &image_idx;
+    pi.pResults = nullptr;
+    r = vkQueuePresentKHR(_vk_queue_pres, &pi);
+    auto const t_presented = frame_clock::now();
+    _frame_stats.record(frame_phase::present, t_presented - t_submitted);
+    if (frame_clock::time_point{} != _last_present) {
+        _present_intervals[static_cast<size_t>(_swap_chain_policy)].record(t_presented - _last_present);
+    }
+    _last_present = t_presented;
+    ++_frame_counter;
+    _frame_idx = (_frame_idx + 1) % _frames_in_flight;
+    if (VK_ERROR_OUT_OF_DATE_KHR == r || VK_SUBOPTIMAL_KHR == r || _framebuffer_resized
+        || _present_policy.load() != _swap_chain_policy) {
+        recreate_swap_chain();
+    }
+    else if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to present swap chain image", r};
+    }
+}
+
+void application::recreate_swap_chain()
+{
+    int w{0}, h{0};
+    glfwGetFramebufferSize(_window, &w, &h);
+    while (0 == w || 0 == h) {
+        // minimized window - no swap chain possible with zero extent
+        if (glfwWindowShouldClose(_window)) {
+            return;
+        }
+        glfwWaitEvents();
+        glfwGetFramebufferSize(_window, &w, &h);
+    }
+    _framebuffer_resized = false;
+
+    // the old swap chain is handed over to the new one and released when its frames are finished
+    auto old_swap_chain = _vk_swap_chain;
+    auto old_views = std::move(_vk_swap_chain_img_views);
+    _vk_swap_chain = VK_NULL_HANDLE;
+    _vk_swap_chain_img_views.clear();
+    for (auto const& img : _vk_swap_chain_images) {
+        _barriers->forget(img);
+    }
+    _vk_swap_chain_images.clear();
+    // the frames up to _frame_counter - 1 use the old images, the next one records with the new ones
+    _deferred_releases.push(_frame_counter, [this, old_swap_chain, old_views]() {
+        for (auto const& iv : old_views) {
+            vkDestroyImageView(_vk_device, iv, nullptr);
+        }
+        vkDestroySwapchainKHR(_vk_device, old_swap_chain, nullptr);
+    });
+
+    create_swap_chain(old_swap_chain);
+    create_image_views();
+    _images_in_flight.assign(_vk_swap_chain_images.size(), VK_NULL_HANDLE);
+    on_swap_chain_recreated();
+}
+
+void application::recreate_offscreen_images()
+{
+    // like the swap chain images the old ones are released when their frames are finished
+    auto old_views = std::move(_vk_swap_chain_img_views);
+    auto old_images = std::move(_vk_swap_chain_images);
+    auto old_memory = std::move(_offscreen_memory);
+    _vk_swap_chain_img_views.clear();
+    _vk_swap_chain_images.clear();
+    _offscreen_memory.clear();
+    for (auto const& img : old_images) {
+        _barriers->forget(img);
+    }
+    _deferred_releases.push(_frame_counter, [this, old_views, old_images, old_memory]() mutable {
+        for (auto const& iv : old_views) {
+            vkDestroyImageView(_vk_device, iv, nullptr);
+        }
+        for (auto const& img : old_images) {
+            vkDestroyImage(_vk_device, img, nullptr);
+        }
+        for (auto& mem : old_memory) {
+            _allocator->free(mem);
+        }
+    });
+
+    create_offscreen_images();
+    create_image_views();
+    _images_in_flight.assign(_vk_swap_chain_images.size(), VK_NULL_HANDLE);
+    on_swap_chain_recreated();
+}
+
+void application::on_swap_chain_recreated()
+{}
+
+void application::defer_release(std::function<void()> fn)
+{
+    // called while frame _frame_counter is recorded (or, after a swap chain re-creation, before the next frame is
+    // recorded), the resource may be used by that frame
+    _deferred_releases.push(_frame_counter + 1U, std::move(fn));
+}
+
+bool application::has_compute() const
+{
+    return false;
+}
+
+VkPipelineStageFlags application::record_compute(VkCommandBuffer)
+{
+    return 0;
+}
+
+void application::record_frame(VkCommandBuffer, uint32_t)
+{}
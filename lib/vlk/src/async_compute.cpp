@@ -0,0 +1,131 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/async_compute.h>
+#include <vlk/exception.h>
+#include <vlk/final.h>
+
+#include <cassert>
+
+using namespace vlk;
+
+async_compute::async_compute(VkDevice device, uint32_t queue_family_index, VkQueue queue, uint32_t frames_in_flight)
+    : _device{device}
+    , _qfi{queue_family_index}
+    , _queue{queue}
+{
+    vlk::final exception_cleanup{[this]() { release(); }};
+
+    VkCommandPoolCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    ci.pNext = nullptr;
+    ci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    ci.queueFamilyIndex = _qfi;
+    auto r = vkCreateCommandPool(_device, &ci, nullptr, &_pool);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to create compute command pool", r};
+    }
+
+    _slots.resize(frames_in_flight);
+    std::vector<VkCommandBuffer> cmds{frames_in_flight};
+    VkCommandBufferAllocateInfo ai{};
+    ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    ai.pNext = nullptr;
+    ai.commandPool = _pool;
+    ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    ai.commandBufferCount = frames_in_flight;
+    r = vkAllocateCommandBuffers(_device, &ai, cmds.data());
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to allocate compute command buffers", r};
+    }
+
+    VkSemaphoreCreateInfo sci{};
+    sci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    sci.pNext = nullptr;
+    sci.flags = 0;
+    for (uint32_t i = 0; i < frames_in_flight; ++i) {
+        _slots[i].cmd = cmds[i];
+        r = vkCreateSemaphore(_device, &sci, nullptr, &_slots[i].finished);
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to create semaphore", r};
+        }
+    }
+    exception_cleanup.reset();
+}
+
+async_compute::~async_compute()
+{
+    release();
+}
+
+void async_compute::release() noexcept
+{
+    for (auto const& s : _slots) {
+        if (VK_NULL_HANDLE != s.finished) {
+            vkDestroySemaphore(_device, s.finished, nullptr);
+        }
+    }
+    _slots.clear();
+    if (VK_NULL_HANDLE != _pool) {
+        vkDestroyCommandPool(_device, _pool, nullptr);
+        _pool = VK_NULL_HANDLE;
+    }
+}
+
+VkCommandBuffer async_compute::begin(uint32_t frame_index)
+{
+    assert(frame_index < _slots.size());
+    auto cmd = _slots[frame_index].cmd;
+    vkResetCommandBuffer(cmd, 0);
+    VkCommandBufferBeginInfo bi{};
+    bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    bi.pNext = nullptr;
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    bi.pInheritanceInfo = nullptr;
+    auto r = vkBeginCommandBuffer(cmd, &bi);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to begin compute command buffer", r};
+    }
+    return cmd;
+}
+
+VkSemaphore async_compute::submit(uint32_t frame_index)
+{
+    assert(frame_index < _slots.size());
+    auto const& s = _slots[frame_index];
+    auto r = vkEndCommandBuffer(s.cmd);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to record compute command buffer", r};
+    }
+    VkSubmitInfo si{};
+    si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    si.pNext = nullptr;
+    si.waitSemaphoreCount = 0;
+    si.pWaitSemaphores = nullptr;
+    si.pWaitDstStageMask = nullptr;
+    si.commandBufferCount = 1U;
+    si.pCommandBuffers = &s.cmd;
+    si.signalSemaphoreCount = 1U;
+    si.pSignalSemaphores = &s.finished;
+    r = vkQueueSubmit(_queue, 1U, &si, VK_NULL_HANDLE);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to submit compute command buffer", r};
+    }
+    return s.finished;
+}
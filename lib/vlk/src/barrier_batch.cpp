@@ -0,0 +1,340 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/barrier_batch.h>
+
+#include <algorithm>
+
+using namespace vlk;
+
+namespace {
+
+    constexpr VkAccessFlags write_access_mask{VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+            | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT
+            | VK_ACCESS_MEMORY_WRITE_BIT};
+
+    bool same_range(VkImageSubresourceRange const& l, VkImageSubresourceRange const& r)
+    {
+        return l.aspectMask == r.aspectMask && l.baseMipLevel == r.baseMipLevel && l.levelCount == r.levelCount
+               && l.baseArrayLayer == r.baseArrayLayer && l.layerCount == r.layerCount;
+    }
+
+    //! Smallest [base, base + count) covering both, VK_REMAINING_* stays open ended.
+    void widen(uint32_t& base, uint32_t& count, uint32_t other_base, uint32_t other_count, uint32_t remaining)
+    {
+        auto const new_base = std::min(base, other_base);
+        if (remaining == count || remaining == other_count) {
+            count = remaining;
+        }
+        else {
+            count = std::max(base + count, other_base + other_count) - new_base;
+        }
+        base = new_base;
+    }
+
+}
+
+barrier_batch::barrier_batch(VkDevice device, bool synchronization2)
+    : _cmd_pipeline_barrier{vkCmdPipelineBarrier}
+{
+#ifdef VK_KHR_synchronization2
+    if (synchronization2 && VK_NULL_HANDLE != device) {
+        _cmd_pipeline_barrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(
+                vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR"));
+    }
+#else
+    (void)device;
+    (void)synchronization2;
+#endif
+}
+
+barrier_batch::barrier_batch(PFN_vkCmdPipelineBarrier cmd_pipeline_barrier)
+    : _cmd_pipeline_barrier{cmd_pipeline_barrier}
+{}
+
+bool barrier_batch::uses_synchronization2() const
+{
+#ifdef VK_KHR_synchronization2
+    return nullptr != _cmd_pipeline_barrier2;
+#else
+    return false;
+#endif
+}
+
+bool barrier_batch::next_use(state& s, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout,
+                             barrier& b)
+{
+    b.old_layout = s.layout;
+    b.new_layout = layout;
+    b.dst_stages = stages;
+    b.dst_access = access;
+    if (0 == (access & write_access_mask) && layout == s.layout) {
+        // read: only the last write has to be finished and visible
+        s.read_stages |= stages;
+        if (stages == (stages & s.visible_stages) && access == (access & s.visible_access)) {
+            return false;
+        }
+        b.src_stages = s.write_stages;
+        b.src_access = s.write_access;
+        s.visible_stages |= stages;
+        s.visible_access |= access;
+        return true;
+    }
+    // write or layout transition: wait for everything since the last write as well
+    b.src_stages = s.write_stages | s.read_stages;
+    b.src_access = s.write_access;
+    s.layout = layout;
+    s.write_stages = stages;
+    s.write_access = access & write_access_mask;
+    s.read_stages = 0 == (access & ~write_access_mask) ? 0 : stages;
+    s.visible_stages = stages;
+    s.visible_access = access;
+    return true;
+}
+
+void barrier_batch::merge(barrier& pending, barrier const& b)
+{
+    // the pending barrier has to wait for everything the merged one waits for, e.g. reads flushed before the
+    // pending one when b is a write
+    pending.src_stages |= b.src_stages;
+    pending.src_access |= b.src_access;
+    // nothing is recorded between the two, the intermediate use never happens
+    if (pending.new_layout == b.new_layout && 0 == (b.dst_access & write_access_mask)
+        && 0 == (pending.dst_access & write_access_mask)) {
+        pending.dst_stages |= b.dst_stages;
+        pending.dst_access |= b.dst_access;
+    }
+    else {
+        pending.dst_stages = b.dst_stages;
+        pending.dst_access = b.dst_access;
+    }
+    pending.new_layout = b.new_layout;
+}
+
+void barrier_batch::image(VkImage image, VkImageSubresourceRange const& range, VkPipelineStageFlags stages,
+                          VkAccessFlags access, VkImageLayout layout, bool discard)
+{
+    auto& s = _image_states[image];
+    if (discard) {
+        s.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+    barrier b{};
+    auto const needed = next_use(s, stages, access, layout, b);
+    auto it = _pending_images.find(image);
+    if (_pending_images.end() != it) {
+        auto& pending = _images[it->second];
+        if (same_range(pending.range, range)) {
+            if (discard) {
+                pending.b.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            }
+        }
+        else {
+            // the state is tracked per image: the pending barrier has to cover range as well, even when the state
+            // needs no further barrier. The content of the other range is kept.
+            pending.range.aspectMask |= range.aspectMask;
+            widen(pending.range.baseMipLevel, pending.range.levelCount, range.baseMipLevel, range.levelCount,
+                  VK_REMAINING_MIP_LEVELS);
+            widen(pending.range.baseArrayLayer, pending.range.layerCount, range.baseArrayLayer, range.layerCount,
+                  VK_REMAINING_ARRAY_LAYERS);
+        }
+        if (needed) {
+            merge(pending.b, b);
+        }
+        return;
+    }
+    if (!needed) {
+        return;
+    }
+    _pending_images.emplace(image, _images.size());
+    _images.push_back(image_barrier{image, range, b});
+}
+
+void barrier_batch::buffer(VkBuffer buffer, VkPipelineStageFlags stages, VkAccessFlags access)
+{
+    auto& s = _buffer_states[buffer];
+    barrier b{};
+    if (!next_use(s, stages, access, VK_IMAGE_LAYOUT_UNDEFINED, b)) {
+        return;
+    }
+    auto it = _pending_buffers.find(buffer);
+    if (_pending_buffers.end() != it) {
+        merge(_buffers[it->second].b, b);
+        return;
+    }
+    _pending_buffers.emplace(buffer, _buffers.size());
+    _buffers.push_back(buffer_barrier{buffer, b});
+}
+
+void barrier_batch::track(VkImage image, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access)
+{
+    state s{};
+    s.layout = layout;
+    s.write_stages = stages;
+    s.write_access = access & write_access_mask;
+    _image_states[image] = s;
+}
+
+void barrier_batch::track(VkBuffer buffer, VkPipelineStageFlags stages, VkAccessFlags access)
+{
+    state s{};
+    s.write_stages = stages;
+    s.write_access = access & write_access_mask;
+    _buffer_states[buffer] = s;
+}
+
+void barrier_batch::forget(VkImage image)
+{
+    _image_states.erase(image);
+}
+
+void barrier_batch::forget(VkBuffer buffer)
+{
+    _buffer_states.erase(buffer);
+}
+
+barrier_batch::state barrier_batch::image_state(VkImage image) const
+{
+    auto it = _image_states.find(image);
+    return _image_states.end() != it ? it->second : state{};
+}
+
+barrier_batch::state barrier_batch::buffer_state(VkBuffer buffer) const
+{
+    auto it = _buffer_states.find(buffer);
+    return _buffer_states.end() != it ? it->second : state{};
+}
+
+void barrier_batch::flush(VkCommandBuffer cmd)
+{
+    if (empty()) {
+        return;
+    }
+    if (uses_synchronization2()) {
+        flush_v2(cmd);
+    }
+    else {
+        flush_v1(cmd);
+    }
+    _images.clear();
+    _buffers.clear();
+    _pending_images.clear();
+    _pending_buffers.clear();
+}
+
+void barrier_batch::flush_v1(VkCommandBuffer cmd)
+{
+    VkPipelineStageFlags src_stages{0};
+    VkPipelineStageFlags dst_stages{0};
+    std::vector<VkImageMemoryBarrier> image_barriers(_images.size());
+    for (size_t i = 0; i < _images.size(); ++i) {
+        auto const& ib = _images[i];
+        auto& b = image_barriers[i];
+        b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        b.pNext = nullptr;
+        b.srcAccessMask = ib.b.src_access;
+        b.dstAccessMask = ib.b.dst_access;
+        b.oldLayout = ib.b.old_layout;
+        b.newLayout = ib.b.new_layout;
+        b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.image = ib.image;
+        b.subresourceRange = ib.range;
+        src_stages |= ib.b.src_stages;
+        dst_stages |= ib.b.dst_stages;
+    }
+    std::vector<VkBufferMemoryBarrier> buffer_barriers(_buffers.size());
+    for (size_t i = 0; i < _buffers.size(); ++i) {
+        auto const& bb = _buffers[i];
+        auto& b = buffer_barriers[i];
+        b.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        b.pNext = nullptr;
+        b.srcAccessMask = bb.b.src_access;
+        b.dstAccessMask = bb.b.dst_access;
+        b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.buffer = bb.buffer;
+        b.offset = 0;
+        b.size = VK_WHOLE_SIZE;
+        src_stages |= bb.b.src_stages;
+        dst_stages |= bb.b.dst_stages;
+    }
+    // stage masks must not be empty before synchronization2
+    if (0 == src_stages) {
+        src_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    }
+    if (0 == dst_stages) {
+        dst_stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    }
+    _cmd_pipeline_barrier(cmd, src_stages, dst_stages, 0, 0, nullptr,
+                          static_cast<uint32_t>(buffer_barriers.size()), buffer_barriers.data(),
+                          static_cast<uint32_t>(image_barriers.size()), image_barriers.data());
+}
+
+void barrier_batch::flush_v2(VkCommandBuffer cmd)
+{
+#ifdef VK_KHR_synchronization2
+    // the synchronization2 flags are a superset of the original ones with the same bit values
+    std::vector<VkImageMemoryBarrier2KHR> image_barriers(_images.size());
+    for (size_t i = 0; i < _images.size(); ++i) {
+        auto const& ib = _images[i];
+        auto& b = image_barriers[i];
+        b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+        b.pNext = nullptr;
+        b.srcStageMask = ib.b.src_stages;
+        b.srcAccessMask = ib.b.src_access;
+        b.dstStageMask = ib.b.dst_stages;
+        b.dstAccessMask = ib.b.dst_access;
+        b.oldLayout = ib.b.old_layout;
+        b.newLayout = ib.b.new_layout;
+        b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.image = ib.image;
+        b.subresourceRange = ib.range;
+    }
+    std::vector<VkBufferMemoryBarrier2KHR> buffer_barriers(_buffers.size());
+    for (size_t i = 0; i < _buffers.size(); ++i) {
+        auto const& bb = _buffers[i];
+        auto& b = buffer_barriers[i];
+        b.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+        b.pNext = nullptr;
+        b.srcStageMask = bb.b.src_stages;
+        b.srcAccessMask = bb.b.src_access;
+        b.dstStageMask = bb.b.dst_stages;
+        b.dstAccessMask = bb.b.dst_access;
+        b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.buffer = bb.buffer;
+        b.offset = 0;
+        b.size = VK_WHOLE_SIZE;
+    }
+    VkDependencyInfoKHR di{};
+    di.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+    di.pNext = nullptr;
+    di.dependencyFlags = 0;
+    di.memoryBarrierCount = 0;
+    di.pMemoryBarriers = nullptr;
+    di.bufferMemoryBarrierCount = static_cast<uint32_t>(buffer_barriers.size());
+    di.pBufferMemoryBarriers = buffer_barriers.data();
+    di.imageMemoryBarrierCount = static_cast<uint32_t>(image_barriers.size());
+    di.pImageMemoryBarriers = image_barriers.data();
+    _cmd_pipeline_barrier2(cmd, &di);
+#else
+    flush_v1(cmd);
+#endif
+}
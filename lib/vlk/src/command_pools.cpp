@@ -0,0 +1,158 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/command_pools.h>
+#include <vlk/exception.h>
+#include <vlk/final.h>
+
+#include <algorithm>
+#include <cassert>
+
+using namespace vlk;
+
+command_pools::command_pools(VkDevice device, uint32_t queue_family_index, uint32_t frames_in_flight,
+                             job_system& jobs)
+    : _device{device}
+    , _jobs{jobs}
+    , _thread_count{jobs.thread_count()}
+{
+    vlk::final exception_cleanup{[this]() { release(); }};
+
+    VkCommandPoolCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    ci.pNext = nullptr;
+    ci.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    ci.queueFamilyIndex = queue_family_index;
+    _pools.resize(frames_in_flight * _thread_count);
+    for (auto& p : _pools) {
+        auto r = vkCreateCommandPool(_device, &ci, nullptr, &p.pool);
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to create command pool", r};
+        }
+    }
+    exception_cleanup.reset();
+}
+
+command_pools::~command_pools()
+{
+    release();
+}
+
+void command_pools::release() noexcept
+{
+    // destroying a pool frees its command buffers
+    for (auto& p : _pools) {
+        if (VK_NULL_HANDLE != p.pool) {
+            vkDestroyCommandPool(_device, p.pool, nullptr);
+        }
+    }
+    _pools.clear();
+}
+
+void command_pools::begin_frame(uint32_t frame_index)
+{
+    assert(frame_index * _thread_count < _pools.size());
+    _frame_idx = frame_index;
+    for (uint32_t t = 0; t < _thread_count; ++t) {
+        auto& p = thread_pool(t);
+        auto r = vkResetCommandPool(_device, p.pool, 0);
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to reset command pool", r};
+        }
+        p.used[0] = 0;
+        p.used[1] = 0;
+    }
+}
+
+VkCommandBuffer command_pools::allocate(uint32_t thread_index, VkCommandBufferLevel level)
+{
+    assert(thread_index < _thread_count);
+    auto& p = thread_pool(thread_index);
+    auto const l = VK_COMMAND_BUFFER_LEVEL_PRIMARY == level ? 0U : 1U;
+    if (p.used[l] == p.buffers[l].size()) {
+        VkCommandBufferAllocateInfo ai{};
+        ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        ai.pNext = nullptr;
+        ai.commandPool = p.pool;
+        ai.level = level;
+        ai.commandBufferCount = 1U;
+        VkCommandBuffer cmd{VK_NULL_HANDLE};
+        auto r = vkAllocateCommandBuffers(_device, &ai, &cmd);
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to allocate command buffer", r};
+        }
+        p.buffers[l].push_back(cmd);
+    }
+    return p.buffers[l][p.used[l]++];
+}
+
+void command_pools::record_parallel(VkCommandBuffer primary, VkCommandBufferInheritanceInfo const& inheritance,
+                                    uint32_t item_count, record_fn const& fn, uint32_t min_items_per_chunk)
+{
+    if (0 == item_count) {
+        return;
+    }
+    auto const max_chunks = std::min(_thread_count,
+            std::max(1U, (item_count + min_items_per_chunk - 1U) / std::max(1U, min_items_per_chunk)));
+    auto const chunk_size = (item_count + max_chunks - 1U) / max_chunks;
+    // the rounded up chunk size may need fewer chunks, e.g. 5 items in 4 chunks of 2 leave the last one empty
+    auto const chunk_count = (item_count + chunk_size - 1U) / chunk_size;
+
+    // chunk i is recorded with the pool of thread index i, i.e. each pool is used by exactly one job no matter which
+    // thread executes it
+    std::vector<VkCommandBuffer> secondaries(chunk_count);
+    for (uint32_t i = 0; i < chunk_count; ++i) {
+        secondaries[i] = allocate(i, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+    }
+    auto record = [&](uint32_t chunk) {
+        VkCommandBufferBeginInfo bi{};
+        bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        bi.pNext = nullptr;
+        bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (VK_NULL_HANDLE != inheritance.renderPass) {
+            bi.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        }
+        bi.pInheritanceInfo = &inheritance;
+        auto r = vkBeginCommandBuffer(secondaries[chunk], &bi);
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to begin secondary command buffer", r};
+        }
+        auto const begin = chunk * chunk_size;
+        fn(secondaries[chunk], begin, std::min(item_count, begin + chunk_size));
+        r = vkEndCommandBuffer(secondaries[chunk]);
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to record secondary command buffer", r};
+        }
+    };
+
+    job_system::counter recorded{};
+    for (uint32_t i = 1; i < chunk_count; ++i) {
+        _jobs.run([&record, i]() { record(i); }, &recorded);
+    }
+    try {
+        record(0);
+    }
+    catch (...) {
+        // the other chunks reference this frame
+        _jobs.wait(recorded);
+        throw;
+    }
+    _jobs.wait(recorded);
+    vkCmdExecuteCommands(primary, chunk_count, secondaries.data());
+}
@@ -68,7 +68,7 @@
 #else
 #define DBG_PRINT_GLFW_VERSION()
 #define DBG_PRINT_CHAR_VEC(msg, vec)
-#define DBG_PRINT_PHYS_DEVICES(msg, vec)
+#define DBG_PRINT_PHYS_DEVICES(msg, vec, surface)
 #define DBG_PRINT_DEVICE_EXTENSIONS(msg, vec)
 #define DBG_PRINT_SWAP_CHAIN_PROPERTIES(msg, sps)
 #endif
@@ -0,0 +1,171 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/debug_messenger.h>
+#include <vlk/exception.h>
+
+#include "vulkan-bindings.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace vlk;
+
+namespace {
+
+    //! Validation messages share id 0 when the layer has no number for them, their names still differ.
+    uint64_t message_key(int32_t id, char const* id_name)
+    {
+        uint32_t h{2166136261U};
+        for (auto const* p = id_name; nullptr != p && '\0' != *p; ++p) {
+            h = (h ^ static_cast<uint8_t>(*p)) * 16777619U;
+        }
+        return (static_cast<uint64_t>(static_cast<uint32_t>(id)) << 32U) | h;
+    }
+
+}
+
+debug_message_filter::verdict debug_message_filter::filter(int32_t id, char const* id_name, clock::time_point now)
+{
+    auto const key = message_key(id, id_name);
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto i = _entries.find(key);
+    if (_entries.end() == i) {
+        // the first message passes even without burst
+        i = _entries.emplace(key, entry{id, id_name ? id_name : "", 0, 0, 0, now - _limits.interval}).first;
+    }
+    auto& e = i->second;
+    ++e.count;
+    if (e.count <= _limits.burst || now - e.last_pass >= _limits.interval) {
+        verdict const v{true, e.suppressed_since_pass};
+        e.suppressed_since_pass = 0;
+        e.last_pass = now;
+        return v;
+    }
+    ++e.suppressed;
+    ++e.suppressed_since_pass;
+    return verdict{false, 0};
+}
+
+std::vector<debug_message_filter::id_stats> debug_message_filter::stats() const
+{
+    std::vector<id_stats> r{};
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        r.reserve(_entries.size());
+        for (auto const& [key, e] : _entries) {
+            r.push_back(id_stats{e.id, e.name, e.count, e.suppressed});
+        }
+    }
+    std::sort(r.begin(), r.end(), [](id_stats const& a, id_stats const& b) {
+        return a.count != b.count ? a.count > b.count : a.name < b.name;
+    });
+    return r;
+}
+
+debug_messenger::debug_messenger(VkDebugUtilsMessageSeverityFlagsEXT severities,
+                                 VkDebugUtilsMessageTypeFlagsEXT types, handler fn, debug_message_limits l)
+    : _handler{std::move(fn)}
+    , _filter{l}
+{
+    _create_info.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+    _create_info.pNext = nullptr;
+    _create_info.flags = 0;
+    _create_info.messageSeverity = severities;
+    _create_info.messageType = types;
+    _create_info.pfnUserCallback = &debug_messenger::callback;
+    _create_info.pUserData = static_cast<void*>(this);
+}
+
+debug_messenger::debug_messenger(VkInstance instance, VkDebugUtilsMessageSeverityFlagsEXT severities,
+                                 VkDebugUtilsMessageTypeFlagsEXT types, handler fn, debug_message_limits l)
+    : debug_messenger{severities, types, std::move(fn), l}
+{
+    attach(instance);
+}
+
+debug_messenger::~debug_messenger()
+{
+    detach();
+}
+
+void debug_messenger::attach(VkInstance instance)
+{
+    detach();
+    auto const r = vlk::createDebugUtilsMessengerEXT(instance, &_create_info, nullptr, &_messenger);
+    if (VK_SUCCESS != r) {
+        _messenger = VK_NULL_HANDLE;
+        throw vlk::vulkan_exception{"Unable to create debug utils messenger", r};
+    }
+    _instance = instance;
+}
+
+void debug_messenger::detach() noexcept
+{
+    if (VK_NULL_HANDLE != _messenger) {
+        vlk::destroyDebugUtilsMessengerEXT(_instance, _messenger, nullptr);
+        _messenger = VK_NULL_HANDLE;
+    }
+    _instance = VK_NULL_HANDLE;
+}
+
+void debug_messenger::set_object_name(VkDevice device, VkObjectType type, uint64_t handle, char const* name) const
+{
+    VkDebugUtilsObjectNameInfoEXT ni{};
+    ni.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+    ni.pNext = nullptr;
+    ni.objectType = type;
+    ni.objectHandle = handle;
+    ni.pObjectName = name;
+    // names are a debugging aid, a failure is not worth an exception
+    vlk::setDebugUtilsObjectNameEXT(_instance, device, &ni);
+}
+
+void debug_messenger::submit(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types,
+                             char const* message) const
+{
+    VkDebugUtilsMessengerCallbackDataEXT data{};
+    data.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CALLBACK_DATA_EXT;
+    data.pMessageIdName = "vlk";
+    data.pMessage = message;
+    vlk::submitDebugUtilsMessageEXT(_instance, severity, types, &data);
+}
+
+VkBool32 debug_messenger::callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                                   VkDebugUtilsMessageTypeFlagsEXT types,
+                                   VkDebugUtilsMessengerCallbackDataEXT const* data,
+                                   void* user_data)
+{
+    auto* self = static_cast<debug_messenger*>(user_data);
+    if (nullptr == self || nullptr == data) {
+        return VK_FALSE;
+    }
+    auto const v = self->_filter.filter(data->messageIdNumber, data->pMessageIdName,
+                                        debug_message_filter::clock::now());
+    if (v.pass && self->_handler) {
+        try {
+            self->_handler(severity, types, *data, v.suppressed);
+        }
+        catch (...) {
+            // exceptions must not unwind through the Vulkan loader
+        }
+    }
+    // VK_TRUE would abort the Vulkan call which triggered the message
+    return VK_FALSE;
+}
@@ -0,0 +1,298 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/descriptor_allocator.h>
+#include <vlk/exception.h>
+#include <vlk/final.h>
+#include <vlk/log.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+using namespace vlk;
+
+namespace {
+
+    constexpr uint32_t max_sets_per_pool{4096U};
+
+    template<typename Tp>
+    void hash_combine(size_t& seed, Tp const& v)
+    {
+        seed ^= std::hash<Tp>{}(v) + 0x9e3779b97f4a7c15ULL + (seed << 6U) + (seed >> 2U);
+    }
+
+}
+
+descriptor_set_desc& descriptor_set_desc::add(entry const& e)
+{
+    // bindings may be given in any order, they are kept sorted so equal contents compare equal
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), e.binding,
+                               [](entry const& a, uint32_t b) { return a.binding < b; });
+    if (_entries.end() != it && it->binding == e.binding) {
+        *it = e;
+    }
+    else {
+        _entries.insert(it, e);
+    }
+    _hash = 0;
+    for (auto const& x : _entries) {
+        hash_combine(_hash, x.binding);
+        hash_combine(_hash, static_cast<uint32_t>(x.type));
+        hash_combine(_hash, static_cast<void const*>(x.buffer_info.buffer));
+        hash_combine(_hash, x.buffer_info.offset);
+        hash_combine(_hash, x.buffer_info.range);
+        hash_combine(_hash, static_cast<void const*>(x.image_info.sampler));
+        hash_combine(_hash, static_cast<void const*>(x.image_info.imageView));
+        hash_combine(_hash, static_cast<uint32_t>(x.image_info.imageLayout));
+        hash_combine(_hash, static_cast<void const*>(x.texel_view));
+    }
+    return *this;
+}
+
+descriptor_set_desc& descriptor_set_desc::buffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer,
+                                                 VkDeviceSize offset, VkDeviceSize range)
+{
+    entry e{};
+    e.binding = binding;
+    e.type = type;
+    e.buffer_info.buffer = buffer;
+    e.buffer_info.offset = offset;
+    e.buffer_info.range = range;
+    return add(e);
+}
+
+descriptor_set_desc& descriptor_set_desc::image(uint32_t binding, VkDescriptorType type, VkImageView view,
+                                                VkImageLayout layout, VkSampler sampler)
+{
+    entry e{};
+    e.binding = binding;
+    e.type = type;
+    e.image_info.sampler = sampler;
+    e.image_info.imageView = view;
+    e.image_info.imageLayout = layout;
+    return add(e);
+}
+
+descriptor_set_desc& descriptor_set_desc::texel_buffer(uint32_t binding, VkDescriptorType type, VkBufferView view)
+{
+    entry e{};
+    e.binding = binding;
+    e.type = type;
+    e.texel_view = view;
+    return add(e);
+}
+
+bool descriptor_set_desc::operator==(descriptor_set_desc const& other) const
+{
+    if (_hash != other._hash || _entries.size() != other._entries.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        auto const& a = _entries[i];
+        auto const& b = other._entries[i];
+        if (a.binding != b.binding || a.type != b.type || a.texel_view != b.texel_view
+            || a.buffer_info.buffer != b.buffer_info.buffer || a.buffer_info.offset != b.buffer_info.offset
+            || a.buffer_info.range != b.buffer_info.range || a.image_info.sampler != b.image_info.sampler
+            || a.image_info.imageView != b.image_info.imageView
+            || a.image_info.imageLayout != b.image_info.imageLayout) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void descriptor_set_desc::write(VkDevice device, VkDescriptorSet set) const
+{
+    std::vector<VkWriteDescriptorSet> writes(_entries.size());
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        auto const& e = _entries[i];
+        auto& w = writes[i];
+        w.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        w.pNext = nullptr;
+        w.dstSet = set;
+        w.dstBinding = e.binding;
+        w.dstArrayElement = 0;
+        w.descriptorCount = 1U;
+        w.descriptorType = e.type;
+        w.pImageInfo = &e.image_info;
+        w.pBufferInfo = &e.buffer_info;
+        w.pTexelBufferView = &e.texel_view;
+    }
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+size_t descriptor_allocator::cache_key_hash::operator()(cache_key const& k) const
+{
+    auto h = k.desc.hash();
+    hash_combine(h, static_cast<void const*>(k.layout));
+    return h;
+}
+
+descriptor_allocator::pool_ratios descriptor_allocator::default_ratios()
+{
+    return {
+        {VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1.0f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f},
+        {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f},
+    };
+}
+
+descriptor_allocator::descriptor_allocator(VkDevice device, uint32_t frames_in_flight, pool_ratios ratios,
+                                           uint32_t initial_sets_per_pool)
+    : _device{device}
+    , _ratios{std::move(ratios)}
+    , _sets_per_pool{std::max(1U, initial_sets_per_pool)}
+    , _frames(frames_in_flight)
+{
+    vlk::final exception_cleanup{[this]() { release(); }};
+    for (auto& f : _frames) {
+        f.pools.push_back(create_pool());
+    }
+    exception_cleanup.reset();
+}
+
+descriptor_allocator::~descriptor_allocator()
+{
+    release();
+}
+
+void descriptor_allocator::release() noexcept
+{
+    // destroying a pool frees its sets
+    for (auto& f : _frames) {
+        for (auto p : f.pools) {
+            vkDestroyDescriptorPool(_device, p, nullptr);
+        }
+        f.pools.clear();
+    }
+}
+
+VkDescriptorPool descriptor_allocator::create_pool()
+{
+    std::vector<VkDescriptorPoolSize> sizes;
+    sizes.reserve(_ratios.size());
+    for (auto const& r : _ratios) {
+        auto const count = static_cast<uint32_t>(std::ceil(r.second * static_cast<float>(_sets_per_pool)));
+        if (0 != count) {
+            sizes.push_back(VkDescriptorPoolSize{r.first, count});
+        }
+    }
+    VkDescriptorPoolCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    ci.pNext = nullptr;
+    ci.flags = 0;
+    ci.maxSets = _sets_per_pool;
+    ci.poolSizeCount = static_cast<uint32_t>(sizes.size());
+    ci.pPoolSizes = sizes.data();
+    VkDescriptorPool pool{VK_NULL_HANDLE};
+    auto r = vkCreateDescriptorPool(_device, &ci, nullptr, &pool);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to create descriptor pool", r};
+    }
+    ++_stats.pools;
+    return pool;
+}
+
+void descriptor_allocator::begin_frame(uint32_t frame_index)
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    assert(frame_index < _frames.size());
+    _frame_idx = frame_index;
+    auto& f = _frames[_frame_idx];
+    for (size_t i = 0; i <= f.current && i < f.pools.size(); ++i) {
+        auto r = vkResetDescriptorPool(_device, f.pools[i], 0);
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to reset descriptor pool", r};
+        }
+    }
+    f.current = 0;
+    f.cache.clear();
+}
+
+VkDescriptorSet descriptor_allocator::allocate_locked(VkDescriptorSetLayout layout)
+{
+    auto& f = _frames[_frame_idx];
+    VkDescriptorSetAllocateInfo ai{};
+    ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    ai.pNext = nullptr;
+    ai.descriptorSetCount = 1U;
+    ai.pSetLayouts = &layout;
+    bool fresh_pool{false};
+    for (;;) {
+        ai.descriptorPool = f.pools[f.current];
+        VkDescriptorSet set{VK_NULL_HANDLE};
+        auto r = vkAllocateDescriptorSets(_device, &ai, &set);
+        if (VK_SUCCESS == r) {
+            ++_stats.allocated;
+            return set;
+        }
+        if ((VK_ERROR_OUT_OF_POOL_MEMORY != r && VK_ERROR_FRAGMENTED_POOL != r) || fresh_pool) {
+            // failing on an empty pool means the layout does not fit into the pool ratios at all
+            throw vlk::vulkan_exception{"unable to allocate descriptor set", r};
+        }
+        // pools behind current are unused since their last reset
+        ++f.current;
+        if (f.current == f.pools.size()) {
+            _sets_per_pool = std::min(max_sets_per_pool, 2U * _sets_per_pool);
+            f.pools.push_back(create_pool());
+            fresh_pool = true;
+            VLK_LOGF_DEBUG("descriptor_allocator: frame slot {} grows to {} pools after {} ({})", _frame_idx,
+                           f.pools.size(), vlk::to_string(r), r);
+        }
+    }
+}
+
+VkDescriptorSet descriptor_allocator::allocate(VkDescriptorSetLayout layout)
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    return allocate_locked(layout);
+}
+
+VkDescriptorSet descriptor_allocator::get(VkDescriptorSetLayout layout, descriptor_set_desc const& desc)
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto& f = _frames[_frame_idx];
+    cache_key key{layout, desc};
+    auto it = f.cache.find(key);
+    if (f.cache.end() != it) {
+        ++_stats.cache_hits;
+        return it->second;
+    }
+    auto set = allocate_locked(layout);
+    desc.write(_device, set);
+    f.cache.emplace(std::move(key), set);
+    return set;
+}
+
+descriptor_allocator::stats descriptor_allocator::get_stats() const
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    return _stats;
+}
@@ -0,0 +1,243 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/frame_stats.h>
+#include <vlk/log.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iomanip>
+
+using namespace vlk;
+
+namespace {
+
+    constexpr double ns_per_ms{1.0e6};
+
+    uint32_t msb(uint64_t v)
+    {
+        assert(0 != v);
+        return 63U - static_cast<uint32_t>(__builtin_clzll(v));
+    }
+
+    template<typename Tp, typename Cmp>
+    void atomic_update(std::atomic<Tp>& target, Tp value, Cmp replace)
+    {
+        auto current = target.load(std::memory_order_relaxed);
+        while (replace(value, current) &&
+               !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+}
+
+uint32_t histogram::bucket_index(uint64_t ns)
+{
+    if (ns < sub_bucket_count) {
+        return static_cast<uint32_t>(ns);
+    }
+    auto const m = msb(ns);
+    if (m >= max_value_bits) {
+        return bucket_count - 1U;
+    }
+    auto const group = m - sub_bucket_bits + 1U;
+    auto const sub = static_cast<uint32_t>(ns >> (m - sub_bucket_bits)) & (sub_bucket_count - 1U);
+    return (group << sub_bucket_bits) + sub;
+}
+
+uint64_t histogram::bucket_upper_bound(uint32_t idx)
+{
+    if (idx < sub_bucket_count) {
+        return idx;
+    }
+    auto const group = idx >> sub_bucket_bits;
+    auto const sub = static_cast<uint64_t>(idx & (sub_bucket_count - 1U));
+    auto const m = group + sub_bucket_bits - 1U;
+    auto const width = uint64_t{1} << (m - sub_bucket_bits);
+    return (uint64_t{1} << m) + sub * width + width - 1U;
+}
+
+void histogram::record(std::chrono::nanoseconds duration)
+{
+    auto const ns = duration.count() < 0 ? uint64_t{0} : static_cast<uint64_t>(duration.count());
+    _buckets[bucket_index(ns)].fetch_add(1U, std::memory_order_relaxed);
+    _count.fetch_add(1U, std::memory_order_relaxed);
+    _sum_ns.fetch_add(ns, std::memory_order_relaxed);
+
+    auto const ms = static_cast<double>(ns) / ns_per_ms;
+    auto sum_sq = _sum_sq_ms2.load(std::memory_order_relaxed);
+    while (!_sum_sq_ms2.compare_exchange_weak(sum_sq, sum_sq + ms * ms, std::memory_order_relaxed)) {
+    }
+    atomic_update(_min_ns, ns, [](uint64_t v, uint64_t cur) { return v < cur; });
+    atomic_update(_max_ns, ns, [](uint64_t v, uint64_t cur) { return v > cur; });
+}
+
+void histogram::reset()
+{
+    for (auto& b : _buckets) {
+        b.store(0U, std::memory_order_relaxed);
+    }
+    _count.store(0U, std::memory_order_relaxed);
+    _sum_ns.store(0U, std::memory_order_relaxed);
+    _sum_sq_ms2.store(0.0, std::memory_order_relaxed);
+    _min_ns.store(UINT64_MAX, std::memory_order_relaxed);
+    _max_ns.store(0U, std::memory_order_relaxed);
+}
+
+uint64_t histogram::count() const
+{
+    return _count.load(std::memory_order_relaxed);
+}
+
+double histogram::percentile_ms(double p) const
+{
+    uint64_t total{0};
+    for (auto const& b : _buckets) {
+        total += b.load(std::memory_order_relaxed);
+    }
+    if (0 == total) {
+        return 0.0;
+    }
+    auto const max_ns = _max_ns.load(std::memory_order_relaxed);
+    if (p >= 100.0) {
+        return static_cast<double>(max_ns) / ns_per_ms;
+    }
+    auto target = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total)));
+    if (0 == target) {
+        target = 1U;
+    }
+    uint64_t cumulated{0};
+    for (uint32_t idx = 0; idx < bucket_count; ++idx) {
+        cumulated += _buckets[idx].load(std::memory_order_relaxed);
+        if (cumulated >= target) {
+            // the bucket's upper bound overestimates, the real maximum is a better estimate for the top bucket
+            auto const ns = std::min(bucket_upper_bound(idx), max_ns);
+            return static_cast<double>(ns) / ns_per_ms;
+        }
+    }
+    return static_cast<double>(max_ns) / ns_per_ms;
+}
+
+double histogram::min_ms() const
+{
+    auto const ns = _min_ns.load(std::memory_order_relaxed);
+    return UINT64_MAX == ns ? 0.0 : static_cast<double>(ns) / ns_per_ms;
+}
+
+double histogram::max_ms() const
+{
+    return static_cast<double>(_max_ns.load(std::memory_order_relaxed)) / ns_per_ms;
+}
+
+double histogram::mean_ms() const
+{
+    auto const n = count();
+    if (0 == n) {
+        return 0.0;
+    }
+    return static_cast<double>(_sum_ns.load(std::memory_order_relaxed)) / ns_per_ms / static_cast<double>(n);
+}
+
+double histogram::variance_ms2() const
+{
+    auto const n = count();
+    if (n < 2) {
+        return 0.0;
+    }
+    auto const sum = static_cast<double>(_sum_ns.load(std::memory_order_relaxed)) / ns_per_ms;
+    auto const sum_sq = _sum_sq_ms2.load(std::memory_order_relaxed);
+    auto const v = (sum_sq - sum * sum / static_cast<double>(n)) / static_cast<double>(n - 1);
+    return v < 0.0 ? 0.0 : v;  // rounding may produce tiny negative values for constant samples
+}
+
+double histogram::stddev_ms() const
+{
+    return std::sqrt(variance_ms2());
+}
+
+char const* vlk::to_string(frame_phase fp)
+{
+    switch (fp) {
+        case frame_phase::acquire: return "acquire";
+        case frame_phase::record: return "record";
+        case frame_phase::submit: return "submit";
+        case frame_phase::present: return "present";
+        case frame_phase::frame: return "frame";
+        default:
+            break;
+    }
+    return "unknown";
+}
+
+void frame_stats::record(frame_phase phase, std::chrono::nanoseconds duration)
+{
+    assert(phase < frame_phase::count);
+    _phases[static_cast<size_t>(phase)].record(duration);
+    if (frame_phase::frame == phase) {
+        auto const ns = duration.count() < 0 ? uint64_t{0} : static_cast<uint64_t>(duration.count());
+        auto const last = _last_frame_ns.exchange(ns, std::memory_order_relaxed);
+        if (0 != last) {
+            _delta_sum_ns.fetch_add(ns > last ? ns - last : last - ns, std::memory_order_relaxed);
+            _delta_count.fetch_add(1U, std::memory_order_relaxed);
+        }
+    }
+}
+
+void frame_stats::reset()
+{
+    for (auto& h : _phases) {
+        h.reset();
+    }
+    _last_frame_ns.store(0U, std::memory_order_relaxed);
+    _delta_sum_ns.store(0U, std::memory_order_relaxed);
+    _delta_count.store(0U, std::memory_order_relaxed);
+}
+
+histogram const& frame_stats::phase(frame_phase phase) const
+{
+    assert(phase < frame_phase::count);
+    return _phases[static_cast<size_t>(phase)];
+}
+
+double frame_stats::jitter_ms() const
+{
+    auto const n = _delta_count.load(std::memory_order_relaxed);
+    if (0 == n) {
+        return 0.0;
+    }
+    return static_cast<double>(_delta_sum_ns.load(std::memory_order_relaxed)) / ns_per_ms / static_cast<double>(n);
+}
+
+void frame_stats::log(std::string const& prefix) const
+{
+    for (uint32_t i = 0; i < static_cast<uint32_t>(frame_phase::count); ++i) {
+        auto const& h = _phases[i];
+        VLK_LOG_INFO() << prefix << std::setw(8) << std::left << to_string(static_cast<frame_phase>(i))
+                       << std::fixed << std::setprecision(3)
+                       << " n=" << h.count()
+                       << " mean=" << h.mean_ms() << "ms"
+                       << " p50=" << h.p50_ms() << "ms"
+                       << " p95=" << h.p95_ms() << "ms"
+                       << " p99=" << h.p99_ms() << "ms"
+                       << " max=" << h.max_ms() << "ms"
+                       << " stddev=" << h.stddev_ms() << "ms";
+    }
+    VLK_LOG_INFO() << prefix << "frame-to-frame jitter=" << std::fixed << std::setprecision(3) << jitter_ms() << "ms";
+}
@@ -0,0 +1,194 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/gpu_profiler.h>
+#include <vlk/exception.h>
+#include <vlk/log.h>
+
+#include <cassert>
+
+using namespace vlk;
+
+gpu_zone_list::gpu_zone_list(uint32_t max_zones)
+    : _max_zones{max_zones}
+{
+    _zones.reserve(_max_zones);
+}
+
+uint32_t gpu_zone_list::open(char const* name)
+{
+    if (_zones.size() >= _max_zones) {
+        return invalid_zone;
+    }
+    auto const idx = static_cast<uint32_t>(_zones.size());
+    _zones.push_back(zone{name, _depth, false});
+    ++_depth;
+    return idx;
+}
+
+void gpu_zone_list::close(uint32_t zone_idx)
+{
+    if (invalid_zone == zone_idx) {
+        return;
+    }
+    assert(zone_idx < _zones.size());
+    assert(!_zones[zone_idx].closed);
+    assert(_depth > 0);
+    --_depth;
+    _zones[zone_idx].closed = true;
+}
+
+void gpu_zone_list::clear()
+{
+    _zones.clear();
+    _depth = 0;
+}
+
+gpu_zone_list::zone const* gpu_zone_list::first_open() const
+{
+    for (auto const& z : _zones) {
+        if (!z.closed) {
+            return &z;
+        }
+    }
+    return nullptr;
+}
+
+gpu_profiler::scoped_zone::scoped_zone(gpu_profiler& profiler, VkCommandBuffer cmd, char const* name)
+    : _profiler{profiler}
+    , _cmd{cmd}
+    , _zone{profiler.begin_zone(cmd, name)}
+{}
+
+gpu_profiler::scoped_zone::~scoped_zone()
+{
+    _profiler.end_zone(_cmd, _zone);
+}
+
+gpu_profiler::gpu_profiler(VkDevice device, vlk::phys_device const& pd, uint32_t queue_family_index,
+                           uint32_t frames_in_flight, uint32_t max_zones_per_frame)
+    : _device{device}
+    , _valid_bits{0}
+    , _ns_per_tick{static_cast<double>(pd.properties.limits.timestampPeriod)}
+    , _max_zones{max_zones_per_frame}
+{
+    assert(queue_family_index < pd.queue_family_properties.size());
+    _valid_bits = pd.queue_family_properties[queue_family_index].timestampValidBits;
+    if (0 == _valid_bits || 0 == frames_in_flight) {
+        return;
+    }
+
+    _pools.resize(frames_in_flight, frame_pool{VK_NULL_HANDLE, gpu_zone_list{_max_zones}, false});
+    VkQueryPoolCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    ci.pNext = nullptr;
+    ci.flags = 0;
+    ci.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    ci.queryCount = 2U * _max_zones;
+    ci.pipelineStatistics = 0;
+    for (auto& fp : _pools) {
+        auto r = vkCreateQueryPool(_device, &ci, nullptr, &fp.pool);
+        if (VK_SUCCESS != r) {
+            for (auto const& p : _pools) {
+                if (VK_NULL_HANDLE != p.pool) {
+                    vkDestroyQueryPool(_device, p.pool, nullptr);
+                }
+            }
+            throw vlk::vulkan_exception{"unable to create timestamp query pool", r};
+        }
+    }
+    _timestamps.resize(2U * _max_zones);
+}
+
+gpu_profiler::~gpu_profiler()
+{
+    for (auto const& fp : _pools) {
+        vkDestroyQueryPool(_device, fp.pool, nullptr);
+    }
+}
+
+void gpu_profiler::begin_frame(uint32_t frame_index, VkCommandBuffer cmd)
+{
+    if (!enabled()) {
+        return;
+    }
+    assert(frame_index < _pools.size());
+    if (nullptr != _current && 0 != _current->zones.depth()) {
+        VLK_LOG_WARNING() << "GPU zone " << _current->zones.first_open()->name << " not closed, "
+                          << _current->zones.depth() << " zone(s) left out of the results";
+    }
+    auto& fp = _pools[frame_index];
+    collect(fp);
+
+    fp.zones.clear();
+    vkCmdResetQueryPool(cmd, fp.pool, 0, 2U * _max_zones);
+    _current = &fp;
+}
+
+uint32_t gpu_profiler::begin_zone(VkCommandBuffer cmd, char const* name)
+{
+    if (nullptr == _current) {
+        return gpu_zone_list::invalid_zone;
+    }
+    auto const idx = _current->zones.open(name);
+    if (gpu_zone_list::invalid_zone == idx) {
+        ++_dropped_zones;
+        return idx;
+    }
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _current->pool, 2U * idx);
+    _current->pending = true;
+    return idx;
+}
+
+void gpu_profiler::end_zone(VkCommandBuffer cmd, uint32_t zone_idx)
+{
+    if (gpu_zone_list::invalid_zone == zone_idx || nullptr == _current) {
+        return;
+    }
+    _current->zones.close(zone_idx);
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _current->pool, 2U * zone_idx + 1U);
+}
+
+void gpu_profiler::collect(frame_pool& fp)
+{
+    auto const& zones = fp.zones.zones();
+    if (!fp.pending || zones.empty()) {
+        return;
+    }
+    fp.pending = false;
+
+    // timestamps only have timestampValidBits significant bits, deltas are taken modulo 2^bits
+    auto const mask = _valid_bits >= 64U ? UINT64_MAX : (uint64_t{1} << _valid_bits) - 1U;
+    _results.clear();
+    // only the queries of closed zones were written, querying the end of an open zone would fail the whole range
+    fp.zones.for_each_closed_run([&](uint32_t first, uint32_t count) {
+        // no VK_QUERY_RESULT_WAIT_BIT: the frame's fence was signaled, VK_NOT_READY means the results are lost
+        auto const query_count = 2U * count;
+        auto r = vkGetQueryPoolResults(_device, fp.pool, 2U * first, query_count, query_count * sizeof(uint64_t),
+                _timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (VK_SUCCESS != r) {
+            return;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            auto const& z = zones[first + i];
+            auto const ticks = (_timestamps[2U * i + 1U] - _timestamps[2U * i]) & mask;
+            _results.push_back(zone_result{z.name, z.depth, static_cast<double>(ticks) * _ns_per_tick * 1.0e-6});
+        }
+    });
+}
@@ -0,0 +1,275 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/job_system.h>
+#include <vlk/log.h>
+
+#include <algorithm>
+#include <cassert>
+
+using namespace vlk;
+
+namespace {
+
+    // index of the current thread within the job system it belongs to
+    thread_local job_system const* t_owner{nullptr};
+    thread_local uint32_t t_index{job_system::invalid_thread_index};
+
+}
+
+job_system::job_system(uint32_t worker_count)
+{
+    if (0 == worker_count) {
+        worker_count = std::max(2U, std::thread::hardware_concurrency()) - 1U;
+    }
+    t_owner = this;
+    t_index = 0;
+    for (uint32_t i = 0; i <= worker_count; ++i) {
+        _queues.push_back(std::make_unique<queue>());
+    }
+    for (uint32_t i = 1; i <= worker_count; ++i) {
+        _threads.emplace_back([this, i]() { worker_loop(i); });
+    }
+}
+
+job_system::~job_system()
+{
+    {
+        std::lock_guard<std::mutex> lock{_sleep_mutex};
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (auto& t : _threads) {
+        t.join();
+    }
+    if (t_owner == this) {
+        t_owner = nullptr;
+        t_index = invalid_thread_index;
+    }
+}
+
+uint32_t job_system::thread_index() const
+{
+    return t_owner == this ? t_index : invalid_thread_index;
+}
+
+job_system::job job_system::wrap(job j, counter* c)
+{
+    if (nullptr != c) {
+        c->_pending.fetch_add(1U, std::memory_order_relaxed);
+    }
+    return [this, j = std::move(j), c]() {
+        std::exception_ptr error{};
+        try {
+            j();
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        finish(c, error);
+    };
+}
+
+void job_system::finish(counter* c, std::exception_ptr error)
+{
+    if (nullptr == c) {
+        if (error) {
+            try {
+                std::rethrow_exception(error);
+            }
+            catch (std::exception const& e) {
+                VLK_LOGF_ERROR("job_system: unhandled exception in job: {}", e.what());
+            }
+            catch (...) {
+                VLK_LOGF_ERROR("job_system: unhandled exception in job");
+            }
+        }
+        return;
+    }
+
+    // the counter may be destroyed by a waiter as soon as it reaches zero, so the continuations are owned by the
+    // job system and taken in the same critical section as the last decrement
+    std::vector<job> continuations;
+    {
+        std::lock_guard<std::mutex> lock{_continuation_mutex};
+        if (error && !c->_error) {
+            c->_error = error;
+        }
+        if (1U == c->_pending.fetch_sub(1U, std::memory_order_acq_rel)) {
+            auto it = _continuations.find(c);
+            if (_continuations.end() != it) {
+                continuations.swap(it->second);
+                _continuations.erase(it);
+            }
+        }
+    }
+    for (auto& j : continuations) {
+        push(std::move(j));
+    }
+}
+
+void job_system::push(job j)
+{
+    auto self = thread_index();
+    if (invalid_thread_index == self) {
+        // foreign threads distribute their jobs round robin over the workers
+        self = 1U + _next_queue.fetch_add(1U, std::memory_order_relaxed) % worker_count();
+    }
+    {
+        std::lock_guard<std::mutex> lock{_queues[self]->mutex};
+        _queues[self]->jobs.push_back(std::move(j));
+    }
+    _queued.fetch_add(1U, std::memory_order_release);
+    {
+        // pairs with the predicate check of the sleeping workers - no lost wake up
+        std::lock_guard<std::mutex> lock{_sleep_mutex};
+    }
+    _wake.notify_one();
+}
+
+void job_system::run(job j, counter* c)
+{
+    push(wrap(std::move(j), c));
+}
+
+void job_system::run_after(counter& dependency, job j, counter* c)
+{
+    auto wrapped = wrap(std::move(j), c);
+    {
+        std::lock_guard<std::mutex> lock{_continuation_mutex};
+        if (!dependency.done()) {
+            _continuations[&dependency].push_back(std::move(wrapped));
+            return;
+        }
+    }
+    push(std::move(wrapped));
+}
+
+void job_system::run_on_main(job j, counter* c)
+{
+    auto wrapped = wrap(std::move(j), c);
+    std::lock_guard<std::mutex> lock{_main_mutex};
+    _main_jobs.push_back(std::move(wrapped));
+}
+
+bool job_system::run_one_main_job()
+{
+    job j;
+    {
+        std::lock_guard<std::mutex> lock{_main_mutex};
+        if (_main_jobs.empty()) {
+            return false;
+        }
+        j = std::move(_main_jobs.front());
+        _main_jobs.pop_front();
+    }
+    j();
+    return true;
+}
+
+void job_system::run_main_thread_jobs()
+{
+    assert(is_main_thread());
+    while (run_one_main_job()) {
+    }
+}
+
+bool job_system::try_run_one(uint32_t self)
+{
+    job j;
+    {
+        auto& own = *_queues[self];
+        std::lock_guard<std::mutex> lock{own.mutex};
+        if (!own.jobs.empty()) {
+            j = std::move(own.jobs.back());
+            own.jobs.pop_back();
+        }
+    }
+    auto const n = static_cast<uint32_t>(_queues.size());
+    for (uint32_t i = 1; !j && i < n; ++i) {
+        auto& victim = *_queues[(self + i) % n];
+        std::lock_guard<std::mutex> lock{victim.mutex};
+        if (!victim.jobs.empty()) {
+            j = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+        }
+    }
+    if (!j) {
+        return false;
+    }
+    _queued.fetch_sub(1U, std::memory_order_relaxed);
+    j();
+    return true;
+}
+
+void job_system::worker_loop(uint32_t index)
+{
+    t_owner = this;
+    t_index = index;
+    while (!_stop.load(std::memory_order_relaxed)) {
+        if (try_run_one(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock{_sleep_mutex};
+        _wake.wait(lock, [this]() { return _stop.load() || _queued.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+void job_system::wait(counter& c)
+{
+    auto const self = thread_index();
+    while (!c.done()) {
+        if (0 == self && run_one_main_job()) {
+            continue;
+        }
+        if (!try_run_one(invalid_thread_index == self ? 0U : self)) {
+            std::this_thread::yield();
+        }
+    }
+    if (c._error) {
+        auto error = c._error;
+        c._error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void job_system::parallel_for(uint32_t count, uint32_t min_chunk, std::function<void(uint32_t, uint32_t)> const& fn)
+{
+    if (0 == count) {
+        return;
+    }
+    // a few chunks per thread balance uneven work
+    auto const max_chunks = 4U * thread_count();
+    auto const chunks = std::min(max_chunks, std::max(1U, count / std::max(1U, min_chunk)));
+    auto const chunk_size = (count + chunks - 1U) / chunks;
+    counter c{};
+    for (uint32_t begin = chunk_size; begin < count; begin += chunk_size) {
+        auto const end = std::min(count, begin + chunk_size);
+        run([&fn, begin, end]() { fn(begin, end); }, &c);
+    }
+    try {
+        fn(0, std::min(count, chunk_size));
+    }
+    catch (...) {
+        // the other chunks reference fn
+        wait(c);
+        throw;
+    }
+    wait(c);
+}
@@ -20,12 +20,1077 @@
 #include <vlk/log.h>
 #include <iostream>
 
-#include <boost/log/core.hpp>
 #include <boost/log/trivial.hpp>
-#include <boost/log/expressions.hpp>
+
+#include <vlk/exception.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::atomic<int> vlk::detail::global_log_level{static_cast<int>(vlk::log_level::trace)};
+
+namespace {
+
+    using vlk::log_level;
+    using vlk::detail::log_arg;
+
+    constexpr size_t ring_capacity{256U * 1024U};   //!< bytes per thread
+    constexpr size_t max_message_length{2048U};
+    constexpr size_t max_log_sites{16384U};
+    constexpr size_t max_crash_rings{256U};         //!< rings of threads beyond are not flushed by the crash handler
+
+    enum entry_kind : uint8_t
+    {
+        entry_text = 0,     //!< formatted message
+        entry_padding,      //!< skip size bytes
+        entry_args,         //!< 32 bit site id followed by the encoded VLK_LOGF_* arguments
+    };
+
+    //! Entry of a ring, followed by length bytes of payload. Entries are 8 byte aligned, an entry never wraps around
+    //! the end of the ring - the rest of the ring is skipped with a padding entry instead.
+    struct entry_header
+    {
+        uint32_t size;      //!< whole entry including the header and alignment
+        uint16_t length;
+        uint8_t level;
+        uint8_t kind;       //!< entry_kind
+        int64_t time_ns;
+        uint64_t thread;
+    };
+    static_assert(0 == sizeof(entry_header) % 8U, "entries must stay 8 byte aligned");
+
+    //! Single producer (the owning thread), single consumer (whoever holds the backend's drain flag).
+    class ring
+    {
+    public:
+        ring()
+            : _data{new uint64_t[ring_capacity / sizeof(uint64_t)]}
+        {}
+
+        bool push(uint8_t level, uint8_t kind, int64_t time_ns, uint64_t thread, char const* text, size_t length)
+        {
+            auto const size = static_cast<uint32_t>((sizeof(entry_header) + length + 7U) & ~size_t{7U});
+            auto head = _head.load(std::memory_order_relaxed);
+            auto const tail = _tail.load(std::memory_order_acquire);
+            auto pos = static_cast<size_t>(head % ring_capacity);
+            auto const to_end = ring_capacity - pos;
+            auto const needed = size + (to_end < size ? to_end : 0U);
+            if (head - tail + needed > ring_capacity) {
+                return false;
+            }
+            if (to_end < size) {
+                // the first 8 bytes of a padding entry always fit, entries are aligned
+                auto* pad = reinterpret_cast<entry_header*>(bytes() + pos);
+                pad->size = static_cast<uint32_t>(to_end);
+                pad->kind = entry_padding;
+                head += to_end;
+                pos = 0;
+            }
+            auto* h = reinterpret_cast<entry_header*>(bytes() + pos);
+            h->size = size;
+            h->length = static_cast<uint16_t>(length);
+            h->level = level;
+            h->kind = kind;
+            h->time_ns = time_ns;
+            h->thread = thread;
+            std::memcpy(bytes() + pos + sizeof(entry_header), text, length);
+            _head.store(head + size, std::memory_order_release);
+            return true;
+        }
+
+        //! Calls fn(header, payload) for every published entry.
+        template<typename Fn>
+        bool drain(Fn&& fn)
+        {
+            auto tail = _tail.load(std::memory_order_relaxed);
+            auto const head = _head.load(std::memory_order_acquire);
+            if (tail == head) {
+                return false;
+            }
+            while (tail < head) {
+                auto const pos = static_cast<size_t>(tail % ring_capacity);
+                auto const* h = reinterpret_cast<entry_header const*>(bytes() + pos);
+                if (entry_padding != h->kind) {
+                    fn(*h, reinterpret_cast<char const*>(h) + sizeof(entry_header));
+                }
+                tail += h->size;
+            }
+            _tail.store(tail, std::memory_order_release);
+            return true;
+        }
+
+        std::atomic<bool> orphaned{false};  //!< owning thread has exited
+
+    private:
+        uint8_t* bytes() { return reinterpret_cast<uint8_t*>(_data.get()); }
+
+        std::unique_ptr<uint64_t[]> _data;
+        alignas(64) std::atomic<uint64_t> _head{0};
+        alignas(64) std::atomic<uint64_t> _tail{0};
+    };
+
+    //! Format sites of the VLK_LOGF_* statements, ids are indices. Entries below site_count are immutable.
+    struct log_site
+    {
+        uint8_t level;
+        uint32_t line;
+        char const* file;
+        char const* format;
+    };
+
+    std::array<log_site, max_log_sites> sites{};
+    std::atomic<uint32_t> site_count{0};
+    std::mutex sites_mutex{};
+
+    log_site const* find_site(uint32_t id)
+    {
+        return id < site_count.load(std::memory_order_acquire) ? &sites[id] : nullptr;
+    }
+
+    char const* level_tag(uint8_t level)
+    {
+        // padded like Boost.Log's default format, messages of all levels start in the same column
+        switch (static_cast<log_level>(level)) {
+            case log_level::trace: return "[trace]   ";
+            case log_level::debug: return "[debug]   ";
+            case log_level::info: return "[info]    ";
+            case log_level::warning: return "[warning] ";
+            case log_level::error: return "[error]   ";
+            case log_level::fatal: return "[fatal]   ";
+            default:
+                break;
+        }
+        return "[unknown] ";
+    }
+
+    char* put_digits(char* out, uint64_t value, int digits)
+    {
+        for (int i = digits - 1; i >= 0; --i) {
+            out[i] = static_cast<char>('0' + value % 10U);
+            value /= 10U;
+        }
+        return out + digits;
+    }
+
+    //! "[2024-01-31 13:45:12.123456] [0x00007f0123456789] [info]    " without library calls, usable in the crash
+    //! handler. Returns the number of characters written, out must hold 64 characters.
+    size_t format_prefix(char* out, int64_t time_ns, uint64_t thread, uint8_t level, int64_t utc_offset_s)
+    {
+        auto const local_s = time_ns / 1000000000LL + utc_offset_s;
+        auto const micros = static_cast<uint64_t>((time_ns / 1000LL) % 1000000LL);
+        auto days = local_s / 86400LL;
+        auto const secs = static_cast<uint64_t>(local_s % 86400LL);
+        // civil date from days since 1970-01-01 (H. Hinnant)
+        days += 719468;
+        auto const era = days / 146097;
+        auto const doe = static_cast<uint64_t>(days - era * 146097);
+        auto const yoe = (doe - doe / 1460U + doe / 36524U - doe / 146096U) / 365U;
+        auto const doy = doe - (365U * yoe + yoe / 4U - yoe / 100U);
+        auto const mp = (5U * doy + 2U) / 153U;
+        auto const day = doy - (153U * mp + 2U) / 5U + 1U;
+        auto const month = mp < 10U ? mp + 3U : mp - 9U;
+        auto const year = static_cast<uint64_t>(static_cast<int64_t>(yoe) + era * 400) + (month <= 2U ? 1U : 0U);
+
+        auto* p = out;
+        *p++ = '[';
+        p = put_digits(p, year, 4);
+        *p++ = '-';
+        p = put_digits(p, month, 2);
+        *p++ = '-';
+        p = put_digits(p, day, 2);
+        *p++ = ' ';
+        p = put_digits(p, secs / 3600U, 2);
+        *p++ = ':';
+        p = put_digits(p, (secs / 60U) % 60U, 2);
+        *p++ = ':';
+        p = put_digits(p, secs % 60U, 2);
+        *p++ = '.';
+        p = put_digits(p, micros, 6);
+        *p++ = ']';
+        *p++ = ' ';
+        *p++ = '[';
+        *p++ = '0';
+        *p++ = 'x';
+        for (int i = 15; i >= 0; --i) {
+            *p++ = "0123456789abcdef"[(thread >> (4U * static_cast<unsigned>(i))) & 0xFU];
+        }
+        *p++ = ']';
+        *p++ = ' ';
+        auto const* tag = level_tag(level);
+        auto const tag_length = std::strlen(tag);
+        std::memcpy(p, tag, tag_length);
+        p += tag_length;
+        return static_cast<size_t>(p - out);
+    }
+
+    //! Decimal digits of v without library calls, returns the number of characters written (20 at most).
+    size_t put_decimal(char* out, uint64_t v)
+    {
+        std::array<char, 20> digits{};
+        size_t n{0};
+        do {
+            digits[n++] = static_cast<char>('0' + v % 10U);
+            v /= 10U;
+        } while (0 != v);
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = digits[n - 1U - i];
+        }
+        return n;
+    }
+
+    //! "0x" and the hex digits of v without leading zeros, at most 18 characters.
+    size_t put_hex(char* out, uint64_t v)
+    {
+        out[0] = '0';
+        out[1] = 'x';
+        size_t n{2};
+        int shift{60};
+        while (shift > 0 && 0 == ((v >> static_cast<unsigned>(shift)) & 0xFU)) {
+            shift -= 4;
+        }
+        for (; shift >= 0; shift -= 4) {
+            out[n++] = "0123456789abcdef"[(v >> static_cast<unsigned>(shift)) & 0xFU];
+        }
+        return n;
+    }
+
+    //! "%g" without library calls for the crash handler: six significant digits, exponent notation below 1e-4 and
+    //! from 1e6 on. The last digit may be off by one, the scaling by 10 is not exact. At most 16 characters.
+    size_t put_double(char* out, double v)
+    {
+        size_t n{0};
+        if (v != v) {
+            std::memcpy(out, "nan", 3U);
+            return 3U;
+        }
+        if (std::signbit(v)) {
+            out[n++] = '-';
+            v = -v;
+        }
+        if (v > std::numeric_limits<double>::max()) {
+            std::memcpy(out + n, "inf", 3U);
+            return n + 3U;
+        }
+        if (0.0 == v) {
+            out[n++] = '0';
+            return n;
+        }
+        int exp10{0};
+        while (v >= 10.0) {
+            v /= 10.0;
+            ++exp10;
+        }
+        while (v < 1.0) {
+            v *= 10.0;
+            --exp10;
+        }
+        auto mantissa = static_cast<uint64_t>(v * 100000.0 + 0.5);
+        if (mantissa >= 1000000U) {
+            mantissa /= 10U;
+            ++exp10;
+        }
+        std::array<char, 6> d{};
+        for (size_t i = d.size(); i-- > 0;) {
+            d[i] = static_cast<char>('0' + mantissa % 10U);
+            mantissa /= 10U;
+        }
+        // trailing zeros are dropped like by %g
+        int last{5};
+        while (last > 0 && '0' == d[static_cast<size_t>(last)]) {
+            --last;
+        }
+        if (exp10 < -4 || exp10 >= 6) {
+            out[n++] = d[0];
+            if (last > 0) {
+                out[n++] = '.';
+                for (int i = 1; i <= last; ++i) {
+                    out[n++] = d[static_cast<size_t>(i)];
+                }
+            }
+            out[n++] = 'e';
+            out[n++] = exp10 < 0 ? '-' : '+';
+            auto const e = static_cast<uint64_t>(exp10 < 0 ? -exp10 : exp10);
+            if (e < 10U) {
+                out[n++] = '0';
+            }
+            n += put_decimal(out + n, e);
+        }
+        else if (exp10 >= 0) {
+            for (int i = 0; i <= exp10; ++i) {
+                out[n++] = d[static_cast<size_t>(i)];
+            }
+            if (last > exp10) {
+                out[n++] = '.';
+                for (int i = exp10 + 1; i <= last; ++i) {
+                    out[n++] = d[static_cast<size_t>(i)];
+                }
+            }
+        }
+        else {
+            out[n++] = '0';
+            out[n++] = '.';
+            for (int i = -1; i > exp10; --i) {
+                out[n++] = '0';
+            }
+            for (int i = 0; i <= last; ++i) {
+                out[n++] = d[static_cast<size_t>(i)];
+            }
+        }
+        return n;
+    }
+
+    //! format_log_args(), signal_safe formats without library calls (doubles only approximately).
+    size_t format_args(char* out, size_t capacity, char const* format, uint8_t const* args, size_t size,
+                       bool signal_safe)
+    {
+        size_t n{0};
+        size_t pos{0};
+        auto const put = [&](char const* s, size_t length) {
+            length = std::min(length, capacity - n);
+            std::memcpy(out + n, s, length);
+            n += length;
+        };
+        // writes the next argument, false if there is none (or the encoding is broken)
+        auto const next_arg = [&]() -> bool {
+            if (pos >= size) {
+                return false;
+            }
+            auto const tag = static_cast<log_arg>(args[pos]);
+            auto const payload_size = [tag]() -> size_t {
+                switch (tag) {
+                    case log_arg::boolean: return 1U;
+                    case log_arg::string: return 2U;
+                    case log_arg::i64:
+                    case log_arg::u64:
+                    case log_arg::f64:
+                    case log_arg::pointer: return 8U;
+                }
+                return 0U;
+            }();
+            if (0 == payload_size || pos + 1U + payload_size > size) {
+                pos = size;
+                return false;
+            }
+            auto const* p = args + pos + 1U;
+            pos += 1U + payload_size;
+            std::array<char, 32> buffer{};
+            int length{0};
+            switch (tag) {
+                case log_arg::boolean:
+                    put(0 != *p ? "true" : "false", 0 != *p ? 4U : 5U);
+                    return true;
+                case log_arg::string: {
+                    uint16_t l{0};
+                    std::memcpy(&l, p, sizeof(l));
+                    auto const available = std::min<size_t>(l, size - pos);
+                    put(reinterpret_cast<char const*>(args + pos), available);
+                    pos += available;
+                    return true;
+                }
+                case log_arg::i64: {
+                    int64_t v{0};
+                    std::memcpy(&v, p, sizeof(v));
+                    if (v < 0) {
+                        buffer[length++] = '-';
+                    }
+                    length += put_decimal(buffer.data() + length,
+                                          v < 0 ? 0U - static_cast<uint64_t>(v) : static_cast<uint64_t>(v));
+                    break;
+                }
+                case log_arg::u64: {
+                    uint64_t v{0};
+                    std::memcpy(&v, p, sizeof(v));
+                    length = put_decimal(buffer.data(), v);
+                    break;
+                }
+                case log_arg::f64: {
+                    double v{0};
+                    std::memcpy(&v, p, sizeof(v));
+                    if (signal_safe) {
+                        length = put_double(buffer.data(), v);
+                    }
+                    else {
+                        // the default precision of an ostream
+                        length = static_cast<size_t>(
+                                std::max(std::snprintf(buffer.data(), buffer.size(), "%g", v), 0));
+                    }
+                    break;
+                }
+                case log_arg::pointer: {
+                    uint64_t v{0};
+                    std::memcpy(&v, p, sizeof(v));
+                    length = put_hex(buffer.data(), v);
+                    break;
+                }
+            }
+            put(buffer.data(), length);
+            return true;
+        };
+
+        for (auto const* f = format; '\0' != *f; ++f) {
+            if ('{' == f[0] && '}' == f[1]) {
+                if (!next_arg()) {
+                    put("{}", 2U);
+                }
+                ++f;
+            }
+            else {
+                put(f, 1U);
+            }
+        }
+        while (pos < size) {
+            auto const before = n;
+            put(" ", 1U);
+            if (!next_arg()) {
+                n = before;
+            }
+        }
+        return n;
+    }
+
+    void write_all(int fd, char const* data, size_t size)
+    {
+        while (size > 0) {
+            auto const n = ::write(fd, data, size);
+            if (n <= 0) {
+                return;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+
+    //! Binary log: "VLKL", u32 version, i64 UTC offset in seconds, then records starting with a record type byte.
+    //! All numbers in host byte order, the file is meant to be decoded on the machine that wrote it.
+    constexpr char binary_magic[4]{'V', 'L', 'K', 'L'};
+    constexpr uint32_t binary_version{1U};
+
+    enum binary_record : uint8_t
+    {
+        record_site = 1,    //!< u32 id, u8 level, u32 line, u16 length + file, u16 length + format
+        record_args,        //!< i64 time, u64 thread, u32 site, u16 length + encoded arguments
+        record_text,        //!< i64 time, u64 thread, u8 level, u16 length + text
+    };
+
+    //! Serializes binary records to sink(data, size), the crash handler writes them straight to the file.
+    template<typename Sink>
+    class binary_writer
+    {
+    public:
+        explicit binary_writer(Sink& sink)
+            : _sink{sink}
+        {}
+
+        void site(uint32_t id, log_site const& s)
+        {
+            put(record_site);
+            put(id);
+            put(s.level);
+            put(s.line);
+            put_string(s.file, std::strlen(s.file));
+            put_string(s.format, std::strlen(s.format));
+        }
+
+        void entry(entry_header const& h, char const* payload)
+        {
+            put(entry_args == h.kind ? record_args : record_text);
+            put(h.time_ns);
+            put(h.thread);
+            if (entry_args == h.kind) {
+                uint32_t id{0};
+                std::memcpy(&id, payload, sizeof(id));
+                put(id);
+                put_string(payload + sizeof(id), h.length - sizeof(id));
+            }
+            else {
+                put(h.level);
+                put_string(payload, h.length);
+            }
+        }
+
+    private:
+        template<typename T>
+        void put(T v) { _sink(reinterpret_cast<char const*>(&v), sizeof(T)); }
+
+        void put_string(char const* s, size_t length)
+        {
+            auto const n = static_cast<uint16_t>(std::min<size_t>(length, UINT16_MAX));
+            put(n);
+            _sink(s, n);
+        }
+
+        Sink& _sink;
+    };
+
+    constexpr std::array<int, 5> crash_signals{SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+
+    //! \brief Owner of all rings and the writer thread.
+    //! Created with the first message and never destroyed: messages logged by static destructors after exit()
+    //! started are written synchronously. The writer sleeps while all rings are empty, a producer only wakes it
+    //! (and only then takes a lock) when it finds the writer idle.
+    class backend
+    {
+    public:
+        static backend& get()
+        {
+            static backend* instance{new backend{}};
+            return *instance;
+        }
+
+        void push(log_level level, uint8_t kind, char const* payload, size_t length);
+
+        //! Switches between stderr (empty path) and a binary log file.
+        void set_binary_log(std::string const& path);
+
+        //! Drains all rings, returns whether anything was written. Sorts the messages by time, the order within
+        //! one thread is kept.
+        bool drain_all();
+
+        //! Drains all rings from a signal handler: no allocation, no sorting.
+        void crash_flush() noexcept;
+
+        //! Installs signal_handler() for crash_signals, once.
+        void install_crash_handler();
+
+        void stop();
+
+    private:
+        struct message
+        {
+            entry_header header;
+            std::string payload;
+        };
+
+        backend();
+        ring* thread_ring();
+        bool lock_drain(bool bounded) noexcept;
+        void unlock_drain() noexcept { _draining.clear(std::memory_order_release); }
+        static void signal_handler(int sig);
+
+        void run_writer();
+        //! Wakes the writer if it waits for messages, called after a message was pushed.
+        void notify_writer();
+        void wake_writer();
+
+        //! Appends the text form of an entry to _out.
+        void append_text(entry_header const& h, char const* payload);
+        //! Writes the sites registered since the last call, binary mode only.
+        template<typename Sink>
+        void write_new_sites(Sink& sink) noexcept;
+
+        int64_t _utc_offset_s{0};
+        std::atomic<bool> _running{true};
+        std::atomic_flag _draining = ATOMIC_FLAG_INIT;
+        std::atomic<uint64_t> _dropped{0};
+        int _binary_fd{-1};             //!< guarded by _draining
+        uint32_t _sites_written{0};     //!< sites already in the binary log
+        std::mutex _rings_mutex{};
+        std::vector<std::shared_ptr<ring>> _rings{};
+        std::vector<std::shared_ptr<ring>> _drain_rings{};  //!< copy of _rings used by drain_all()
+        //! The rings for the crash handler, which can't take _rings_mutex. Changed under _rings_mutex, rings are
+        //! removed before they are released by drain_all() - which the crash handler excludes by lock_drain().
+        std::array<std::atomic<ring*>, max_crash_rings> _crash_rings{};
+        std::vector<message> _messages{};
+        std::string _out{};
+        std::array<struct sigaction, crash_signals.size()> _previous_actions{};
+        std::once_flag _crash_handler_installed{};
+        std::atomic<bool> _writer_idle{false};    //!< changed to false only under _wake_mutex
+        std::mutex _wake_mutex{};
+        std::condition_variable _wake{};
+        std::thread _writer{};
+    };
+
+    //! Per-thread message formatting: the ostream is reused for every message of the thread.
+    class record_buffer : public std::streambuf
+    {
+    public:
+        record_buffer()
+            : stream{this}
+        {
+            reset();
+            default_flags = stream.flags();
+        }
+
+        void reset()
+        {
+            setp(_text.data(), _text.data() + _text.size());
+            truncated = false;
+        }
+
+        char const* text() const { return pbase(); }
+        size_t length() const { return static_cast<size_t>(pptr() - pbase()); }
+
+        std::ostream stream;
+        std::ios_base::fmtflags default_flags{};
+        bool truncated{false};
+        int depth{0};
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            truncated = true;
+            return traits_type::not_eof(c);
+        }
+
+    private:
+        std::array<char, max_message_length> _text{};
+    };
+
+    record_buffer& thread_buffer()
+    {
+        static thread_local record_buffer buffer{};
+        return buffer;
+    }
+
+    //! Marks the thread's ring orphaned when the thread exits, the writer drops it once it is drained.
+    struct ring_owner
+    {
+        std::shared_ptr<ring> r{};
+        ~ring_owner()
+        {
+            if (r) {
+                r->orphaned.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    backend::backend()
+    {
+        auto const now = std::time(nullptr);
+        std::tm local{};
+        localtime_r(&now, &local);
+        _utc_offset_s = local.tm_gmtoff;
+
+        _writer = std::thread{[this]() { run_writer(); }};
+        std::atexit([]() { backend::get().stop(); });
+    }
+
+    void backend::install_crash_handler()
+    {
+        std::call_once(_crash_handler_installed, [this]() {
+            struct sigaction sa{};
+            sa.sa_handler = &backend::signal_handler;
+            sigemptyset(&sa.sa_mask);
+            sa.sa_flags = 0;
+            for (size_t i = 0; i < crash_signals.size(); ++i) {
+                sigaction(crash_signals[i], &sa, &_previous_actions[i]);
+            }
+        });
+    }
+
+    void backend::run_writer()
+    {
+        while (_running.load(std::memory_order_acquire)) {
+            if (drain_all()) {
+                continue;
+            }
+            // Dekker style handshake with notify_writer(): either the producer sees the idle flag or the second
+            // drain sees its message
+            _writer_idle.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (drain_all()) {
+                _writer_idle.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock{_wake_mutex};
+            _wake.wait(lock, [this]() {
+                return !_writer_idle.load(std::memory_order_relaxed) || !_running.load(std::memory_order_acquire);
+            });
+        }
+    }
+
+    void backend::notify_writer()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_writer_idle.load(std::memory_order_relaxed)) {
+            wake_writer();
+        }
+    }
+
+    void backend::wake_writer()
+    {
+        {
+            std::lock_guard<std::mutex> lock{_wake_mutex};
+            _writer_idle.store(false, std::memory_order_relaxed);
+        }
+        _wake.notify_one();
+    }
+
+    ring* backend::thread_ring()
+    {
+        static thread_local ring_owner owner{};
+        if (!owner.r) {
+            owner.r = std::make_shared<ring>();
+            std::lock_guard<std::mutex> lock{_rings_mutex};
+            _rings.push_back(owner.r);
+            for (auto& slot : _crash_rings) {
+                if (nullptr == slot.load(std::memory_order_relaxed)) {
+                    slot.store(owner.r.get(), std::memory_order_release);
+                    break;
+                }
+            }
+        }
+        return owner.r.get();
+    }
+
+    void backend::push(log_level level, uint8_t kind, char const* payload, size_t length)
+    {
+        auto const time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        auto const thread = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(reinterpret_cast<void*>(pthread_self())));
+        auto const lv = static_cast<uint8_t>(level);
+        if (!_running.load(std::memory_order_acquire)) {
+            // no writer anymore, the message is written synchronously
+            auto* r = thread_ring();
+            while (!r->push(lv, kind, time_ns, thread, payload, length)) {
+                drain_all();
+            }
+            drain_all();
+            return;
+        }
+        auto* r = thread_ring();
+        if (r->push(lv, kind, time_ns, thread, payload, length)) {
+            if (log_level::fatal == level) {
+                // the process is likely to end before the writer wakes up
+                drain_all();
+            }
+            else {
+                notify_writer();
+            }
+            return;
+        }
+        if (level < log_level::warning) {
+            // a full ring means the writer cannot keep up, dropping debug output beats stalling the frame
+            _dropped.fetch_add(1U, std::memory_order_relaxed);
+            return;
+        }
+        while (!r->push(lv, kind, time_ns, thread, payload, length)) {
+            if (!_running.load(std::memory_order_acquire)) {
+                drain_all();
+            }
+            std::this_thread::yield();
+        }
+        notify_writer();
+    }
+
+    bool backend::lock_drain(bool bounded) noexcept
+    {
+        // bounded: the holder may be the crashed thread, after ~100 ms the crash handler drains regardless
+        for (uint32_t i = 0; _draining.test_and_set(std::memory_order_acquire); ++i) {
+            if (bounded && i > 100000U) {
+                return false;
+            }
+            if (bounded) {
+                timespec const ts{0, 1000};
+                nanosleep(&ts, nullptr);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+        return true;
+    }
+
+    bool backend::drain_all()
+    {
+        lock_drain(false);
+        {
+            std::lock_guard<std::mutex> lock{_rings_mutex};
+            _drain_rings = _rings;
+        }
+        _messages.clear();
+        bool any{false};
+        for (auto const& r : _drain_rings) {
+            auto const orphaned = r->orphaned.load(std::memory_order_acquire);
+            any = r->drain([this](entry_header const& h, char const* payload) {
+                _messages.push_back(message{h, std::string{payload, h.length}});
+            }) || any;
+            if (orphaned) {
+                // nothing can be pushed anymore, the ring is empty now
+                std::lock_guard<std::mutex> lock{_rings_mutex};
+                for (auto& slot : _crash_rings) {
+                    if (r.get() == slot.load(std::memory_order_relaxed)) {
+                        slot.store(nullptr, std::memory_order_release);
+                    }
+                }
+                _rings.erase(std::remove(_rings.begin(), _rings.end(), r), _rings.end());
+            }
+        }
+        _drain_rings.clear();
+        std::stable_sort(_messages.begin(), _messages.end(), [](message const& a, message const& b) {
+            return a.header.time_ns < b.header.time_ns;
+        });
+        _out.clear();
+        auto const dropped = _dropped.exchange(0, std::memory_order_relaxed);
+        if (_binary_fd >= 0) {
+            auto sink = [this](char const* data, size_t size) { _out.append(data, size); };
+            // sites first, the decoder needs them before the first message referencing them
+            write_new_sites(sink);
+            binary_writer<decltype(sink)> writer{sink};
+            for (auto const& m : _messages) {
+                writer.entry(m.header, m.payload.data());
+            }
+            if (0 != dropped) {
+                auto const text = std::to_string(dropped) + " messages dropped, log rings full";
+                entry_header h{};
+                h.length = static_cast<uint16_t>(text.size());
+                h.level = static_cast<uint8_t>(log_level::warning);
+                h.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count();
+                writer.entry(h, text.data());
+            }
+            write_all(_binary_fd, _out.data(), _out.size());
+        }
+        else {
+            for (auto const& m : _messages) {
+                append_text(m.header, m.payload.data());
+            }
+            if (0 != dropped) {
+                _out += "[vlk log] " + std::to_string(dropped) + " messages dropped, log rings full\n";
+            }
+            write_all(STDERR_FILENO, _out.data(), _out.size());
+        }
+        unlock_drain();
+        return any;
+    }
+
+    void backend::append_text(entry_header const& h, char const* payload)
+    {
+        std::array<char, 64> prefix{};
+        _out.append(prefix.data(), format_prefix(prefix.data(), h.time_ns, h.thread, h.level, _utc_offset_s));
+        if (entry_args == h.kind) {
+            uint32_t id{0};
+            std::memcpy(&id, payload, sizeof(id));
+            auto const* site = find_site(id);
+            std::array<char, max_message_length> text{};
+            auto const n = vlk::detail::format_log_args(text.data(), text.size(), site ? site->format : "",
+                    reinterpret_cast<uint8_t const*>(payload) + sizeof(id), h.length - sizeof(id));
+            _out.append(text.data(), n);
+        }
+        else {
+            _out.append(payload, h.length);
+        }
+        _out.push_back('\n');
+    }
+
+    template<typename Sink>
+    void backend::write_new_sites(Sink& sink) noexcept
+    {
+        auto const count = site_count.load(std::memory_order_acquire);
+        binary_writer<Sink> writer{sink};
+        for (; _sites_written < count; ++_sites_written) {
+            writer.site(_sites_written, sites[_sites_written]);
+        }
+    }
+
+    void backend::set_binary_log(std::string const& path)
+    {
+        drain_all();
+        auto fd = -1;
+        if (!path.empty()) {
+            fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                throw vlk::app_exception{"Failed to open binary log " + path, errno, std::strerror(errno)};
+            }
+            std::string header{binary_magic, sizeof(binary_magic)};
+            header.append(reinterpret_cast<char const*>(&binary_version), sizeof(binary_version));
+            header.append(reinterpret_cast<char const*>(&_utc_offset_s), sizeof(_utc_offset_s));
+            write_all(fd, header.data(), header.size());
+        }
+        lock_drain(false);
+        // messages logged since drain_all() go to the new destination
+        if (_binary_fd >= 0) {
+            ::close(_binary_fd);
+        }
+        _binary_fd = fd;
+        _sites_written = 0;
+        unlock_drain();
+    }
+
+    void backend::crash_flush() noexcept
+    {
+        auto const locked = lock_drain(true);
+        // only async-signal-safe calls from here on: the rings come from the fixed snapshot, numbers are formatted
+        // by hand
+        if (_binary_fd >= 0) {
+            auto sink = [this](char const* data, size_t size) { write_all(_binary_fd, data, size); };
+            write_new_sites(sink);
+            binary_writer<decltype(sink)> writer{sink};
+            for (auto const& slot : _crash_rings) {
+                if (auto* r = slot.load(std::memory_order_acquire)) {
+                    r->drain([&writer](entry_header const& h, char const* payload) { writer.entry(h, payload); });
+                }
+            }
+        }
+        else {
+            for (auto const& slot : _crash_rings) {
+                auto* r = slot.load(std::memory_order_acquire);
+                if (nullptr == r) {
+                    continue;
+                }
+                r->drain([this](entry_header const& h, char const* payload) {
+                    std::array<char, 64> prefix{};
+                    write_all(STDERR_FILENO, prefix.data(),
+                              format_prefix(prefix.data(), h.time_ns, h.thread, h.level, _utc_offset_s));
+                    if (entry_args == h.kind) {
+                        uint32_t id{0};
+                        std::memcpy(&id, payload, sizeof(id));
+                        auto const* site = find_site(id);
+                        std::array<char, 512> text{};
+                        auto const n = format_args(text.data(), text.size(), site ? site->format : "",
+                                reinterpret_cast<uint8_t const*>(payload) + sizeof(id), h.length - sizeof(id), true);
+                        write_all(STDERR_FILENO, text.data(), n);
+                    }
+                    else {
+                        write_all(STDERR_FILENO, payload, h.length);
+                    }
+                    write_all(STDERR_FILENO, "\n", 1U);
+                });
+            }
+        }
+        if (locked) {
+            unlock_drain();
+        }
+    }
+
+    void backend::signal_handler(int sig)
+    {
+        auto& b = backend::get();
+        b.crash_flush();
+        // continue with whatever was installed before, by default terminate with a core dump
+        for (size_t i = 0; i < crash_signals.size(); ++i) {
+            if (crash_signals[i] == sig) {
+                sigaction(sig, &b._previous_actions[i], nullptr);
+            }
+        }
+        raise(sig);
+    }
+
+    void backend::stop()
+    {
+        if (!_running.exchange(false, std::memory_order_acq_rel)) {
+            return;
+        }
+        wake_writer();
+        if (_writer.joinable()) {
+            _writer.join();
+        }
+        drain_all();
+    }
+
+}
 
 void vlk::set_global_log_level(log_level lv)
 {
-    namespace logging = boost::log;
-    logging::core::get()->set_filter(logging::trivial::severity >= lv);
+    detail::global_log_level.store(static_cast<int>(lv), std::memory_order_relaxed);
+}
+
+void vlk::install_crash_log_flush()
+{
+    backend::get().install_crash_handler();
+}
+
+void vlk::flush_log()
+{
+    backend::get().drain_all();
+}
+
+void vlk::set_binary_log(std::string const& path)
+{
+    backend::get().set_binary_log(path);
+}
+
+uint32_t vlk::detail::register_log_site(log_level lv, char const* file, uint32_t line, char const* format)
+{
+    std::lock_guard<std::mutex> lock{sites_mutex};
+    auto const id = site_count.load(std::memory_order_relaxed);
+    if (id >= max_log_sites) {
+        return invalid_log_site;
+    }
+    sites[id] = log_site{static_cast<uint8_t>(lv), line, file, format};
+    site_count.store(id + 1U, std::memory_order_release);
+    return id;
+}
+
+void vlk::detail::push_log_args(uint32_t site, uint8_t const* args, size_t size)
+{
+    auto const* s = find_site(site);
+    if (nullptr == s) {
+        return;
+    }
+    std::array<char, sizeof(uint32_t) + log_args::capacity> payload{};
+    size = std::min(size, log_args::capacity);
+    std::memcpy(payload.data(), &site, sizeof(site));
+    std::memcpy(payload.data() + sizeof(site), args, size);
+    try {
+        backend::get().push(static_cast<log_level>(s->level), entry_args, payload.data(), sizeof(site) + size);
+    }
+    catch (...) {
+        // see ~log_record()
+    }
+}
+
+size_t vlk::detail::format_log_args(char* out, size_t capacity, char const* format, uint8_t const* args, size_t size)
+{
+    return format_args(out, capacity, format, args, size, false);
+}
+
+vlk::detail::log_record::log_record(log_level lv)
+    : _level{lv}
+{
+    auto& buffer = thread_buffer();
+    if (0 != buffer.depth++) {
+        _nested = std::make_unique<std::ostringstream>();
+        _stream = _nested.get();
+    }
+    else {
+        _stream = &buffer.stream;
+    }
+}
+
+vlk::detail::log_record::~log_record()
+{
+    auto& buffer = thread_buffer();
+    --buffer.depth;
+    try {
+        if (_nested) {
+            auto const text = _nested->str();
+            backend::get().push(_level, entry_text, text.data(), std::min(text.size(), max_message_length));
+            return;
+        }
+        auto const length = buffer.length();
+        if (buffer.truncated) {
+            std::memcpy(const_cast<char*>(buffer.text()) + length - 3U, "...", 3U);
+        }
+        backend::get().push(_level, entry_text, buffer.text(), length);
+    }
+    catch (...) {
+        // the first message of a thread allocates its ring, without memory the message is lost
+    }
+    // manipulators like std::hex must not leak into the thread's next message
+    buffer.reset();
+    buffer.stream.clear();
+    buffer.stream.flags(buffer.default_flags);
+    buffer.stream.precision(6);
+    buffer.stream.width(0);
+    buffer.stream.fill(' ');
 }
@@ -0,0 +1,233 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/mapped_file.h>
+#include <vlk/exception.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+// POSIX: the file is mapped and the content synced before the rename. Elsewhere it is read into a heap buffer and
+// written with the C library, the rename still replaces the file atomically but without the sync.
+#if defined(__unix__) || defined(__APPLE__)
+#define VLK_POSIX_FILES
+#endif
+
+#ifdef VLK_POSIX_FILES
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <system_error>
+#endif
+
+using namespace vlk;
+
+namespace {
+
+    [[noreturn]] void throw_errno(std::string const& msg, std::string const& path)
+    {
+        auto const error = errno;
+        throw vlk::app_exception{msg + " '" + path + "'", error, std::strerror(error)};
+    }
+
+}
+
+#ifdef VLK_POSIX_FILES
+
+mapped_file::mapped_file(std::string const& path)
+{
+    auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (0 > fd) {
+        throw_errno("unable to open file", path);
+    }
+    struct stat st{};
+    if (0 != ::fstat(fd, &st)) {
+        auto const error = errno;
+        ::close(fd);
+        errno = error;
+        throw_errno("unable to stat file", path);
+    }
+    _size = static_cast<size_t>(st.st_size);
+    if (0 != _size) {
+        auto p = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED == p) {
+            auto const error = errno;
+            ::close(fd);
+            errno = error;
+            throw_errno("unable to map file", path);
+        }
+        _data = static_cast<uint8_t const*>(p);
+    }
+    // the mapping stays valid after closing the descriptor
+    ::close(fd);
+}
+
+#else
+
+mapped_file::mapped_file(std::string const& path)
+{
+    auto* f = std::fopen(path.c_str(), "rb");
+    if (nullptr == f) {
+        throw_errno("unable to open file", path);
+    }
+    auto fail = [f, &path](std::string const& msg) {
+        auto const error = errno;
+        std::fclose(f);
+        errno = error;
+        throw_errno(msg, path);
+    };
+    if (0 != std::fseek(f, 0, SEEK_END)) {
+        fail("unable to seek file");
+    }
+    auto const size = std::ftell(f);
+    if (0 > size || 0 != std::fseek(f, 0, SEEK_SET)) {
+        fail("unable to seek file");
+    }
+    if (0 != size) {
+        auto buffer = std::make_unique<uint8_t[]>(static_cast<size_t>(size));
+        if (static_cast<size_t>(size) != std::fread(buffer.get(), 1U, static_cast<size_t>(size), f)) {
+            fail("unable to read file");
+        }
+        _size = static_cast<size_t>(size);
+        _data = buffer.release();
+    }
+    std::fclose(f);
+}
+
+#endif
+
+mapped_file::~mapped_file()
+{
+    release();
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : _data{std::exchange(other._data, nullptr)}
+    , _size{std::exchange(other._size, 0)}
+{}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0);
+    }
+    return *this;
+}
+
+void mapped_file::release() noexcept
+{
+    if (nullptr != _data) {
+#ifdef VLK_POSIX_FILES
+        ::munmap(const_cast<uint8_t*>(_data), _size);
+#else
+        delete[] _data;
+#endif
+    }
+    _data = nullptr;
+    _size = 0;
+}
+
+#ifdef VLK_POSIX_FILES
+
+void vlk::write_file_atomic(std::string const& path, void const* data, size_t size)
+{
+    auto const tmp_path = path + ".tmp." + std::to_string(::getpid());
+    auto const fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (0 > fd) {
+        throw_errno("unable to create file", tmp_path);
+    }
+    auto fail = [fd, &tmp_path](std::string const& msg) {
+        auto const error = errno;
+        ::close(fd);
+        ::unlink(tmp_path.c_str());
+        errno = error;
+        throw_errno(msg, tmp_path);
+    };
+    auto p = static_cast<char const*>(data);
+    auto remaining = size;
+    while (0 != remaining) {
+        auto const n = ::write(fd, p, remaining);
+        if (0 > n) {
+            if (EINTR == errno) {
+                continue;
+            }
+            fail("unable to write file");
+        }
+        p += n;
+        remaining -= static_cast<size_t>(n);
+    }
+    // the content has to be on disk before the rename makes it visible, otherwise a crash may leave an empty file
+    if (0 != ::fsync(fd)) {
+        fail("unable to sync file");
+    }
+    if (0 != ::close(fd)) {
+        auto const error = errno;
+        ::unlink(tmp_path.c_str());
+        errno = error;
+        throw_errno("unable to close file", tmp_path);
+    }
+    if (0 != std::rename(tmp_path.c_str(), path.c_str())) {
+        auto const error = errno;
+        ::unlink(tmp_path.c_str());
+        errno = error;
+        throw_errno("unable to rename file to", path);
+    }
+}
+
+#else
+
+void vlk::write_file_atomic(std::string const& path, void const* data, size_t size)
+{
+    auto const tmp_path = path + ".tmp." + std::to_string(std::random_device{}());
+    auto* f = std::fopen(tmp_path.c_str(), "wb");
+    if (nullptr == f) {
+        throw_errno("unable to create file", tmp_path);
+    }
+    if (size != std::fwrite(data, 1U, size, f)) {
+        auto const error = errno;
+        std::fclose(f);
+        std::remove(tmp_path.c_str());
+        errno = error;
+        throw_errno("unable to write file", tmp_path);
+    }
+    if (0 != std::fclose(f)) {
+        auto const error = errno;
+        std::remove(tmp_path.c_str());
+        errno = error;
+        throw_errno("unable to close file", tmp_path);
+    }
+    // unlike std::rename() replaces an existing file on every platform
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::remove(tmp_path.c_str());
+        throw vlk::app_exception{"unable to rename file to '" + path + "'", ec.value(), ec.message()};
+    }
+}
+
+#endif
@@ -0,0 +1,540 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/memory_allocator.h>
+#include <vlk/exception.h>
+#include <vlk/log.h>
+
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+
+using namespace vlk;
+
+namespace {
+
+    VkDeviceSize align_down(VkDeviceSize v, VkDeviceSize alignment)
+    {
+        return v / alignment * alignment;
+    }
+
+    VkDeviceSize align_up(VkDeviceSize v, VkDeviceSize alignment)
+    {
+        return (v + alignment - 1U) / alignment * alignment;
+    }
+
+    bool is_out_of_memory(VkResult r)
+    {
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY == r || VK_ERROR_OUT_OF_HOST_MEMORY == r;
+    }
+
+}
+
+memory_allocator::memory_allocator(VkDevice device, vlk::phys_device const& pd, VkDeviceSize block_size)
+    : memory_allocator{device, pd.properties, pd.memory_properties, block_size}
+{}
+
+memory_allocator::memory_allocator(VkDevice device, VkPhysicalDeviceProperties const& properties,
+                                   VkPhysicalDeviceMemoryProperties const& memory_properties,
+                                   VkDeviceSize block_size)
+    : _device{device}
+    , _mem_props{memory_properties}
+    , _block_size{block_size}
+    , _non_coherent_atom_size{std::max<VkDeviceSize>(1U, properties.limits.nonCoherentAtomSize)}
+    , _separate_linear{properties.limits.bufferImageGranularity > 1U}
+    , _max_allocations{properties.limits.maxMemoryAllocationCount}
+{
+    assert(VK_NULL_HANDLE != _device);
+    _heap_stats.resize(_mem_props.memoryHeapCount);
+}
+
+memory_allocator::~memory_allocator()
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    for (auto& b : _blocks) {
+        if (!b) {
+            continue;
+        }
+        if (!b->ranges.empty()) {
+            VLK_LOG_WARNING() << "memory_allocator: " << b->ranges.allocation_count()
+                              << " allocation(s) not freed in block of memory type " << b->memory_type;
+        }
+        free_device_memory(b->memory, nullptr != b->mapped);
+    }
+    _blocks.clear();
+    for (auto const& hs : _heap_stats) {
+        if (0 != hs.dedicated_count) {
+            VLK_LOG_WARNING() << "memory_allocator: " << hs.dedicated_count << " dedicated allocation(s) not freed";
+        }
+    }
+}
+
+uint32_t memory_allocator::find_memory_type(uint32_t type_bits, memory_usage usage) const
+{
+    VkMemoryPropertyFlags required{0};
+    VkMemoryPropertyFlags preferred{0};
+    VkMemoryPropertyFlags not_preferred{0};
+    switch (usage) {
+        case memory_usage::gpu_only:
+            preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            not_preferred = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+            break;
+        case memory_usage::cpu_to_gpu:
+            required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+            preferred = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            not_preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+            break;
+        case memory_usage::gpu_to_cpu:
+            required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+            preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+            break;
+    }
+    VkMemoryPropertyFlags const excluded{VK_MEMORY_PROPERTY_PROTECTED_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT};
+
+    // the type with the fewest missing preferred and present not-preferred properties wins
+    auto best = UINT32_MAX;
+    auto best_cost = SIZE_MAX;
+    for (uint32_t i = 0; i < _mem_props.memoryTypeCount; ++i) {
+        auto const flags = _mem_props.memoryTypes[i].propertyFlags;
+        if (0 == (type_bits & (1U << i)) || required != (flags & required) || 0 != (flags & excluded)) {
+            continue;
+        }
+        auto const cost = std::bitset<32>(preferred & ~flags).count() + std::bitset<32>(not_preferred & flags).count();
+        if (cost < best_cost) {
+            best = i;
+            best_cost = cost;
+        }
+    }
+    if (UINT32_MAX == best) {
+        throw vlk::vulkan_exception{"no suitable memory type found", VK_ERROR_FEATURE_NOT_PRESENT};
+    }
+    return best;
+}
+
+bool memory_allocator::is_coherent(uint32_t memory_type) const
+{
+    assert(memory_type < _mem_props.memoryTypeCount);
+    return 0 != (_mem_props.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+bool memory_allocator::is_host_visible(uint32_t memory_type) const
+{
+    assert(memory_type < _mem_props.memoryTypeCount);
+    return 0 != (_mem_props.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+}
+
+VkDeviceSize memory_allocator::block_size_for(uint32_t memory_type) const
+{
+    // small heaps (e.g. the 256 MiB device local + host visible window) must not be eaten by a single block
+    auto const heap_size = _mem_props.memoryHeaps[_mem_props.memoryTypes[memory_type].heapIndex].size;
+    return std::min(_block_size, std::max<VkDeviceSize>(heap_size / 8U, 1U));
+}
+
+memory_allocation memory_allocator::allocate(VkMemoryRequirements const& requirements, memory_usage usage,
+                                             bool linear)
+{
+    return allocate_for(requirements, usage, linear, false, VK_NULL_HANDLE, VK_NULL_HANDLE);
+}
+
+memory_allocation memory_allocator::allocate_for(VkMemoryRequirements const& requirements, memory_usage usage,
+                                                 bool linear, bool prefer_dedicated, VkBuffer buffer, VkImage image)
+{
+    auto const type = find_memory_type(requirements.memoryTypeBits, usage);
+    std::lock_guard<std::mutex> lock{_mutex};
+    if (!prefer_dedicated && requirements.size <= block_size_for(type) / 2U) {
+        auto a = allocate_from_blocks(requirements, type, linear);
+        if (a) {
+            return a;
+        }
+    }
+    auto a = allocate_dedicated(requirements, type, buffer, image);
+    if (!a) {
+        throw vlk::vulkan_exception{"unable to allocate device memory", VK_ERROR_OUT_OF_DEVICE_MEMORY};
+    }
+    return a;
+}
+
+memory_allocation memory_allocator::allocate_from_blocks(VkMemoryRequirements const& requirements,
+                                                         uint32_t memory_type, bool linear)
+{
+    auto const pool_linear = _separate_linear ? linear : true;
+    for (uint32_t i = 0; i < _blocks.size(); ++i) {
+        auto const& b = _blocks[i];
+        if (b && b->memory_type == memory_type && b->linear == pool_linear) {
+            auto a = sub_allocate(i, requirements);
+            if (a) {
+                return a;
+            }
+        }
+    }
+
+    // new block - halve the size when the heap is (nearly) exhausted
+    // tlsf searches for size + alignment - 1 bytes, a block of just the aligned size may not satisfy the request
+    auto const alignment = std::max<VkDeviceSize>(1U, requirements.alignment);
+    auto const min_size = std::max<VkDeviceSize>(1U, requirements.size) + alignment - 1U;
+    VkDeviceMemory mem{VK_NULL_HANDLE};
+    void* mapped{nullptr};
+    auto size = block_size_for(memory_type);
+    for (; size >= min_size; size /= 2U) {
+        mem = allocate_device_memory(size, memory_type, nullptr, &mapped);
+        if (VK_NULL_HANDLE != mem) {
+            break;
+        }
+    }
+    if (VK_NULL_HANDLE == mem) {
+        return memory_allocation{};
+    }
+    auto& hs = _heap_stats[_mem_props.memoryTypes[memory_type].heapIndex];
+    hs.block_bytes += size;
+    ++hs.block_count;
+    VLK_LOGF_DEBUG("memory_allocator: new block of {} bytes in memory type {}", size, memory_type);
+
+    auto it = std::find(_blocks.begin(), _blocks.end(), nullptr);
+    if (_blocks.end() == it) {
+        it = _blocks.insert(_blocks.end(), nullptr);
+    }
+    *it = std::make_unique<block>(block{mem, memory_type, pool_linear, tlsf{size}, mapped});
+    auto a = sub_allocate(static_cast<uint32_t>(it - _blocks.begin()), requirements);
+    if (!a) {
+        // the caller falls back to a dedicated allocation, the empty block would never be used
+        hs.block_bytes -= size;
+        --hs.block_count;
+        free_device_memory(mem, nullptr != mapped);
+        it->reset();
+    }
+    return a;
+}
+
+memory_allocation memory_allocator::sub_allocate(uint32_t block_idx, VkMemoryRequirements const& requirements)
+{
+    memory_allocation a{};
+    auto& b = *_blocks[block_idx];
+    if (auto r = b.ranges.allocate(requirements.size, std::max<VkDeviceSize>(1U, requirements.alignment))) {
+        a.memory = b.memory;
+        a.offset = r->offset;
+        a.size = r->size;
+        a.mapped = nullptr != b.mapped ? static_cast<char*>(b.mapped) + r->offset : nullptr;
+        a.memory_type = b.memory_type;
+        a.block = block_idx;
+        a.range = r->id;
+        auto& hs = _heap_stats[_mem_props.memoryTypes[b.memory_type].heapIndex];
+        hs.used_bytes += r->size;
+        ++hs.allocation_count;
+    }
+    return a;
+}
+
+memory_allocation memory_allocator::allocate_dedicated(VkMemoryRequirements const& requirements,
+                                                       uint32_t memory_type, VkBuffer buffer, VkImage image)
+{
+    VkMemoryDedicatedAllocateInfo dai{};
+    dai.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dai.pNext = nullptr;
+    dai.image = image;
+    dai.buffer = buffer;
+    auto const dedicated = VK_NULL_HANDLE != buffer || VK_NULL_HANDLE != image;
+
+    memory_allocation a{};
+    a.memory = allocate_device_memory(requirements.size, memory_type, dedicated ? &dai : nullptr, &a.mapped);
+    if (VK_NULL_HANDLE == a.memory) {
+        return a;
+    }
+    a.offset = 0;
+    a.size = requirements.size;
+    a.memory_type = memory_type;
+    auto& hs = _heap_stats[_mem_props.memoryTypes[memory_type].heapIndex];
+    hs.dedicated_bytes += a.size;
+    ++hs.dedicated_count;
+    return a;
+}
+
+VkDeviceMemory memory_allocator::allocate_device_memory(VkDeviceSize size, uint32_t memory_type, void const* next,
+                                                        void** mapped)
+{
+    if (_device_allocations >= _max_allocations) {
+        throw vlk::vulkan_exception{"maxMemoryAllocationCount exceeded", VK_ERROR_TOO_MANY_OBJECTS};
+    }
+    VkMemoryAllocateInfo ai{};
+    ai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    ai.pNext = next;
+    ai.allocationSize = size;
+    ai.memoryTypeIndex = memory_type;
+    VkDeviceMemory mem{VK_NULL_HANDLE};
+    auto r = vkAllocateMemory(_device, &ai, nullptr, &mem);
+    if (is_out_of_memory(r)) {
+        return VK_NULL_HANDLE;
+    }
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to allocate device memory", r};
+    }
+    ++_device_allocations;
+
+    *mapped = nullptr;
+    if (is_host_visible(memory_type)) {
+        r = vkMapMemory(_device, mem, 0, VK_WHOLE_SIZE, 0, mapped);
+        if (VK_SUCCESS != r) {
+            free_device_memory(mem, false);
+            throw vlk::vulkan_exception{"unable to map device memory", r};
+        }
+    }
+    return mem;
+}
+
+void memory_allocator::free_device_memory(VkDeviceMemory memory, bool mapped)
+{
+    if (mapped) {
+        vkUnmapMemory(_device, memory);
+    }
+    vkFreeMemory(_device, memory, nullptr);
+    --_device_allocations;
+}
+
+void memory_allocator::free(memory_allocation& allocation)
+{
+    if (!allocation) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto& hs = _heap_stats[_mem_props.memoryTypes[allocation.memory_type].heapIndex];
+    if (allocation.dedicated()) {
+        free_device_memory(allocation.memory, nullptr != allocation.mapped);
+        hs.dedicated_bytes -= allocation.size;
+        --hs.dedicated_count;
+        allocation = memory_allocation{};
+        return;
+    }
+
+    assert(allocation.block < _blocks.size() && _blocks[allocation.block]);
+    auto& b = *_blocks[allocation.block];
+    hs.used_bytes -= b.ranges.size(allocation.range);
+    --hs.allocation_count;
+    b.ranges.free(allocation.range);
+    if (b.ranges.empty()) {
+        // one empty block per pool is kept to avoid allocation thrashing
+        auto const other_empty = std::any_of(_blocks.begin(), _blocks.end(), [&](auto const& o) {
+            return o && o.get() != &b && o->memory_type == b.memory_type && o->linear == b.linear && o->ranges.empty();
+        });
+        if (other_empty) {
+            hs.block_bytes -= b.ranges.size();
+            --hs.block_count;
+            free_device_memory(b.memory, nullptr != b.mapped);
+            _blocks[allocation.block].reset();
+        }
+    }
+    allocation = memory_allocation{};
+}
+
+allocated_buffer memory_allocator::create_buffer(VkBufferCreateInfo const& ci, memory_usage usage)
+{
+    allocated_buffer res{};
+    auto r = vkCreateBuffer(_device, &ci, nullptr, &res.buffer);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to create buffer", r};
+    }
+
+    VkBufferMemoryRequirementsInfo2 info{};
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+    info.pNext = nullptr;
+    info.buffer = res.buffer;
+    VkMemoryDedicatedRequirements dr{};
+    dr.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+    dr.pNext = nullptr;
+    VkMemoryRequirements2 mr{};
+    mr.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    mr.pNext = &dr;
+    vkGetBufferMemoryRequirements2(_device, &info, &mr);
+
+    try {
+        auto const dedicated = VK_FALSE != dr.prefersDedicatedAllocation || VK_FALSE != dr.requiresDedicatedAllocation;
+        res.memory = allocate_for(mr.memoryRequirements, usage, true, dedicated,
+                                  dedicated ? res.buffer : VK_NULL_HANDLE, VK_NULL_HANDLE);
+        r = vkBindBufferMemory(_device, res.buffer, res.memory.memory, res.memory.offset);
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to bind buffer memory", r};
+        }
+    }
+    catch (...) {
+        destroy(res);
+        throw;
+    }
+    return res;
+}
+
+void memory_allocator::destroy(allocated_buffer& buffer)
+{
+    if (VK_NULL_HANDLE != buffer.buffer) {
+        vkDestroyBuffer(_device, buffer.buffer, nullptr);
+        buffer.buffer = VK_NULL_HANDLE;
+    }
+    free(buffer.memory);
+}
+
+allocated_image memory_allocator::create_image(VkImageCreateInfo const& ci, memory_usage usage)
+{
+    allocated_image res{};
+    auto r = vkCreateImage(_device, &ci, nullptr, &res.image);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to create image", r};
+    }
+
+    VkImageMemoryRequirementsInfo2 info{};
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+    info.pNext = nullptr;
+    info.image = res.image;
+    VkMemoryDedicatedRequirements dr{};
+    dr.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+    dr.pNext = nullptr;
+    VkMemoryRequirements2 mr{};
+    mr.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    mr.pNext = &dr;
+    vkGetImageMemoryRequirements2(_device, &info, &mr);
+
+    try {
+        auto const dedicated = VK_FALSE != dr.prefersDedicatedAllocation || VK_FALSE != dr.requiresDedicatedAllocation;
+        res.memory = allocate_for(mr.memoryRequirements, usage, VK_IMAGE_TILING_LINEAR == ci.tiling, dedicated,
+                                  VK_NULL_HANDLE, dedicated ? res.image : VK_NULL_HANDLE);
+        r = vkBindImageMemory(_device, res.image, res.memory.memory, res.memory.offset);
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to bind image memory", r};
+        }
+    }
+    catch (...) {
+        destroy(res);
+        throw;
+    }
+    return res;
+}
+
+void memory_allocator::destroy(allocated_image& image)
+{
+    if (VK_NULL_HANDLE != image.image) {
+        vkDestroyImage(_device, image.image, nullptr);
+        image.image = VK_NULL_HANDLE;
+    }
+    free(image.memory);
+}
+
+void memory_allocator::mapped_range(memory_allocation const& allocation, VkDeviceSize offset, VkDeviceSize size,
+                                    VkMappedMemoryRange& range) const
+{
+    // ranges have to be aligned to nonCoherentAtomSize but must not exceed the device memory object
+    auto const memory_size = allocation.dedicated() ? allocation.size : _blocks[allocation.block]->ranges.size();
+    auto const begin = allocation.offset + offset;
+    auto const end = VK_WHOLE_SIZE == size ? allocation.offset + allocation.size : begin + size;
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.pNext = nullptr;
+    range.memory = allocation.memory;
+    range.offset = align_down(begin, _non_coherent_atom_size);
+    auto const aligned_end = align_up(end, _non_coherent_atom_size);
+    range.size = aligned_end >= memory_size ? VK_WHOLE_SIZE : aligned_end - range.offset;
+}
+
+void memory_allocator::flush(memory_allocation const& allocation, VkDeviceSize offset, VkDeviceSize size)
+{
+    assert(allocation && nullptr != allocation.mapped);
+    if (is_coherent(allocation.memory_type)) {
+        return;
+    }
+    VkMappedMemoryRange range{};
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        mapped_range(allocation, offset, size, range);
+    }
+    auto r = vkFlushMappedMemoryRanges(_device, 1U, &range);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to flush mapped memory", r};
+    }
+}
+
+void memory_allocator::invalidate(memory_allocation const& allocation, VkDeviceSize offset, VkDeviceSize size)
+{
+    assert(allocation && nullptr != allocation.mapped);
+    if (is_coherent(allocation.memory_type)) {
+        return;
+    }
+    VkMappedMemoryRange range{};
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        mapped_range(allocation, offset, size, range);
+    }
+    auto r = vkInvalidateMappedMemoryRanges(_device, 1U, &range);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to invalidate mapped memory", r};
+    }
+}
+
+void memory_heap_stats::add_free_ranges(tlsf const& ranges)
+{
+    auto const largest = ranges.largest_free();
+    free_range_count += ranges.free_block_count();
+    largest_free_range = std::max(largest_free_range, largest);
+    scattered_free_bytes += ranges.free_size() - largest;
+}
+
+std::vector<memory_heap_stats> memory_allocator::heap_stats() const
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto res = _heap_stats;
+    for (auto const& b : _blocks) {
+        if (b) {
+            res[_mem_props.memoryTypes[b->memory_type].heapIndex].add_free_ranges(b->ranges);
+        }
+    }
+    return res;
+}
+
+double memory_allocator::block_usage(uint32_t block_idx) const
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    assert(block_idx < _blocks.size() && _blocks[block_idx]);
+    auto const& r = _blocks[block_idx]->ranges;
+    return static_cast<double>(r.used()) / static_cast<double>(r.size());
+}
+
+memory_allocation memory_allocator::allocate_compacting(VkMemoryRequirements const& requirements,
+                                                        memory_allocation const& allocation)
+{
+    assert(allocation && !allocation.dedicated());
+    if (0 == (requirements.memoryTypeBits & (1U << allocation.memory_type))) {
+        return memory_allocation{};
+    }
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto const& src = *_blocks[allocation.block];
+
+    // fullest blocks first, moving only into blocks fuller than the source avoids moving back and forth
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < _blocks.size(); ++i) {
+        auto const& b = _blocks[i];
+        if (b && i != allocation.block && b->memory_type == src.memory_type && b->linear == src.linear
+            && b->ranges.used() > src.ranges.used()) {
+            candidates.push_back(i);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](uint32_t l, uint32_t r) {
+        return _blocks[l]->ranges.used() > _blocks[r]->ranges.used();
+    });
+
+    for (auto idx : candidates) {
+        auto a = sub_allocate(idx, requirements);
+        if (a) {
+            return a;
+        }
+    }
+    return memory_allocation{};
+}
@@ -0,0 +1,263 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/memory_defragmenter.h>
+#include <vlk/exception.h>
+
+#include <algorithm>
+#include <cassert>
+
+using namespace vlk;
+
+memory_defragmenter::memory_defragmenter(VkDevice device, memory_allocator& allocator)
+    : _device{device}
+    , _allocator{allocator}
+{}
+
+memory_defragmenter::resource_id memory_defragmenter::register_buffer(allocated_buffer const& buffer,
+                                                                      VkBufferCreateInfo const& ci,
+                                                                      buffer_relocation on_move)
+{
+    assert(VK_NULL_HANDLE != buffer.buffer && buffer.memory);
+    entry e{};
+    e.is_image = false;
+    e.buffer = buffer;
+    e.buffer_ci = ci;
+    e.buffer_ci.pNext = nullptr;
+    e.on_buffer_move = std::move(on_move);
+    // identical create infos result in identical memory requirements
+    vkGetBufferMemoryRequirements(_device, buffer.buffer, &e.requirements);
+    if (VK_SHARING_MODE_CONCURRENT == ci.sharingMode) {
+        e.queue_families.assign(ci.pQueueFamilyIndices, ci.pQueueFamilyIndices + ci.queueFamilyIndexCount);
+    }
+    _entries.emplace(_next_id, std::move(e));
+    return _next_id++;
+}
+
+memory_defragmenter::resource_id memory_defragmenter::register_image(allocated_image const& image,
+                                                                     VkImageCreateInfo const& ci,
+                                                                     VkImageLayout layout, VkImageAspectFlags aspect,
+                                                                     image_relocation on_move)
+{
+    assert(VK_NULL_HANDLE != image.image && image.memory);
+    assert(VK_IMAGE_LAYOUT_UNDEFINED != layout && VK_IMAGE_LAYOUT_PREINITIALIZED != layout);
+    entry e{};
+    e.is_image = true;
+    e.image = image;
+    e.image_ci = ci;
+    e.image_ci.pNext = nullptr;
+    e.image_ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    e.layout = layout;
+    e.aspect = aspect;
+    e.on_image_move = std::move(on_move);
+    vkGetImageMemoryRequirements(_device, image.image, &e.requirements);
+    if (VK_SHARING_MODE_CONCURRENT == ci.sharingMode) {
+        e.queue_families.assign(ci.pQueueFamilyIndices, ci.pQueueFamilyIndices + ci.queueFamilyIndexCount);
+    }
+    _entries.emplace(_next_id, std::move(e));
+    return _next_id++;
+}
+
+void memory_defragmenter::unregister(resource_id id)
+{
+    _entries.erase(id);
+}
+
+bool memory_defragmenter::prepare_move(entry& e, move& m)
+{
+    // allocate first, creating a resource for a move which can't be done is expensive
+    auto mem = _allocator.allocate_compacting(e.requirements, e.memory());
+    if (!mem) {
+        return false;
+    }
+
+    VkResult r;
+    if (e.is_image) {
+        auto ci = e.image_ci;
+        ci.pQueueFamilyIndices = e.queue_families.data();
+        m.image.memory = mem;
+        r = vkCreateImage(_device, &ci, nullptr, &m.image.image);
+        if (VK_SUCCESS == r) {
+            r = vkBindImageMemory(_device, m.image.image, mem.memory, mem.offset);
+        }
+        if (VK_SUCCESS != r) {
+            _allocator.destroy(m.image);
+            throw vlk::vulkan_exception{"unable to create relocated image", r};
+        }
+    }
+    else {
+        auto ci = e.buffer_ci;
+        ci.pQueueFamilyIndices = e.queue_families.data();
+        m.buffer.memory = mem;
+        r = vkCreateBuffer(_device, &ci, nullptr, &m.buffer.buffer);
+        if (VK_SUCCESS == r) {
+            r = vkBindBufferMemory(_device, m.buffer.buffer, mem.memory, mem.offset);
+        }
+        if (VK_SUCCESS != r) {
+            _allocator.destroy(m.buffer);
+            throw vlk::vulkan_exception{"unable to create relocated buffer", r};
+        }
+    }
+    return true;
+}
+
+uint32_t memory_defragmenter::step(VkCommandBuffer cmd, defer_fn const& defer, budget const& b)
+{
+    if (_entries.empty()) {
+        return 0;
+    }
+    ++_stats.steps;
+    auto const deadline = std::chrono::steady_clock::now() + b.cpu_time;
+
+    // evacuate the emptiest blocks first
+    std::unordered_map<uint32_t, std::vector<resource_id>> by_block;
+    for (auto const& e : _entries) {
+        if (!e.second.memory().dedicated()) {
+            by_block[e.second.memory().block].push_back(e.first);
+        }
+    }
+    std::vector<std::pair<double, uint32_t>> sources;
+    for (auto const& bb : by_block) {
+        sources.emplace_back(_allocator.block_usage(bb.first), bb.first);
+    }
+    std::sort(sources.begin(), sources.end());
+
+    std::vector<move> moves;
+    VkDeviceSize bytes{0};
+    auto in_budget = [&]() { return bytes < b.bytes && std::chrono::steady_clock::now() < deadline; };
+    for (auto const& src : sources) {
+        for (auto id : by_block[src.second]) {
+            if (!in_budget()) {
+                break;
+            }
+            move m{id, {}, {}};
+            if (prepare_move(_entries.at(id), m)) {
+                bytes += _entries.at(id).requirements.size;
+                moves.push_back(m);
+            }
+        }
+    }
+    if (moves.empty()) {
+        return 0;
+    }
+
+    record(cmd, moves);
+
+    for (auto const& m : moves) {
+        auto& e = _entries.at(m.id);
+        if (e.is_image) {
+            auto old = e.image;
+            e.image = m.image;
+            defer([this, old]() mutable { _allocator.destroy(old); });
+            e.on_image_move(e.image);
+        }
+        else {
+            auto old = e.buffer;
+            e.buffer = m.buffer;
+            defer([this, old]() mutable { _allocator.destroy(old); });
+            e.on_buffer_move(e.buffer);
+        }
+    }
+    _stats.moves += moves.size();
+    _stats.bytes_moved += bytes;
+    return static_cast<uint32_t>(moves.size());
+}
+
+void memory_defragmenter::record(VkCommandBuffer cmd, std::vector<move> const& moves) const
+{
+    auto image_barrier = [](VkImage img, VkImageAspectFlags aspect, VkImageLayout old_layout,
+                            VkImageLayout new_layout, VkAccessFlags src, VkAccessFlags dst) {
+        VkImageMemoryBarrier ib{};
+        ib.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        ib.pNext = nullptr;
+        ib.srcAccessMask = src;
+        ib.dstAccessMask = dst;
+        ib.oldLayout = old_layout;
+        ib.newLayout = new_layout;
+        ib.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        ib.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        ib.image = img;
+        ib.subresourceRange = VkImageSubresourceRange{aspect, 0, VK_REMAINING_MIP_LEVELS, 0,
+                                                      VK_REMAINING_ARRAY_LAYERS};
+        return ib;
+    };
+
+    // 1. everything written before (previous frames included) is visible to the copies
+    VkMemoryBarrier mb{};
+    mb.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    mb.pNext = nullptr;
+    mb.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    mb.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    std::vector<VkImageMemoryBarrier> ibs;
+    for (auto const& m : moves) {
+        auto const& e = _entries.at(m.id);
+        if (e.is_image) {
+            if (VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL != e.layout) {
+                ibs.push_back(image_barrier(e.image.image, e.aspect, e.layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                            VK_ACCESS_MEMORY_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT));
+            }
+            ibs.push_back(image_barrier(m.image.image, e.aspect, VK_IMAGE_LAYOUT_UNDEFINED,
+                                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+        }
+    }
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                         1U, &mb, 0, nullptr, static_cast<uint32_t>(ibs.size()), ibs.data());
+
+    // 2. copies
+    std::vector<VkImageCopy> regions;
+    for (auto const& m : moves) {
+        auto const& e = _entries.at(m.id);
+        if (e.is_image) {
+            regions.clear();
+            for (uint32_t mip = 0; mip < e.image_ci.mipLevels; ++mip) {
+                VkImageCopy ic{};
+                ic.srcSubresource = VkImageSubresourceLayers{e.aspect, mip, 0, e.image_ci.arrayLayers};
+                ic.srcOffset = VkOffset3D{0, 0, 0};
+                ic.dstSubresource = ic.srcSubresource;
+                ic.dstOffset = VkOffset3D{0, 0, 0};
+                ic.extent = VkExtent3D{std::max(1U, e.image_ci.extent.width >> mip),
+                                       std::max(1U, e.image_ci.extent.height >> mip),
+                                       std::max(1U, e.image_ci.extent.depth >> mip)};
+                regions.push_back(ic);
+            }
+            vkCmdCopyImage(cmd, e.image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m.image.image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()),
+                           regions.data());
+        }
+        else {
+            VkBufferCopy bc{0, 0, e.buffer_ci.size};
+            vkCmdCopyBuffer(cmd, e.buffer.buffer, m.buffer.buffer, 1U, &bc);
+        }
+    }
+
+    // 3. moved resources are ready for any use, images back in their registered layout
+    mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    mb.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    ibs.clear();
+    for (auto const& m : moves) {
+        auto const& e = _entries.at(m.id);
+        if (e.is_image) {
+            ibs.push_back(image_barrier(m.image.image, e.aspect, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, e.layout,
+                                        VK_ACCESS_TRANSFER_WRITE_BIT,
+                                        VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT));
+        }
+    }
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                         1U, &mb, 0, nullptr, static_cast<uint32_t>(ibs.size()), ibs.data());
+}
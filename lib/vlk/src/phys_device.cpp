@@ -18,7 +18,11 @@
 //
 // ================================================================================================
 #include <vlk/phys_device.h>
+#include <vlk/final.h>
+
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 
 
 using namespace vlk;
@@ -27,6 +31,7 @@ phys_device::phys_device(VkPhysicalDevice dev)
     : device{dev}
     , properties{}
     , features{}
+    , memory_properties{}
     , queue_family_properties{}
     , extensions{}
 {
@@ -34,6 +39,7 @@ phys_device::phys_device(VkPhysicalDevice dev)
 
     vkGetPhysicalDeviceProperties(device, &properties);
     vkGetPhysicalDeviceFeatures(device, &features);
+    vkGetPhysicalDeviceMemoryProperties(device, &memory_properties);
 
     uint32_t qf_count{0};
     vkGetPhysicalDeviceQueueFamilyProperties(device, &qf_count, nullptr);
@@ -44,6 +50,19 @@ phys_device::phys_device(VkPhysicalDevice dev)
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
     extensions.resize(extension_count);
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, extensions.data());
+
+#ifdef VK_KHR_synchronization2
+    if (supports_extension(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+        VkPhysicalDeviceSynchronization2FeaturesKHR sync2{};
+        sync2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+        sync2.pNext = nullptr;
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &sync2;
+        vkGetPhysicalDeviceFeatures2(device, &features2);
+        synchronization2 = VK_TRUE == sync2.synchronization2;
+    }
+#endif
 }
 
 bool phys_device::can_present_on_surface(uint32_t queue_family_idx, VkSurfaceKHR surface) const
@@ -64,3 +83,212 @@ bool phys_device::supports_extension(std::string const& extension_name) const
     return false;
 }
 
+
+uint32_t phys_device::find_queue_family(VkQueueFlags required, VkQueueFlags excluded) const
+{
+    for (uint32_t i = 0; i < queue_family_properties.size(); ++i) {
+        auto const flags = queue_family_properties[i].queueFlags;
+        if (required == (flags & required) && 0 == (flags & excluded) && queue_family_properties[i].queueCount > 0) {
+            return i;
+        }
+    }
+    return VLK_INVALID_QF_IDX;
+}
+
+device_score vlk::score_device(VkPhysicalDeviceProperties const& properties,
+                               VkPhysicalDeviceMemoryProperties const& memory_properties,
+                               std::vector<VkQueueFamilyProperties> const& queue_families, double probe_gb_s)
+{
+    device_score s{};
+    switch (properties.deviceType) {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: s.type = 1000.0; break;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: s.type = 500.0; break;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: s.type = 250.0; break;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU: s.type = 50.0; break;
+        default: break;
+    }
+
+    // integrated GPUs report (a part of) the system memory as device local, the cap keeps that from outweighing
+    // the device type
+    VkDeviceSize local_heap{0};
+    for (uint32_t i = 0; i < memory_properties.memoryHeapCount; ++i) {
+        if (0 != (memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) {
+            local_heap = std::max(local_heap, memory_properties.memoryHeaps[i].size);
+        }
+    }
+    s.memory = std::min(200.0, 25.0 * static_cast<double>(local_heap) / (1024.0 * 1024.0 * 1024.0));
+
+    bool async_compute{false};
+    bool dma{false};
+    bool multi_graphics{false};
+    for (auto const& qf : queue_families) {
+        if (0 == qf.queueCount) {
+            continue;
+        }
+        auto const flags = qf.queueFlags;
+        async_compute = async_compute || (0 != (flags & VK_QUEUE_COMPUTE_BIT) && 0 == (flags & VK_QUEUE_GRAPHICS_BIT));
+        dma = dma || (0 != (flags & VK_QUEUE_TRANSFER_BIT)
+                      && 0 == (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)));
+        multi_graphics = multi_graphics || (0 != (flags & VK_QUEUE_GRAPHICS_BIT) && qf.queueCount > 1U);
+    }
+    s.queues = (async_compute ? 100.0 : 0.0) + (dma ? 50.0 : 0.0) + (multi_graphics ? 25.0 : 0.0);
+
+    auto const& l = properties.limits;
+    s.limits = 100.0 * std::min(1.0, l.maxImageDimension2D / 16384.0)
+             + 50.0 * std::min(1.0, l.maxComputeSharedMemorySize / 49152.0)
+             + 50.0 * std::min(1.0, l.maxPushConstantsSize / 256.0);
+
+    s.probe = std::min(500.0, std::max(0.0, probe_gb_s));
+    return s;
+}
+
+double vlk::probe_copy_bandwidth(phys_device const& pd, uint32_t queue_family_idx)
+{
+    constexpr VkDeviceSize probe_size{64ULL * 1024ULL * 1024ULL};
+    constexpr uint32_t copies{8U};
+
+    uint32_t memory_type{VLK_INVALID_QF_IDX};
+    for (uint32_t i = 0; i < pd.memory_properties.memoryTypeCount; ++i) {
+        if (0 != (pd.memory_properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+            memory_type = i;
+            break;
+        }
+    }
+    if (VLK_INVALID_QF_IDX == memory_type || queue_family_idx >= pd.queue_family_properties.size()) {
+        return 0.0;
+    }
+
+    float const priority{1.0f};
+    VkDeviceQueueCreateInfo qci{};
+    qci.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    qci.pNext = nullptr;
+    qci.flags = 0;
+    qci.queueFamilyIndex = queue_family_idx;
+    qci.queueCount = 1U;
+    qci.pQueuePriorities = &priority;
+    VkDeviceCreateInfo dci{};
+    dci.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    dci.pNext = nullptr;
+    dci.flags = 0;
+    dci.queueCreateInfoCount = 1U;
+    dci.pQueueCreateInfos = &qci;
+    dci.enabledLayerCount = 0;
+    dci.ppEnabledLayerNames = nullptr;
+    dci.enabledExtensionCount = 0;
+    dci.ppEnabledExtensionNames = nullptr;
+    dci.pEnabledFeatures = nullptr;
+    VkDevice device{VK_NULL_HANDLE};
+    if (VK_SUCCESS != vkCreateDevice(pd.device, &dci, nullptr, &device)) {
+        return 0.0;
+    }
+
+    VkBuffer buffers[2]{VK_NULL_HANDLE, VK_NULL_HANDLE};
+    VkDeviceMemory memory[2]{VK_NULL_HANDLE, VK_NULL_HANDLE};
+    VkCommandPool pool{VK_NULL_HANDLE};
+    vlk::final cleanup{[&]() {
+        if (VK_NULL_HANDLE != pool) {
+            vkDestroyCommandPool(device, pool, nullptr);
+        }
+        for (uint32_t i = 0; i < 2U; ++i) {
+            if (VK_NULL_HANDLE != buffers[i]) {
+                vkDestroyBuffer(device, buffers[i], nullptr);
+            }
+            if (VK_NULL_HANDLE != memory[i]) {
+                vkFreeMemory(device, memory[i], nullptr);
+            }
+        }
+        vkDestroyDevice(device, nullptr);
+    }};
+
+    for (uint32_t i = 0; i < 2U; ++i) {
+        VkBufferCreateInfo bci{};
+        bci.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bci.pNext = nullptr;
+        bci.flags = 0;
+        bci.size = probe_size;
+        bci.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        bci.queueFamilyIndexCount = 0;
+        bci.pQueueFamilyIndices = nullptr;
+        if (VK_SUCCESS != vkCreateBuffer(device, &bci, nullptr, &buffers[i])) {
+            return 0.0;
+        }
+        VkMemoryRequirements req{};
+        vkGetBufferMemoryRequirements(device, buffers[i], &req);
+        VkMemoryAllocateInfo mai{};
+        mai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        mai.pNext = nullptr;
+        mai.allocationSize = req.size;
+        mai.memoryTypeIndex = memory_type;
+        if (0 == (req.memoryTypeBits & (1U << memory_type))
+            || VK_SUCCESS != vkAllocateMemory(device, &mai, nullptr, &memory[i])
+            || VK_SUCCESS != vkBindBufferMemory(device, buffers[i], memory[i], 0)) {
+            return 0.0;
+        }
+    }
+
+    VkCommandPoolCreateInfo pci{};
+    pci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pci.pNext = nullptr;
+    pci.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pci.queueFamilyIndex = queue_family_idx;
+    if (VK_SUCCESS != vkCreateCommandPool(device, &pci, nullptr, &pool)) {
+        return 0.0;
+    }
+    VkCommandBufferAllocateInfo cai{};
+    cai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cai.pNext = nullptr;
+    cai.commandPool = pool;
+    cai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cai.commandBufferCount = 1U;
+    VkCommandBuffer cmd{VK_NULL_HANDLE};
+    if (VK_SUCCESS != vkAllocateCommandBuffers(device, &cai, &cmd)) {
+        return 0.0;
+    }
+
+    // back and forth copies, each one waits for the previous so the copies do not overlap
+    VkCommandBufferBeginInfo bi{};
+    bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    bi.pNext = nullptr;
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    bi.pInheritanceInfo = nullptr;
+    vkBeginCommandBuffer(cmd, &bi);
+    VkBufferCopy region{0, 0, probe_size};
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    for (uint32_t i = 0; i < copies; ++i) {
+        vkCmdCopyBuffer(cmd, buffers[i % 2U], buffers[(i + 1U) % 2U], 1U, &region);
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1U, &barrier,
+                             0, nullptr, 0, nullptr);
+    }
+    if (VK_SUCCESS != vkEndCommandBuffer(cmd)) {
+        return 0.0;
+    }
+
+    VkQueue queue{VK_NULL_HANDLE};
+    vkGetDeviceQueue(device, queue_family_idx, 0, &queue);
+    VkSubmitInfo si{};
+    si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    si.pNext = nullptr;
+    si.waitSemaphoreCount = 0;
+    si.pWaitSemaphores = nullptr;
+    si.pWaitDstStageMask = nullptr;
+    si.commandBufferCount = 1U;
+    si.pCommandBuffers = &cmd;
+    si.signalSemaphoreCount = 0;
+    si.pSignalSemaphores = nullptr;
+    // wall clock including the submission, small against 8 copies of 64 MiB on any GPU
+    auto const begin = std::chrono::steady_clock::now();
+    if (VK_SUCCESS != vkQueueSubmit(queue, 1U, &si, VK_NULL_HANDLE) || VK_SUCCESS != vkQueueWaitIdle(queue)) {
+        return 0.0;
+    }
+    auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (seconds <= 0.0) {
+        return 0.0;
+    }
+    // every copy reads and writes probe_size bytes
+    return 2.0 * static_cast<double>(probe_size) * copies / seconds / 1e9;
+}
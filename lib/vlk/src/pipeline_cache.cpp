@@ -0,0 +1,195 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/pipeline_cache.h>
+#include <vlk/exception.h>
+#include <vlk/log.h>
+#include <vlk/mapped_file.h>
+
+#include <cassert>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using namespace vlk;
+
+namespace {
+
+    constexpr uint32_t cache_magic{0x504b4c56U};     // "VLKP"
+    constexpr uint32_t cache_version{1U};
+
+    struct cache_header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendor_id;
+        uint32_t device_id;
+        uint32_t driver_version;
+        uint32_t reserved;
+        uint8_t uuid[VK_UUID_SIZE];
+        uint64_t data_size;
+        uint64_t checksum;
+    };
+
+    //! FNV-1a
+    uint64_t checksum(uint8_t const* data, size_t size)
+    {
+        uint64_t h{14695981039346656037ULL};
+        for (size_t i = 0; i < size; ++i) {
+            h = (h ^ data[i]) * 1099511628211ULL;
+        }
+        return h;
+    }
+
+}
+
+pipeline_cache::pipeline_cache(VkDevice device, phys_device const& pd, std::string path)
+    : _device{device}
+    , _props{pd.properties}
+    , _path{std::move(path)}
+{
+    mapped_file file{};
+    if (!_path.empty()) {
+        try {
+            file = mapped_file{_path};
+        }
+        catch (vlk::app_exception const& e) {
+            VLK_LOG_DEBUG() << "No pipeline cache loaded: " << e.what();
+        }
+    }
+
+    VkPipelineCacheCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    ci.pNext = nullptr;
+    ci.flags = 0;
+    ci.initialDataSize = 0;
+    ci.pInitialData = nullptr;
+    if (!file.empty()) {
+        if (is_valid(file.data(), file.size(), _props)) {
+            ci.initialDataSize = file.size() - sizeof(cache_header);
+            ci.pInitialData = file.data() + sizeof(cache_header);
+            _checksum = checksum(file.data() + sizeof(cache_header), ci.initialDataSize);
+            _data_size = ci.initialDataSize;
+        }
+        else {
+            VLK_LOG_INFO() << "Pipeline cache '" << _path << "' discarded, created by another device or driver";
+        }
+    }
+    auto r = vkCreatePipelineCache(_device, &ci, nullptr, &_cache);
+    if (VK_SUCCESS != r && nullptr != ci.pInitialData) {
+        // the driver may still reject the data although the header matches
+        VLK_LOG_WARNING() << "Pipeline cache '" << _path << "' rejected by the driver: " << vlk::to_string(r) << " ("
+                          << r << ")";
+        ci.initialDataSize = 0;
+        ci.pInitialData = nullptr;
+        _checksum = 0;
+        _data_size = 0;
+        r = vkCreatePipelineCache(_device, &ci, nullptr, &_cache);
+    }
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to create pipeline cache", r};
+    }
+    _loaded = nullptr != ci.pInitialData;
+    if (_loaded) {
+        VLK_LOG_DEBUG() << "Loaded pipeline cache '" << _path << "': " << _data_size << " bytes";
+    }
+}
+
+pipeline_cache::~pipeline_cache()
+{
+    vkDestroyPipelineCache(_device, _cache, nullptr);
+}
+
+bool pipeline_cache::is_valid(void const* file, size_t size, VkPhysicalDeviceProperties const& props)
+{
+    if (size < sizeof(cache_header)) {
+        return false;
+    }
+    cache_header h{};
+    std::memcpy(&h, file, sizeof(h));
+    auto const data = static_cast<uint8_t const*>(file) + sizeof(h);
+    return cache_magic == h.magic
+        && cache_version == h.version
+        && props.vendorID == h.vendor_id
+        && props.deviceID == h.device_id
+        && props.driverVersion == h.driver_version
+        && 0 == std::memcmp(props.pipelineCacheUUID, h.uuid, VK_UUID_SIZE)
+        && size - sizeof(h) == h.data_size
+        && checksum(data, h.data_size) == h.checksum;
+}
+
+uint64_t pipeline_cache::write_header(void* file, size_t size, VkPhysicalDeviceProperties const& props)
+{
+    assert(size >= sizeof(cache_header));
+    auto const data_size = size - sizeof(cache_header);
+    cache_header h{};
+    h.magic = cache_magic;
+    h.version = cache_version;
+    h.vendor_id = props.vendorID;
+    h.device_id = props.deviceID;
+    h.driver_version = props.driverVersion;
+    h.reserved = 0;
+    std::memcpy(h.uuid, props.pipelineCacheUUID, VK_UUID_SIZE);
+    h.data_size = data_size;
+    h.checksum = checksum(static_cast<uint8_t const*>(file) + sizeof(cache_header), data_size);
+    std::memcpy(file, &h, sizeof(h));
+    return h.checksum;
+}
+
+size_t pipeline_cache::header_size()
+{
+    return sizeof(cache_header);
+}
+
+void pipeline_cache::save()
+{
+    if (_path.empty()) {
+        return;
+    }
+    std::vector<uint8_t> file;
+    for (;;) {
+        size_t size{0};
+        auto r = vkGetPipelineCacheData(_device, _cache, &size, nullptr);
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to query pipeline cache size", r};
+        }
+        file.resize(sizeof(cache_header) + size);
+        r = vkGetPipelineCacheData(_device, _cache, &size, file.data() + sizeof(cache_header));
+        if (VK_INCOMPLETE == r) {
+            // grown in between by another thread
+            continue;
+        }
+        if (VK_SUCCESS != r) {
+            throw vlk::vulkan_exception{"unable to retrieve pipeline cache data", r};
+        }
+        file.resize(sizeof(cache_header) + size);
+        break;
+    }
+
+    auto const data_size = file.size() - sizeof(cache_header);
+    auto const data_checksum = write_header(file.data(), file.size(), _props);
+    if (data_size == _data_size && data_checksum == _checksum) {
+        VLK_LOG_DEBUG() << "Pipeline cache '" << _path << "' unchanged";
+        return;
+    }
+    vlk::write_file_atomic(_path, file.data(), file.size());
+    _checksum = data_checksum;
+    _data_size = data_size;
+    VLK_LOG_DEBUG() << "Saved pipeline cache '" << _path << "': " << data_size << " bytes";
+}
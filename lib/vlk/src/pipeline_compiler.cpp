@@ -0,0 +1,204 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/pipeline_compiler.h>
+#include <vlk/exception.h>
+#include <vlk/log.h>
+
+#include <cassert>
+
+using namespace vlk;
+
+pipeline_compiler::pipeline_compiler(VkDevice device, VkPipelineCache cache, job_system& jobs)
+    : _device{device}
+    , _cache{cache}
+    , _jobs{jobs}
+{}
+
+pipeline_compiler::~pipeline_compiler()
+{
+    try {
+        _jobs.wait(_outstanding);
+    }
+    catch (std::exception const& e) {
+        VLK_LOG_ERROR() << "pipeline_compiler: " << e.what();
+    }
+    for (auto const& r : _requests) {
+        if (VK_NULL_HANDLE != r.second.pipeline) {
+            vkDestroyPipeline(_device, r.second.pipeline, nullptr);
+        }
+    }
+}
+
+pipeline_compiler::ticket pipeline_compiler::enqueue(request r)
+{
+    ticket t;
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        t = _next++;
+        _queue.push(queued{r.priority, t});
+        _requests.emplace(t, r);
+    }
+    // the job creates whichever request has the highest priority when it starts, not necessarily this one
+    _jobs.run([this]() { compile_next(); }, &_outstanding);
+    return t;
+}
+
+pipeline_compiler::ticket pipeline_compiler::compile(VkGraphicsPipelineCreateInfo const& ci, int priority)
+{
+    request r{};
+    r.is_compute = false;
+    r.graphics = ci;
+    r.priority = priority;
+    return enqueue(r);
+}
+
+pipeline_compiler::ticket pipeline_compiler::compile(VkComputePipelineCreateInfo const& ci, int priority)
+{
+    request r{};
+    r.is_compute = true;
+    r.compute = ci;
+    r.priority = priority;
+    return enqueue(r);
+}
+
+std::vector<pipeline_compiler::ticket> pipeline_compiler::compile(std::vector<VkGraphicsPipelineCreateInfo> const& cis,
+                                                                  int priority)
+{
+    std::vector<ticket> tickets;
+    tickets.reserve(cis.size());
+    for (auto const& ci : cis) {
+        tickets.push_back(compile(ci, priority));
+    }
+    return tickets;
+}
+
+std::vector<pipeline_compiler::ticket> pipeline_compiler::compile(std::vector<VkComputePipelineCreateInfo> const& cis,
+                                                                  int priority)
+{
+    std::vector<ticket> tickets;
+    tickets.reserve(cis.size());
+    for (auto const& ci : cis) {
+        tickets.push_back(compile(ci, priority));
+    }
+    return tickets;
+}
+
+void pipeline_compiler::compile(request& r)
+{
+    auto const start = std::chrono::steady_clock::now();
+    // request nodes of an unordered_map are stable, only the creating thread touches r until done is set
+    auto result = r.is_compute
+                ? vkCreateComputePipelines(_device, _cache, 1U, &r.compute, nullptr, &r.pipeline)
+                : vkCreateGraphicsPipelines(_device, _cache, 1U, &r.graphics, nullptr, &r.pipeline);
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        r.result = result;
+        r.done = true;
+        if (VK_SUCCESS == result) {
+            ++_stats.created;
+        }
+        else {
+            r.pipeline = VK_NULL_HANDLE;
+            ++_stats.failed;
+        }
+        _stats.cpu_time += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+    }
+    _done.notify_all();
+}
+
+bool pipeline_compiler::compile_next()
+{
+    request* r{nullptr};
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (_queue.empty()) {
+            // already created by a thread waiting in take()
+            return false;
+        }
+        r = &_requests.at(_queue.top().t);
+        _queue.pop();
+    }
+    compile(*r);
+    return true;
+}
+
+bool pipeline_compiler::is_ready(ticket t) const
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto it = _requests.find(t);
+    assert(_requests.end() != it);
+    return it->second.done;
+}
+
+VkPipeline pipeline_compiler::take(ticket t)
+{
+    std::unique_lock<std::mutex> lock{_mutex};
+    auto it = _requests.find(t);
+    if (_requests.end() == it) {
+        throw vlk::app_exception{"pipeline_compiler: unknown ticket"};
+    }
+    while (!it->second.done) {
+        if (_queue.empty()) {
+            // t is being created by another thread
+            _done.wait(lock);
+            continue;
+        }
+        // help instead of blocking, highest priority first like the workers
+        auto& r = _requests.at(_queue.top().t);
+        _queue.pop();
+        lock.unlock();
+        compile(r);
+        lock.lock();
+    }
+    auto const result = it->second.result;
+    auto const pipeline = it->second.pipeline;
+    _requests.erase(it);
+    if (VK_SUCCESS != result) {
+        throw vlk::vulkan_exception{"unable to create pipeline", result};
+    }
+    return pipeline;
+}
+
+void pipeline_compiler::wait_idle()
+{
+    std::unique_lock<std::mutex> lock{_mutex};
+    while (!_queue.empty()) {
+        auto& r = _requests.at(_queue.top().t);
+        _queue.pop();
+        lock.unlock();
+        compile(r);
+        lock.lock();
+    }
+    _done.wait(lock, [this]() {
+        for (auto const& r : _requests) {
+            if (!r.second.done) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+pipeline_compiler::stats pipeline_compiler::get_stats() const
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    return _stats;
+}
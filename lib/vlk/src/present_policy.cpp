@@ -0,0 +1,86 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/present_policy.h>
+
+#include <algorithm>
+#include <initializer_list>
+
+using namespace vlk;
+
+namespace {
+
+    VkPresentModeKHR first_supported(std::initializer_list<VkPresentModeKHR> preferred,
+                                     std::vector<VkPresentModeKHR> const& modes)
+    {
+        for (auto pm : preferred) {
+            if (modes.end() != std::find(modes.begin(), modes.end(), pm)) {
+                return pm;
+            }
+        }
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
+
+}
+
+char const* vlk::to_string(present_policy pp)
+{
+    switch (pp) {
+        case present_policy::balanced: return "balanced";
+        case present_policy::low_latency: return "low_latency";
+        case present_policy::throughput: return "throughput";
+        case present_policy::power_saver: return "power_saver";
+        default:
+            break;
+    }
+    return "unknown";
+}
+
+VkPresentModeKHR vlk::select_present_mode(present_policy policy, std::vector<VkPresentModeKHR> const& modes)
+{
+    switch (policy) {
+        case present_policy::balanced:
+            return first_supported({VK_PRESENT_MODE_MAILBOX_KHR}, modes);
+        case present_policy::low_latency:
+            // MAILBOX shows the newest frame at the next vblank without tearing, IMMEDIATE tears but never waits
+            return first_supported({VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR}, modes);
+        case present_policy::power_saver:
+            // late frames are shown immediately instead of waiting another vblank
+            return first_supported({VK_PRESENT_MODE_FIFO_RELAXED_KHR}, modes);
+        default:
+            break;
+    }
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+uint32_t vlk::select_image_count(present_policy policy, VkSurfaceCapabilitiesKHR const& capabilities)
+{
+    uint32_t extra{1U};
+    if (present_policy::low_latency == policy) {
+        extra = 0;
+    }
+    else if (present_policy::throughput == policy) {
+        extra = 2U;
+    }
+    auto count = capabilities.minImageCount + extra;
+    if (capabilities.maxImageCount > 0 && count > capabilities.maxImageCount) {
+        count = capabilities.maxImageCount;
+    }
+    return count;
+}
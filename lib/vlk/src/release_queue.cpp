@@ -0,0 +1,58 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/release_queue.h>
+
+#include <algorithm>
+#include <iterator>
+
+using namespace vlk;
+
+release_queue::release_queue(uint32_t frames_in_flight)
+    : _frames_in_flight{frames_in_flight}
+{}
+
+void release_queue::push(uint64_t unused_from, std::function<void()> fn)
+{
+    _pending.emplace_back(unused_from, std::move(fn));
+}
+
+void release_queue::run(uint64_t frame) noexcept
+{
+    // the last frame using the resources is unused_from - 1, it has to be at most frame - N
+    run_if([this, frame](uint64_t unused_from) { return unused_from + _frames_in_flight <= frame + 1U; });
+}
+
+void release_queue::run_all() noexcept
+{
+    run_if([](uint64_t) { return true; });
+}
+
+void release_queue::run_if(std::function<bool(uint64_t)> const& due) noexcept
+{
+    // functors may queue further releases, so the due ones are taken out before they are invoked
+    auto it = std::stable_partition(_pending.begin(), _pending.end(),
+            [&due](auto const& p) { return !due(p.first); });
+    std::vector<std::pair<uint64_t, std::function<void()>>> ready{std::make_move_iterator(it),
+            std::make_move_iterator(_pending.end())};
+    _pending.erase(it, _pending.end());
+    for (auto& p : ready) {
+        p.second();
+    }
+}
@@ -0,0 +1,521 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/render_graph.h>
+#include <vlk/exception.h>
+#include <vlk/format_info.h>
+#include <vlk/log.h>
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+using namespace vlk;
+
+namespace {
+
+    constexpr VkAccessFlags write_access_mask{VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+            | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT
+            | VK_ACCESS_MEMORY_WRITE_BIT};
+
+    //! Image usage implied by an access.
+    VkImageUsageFlags usage_of(VkAccessFlags access, VkImageLayout layout)
+    {
+        VkImageUsageFlags usage{0};
+        if (0 != (access & (VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT))
+            || VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL == layout) {
+            usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        }
+        if (0 != (access & (VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT))
+            || VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL == layout) {
+            usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        }
+        if (0 != (access & VK_ACCESS_INPUT_ATTACHMENT_READ_BIT)) {
+            usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+        }
+        if (VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL == layout
+            || VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL == layout) {
+            usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+        }
+        if (VK_IMAGE_LAYOUT_GENERAL == layout
+            && 0 != (access & (VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT))) {
+            usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+        }
+        if (0 != (access & VK_ACCESS_TRANSFER_READ_BIT) || VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL == layout) {
+            usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+        if (0 != (access & VK_ACCESS_TRANSFER_WRITE_BIT) || VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL == layout) {
+            usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        }
+        return usage;
+    }
+
+    bool overlaps(uint32_t first_a, uint32_t last_a, uint32_t first_b, uint32_t last_b)
+    {
+        return first_a <= last_b && first_b <= last_a;
+    }
+
+}
+
+render_graph::pass_builder& render_graph::pass_builder::add(resource_id id, VkPipelineStageFlags stages,
+                                                            VkAccessFlags access, VkImageLayout layout, bool write)
+{
+    auto const& r = _graph.get(id);
+    if (r.is_buffer) {
+        layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+    auto& p = _graph._passes[_pass];
+    // several accesses of one resource in a pass become one access, e.g. read-modify-write
+    auto it = std::find_if(p.accesses.begin(), p.accesses.end(), [id](auto const& a) { return a.id == id; });
+    if (p.accesses.end() == it) {
+        p.accesses.push_back(pass_access{id, stages, access, layout, write});
+        return *this;
+    }
+    if (it->layout != layout) {
+        throw vlk::app_exception{"render_graph: pass '" + p.name + "' uses '" + r.name + "' in two layouts"};
+    }
+    it->stages |= stages;
+    it->access |= access;
+    it->write = it->write || write;
+    return *this;
+}
+
+render_graph::pass_builder& render_graph::pass_builder::read(resource_id id, VkPipelineStageFlags stages,
+                                                             VkAccessFlags access, VkImageLayout layout)
+{
+    return add(id, stages, access, layout, false);
+}
+
+render_graph::pass_builder& render_graph::pass_builder::write(resource_id id, VkPipelineStageFlags stages,
+                                                              VkAccessFlags access, VkImageLayout layout)
+{
+    return add(id, stages, access, layout, true);
+}
+
+render_graph::pass_builder& render_graph::pass_builder::side_effect()
+{
+    _graph._passes[_pass].side_effect = true;
+    return *this;
+}
+
+render_graph::render_graph(VkDevice device, memory_allocator& allocator)
+    : _device{device}
+    , _allocator{allocator}
+{}
+
+render_graph::~render_graph()
+{
+    release_transients();
+}
+
+render_graph::resource& render_graph::get(resource_id id)
+{
+    if (id >= _resources.size()) {
+        throw vlk::app_exception{"render_graph: unknown resource"};
+    }
+    return _resources[id];
+}
+
+render_graph::resource const& render_graph::get(resource_id id) const
+{
+    if (id >= _resources.size()) {
+        throw vlk::app_exception{"render_graph: unknown resource"};
+    }
+    return _resources[id];
+}
+
+render_graph::resource_id render_graph::import_image(std::string name, VkImage image, VkImageView view,
+                                                     VkImageSubresourceRange const& range)
+{
+    resource r{};
+    r.name = std::move(name);
+    r.imported = true;
+    r.image = image;
+    r.view = view;
+    r.range = range;
+    _resources.push_back(std::move(r));
+    _compiled = false;
+    return static_cast<resource_id>(_resources.size() - 1U);
+}
+
+render_graph::resource_id render_graph::import_buffer(std::string name, VkBuffer buffer)
+{
+    resource r{};
+    r.name = std::move(name);
+    r.imported = true;
+    r.is_buffer = true;
+    r.buffer = buffer;
+    _resources.push_back(std::move(r));
+    _compiled = false;
+    return static_cast<resource_id>(_resources.size() - 1U);
+}
+
+render_graph::resource_id render_graph::create_image(std::string name, image_desc const& desc)
+{
+    resource r{};
+    r.name = std::move(name);
+    r.desc = desc;
+    r.range.aspectMask = 0 != desc.aspect ? desc.aspect : get_format_info(desc.format).aspect;
+    r.range.baseMipLevel = 0;
+    r.range.levelCount = desc.mip_levels;
+    r.range.baseArrayLayer = 0;
+    r.range.layerCount = desc.array_layers;
+    _resources.push_back(std::move(r));
+    _compiled = false;
+    return static_cast<resource_id>(_resources.size() - 1U);
+}
+
+void render_graph::set_image(resource_id id, VkImage image, VkImageView view)
+{
+    auto& r = get(id);
+    if (!r.imported || r.is_buffer) {
+        throw vlk::app_exception{"render_graph: '" + r.name + "' is no imported image"};
+    }
+    r.image = image;
+    r.view = view;
+}
+
+void render_graph::set_buffer(resource_id id, VkBuffer buffer)
+{
+    auto& r = get(id);
+    if (!r.imported || !r.is_buffer) {
+        throw vlk::app_exception{"render_graph: '" + r.name + "' is no imported buffer"};
+    }
+    r.buffer = buffer;
+}
+
+render_graph::pass_builder render_graph::add_pass(std::string name, execute_fn fn)
+{
+    pass p{};
+    p.name = std::move(name);
+    p.fn = std::move(fn);
+    _passes.push_back(std::move(p));
+    _compiled = false;
+    return pass_builder{*this, static_cast<uint32_t>(_passes.size() - 1U)};
+}
+
+VkImage render_graph::image(resource_id id) const
+{
+    return get(id).image;
+}
+
+VkImageView render_graph::view(resource_id id) const
+{
+    return get(id).view;
+}
+
+VkBuffer render_graph::buffer(resource_id id) const
+{
+    return get(id).buffer;
+}
+
+void render_graph::clear()
+{
+    release_transients();
+    _resources.clear();
+    _passes.clear();
+    _order.clear();
+    _level_begin.clear();
+    _compiled = false;
+    _stats = stats{};
+}
+
+void render_graph::cull()
+{
+    // backwards: a resource is needed when a later kept pass reads it before anyone writes it again
+    std::vector<bool> needed(_resources.size(), false);
+    for (auto it = _passes.rbegin(); it != _passes.rend(); ++it) {
+        auto& p = *it;
+        p.alive = p.side_effect;
+        for (auto const& a : p.accesses) {
+            if (a.write && (needed[a.id] || _resources[a.id].imported)) {
+                p.alive = true;
+            }
+        }
+        if (!p.alive) {
+            continue;
+        }
+        for (auto const& a : p.accesses) {
+            if (a.write) {
+                needed[a.id] = false;
+            }
+        }
+        for (auto const& a : p.accesses) {
+            // writes may only touch a part of the resource (e.g. load op LOAD), reads declare what is kept
+            if (!a.write || 0 != (a.access & ~write_access_mask)) {
+                needed[a.id] = true;
+            }
+        }
+    }
+}
+
+void render_graph::schedule()
+{
+    // a pass depends on the last writer of what it reads, writes (and layout transitions, which write) also depend
+    // on the reads since - the level of a pass is one above its deepest dependency
+    struct tracking
+    {
+        VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+        int last_write{-1};
+        int last_read{-1};
+    };
+    std::vector<tracking> track(_resources.size());
+    uint32_t level_count{0};
+    for (auto& p : _passes) {
+        if (!p.alive) {
+            continue;
+        }
+        int level{0};
+        for (auto const& a : p.accesses) {
+            auto const& t = track[a.id];
+            auto const writes = a.write || 0 != (a.access & write_access_mask) || a.layout != t.layout;
+            level = std::max(level, 1 + (writes ? std::max(t.last_write, t.last_read) : t.last_write));
+        }
+        p.level = static_cast<uint32_t>(level);
+        level_count = std::max(level_count, p.level + 1U);
+        for (auto const& a : p.accesses) {
+            auto& t = track[a.id];
+            auto const writes = a.write || 0 != (a.access & write_access_mask) || a.layout != t.layout;
+            if (writes) {
+                t.layout = a.layout;
+                t.last_write = level;
+                t.last_read = -1;
+            }
+            else {
+                t.last_read = std::max(t.last_read, level);
+            }
+        }
+    }
+
+    _order.clear();
+    for (uint32_t i = 0; i < _passes.size(); ++i) {
+        if (_passes[i].alive) {
+            _order.push_back(i);
+        }
+    }
+    std::stable_sort(_order.begin(), _order.end(),
+                     [this](uint32_t a, uint32_t b) { return _passes[a].level < _passes[b].level; });
+    _level_begin.assign(level_count + 1U, static_cast<uint32_t>(_order.size()));
+    for (uint32_t i = static_cast<uint32_t>(_order.size()); i-- > 0;) {
+        _level_begin[_passes[_order[i]].level] = i;
+    }
+    for (uint32_t l = level_count; l-- > 0;) {
+        // levels are never empty, but keep the table monotonic anyway
+        _level_begin[l] = std::min(_level_begin[l], _level_begin[l + 1U]);
+    }
+
+    for (auto& r : _resources) {
+        r.used = false;
+        r.all_stages = 0;
+        r.all_access = 0;
+        r.usage = r.desc.usage;
+    }
+    for (auto idx : _order) {
+        auto const& p = _passes[idx];
+        for (auto const& a : p.accesses) {
+            auto& r = _resources[a.id];
+            r.first_level = r.used ? std::min(r.first_level, p.level) : p.level;
+            r.last_level = r.used ? std::max(r.last_level, p.level) : p.level;
+            r.used = true;
+            r.all_stages |= a.stages;
+            r.all_access |= a.access;
+            if (!r.is_buffer) {
+                r.usage |= usage_of(a.access, a.layout);
+            }
+        }
+    }
+    _stats.passes = static_cast<uint32_t>(_passes.size());
+    _stats.culled_passes = static_cast<uint32_t>(_passes.size() - _order.size());
+    _stats.levels = level_count;
+}
+
+void render_graph::create_transients()
+{
+    std::vector<resource_id> transients;
+    for (resource_id id = 0; id < _resources.size(); ++id) {
+        auto& r = _resources[id];
+        if (r.imported || !r.used) {
+            continue;
+        }
+        VkImageCreateInfo ci{};
+        ci.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        ci.pNext = nullptr;
+        ci.flags = 0;
+        ci.imageType = VK_IMAGE_TYPE_2D;
+        ci.format = r.desc.format;
+        ci.extent = VkExtent3D{r.desc.extent.width, r.desc.extent.height, 1U};
+        ci.mipLevels = r.desc.mip_levels;
+        ci.arrayLayers = r.desc.array_layers;
+        ci.samples = r.desc.samples;
+        ci.tiling = VK_IMAGE_TILING_OPTIMAL;
+        ci.usage = r.usage;
+        ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        ci.queueFamilyIndexCount = 0;
+        ci.pQueueFamilyIndices = nullptr;
+        ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        auto res = vkCreateImage(_device, &ci, nullptr, &r.image);
+        if (VK_SUCCESS != res) {
+            throw vlk::vulkan_exception{"unable to create transient image '" + r.name + "'", res};
+        }
+        vkGetImageMemoryRequirements(_device, r.image, &r.requirements);
+        transients.push_back(id);
+        ++_stats.transient_images;
+        _stats.transient_bytes += r.requirements.size;
+    }
+
+    // largest first, each image goes to the first slot whose images are all dead during its level range
+    std::stable_sort(transients.begin(), transients.end(), [this](resource_id a, resource_id b) {
+        return _resources[a].requirements.size > _resources[b].requirements.size;
+    });
+    for (auto id : transients) {
+        auto& r = _resources[id];
+        auto it = std::find_if(_slots.begin(), _slots.end(), [this, &r](slot const& s) {
+            if (0 == (s.requirements.memoryTypeBits & r.requirements.memoryTypeBits)) {
+                return false;
+            }
+            return std::none_of(s.images.begin(), s.images.end(), [this, &r](resource_id other) {
+                auto const& o = _resources[other];
+                return overlaps(r.first_level, r.last_level, o.first_level, o.last_level);
+            });
+        });
+        if (_slots.end() == it) {
+            it = _slots.insert(_slots.end(), slot{});
+            it->requirements.memoryTypeBits = r.requirements.memoryTypeBits;
+        }
+        it->images.push_back(id);
+        it->requirements.size = std::max(it->requirements.size, r.requirements.size);
+        it->requirements.alignment = std::max(it->requirements.alignment, r.requirements.alignment);
+        it->requirements.memoryTypeBits &= r.requirements.memoryTypeBits;
+        r.slot = static_cast<uint32_t>(it - _slots.begin());
+    }
+
+    for (auto& s : _slots) {
+        s.memory = _allocator.allocate(s.requirements, memory_usage::gpu_only, false);
+        _stats.allocated_bytes += s.requirements.size;
+        for (auto id : s.images) {
+            auto& r = _resources[id];
+            auto res = vkBindImageMemory(_device, r.image, s.memory.memory, s.memory.offset);
+            if (VK_SUCCESS != res) {
+                throw vlk::vulkan_exception{"unable to bind memory of transient image '" + r.name + "'", res};
+            }
+            VkImageViewCreateInfo vci{};
+            vci.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            vci.pNext = nullptr;
+            vci.flags = 0;
+            vci.image = r.image;
+            vci.viewType = 1U < r.desc.array_layers ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+            vci.format = r.desc.format;
+            vci.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+            vci.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+            vci.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+            vci.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+            vci.subresourceRange = r.range;
+            res = vkCreateImageView(_device, &vci, nullptr, &r.view);
+            if (VK_SUCCESS != res) {
+                throw vlk::vulkan_exception{"unable to create view of transient image '" + r.name + "'", res};
+            }
+        }
+    }
+}
+
+void render_graph::release_transients() noexcept
+{
+    for (auto& r : _resources) {
+        if (r.imported) {
+            continue;
+        }
+        if (VK_NULL_HANDLE != r.view) {
+            vkDestroyImageView(_device, r.view, nullptr);
+        }
+        if (VK_NULL_HANDLE != r.image) {
+            vkDestroyImage(_device, r.image, nullptr);
+        }
+        r.view = VK_NULL_HANDLE;
+        r.image = VK_NULL_HANDLE;
+        r.slot = no_slot;
+    }
+    for (auto& s : _slots) {
+        if (s.memory) {
+            _allocator.free(s.memory);
+        }
+    }
+    _slots.clear();
+}
+
+void render_graph::compile()
+{
+    release_transients();
+    _compiled = false;
+    _stats = stats{};
+    cull();
+    schedule();
+    create_transients();
+    _compiled = true;
+    VLK_LOGF_DEBUG("render_graph: {} of {} passes in {} levels, {} transient images, {} bytes aliased into {} bytes",
+                   _order.size(), _passes.size(), _stats.levels, _stats.transient_images, _stats.transient_bytes,
+                   _stats.allocated_bytes);
+}
+
+void render_graph::execute(VkCommandBuffer cmd, barrier_batch& barriers)
+{
+    if (!_compiled) {
+        throw vlk::app_exception{"render_graph: execute() without compile()"};
+    }
+    for (uint32_t level = 0; level + 1U < _level_begin.size(); ++level) {
+        // transient content starts undefined in each frame, the image has to wait for the slot's previous image
+        for (auto& s : _slots) {
+            for (auto id : s.images) {
+                auto const& r = _resources[id];
+                if (r.first_level == level) {
+                    barriers.track(r.image, VK_IMAGE_LAYOUT_UNDEFINED, s.last_stages, s.last_access);
+                    s.last_stages = r.all_stages;
+                    s.last_access = r.all_access;
+                }
+            }
+        }
+        for (auto i = _level_begin[level]; i < _level_begin[level + 1U]; ++i) {
+            for (auto const& a : _passes[_order[i]].accesses) {
+                auto const& r = _resources[a.id];
+                if (r.is_buffer) {
+                    barriers.buffer(r.buffer, a.stages, a.access);
+                }
+                else {
+                    barriers.image(r.image, r.range, a.stages, a.access, a.layout);
+                }
+            }
+        }
+        barriers.flush(cmd);
+        for (auto i = _level_begin[level]; i < _level_begin[level + 1U]; ++i) {
+            auto const& p = _passes[_order[i]];
+            if (p.fn) {
+                p.fn(cmd);
+            }
+        }
+    }
+}
+
+std::vector<std::string> render_graph::execution_order() const
+{
+    std::vector<std::string> names;
+    names.reserve(_order.size());
+    for (auto idx : _order) {
+        names.push_back(_passes[idx].name);
+    }
+    return names;
+}
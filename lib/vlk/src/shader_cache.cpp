@@ -0,0 +1,235 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/shader_cache.h>
+#include <vlk/exception.h>
+#include <vlk/log.h>
+#include <vlk/mapped_file.h>
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+using namespace vlk;
+
+namespace {
+
+    //! FNV-1a
+    uint64_t content_hash(uint8_t const* data, size_t size)
+    {
+        uint64_t h{14695981039346656037ULL};
+        for (size_t i = 0; i < size; ++i) {
+            h = (h ^ data[i]) * 1099511628211ULL;
+        }
+        return h;
+    }
+
+}
+
+VkPipelineShaderStageCreateInfo shader_cache::shader::stage_info() const
+{
+    VkPipelineShaderStageCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    ci.pNext = nullptr;
+    ci.flags = 0;
+    // the lowest stage bit is the stage of the first entry point for single stage modules
+    ci.stage = static_cast<VkShaderStageFlagBits>(reflection.stages & (~reflection.stages + 1U));
+    ci.module = module;
+    ci.pName = reflection.entry_point.c_str();
+    ci.pSpecializationInfo = nullptr;
+    return ci;
+}
+
+bool shader_cache::binding_key_less::operator()(std::vector<VkDescriptorSetLayoutBinding> const& a,
+                                                std::vector<VkDescriptorSetLayoutBinding> const& b) const
+{
+    return std::lexicographical_compare(
+        a.begin(), a.end(), b.begin(), b.end(),
+        [](VkDescriptorSetLayoutBinding const& x, VkDescriptorSetLayoutBinding const& y) {
+            return std::make_tuple(x.binding, static_cast<uint32_t>(x.descriptorType), x.descriptorCount,
+                                   x.stageFlags)
+                < std::make_tuple(y.binding, static_cast<uint32_t>(y.descriptorType), y.descriptorCount,
+                                  y.stageFlags);
+        });
+}
+
+shader_cache::shader_cache(VkDevice device)
+    : _device{device}
+{}
+
+shader_cache::~shader_cache()
+{
+    release();
+}
+
+void shader_cache::release() noexcept
+{
+    for (auto& l : _layouts) {
+        vkDestroyPipelineLayout(_device, l.second->pipeline_layout, nullptr);
+    }
+    _layouts.clear();
+    for (auto& s : _set_layouts) {
+        vkDestroyDescriptorSetLayout(_device, s.second, nullptr);
+    }
+    _set_layouts.clear();
+    for (auto& s : _shaders) {
+        vkDestroyShaderModule(_device, s.second->module, nullptr);
+    }
+    _shaders.clear();
+}
+
+shader_cache::shader const& shader_cache::load(std::string const& path)
+{
+    mapped_file file{path};
+    if (0 != file.size() % sizeof(uint32_t)) {
+        throw vlk::app_exception{"shader file '" + path + "' is no SPIR-V module"};
+    }
+    try {
+        return create(reinterpret_cast<uint32_t const*>(file.data()), file.size());
+    }
+    // the same exception type with the path prepended, what() adds the error code again
+    catch (vlk::vulkan_exception const& e) {
+        throw vlk::vulkan_exception{"shader file '" + path + "': " + e.std::runtime_error::what(),
+                                    static_cast<VkResult>(e._error_code)};
+    }
+    catch (vlk::app_exception const& e) {
+        throw vlk::app_exception{"shader file '" + path + "': " + e.std::runtime_error::what(), e._error_code,
+                                 e._error_descr};
+    }
+}
+
+shader_cache::shader const& shader_cache::create(uint32_t const* code, size_t size)
+{
+    auto const hash = content_hash(reinterpret_cast<uint8_t const*>(code), size);
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        ++_stats.loads;
+        if (auto const* cached = find(hash, code, size)) {
+            return *cached;
+        }
+    }
+
+    // reflection and module creation run unlocked, a concurrent load of the same code creates a second module
+    // which is dropped below
+    auto s = std::make_unique<shader>();
+    s->hash = hash;
+    s->code.assign(code, code + size / sizeof(uint32_t));
+    s->reflection = reflect_spirv(code, size / sizeof(uint32_t));
+    VkShaderModuleCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    ci.pNext = nullptr;
+    ci.flags = 0;
+    ci.codeSize = size;
+    ci.pCode = code;
+    auto res = vkCreateShaderModule(_device, &ci, nullptr, &s->module);
+    if (VK_SUCCESS != res) {
+        throw vlk::vulkan_exception{"unable to create shader module", res};
+    }
+
+    std::lock_guard<std::mutex> lock{_mutex};
+    if (auto const* cached = find(hash, code, size)) {
+        vkDestroyShaderModule(_device, s->module, nullptr);
+        return *cached;
+    }
+    s->id = ++_stats.modules;
+    return *_shaders.emplace(hash, std::move(s))->second;
+}
+
+shader_cache::shader const* shader_cache::find(uint64_t hash, uint32_t const* code, size_t size) const
+{
+    // modules of different code with the same hash are kept side by side
+    auto range = _shaders.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        auto const& c = it->second->code;
+        if (c.size() * sizeof(uint32_t) == size && 0 == std::memcmp(c.data(), code, size)) {
+            return it->second.get();
+        }
+    }
+    return nullptr;
+}
+
+VkDescriptorSetLayout shader_cache::set_layout(std::vector<VkDescriptorSetLayoutBinding> const& bindings)
+{
+    auto it = _set_layouts.find(bindings);
+    if (_set_layouts.end() != it) {
+        return it->second;
+    }
+    VkDescriptorSetLayoutCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    ci.pNext = nullptr;
+    ci.flags = 0;
+    ci.bindingCount = static_cast<uint32_t>(bindings.size());
+    ci.pBindings = bindings.data();
+    VkDescriptorSetLayout set_layout{VK_NULL_HANDLE};
+    auto res = vkCreateDescriptorSetLayout(_device, &ci, nullptr, &set_layout);
+    if (VK_SUCCESS != res) {
+        throw vlk::vulkan_exception{"unable to create descriptor set layout", res};
+    }
+    _set_layouts.emplace(bindings, set_layout);
+    return set_layout;
+}
+
+shader_cache::layout const& shader_cache::pipeline_layout(std::vector<shader const*> const& stages)
+{
+    std::vector<uint64_t> key;
+    key.reserve(stages.size());
+    for (auto const* s : stages) {
+        key.push_back(s->id);
+    }
+    std::sort(key.begin(), key.end());
+
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto it = _layouts.find(key);
+    if (_layouts.end() != it) {
+        return *it->second;
+    }
+
+    std::vector<spirv_reflection const*> reflections;
+    reflections.reserve(stages.size());
+    for (auto const* s : stages) {
+        reflections.push_back(&s->reflection);
+    }
+    auto const merged = merge_reflections(reflections);
+    auto const& push = merged.push_constants;
+
+    auto l = std::make_unique<layout>();
+    for (auto const& set : merged.sets) {
+        l->set_layouts.push_back(set_layout(set));
+    }
+    VkPipelineLayoutCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    ci.pNext = nullptr;
+    ci.flags = 0;
+    ci.setLayoutCount = static_cast<uint32_t>(l->set_layouts.size());
+    ci.pSetLayouts = l->set_layouts.data();
+    ci.pushConstantRangeCount = 0 != push.size ? 1U : 0;
+    ci.pPushConstantRanges = &push;
+    auto res = vkCreatePipelineLayout(_device, &ci, nullptr, &l->pipeline_layout);
+    if (VK_SUCCESS != res) {
+        throw vlk::vulkan_exception{"unable to create pipeline layout", res};
+    }
+    ++_stats.layouts;
+    return *_layouts.emplace(std::move(key), std::move(l)).first->second;
+}
+
+shader_cache::stats shader_cache::get_stats() const
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    return _stats;
+}
@@ -0,0 +1,448 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/spirv_reflection.h>
+#include <vlk/exception.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace vlk;
+
+namespace {
+
+    constexpr uint32_t spirv_magic{0x07230203U};
+    constexpr size_t header_words{5U};
+
+    // opcodes
+    constexpr uint32_t op_entry_point{15U};
+    constexpr uint32_t op_type_int{21U};
+    constexpr uint32_t op_type_float{22U};
+    constexpr uint32_t op_type_vector{23U};
+    constexpr uint32_t op_type_matrix{24U};
+    constexpr uint32_t op_type_image{25U};
+    constexpr uint32_t op_type_sampler{26U};
+    constexpr uint32_t op_type_sampled_image{27U};
+    constexpr uint32_t op_type_array{28U};
+    constexpr uint32_t op_type_runtime_array{29U};
+    constexpr uint32_t op_type_struct{30U};
+    constexpr uint32_t op_type_pointer{32U};
+    constexpr uint32_t op_constant{43U};
+    constexpr uint32_t op_variable{59U};
+    constexpr uint32_t op_decorate{71U};
+    constexpr uint32_t op_member_decorate{72U};
+
+    // decorations
+    constexpr uint32_t decoration_block{2U};
+    constexpr uint32_t decoration_buffer_block{3U};
+    constexpr uint32_t decoration_array_stride{6U};
+    constexpr uint32_t decoration_matrix_stride{7U};
+    constexpr uint32_t decoration_binding{33U};
+    constexpr uint32_t decoration_descriptor_set{34U};
+    constexpr uint32_t decoration_offset{35U};
+
+    // storage classes
+    constexpr uint32_t storage_uniform_constant{0U};
+    constexpr uint32_t storage_uniform{2U};
+    constexpr uint32_t storage_push_constant{9U};
+    constexpr uint32_t storage_storage_buffer{12U};
+
+    // image dimensions
+    constexpr uint32_t dim_buffer{5U};
+    constexpr uint32_t dim_subpass_data{6U};
+
+    constexpr uint32_t no_value{~0U};
+
+    struct member_info
+    {
+        uint32_t offset{no_value};
+        uint32_t matrix_stride{0};
+    };
+
+    //! Declaration of a result id: types, constants and variables.
+    struct id_info
+    {
+        uint32_t opcode{0};
+        std::vector<uint32_t> operands{};   //!< instruction words behind the opcode without the result id
+        uint32_t set{no_value};
+        uint32_t binding{no_value};
+        uint32_t array_stride{0};
+        bool block{false};
+        bool buffer_block{false};
+        std::vector<member_info> members{};
+    };
+
+    class module_parser
+    {
+    public:
+        module_parser(uint32_t const* code, size_t word_count);
+
+        spirv_reflection reflect() const;
+
+    private:
+        id_info const& get(uint32_t id) const;
+        id_info& decorated(uint32_t id);
+        uint32_t array_length(id_info const& array) const;
+        uint32_t type_size(uint32_t type, uint32_t matrix_stride) const;
+        VkDescriptorType descriptor_type(uint32_t type, uint32_t storage) const;
+
+        std::vector<id_info> _ids{};
+        std::vector<uint32_t> _variables{};
+        VkShaderStageFlags _stages{0};
+        std::string _entry_point{};
+    };
+
+    VkShaderStageFlags stage_of(uint32_t execution_model)
+    {
+        switch (execution_model) {
+        case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+        case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+        default: return 0;
+        }
+    }
+
+    //! Literal string: UTF-8 packed into words, null terminated.
+    std::string literal_string(uint32_t const* words, size_t count)
+    {
+        std::string s;
+        for (size_t i = 0; i < count; ++i) {
+            for (uint32_t b = 0; b < 4U; ++b) {
+                auto const c = static_cast<char>((words[i] >> (8U * b)) & 0xFFU);
+                if ('\0' == c) {
+                    return s;
+                }
+                s.push_back(c);
+            }
+        }
+        throw vlk::app_exception{"SPIR-V string is not terminated"};
+    }
+
+    module_parser::module_parser(uint32_t const* code, size_t word_count)
+    {
+        if (nullptr == code || word_count < header_words || spirv_magic != code[0]) {
+            throw vlk::app_exception{"no SPIR-V module"};
+        }
+        // every id is declared by an instruction of at least one word, a larger bound is corrupt
+        if (code[3] > word_count) {
+            throw vlk::app_exception{"SPIR-V id bound exceeds the module"};
+        }
+        _ids.resize(code[3]);
+
+        size_t pos{header_words};
+        while (pos < word_count) {
+            auto const opcode = code[pos] & 0xFFFFU;
+            auto const count = static_cast<size_t>(code[pos] >> 16U);
+            if (0 == count || pos + count > word_count) {
+                throw vlk::app_exception{"SPIR-V instruction exceeds the module"};
+            }
+            auto const* ops = code + pos + 1U;
+            auto const op_count = count - 1U;
+            switch (opcode) {
+            case op_entry_point:
+                if (op_count < 3U) {
+                    throw vlk::app_exception{"SPIR-V OpEntryPoint is truncated"};
+                }
+                if (0 == _stages) {
+                    _entry_point = literal_string(ops + 2U, op_count - 2U);
+                }
+                _stages |= stage_of(ops[0]);
+                break;
+            case op_type_int:
+            case op_type_float:
+            case op_type_vector:
+            case op_type_matrix:
+            case op_type_image:
+            case op_type_sampler:
+            case op_type_sampled_image:
+            case op_type_array:
+            case op_type_runtime_array:
+            case op_type_struct:
+            case op_type_pointer: {
+                if (op_count < 1U) {
+                    throw vlk::app_exception{"SPIR-V type declaration is truncated"};
+                }
+                auto& info = decorated(ops[0]);
+                info.opcode = opcode;
+                info.operands.assign(ops + 1U, ops + op_count);
+                if (op_type_struct == opcode) {
+                    info.members.resize(info.operands.size());
+                }
+                break;
+            }
+            case op_constant:
+            case op_variable: {
+                // result type comes before the result id
+                if (op_count < 2U) {
+                    throw vlk::app_exception{"SPIR-V instruction is truncated"};
+                }
+                auto& info = decorated(ops[1]);
+                info.opcode = opcode;
+                info.operands.assign(ops, ops + op_count);
+                info.operands.erase(info.operands.begin() + 1);
+                if (op_variable == opcode) {
+                    _variables.push_back(ops[1]);
+                }
+                break;
+            }
+            case op_decorate: {
+                if (op_count < 2U) {
+                    throw vlk::app_exception{"SPIR-V OpDecorate is truncated"};
+                }
+                auto& info = decorated(ops[0]);
+                auto const literal = op_count > 2U ? ops[2] : 0;
+                switch (ops[1]) {
+                case decoration_block: info.block = true; break;
+                case decoration_buffer_block: info.buffer_block = true; break;
+                case decoration_array_stride: info.array_stride = literal; break;
+                case decoration_binding: info.binding = literal; break;
+                case decoration_descriptor_set: info.set = literal; break;
+                default: break;
+                }
+                break;
+            }
+            case op_member_decorate: {
+                if (op_count < 3U) {
+                    throw vlk::app_exception{"SPIR-V OpMemberDecorate is truncated"};
+                }
+                auto& info = decorated(ops[0]);
+                if (info.members.size() <= ops[1]) {
+                    // decorations may precede the struct declaration
+                    info.members.resize(ops[1] + 1U);
+                }
+                auto const literal = op_count > 3U ? ops[3] : 0;
+                if (decoration_offset == ops[2]) {
+                    info.members[ops[1]].offset = literal;
+                }
+                else if (decoration_matrix_stride == ops[2]) {
+                    info.members[ops[1]].matrix_stride = literal;
+                }
+                break;
+            }
+            default:
+                break;
+            }
+            pos += count;
+        }
+    }
+
+    id_info const& module_parser::get(uint32_t id) const
+    {
+        if (id >= _ids.size() || 0 == _ids[id].opcode) {
+            throw vlk::app_exception{"SPIR-V id " + std::to_string(id) + " is not declared"};
+        }
+        return _ids[id];
+    }
+
+    id_info& module_parser::decorated(uint32_t id)
+    {
+        if (id >= _ids.size()) {
+            throw vlk::app_exception{"SPIR-V id " + std::to_string(id) + " exceeds the id bound"};
+        }
+        return _ids[id];
+    }
+
+    uint32_t module_parser::array_length(id_info const& array) const
+    {
+        auto const& length = get(array.operands.at(1));
+        if (op_constant != length.opcode || length.operands.size() < 2U) {
+            // specialization constants keep their default length unknown here
+            throw vlk::app_exception{"SPIR-V array length is no constant"};
+        }
+        return length.operands[1];
+    }
+
+    uint32_t module_parser::type_size(uint32_t type, uint32_t matrix_stride) const
+    {
+        auto const& t = get(type);
+        switch (t.opcode) {
+        case op_type_int:
+        case op_type_float:
+            return t.operands.at(0) / 8U;
+        case op_type_vector:
+            return t.operands.at(1) * type_size(t.operands.at(0), 0);
+        case op_type_matrix:
+            return t.operands.at(1) * (0 != matrix_stride ? matrix_stride : type_size(t.operands.at(0), 0));
+        case op_type_array:
+            return array_length(t) * (0 != t.array_stride ? t.array_stride : type_size(t.operands.at(0), 0));
+        case op_type_struct: {
+            uint32_t size{0};
+            for (size_t i = 0; i < t.operands.size(); ++i) {
+                auto const& m = i < t.members.size() ? t.members[i] : member_info{};
+                auto const offset = no_value != m.offset ? m.offset : size;
+                size = std::max(size, offset + type_size(t.operands[i], m.matrix_stride));
+            }
+            return size;
+        }
+        default:
+            throw vlk::app_exception{"SPIR-V type " + std::to_string(type) + " has no size"};
+        }
+    }
+
+    VkDescriptorType module_parser::descriptor_type(uint32_t type, uint32_t storage) const
+    {
+        auto const& t = get(type);
+        if (storage_storage_buffer == storage) {
+            return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        }
+        if (storage_uniform == storage) {
+            // before SPIR-V 1.3 storage buffers are uniform blocks decorated BufferBlock
+            return t.buffer_block ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        }
+        switch (t.opcode) {
+        case op_type_sampler:
+            return VK_DESCRIPTOR_TYPE_SAMPLER;
+        case op_type_sampled_image:
+            return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        case op_type_image: {
+            // operands: sampled type, dim, depth, arrayed, ms, sampled (1: with sampler, 2: storage), format
+            auto const dim = t.operands.at(1);
+            auto const sampled = t.operands.at(5);
+            if (dim_subpass_data == dim) {
+                return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            }
+            if (dim_buffer == dim) {
+                return 2U == sampled ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            }
+            return 2U == sampled ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        }
+        default:
+            throw vlk::app_exception{"SPIR-V resource type " + std::to_string(type) + " is no descriptor"};
+        }
+    }
+
+    spirv_reflection module_parser::reflect() const
+    {
+        spirv_reflection r{};
+        r.stages = _stages;
+        r.entry_point = _entry_point;
+        uint32_t push_begin{no_value};
+        uint32_t push_end{0};
+        for (auto id : _variables) {
+            auto const& var = get(id);
+            auto const storage = var.operands.at(1);
+            auto const& pointer = get(var.operands.at(0));
+            if (op_type_pointer != pointer.opcode) {
+                throw vlk::app_exception{"SPIR-V variable " + std::to_string(id) + " is no pointer"};
+            }
+            auto type = pointer.operands.at(1);
+            if (storage_push_constant == storage) {
+                auto const& block = get(type);
+                for (size_t i = 0; i < block.operands.size() && i < block.members.size(); ++i) {
+                    auto const& m = block.members[i];
+                    auto const offset = no_value != m.offset ? m.offset : 0;
+                    push_begin = std::min(push_begin, offset);
+                    push_end = std::max(push_end, offset + type_size(block.operands[i], m.matrix_stride));
+                }
+                continue;
+            }
+            if (storage_uniform_constant != storage && storage_uniform != storage && storage_storage_buffer != storage) {
+                continue;
+            }
+            if (no_value == var.binding) {
+                continue;
+            }
+            spirv_binding b{};
+            b.set = no_value != var.set ? var.set : 0;
+            b.binding = var.binding;
+            b.stages = _stages;
+            for (;;) {
+                auto const& t = get(type);
+                if (op_type_array == t.opcode) {
+                    b.count *= array_length(t);
+                }
+                else if (op_type_runtime_array == t.opcode) {
+                    b.count = 0;
+                }
+                else {
+                    break;
+                }
+                type = t.operands.at(0);
+            }
+            b.type = descriptor_type(type, storage);
+            r.bindings.push_back(b);
+        }
+        std::sort(r.bindings.begin(), r.bindings.end(), [](spirv_binding const& a, spirv_binding const& b) {
+            return a.set < b.set || (a.set == b.set && a.binding < b.binding);
+        });
+        if (push_end > 0) {
+            r.push_constants.stageFlags = _stages;
+            r.push_constants.offset = push_begin;
+            r.push_constants.size = push_end - push_begin;
+        }
+        return r;
+    }
+
+}
+
+spirv_reflection vlk::reflect_spirv(uint32_t const* code, size_t word_count)
+{
+    return module_parser{code, word_count}.reflect();
+}
+
+spirv_layout vlk::merge_reflections(std::vector<spirv_reflection const*> const& stages)
+{
+    spirv_layout l{};
+    auto& push = l.push_constants;
+    for (auto const* s : stages) {
+        for (auto const& b : s->bindings) {
+            if (0 == b.count) {
+                throw vlk::app_exception{"pipeline layout: runtime sized array at set " + std::to_string(b.set)
+                                         + " binding " + std::to_string(b.binding)};
+            }
+            if (l.sets.size() <= b.set) {
+                l.sets.resize(b.set + 1U);
+            }
+            auto& set = l.sets[b.set];
+            auto existing = std::find_if(set.begin(), set.end(), [&b](VkDescriptorSetLayoutBinding const& x) {
+                return x.binding == b.binding;
+            });
+            if (set.end() == existing) {
+                set.push_back(VkDescriptorSetLayoutBinding{b.binding, b.type, b.count, b.stages, nullptr});
+                continue;
+            }
+            if (existing->descriptorType != b.type) {
+                throw vlk::app_exception{"pipeline layout: stages disagree on the type of set "
+                                         + std::to_string(b.set) + " binding " + std::to_string(b.binding)};
+            }
+            existing->descriptorCount = std::max(existing->descriptorCount, b.count);
+            existing->stageFlags |= b.stages;
+        }
+        auto const& p = s->push_constants;
+        if (0 == p.size) {
+            continue;
+        }
+        if (0 == push.size) {
+            push = p;
+            continue;
+        }
+        auto const end = std::max(push.offset + push.size, p.offset + p.size);
+        push.offset = std::min(push.offset, p.offset);
+        push.size = end - push.offset;
+        push.stageFlags |= p.stageFlags;
+    }
+    for (auto& set : l.sets) {
+        std::sort(set.begin(), set.end(), [](VkDescriptorSetLayoutBinding const& a,
+                                             VkDescriptorSetLayoutBinding const& b) { return a.binding < b.binding; });
+    }
+    return l;
+}
@@ -0,0 +1,263 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/tlsf.h>
+
+#include <cassert>
+
+using namespace vlk;
+
+namespace {
+
+    uint32_t msb(uint64_t v)
+    {
+        assert(0 != v);
+        return 63U - static_cast<uint32_t>(__builtin_clzll(v));
+    }
+
+    uint32_t lsb(uint64_t v)
+    {
+        assert(0 != v);
+        return static_cast<uint32_t>(__builtin_ctzll(v));
+    }
+
+    uint64_t align_up(uint64_t v, uint64_t alignment)
+    {
+        return (v + alignment - 1U) & ~(alignment - 1U);
+    }
+
+}
+
+tlsf::tlsf(uint64_t size)
+    : _size{size}
+{
+    assert(size > 0);
+    for (auto& fl : _heads) {
+        fl.fill(null_node);
+    }
+    _first = new_node(0, size);
+    insert_free(_first);
+}
+
+void tlsf::mapping(uint64_t size, uint32_t& fl, uint32_t& sl)
+{
+    if (size < sl_count) {
+        fl = 0;
+        sl = static_cast<uint32_t>(size);
+        return;
+    }
+    auto const m = msb(size);
+    fl = m - sl_bits + 1U;
+    sl = static_cast<uint32_t>(size >> (m - sl_bits)) - sl_count;
+}
+
+uint32_t tlsf::find_free(uint64_t size) const
+{
+    // round up to the next list boundary, then every block of the found list is large enough
+    auto rounded = size;
+    if (size >= sl_count) {
+        rounded = size + (uint64_t{1} << (msb(size) - sl_bits)) - 1U;
+    }
+    uint32_t fl, sl;
+    if (rounded >= size) {
+        mapping(rounded, fl, sl);
+        if (fl < fl_count) {
+            auto sl_map = _sl_bitmap[fl] & (~uint32_t{0} << sl);
+            if (0 == sl_map) {
+                auto const fl_map = _fl_bitmap & (~uint64_t{0} << (fl + 1U));
+                if (0 != fl_map) {
+                    fl = lsb(fl_map);
+                    sl_map = _sl_bitmap[fl];
+                    assert(0 != sl_map);
+                }
+            }
+            if (0 != sl_map) {
+                return _heads[fl][lsb(sl_map)];
+            }
+        }
+    }
+
+    // nothing in the larger lists, a block of the request's own list may still fit
+    mapping(size, fl, sl);
+    for (auto idx = _heads[fl][sl]; null_node != idx; idx = _nodes[idx].next_free) {
+        if (_nodes[idx].size >= size) {
+            return idx;
+        }
+    }
+    return null_node;
+}
+
+uint32_t tlsf::new_node(uint64_t offset, uint64_t size)
+{
+    node n{offset, size, null_node, null_node, null_node, null_node, true};
+    if (!_unused_nodes.empty()) {
+        auto const idx = _unused_nodes.back();
+        _unused_nodes.pop_back();
+        _nodes[idx] = n;
+        return idx;
+    }
+    _nodes.push_back(n);
+    return static_cast<uint32_t>(_nodes.size() - 1U);
+}
+
+void tlsf::release_node(uint32_t idx)
+{
+    _unused_nodes.push_back(idx);
+}
+
+void tlsf::insert_free(uint32_t idx)
+{
+    auto& n = _nodes[idx];
+    uint32_t fl, sl;
+    mapping(n.size, fl, sl);
+    n.free = true;
+    n.prev_free = null_node;
+    n.next_free = _heads[fl][sl];
+    if (null_node != n.next_free) {
+        _nodes[n.next_free].prev_free = idx;
+    }
+    _heads[fl][sl] = idx;
+    _fl_bitmap |= uint64_t{1} << fl;
+    _sl_bitmap[fl] |= uint32_t{1} << sl;
+    ++_free_block_count;
+}
+
+void tlsf::remove_free(uint32_t idx)
+{
+    auto& n = _nodes[idx];
+    assert(n.free);
+    uint32_t fl, sl;
+    mapping(n.size, fl, sl);
+    if (null_node != n.prev_free) {
+        _nodes[n.prev_free].next_free = n.next_free;
+    }
+    else {
+        _heads[fl][sl] = n.next_free;
+    }
+    if (null_node != n.next_free) {
+        _nodes[n.next_free].prev_free = n.prev_free;
+    }
+    if (null_node == _heads[fl][sl]) {
+        _sl_bitmap[fl] &= ~(uint32_t{1} << sl);
+        if (0 == _sl_bitmap[fl]) {
+            _fl_bitmap &= ~(uint64_t{1} << fl);
+        }
+    }
+    n.free = false;
+    n.prev_free = null_node;
+    n.next_free = null_node;
+    --_free_block_count;
+}
+
+uint32_t tlsf::split(uint32_t idx, uint64_t size)
+{
+    // splits node idx after size bytes, returns the new (second) node which is not in any free list
+    assert(_nodes[idx].size > size);
+    auto const second = new_node(_nodes[idx].offset + size, _nodes[idx].size - size);
+    auto& n = _nodes[idx];
+    auto& s = _nodes[second];
+    s.prev_phys = idx;
+    s.next_phys = n.next_phys;
+    if (null_node != n.next_phys) {
+        _nodes[n.next_phys].prev_phys = second;
+    }
+    n.next_phys = second;
+    n.size = size;
+    return second;
+}
+
+std::optional<tlsf::allocation> tlsf::allocate(uint64_t size, uint64_t alignment)
+{
+    assert(0 != alignment && 0 == (alignment & (alignment - 1U)));
+    if (0 == size) {
+        size = 1U;
+    }
+    auto const request = size + alignment - 1U;
+    if (request < size) {
+        return std::nullopt;
+    }
+    auto idx = find_free(request);
+    if (null_node == idx) {
+        return std::nullopt;
+    }
+    remove_free(idx);
+
+    auto const aligned = align_up(_nodes[idx].offset, alignment);
+    auto const padding = aligned - _nodes[idx].offset;
+    if (padding > 0) {
+        // the padding in front stays free - the physical predecessor can't be free, it would have been coalesced
+        auto const second = split(idx, padding);
+        insert_free(idx);
+        idx = second;
+    }
+    if (_nodes[idx].size > size) {
+        insert_free(split(idx, size));
+    }
+
+    _nodes[idx].free = false;
+    _used += _nodes[idx].size;
+    ++_allocation_count;
+    return allocation{idx, _nodes[idx].offset, _nodes[idx].size};
+}
+
+void tlsf::free(handle id)
+{
+    assert(id < _nodes.size() && !_nodes[id].free);
+    _used -= _nodes[id].size;
+    --_allocation_count;
+
+    auto const prev = _nodes[id].prev_phys;
+    if (null_node != prev && _nodes[prev].free) {
+        remove_free(prev);
+        _nodes[prev].size += _nodes[id].size;
+        _nodes[prev].next_phys = _nodes[id].next_phys;
+        if (null_node != _nodes[id].next_phys) {
+            _nodes[_nodes[id].next_phys].prev_phys = prev;
+        }
+        release_node(id);
+        id = prev;
+    }
+    auto const next = _nodes[id].next_phys;
+    if (null_node != next && _nodes[next].free) {
+        remove_free(next);
+        _nodes[id].size += _nodes[next].size;
+        _nodes[id].next_phys = _nodes[next].next_phys;
+        if (null_node != _nodes[next].next_phys) {
+            _nodes[_nodes[next].next_phys].prev_phys = id;
+        }
+        release_node(next);
+    }
+    insert_free(id);
+}
+
+uint64_t tlsf::largest_free() const
+{
+    if (0 == _fl_bitmap) {
+        return 0;
+    }
+    auto const fl = msb(_fl_bitmap);
+    auto const sl = msb(_sl_bitmap[fl]);
+    uint64_t largest{0};
+    for (auto idx = _heads[fl][sl]; null_node != idx; idx = _nodes[idx].next_free) {
+        if (_nodes[idx].size > largest) {
+            largest = _nodes[idx].size;
+        }
+    }
+    return largest;
+}
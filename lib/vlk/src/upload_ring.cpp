@@ -0,0 +1,222 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/upload_ring.h>
+#include <vlk/format_info.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <numeric>
+
+using namespace vlk;
+
+namespace {
+
+    VkDeviceSize align_up(VkDeviceSize v, VkDeviceSize alignment)
+    {
+        return (v + alignment - 1U) / alignment * alignment;
+    }
+
+}
+
+upload_ring::upload_ring(VkDevice device, memory_allocator& allocator, vlk::phys_device const& pd,
+                         uint32_t frames_in_flight, VkDeviceSize bytes_per_frame)
+    : _device{device}
+    , _allocator{allocator}
+    , _alignment{std::max({VkDeviceSize{16U}, pd.properties.limits.minUniformBufferOffsetAlignment,
+                           pd.properties.limits.optimalBufferCopyOffsetAlignment,
+                           pd.properties.limits.nonCoherentAtomSize})}
+    , _frame_capacity{align_up(bytes_per_frame, _alignment)}
+    , _frames{frames_in_flight}
+{
+    assert(frames_in_flight > 0 && bytes_per_frame > 0);
+    VkBufferCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    ci.pNext = nullptr;
+    ci.flags = 0;
+    ci.size = _frame_capacity * _frames;
+    ci.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+               | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ci.queueFamilyIndexCount = 0;
+    ci.pQueueFamilyIndices = nullptr;
+    _buffer = _allocator.create_buffer(ci, memory_usage::cpu_to_gpu);
+    assert(nullptr != _buffer.memory.mapped);
+}
+
+upload_ring::~upload_ring()
+{
+    _allocator.destroy(_buffer);
+}
+
+void upload_ring::begin_frame(uint32_t frame_index)
+{
+    assert(frame_index < _frames);
+    _peak = std::max(_peak, _head.load(std::memory_order_relaxed));
+    _base = _frame_capacity * frame_index;
+    _head.store(0, std::memory_order_relaxed);
+    _buffer_copies.clear();
+    _image_copies.clear();
+}
+
+upload_ring::range upload_ring::allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    alignment = 0 == alignment ? _alignment : alignment;
+    auto head = _head.load(std::memory_order_relaxed);
+    VkDeviceSize begin;
+    do {
+        // the offset within the buffer is aligned: alignments like the 12 bytes of RGB32 texels do not divide _base
+        begin = align_up(_base + head, alignment) - _base;
+        if (begin + size > _frame_capacity) {
+            return range{};
+        }
+    } while (!_head.compare_exchange_weak(head, begin + size, std::memory_order_relaxed));
+
+    range r{};
+    r.data = static_cast<char*>(_buffer.memory.mapped) + _base + begin;
+    r.buffer = _buffer.buffer;
+    r.offset = _base + begin;
+    r.size = size;
+    return r;
+}
+
+upload_ring::range upload_ring::upload(void const* data, VkDeviceSize size, VkDeviceSize alignment)
+{
+    auto r = allocate(size, alignment);
+    if (r) {
+        std::memcpy(r.data, data, size);
+    }
+    return r;
+}
+
+upload_ring::range upload_ring::allocate_image(VkFormat format, VkBufferImageCopy const& region)
+{
+    auto const& fi = get_format_info(format);
+    auto const size = image_copy_size(format, region);
+    if (0 == size) {
+        return range{};
+    }
+    return allocate(size, std::lcm(_alignment, VkDeviceSize{std::max<uint8_t>(fi.block_size, 1U)}));
+}
+
+void upload_ring::copy_to_buffer(range const& src, VkBuffer dst, VkDeviceSize dst_offset)
+{
+    assert(src && src.buffer == _buffer.buffer);
+    _buffer_copies.push_back(buffer_copy{dst, VkBufferCopy{src.offset, dst_offset, src.size}});
+}
+
+void upload_ring::copy_to_image(range const& src, VkImage dst, VkBufferImageCopy const& region,
+                                VkImageLayout final_layout)
+{
+    assert(src && src.buffer == _buffer.buffer);
+    image_copy ic{dst, region, final_layout};
+    ic.region.bufferOffset += src.offset;
+    _image_copies.push_back(ic);
+}
+
+void upload_ring::record(VkCommandBuffer cmd)
+{
+    // ranges used directly by the frame have to be flushed as well, not only the copy sources
+    auto const used = _head.load(std::memory_order_relaxed);
+    if (0 != used) {
+        _allocator.flush(_buffer.memory, _base, used);
+    }
+    if (!has_pending_copies()) {
+        return;
+    }
+
+    // batch the regions per destination
+    std::stable_sort(_buffer_copies.begin(), _buffer_copies.end(),
+                     [](auto const& l, auto const& r) { return std::less<VkBuffer>{}(l.dst, r.dst); });
+    std::stable_sort(_image_copies.begin(), _image_copies.end(),
+                     [](auto const& l, auto const& r) { return std::less<VkImage>{}(l.dst, r.dst); });
+
+    auto image_barrier = [](image_copy const& ic, VkImageLayout old_layout, VkImageLayout new_layout,
+                            VkAccessFlags src, VkAccessFlags dst) {
+        VkImageMemoryBarrier ib{};
+        ib.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        ib.pNext = nullptr;
+        ib.srcAccessMask = src;
+        ib.dstAccessMask = dst;
+        ib.oldLayout = old_layout;
+        ib.newLayout = new_layout;
+        ib.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        ib.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        ib.image = ic.dst;
+        auto const& sub = ic.region.imageSubresource;
+        ib.subresourceRange = VkImageSubresourceRange{sub.aspectMask, sub.mipLevel, 1U, sub.baseArrayLayer,
+                                                      sub.layerCount};
+        return ib;
+    };
+
+    std::vector<VkImageMemoryBarrier> ibs;
+    for (auto const& ic : _image_copies) {
+        ibs.push_back(image_barrier(ic, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
+                                    VK_ACCESS_TRANSFER_WRITE_BIT));
+    }
+    // waits for earlier reads and writes of the destinations before they are overwritten, e.g. vertex or uniform
+    // reads of a buffer by the previous frames
+    VkMemoryBarrier before{};
+    before.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    before.pNext = nullptr;
+    before.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    before.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    auto const buffer_barriers = _buffer_copies.empty() ? 0U : 1U;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                         buffer_barriers, &before, 0, nullptr, static_cast<uint32_t>(ibs.size()), ibs.data());
+
+    std::vector<VkBufferCopy> buffer_regions;
+    for (size_t i = 0; i < _buffer_copies.size(); ) {
+        buffer_regions.clear();
+        auto const dst = _buffer_copies[i].dst;
+        for (; i < _buffer_copies.size() && dst == _buffer_copies[i].dst; ++i) {
+            buffer_regions.push_back(_buffer_copies[i].region);
+        }
+        vkCmdCopyBuffer(cmd, _buffer.buffer, dst, static_cast<uint32_t>(buffer_regions.size()),
+                        buffer_regions.data());
+    }
+    std::vector<VkBufferImageCopy> image_regions;
+    for (size_t i = 0; i < _image_copies.size(); ) {
+        image_regions.clear();
+        auto const dst = _image_copies[i].dst;
+        for (; i < _image_copies.size() && dst == _image_copies[i].dst; ++i) {
+            image_regions.push_back(_image_copies[i].region);
+        }
+        vkCmdCopyBufferToImage(cmd, _buffer.buffer, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               static_cast<uint32_t>(image_regions.size()), image_regions.data());
+    }
+
+    VkMemoryBarrier mb{};
+    mb.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    mb.pNext = nullptr;
+    mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    mb.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    ibs.clear();
+    for (auto const& ic : _image_copies) {
+        ibs.push_back(image_barrier(ic, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, ic.final_layout,
+                                    VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT));
+    }
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                         1U, &mb, 0, nullptr, static_cast<uint32_t>(ibs.size()), ibs.data());
+
+    _buffer_copies.clear();
+    _image_copies.clear();
+}
@@ -0,0 +1,332 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <vlk/upload_scheduler.h>
+#include <vlk/exception.h>
+
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+using namespace vlk;
+
+upload_scheduler::upload_scheduler(VkDevice device, memory_allocator& allocator, uint32_t qfi_transfer,
+                                   VkQueue transfer_queue, uint32_t qfi_graphics)
+    : _device{device}
+    , _allocator{allocator}
+    , _qfi_transfer{qfi_transfer}
+    , _queue{transfer_queue}
+    , _qfi_graphics{qfi_graphics}
+{
+    VkCommandPoolCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    ci.pNext = nullptr;
+    ci.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    ci.queueFamilyIndex = _qfi_transfer;
+    auto r = vkCreateCommandPool(_device, &ci, nullptr, &_pool);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to create transfer command pool", r};
+    }
+}
+
+upload_scheduler::~upload_scheduler()
+{
+    wait_idle();
+    auto release = [this](batch& b) {
+        for (auto& u : b.uploads) {
+            _allocator.destroy(u.staging);
+        }
+        vkDestroyFence(_device, b.fence, nullptr);
+    };
+    for (auto& b : _in_flight) {
+        release(b);
+    }
+    for (auto& b : _free_batches) {
+        release(b);
+    }
+    for (auto& u : _pending) {
+        _allocator.destroy(u.staging);
+    }
+    // destroying the pool frees the command buffers
+    vkDestroyCommandPool(_device, _pool, nullptr);
+}
+
+allocated_buffer upload_scheduler::create_staging(void const* data, VkDeviceSize size)
+{
+    VkBufferCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    ci.pNext = nullptr;
+    ci.flags = 0;
+    ci.size = size;
+    ci.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ci.queueFamilyIndexCount = 0;
+    ci.pQueueFamilyIndices = nullptr;
+    auto staging = _allocator.create_buffer(ci, memory_usage::cpu_to_gpu);
+    std::memcpy(staging.memory.mapped, data, size);
+    _allocator.flush(staging.memory);
+    return staging;
+}
+
+upload_scheduler::ticket upload_scheduler::upload_buffer(void const* data, VkDeviceSize size, VkBuffer dst,
+                                                         VkDeviceSize dst_offset)
+{
+    upload u{};
+    u.staging = create_staging(data, size);
+    u.is_image = false;
+    u.dst_buffer = dst;
+    u.buffer_region = VkBufferCopy{0, dst_offset, size};
+    std::lock_guard<std::mutex> lock{_mutex};
+    _pending.push_back(u);
+    return _next;
+}
+
+upload_scheduler::ticket upload_scheduler::upload_image(void const* data, VkDeviceSize size, VkImage dst,
+                                                        VkBufferImageCopy const& region, VkImageLayout final_layout)
+{
+    upload u{};
+    u.staging = create_staging(data, size);
+    u.is_image = true;
+    u.dst_image = dst;
+    u.image_region = region;
+    u.final_layout = final_layout;
+    std::lock_guard<std::mutex> lock{_mutex};
+    _pending.push_back(u);
+    return _next;
+}
+
+VkImageMemoryBarrier upload_scheduler::image_barrier(upload const& u, VkImageLayout old_layout,
+                                                     VkImageLayout new_layout, VkAccessFlags src, VkAccessFlags dst,
+                                                     bool ownership) const
+{
+    VkImageMemoryBarrier ib{};
+    ib.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    ib.pNext = nullptr;
+    ib.srcAccessMask = src;
+    ib.dstAccessMask = dst;
+    ib.oldLayout = old_layout;
+    ib.newLayout = new_layout;
+    ib.srcQueueFamilyIndex = ownership ? _qfi_transfer : VK_QUEUE_FAMILY_IGNORED;
+    ib.dstQueueFamilyIndex = ownership ? _qfi_graphics : VK_QUEUE_FAMILY_IGNORED;
+    ib.image = u.dst_image;
+    auto const& sub = u.image_region.imageSubresource;
+    ib.subresourceRange = VkImageSubresourceRange{sub.aspectMask, sub.mipLevel, 1U, sub.baseArrayLayer,
+                                                  sub.layerCount};
+    return ib;
+}
+
+VkBufferMemoryBarrier upload_scheduler::buffer_barrier(upload const& u, VkAccessFlags src, VkAccessFlags dst) const
+{
+    VkBufferMemoryBarrier bb{};
+    bb.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bb.pNext = nullptr;
+    bb.srcAccessMask = src;
+    bb.dstAccessMask = dst;
+    bb.srcQueueFamilyIndex = _qfi_transfer;
+    bb.dstQueueFamilyIndex = _qfi_graphics;
+    bb.buffer = u.dst_buffer;
+    bb.offset = u.buffer_region.dstOffset;
+    bb.size = u.buffer_region.size;
+    return bb;
+}
+
+void upload_scheduler::submit(batch& b)
+{
+    vkResetCommandBuffer(b.cmd, 0);
+    VkCommandBufferBeginInfo bi{};
+    bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    bi.pNext = nullptr;
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    bi.pInheritanceInfo = nullptr;
+    auto r = vkBeginCommandBuffer(b.cmd, &bi);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to begin transfer command buffer", r};
+    }
+
+    std::vector<VkImageMemoryBarrier> ibs;
+    for (auto const& u : b.uploads) {
+        if (u.is_image) {
+            ibs.push_back(image_barrier(u, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
+                                        VK_ACCESS_TRANSFER_WRITE_BIT, false));
+        }
+    }
+    if (!ibs.empty()) {
+        vkCmdPipelineBarrier(b.cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr, 0, nullptr, static_cast<uint32_t>(ibs.size()), ibs.data());
+    }
+    for (auto const& u : b.uploads) {
+        if (u.is_image) {
+            vkCmdCopyBufferToImage(b.cmd, u.staging.buffer, u.dst_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1U,
+                                   &u.image_region);
+        }
+        else {
+            vkCmdCopyBuffer(b.cmd, u.staging.buffer, u.dst_buffer, 1U, &u.buffer_region);
+        }
+    }
+
+    // release to the graphics family, or make the copies visible when both are the same family
+    auto const ownership = dedicated_queue();
+    std::vector<VkBufferMemoryBarrier> bbs;
+    ibs.clear();
+    for (auto const& u : b.uploads) {
+        if (u.is_image) {
+            ibs.push_back(image_barrier(u, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, u.final_layout,
+                                        VK_ACCESS_TRANSFER_WRITE_BIT, ownership ? 0 : VK_ACCESS_MEMORY_READ_BIT,
+                                        ownership));
+        }
+        else if (ownership) {
+            bbs.push_back(buffer_barrier(u, VK_ACCESS_TRANSFER_WRITE_BIT, 0));
+        }
+    }
+    VkMemoryBarrier mb{};
+    mb.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    mb.pNext = nullptr;
+    mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    mb.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    vkCmdPipelineBarrier(b.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         ownership ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                         ownership ? 0U : 1U, &mb, static_cast<uint32_t>(bbs.size()), bbs.data(),
+                         static_cast<uint32_t>(ibs.size()), ibs.data());
+
+    r = vkEndCommandBuffer(b.cmd);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to record transfer command buffer", r};
+    }
+
+    VkSubmitInfo si{};
+    si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    si.pNext = nullptr;
+    si.waitSemaphoreCount = 0;
+    si.pWaitSemaphores = nullptr;
+    si.pWaitDstStageMask = nullptr;
+    si.commandBufferCount = 1U;
+    si.pCommandBuffers = &b.cmd;
+    si.signalSemaphoreCount = 0;
+    si.pSignalSemaphores = nullptr;
+    vkResetFences(_device, 1U, &b.fence);
+    r = vkQueueSubmit(_queue, 1U, &si, b.fence);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to submit transfer command buffer", r};
+    }
+}
+
+void upload_scheduler::acquire(VkCommandBuffer graphics_cmd, batch const& b) const
+{
+    std::vector<VkImageMemoryBarrier> ibs;
+    std::vector<VkBufferMemoryBarrier> bbs;
+    for (auto const& u : b.uploads) {
+        if (u.is_image) {
+            ibs.push_back(image_barrier(u, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, u.final_layout, 0,
+                                        VK_ACCESS_MEMORY_READ_BIT, true));
+        }
+        else {
+            bbs.push_back(buffer_barrier(u, 0, VK_ACCESS_MEMORY_READ_BIT));
+        }
+    }
+    vkCmdPipelineBarrier(graphics_cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                         0, nullptr, static_cast<uint32_t>(bbs.size()), bbs.data(),
+                         static_cast<uint32_t>(ibs.size()), ibs.data());
+}
+
+void upload_scheduler::update(VkCommandBuffer graphics_cmd)
+{
+    // finished batches in submission order - the fence wait on the host orders the release before the acquire
+    while (!_in_flight.empty() && VK_SUCCESS == vkGetFenceStatus(_device, _in_flight.front().fence)) {
+        auto& b = _in_flight.front();
+        if (dedicated_queue()) {
+            acquire(graphics_cmd, b);
+        }
+        for (auto& u : b.uploads) {
+            _allocator.destroy(u.staging);
+        }
+        b.uploads.clear();
+        _ready.store(b.id, std::memory_order_release);
+        _free_batches.push_back(std::move(b));
+        _in_flight.pop_front();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (_pending.empty()) {
+            return;
+        }
+    }
+
+    // the batch first: the uploads are only taken out of _pending once nothing but the submission can fail
+    _in_flight.push_back(take_batch());
+    auto& b = _in_flight.back();
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        b.uploads.swap(_pending);
+        b.id = _next++;
+    }
+    try {
+        submit(b);
+    }
+    catch (...) {
+        // the uploads are queued again in front of those queued meanwhile. Their ticket b.id stays below the
+        // ticket of the batch finally submitting them, so it isn't ready before they have been executed.
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            b.uploads.insert(b.uploads.end(), _pending.begin(), _pending.end());
+            _pending.swap(b.uploads);
+        }
+        b.uploads.clear();
+        _free_batches.push_back(std::move(b));
+        _in_flight.pop_back();
+        throw;
+    }
+}
+
+upload_scheduler::batch upload_scheduler::take_batch()
+{
+    batch b{};
+    if (!_free_batches.empty()) {
+        b = std::move(_free_batches.back());
+        _free_batches.pop_back();
+        return b;
+    }
+    VkCommandBufferAllocateInfo ai{};
+    ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    ai.pNext = nullptr;
+    ai.commandPool = _pool;
+    ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    ai.commandBufferCount = 1U;
+    auto r = vkAllocateCommandBuffers(_device, &ai, &b.cmd);
+    if (VK_SUCCESS != r) {
+        throw vlk::vulkan_exception{"unable to allocate transfer command buffer", r};
+    }
+    VkFenceCreateInfo fci{};
+    fci.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fci.pNext = nullptr;
+    fci.flags = 0;
+    r = vkCreateFence(_device, &fci, nullptr, &b.fence);
+    if (VK_SUCCESS != r) {
+        vkFreeCommandBuffers(_device, _pool, 1U, &b.cmd);
+        throw vlk::vulkan_exception{"unable to create transfer fence", r};
+    }
+    return b;
+}
+
+void upload_scheduler::wait_idle()
+{
+    for (auto const& b : _in_flight) {
+        vkWaitForFences(_device, 1U, &b.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
+}
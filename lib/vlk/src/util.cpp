@@ -22,343 +22,19 @@
 
 using namespace vlk;
 
-std::string vlk::to_string(VkResult r)
-{
-    switch(r) {
-        case VK_SUCCESS: return "VK_SUCCESS";
-        case VK_NOT_READY: return "VK_NOT_READY";
-        case VK_TIMEOUT: return "VK_TIMEOUT";
-        case VK_EVENT_SET: return "VK_EVENT_SET";
-        case VK_EVENT_RESET: return "VK_EVENT_RESET";
-        case VK_INCOMPLETE: return "VK_INCOMPLETE";
-        case VK_ERROR_OUT_OF_HOST_MEMORY: return "VK_ERROR_OUT_OF_HOST_MEMORY";
-        case VK_ERROR_OUT_OF_DEVICE_MEMORY: return "VK_ERROR_OUT_OF_DEVICE_MEMORY";
-        case VK_ERROR_INITIALIZATION_FAILED: return "VK_ERROR_INITIALIZATION_FAILED";
-        case VK_ERROR_DEVICE_LOST: return "VK_ERROR_DEVICE_LOST";
-        case VK_ERROR_MEMORY_MAP_FAILED: return "VK_ERROR_MEMORY_MAP_FAILED";
-        case VK_ERROR_LAYER_NOT_PRESENT: return "VK_ERROR_LAYER_NOT_PRESENT";
-        case VK_ERROR_EXTENSION_NOT_PRESENT: return "VK_ERROR_EXTENSION_NOT_PRESENT";
-        case VK_ERROR_FEATURE_NOT_PRESENT: return "VK_ERROR_FEATURE_NOT_PRESENT";
-        case VK_ERROR_INCOMPATIBLE_DRIVER: return "VK_ERROR_INCOMPATIBLE_DRIVER";
-        case VK_ERROR_TOO_MANY_OBJECTS: return "VK_ERROR_TOO_MANY_OBJECTS";
-        case VK_ERROR_FORMAT_NOT_SUPPORTED: return "VK_ERROR_FORMAT_NOT_SUPPORTED";
-        case VK_ERROR_FRAGMENTED_POOL: return "VK_ERROR_FRAGMENTED_POOL";
-        case VK_ERROR_OUT_OF_POOL_MEMORY: return "VK_ERROR_OUT_OF_POOL_MEMORY";
-        case VK_ERROR_INVALID_EXTERNAL_HANDLE: return "VK_ERROR_INVALID_EXTERNAL_HANDLE";
-        case VK_ERROR_SURFACE_LOST_KHR: return "VK_ERROR_SURFACE_LOST_KHR";
-        case VK_ERROR_NATIVE_WINDOW_IN_USE_KHR: return "VK_ERROR_NATIVE_WINDOW_IN_USE_KHR";
-        case VK_SUBOPTIMAL_KHR: return "VK_SUBOPTIMAL_KHR";
-        case VK_ERROR_OUT_OF_DATE_KHR: return "VK_ERROR_OUT_OF_DATE_KHR";
-        case VK_ERROR_INCOMPATIBLE_DISPLAY_KHR: return "VK_ERROR_INCOMPATIBLE_DISPLAY_KHR";
-        case VK_ERROR_VALIDATION_FAILED_EXT: return "VK_ERROR_VALIDATION_FAILED_EXT";
-        case VK_ERROR_INVALID_SHADER_NV: return "VK_ERROR_INVALID_SHADER_NV";
-        case VK_ERROR_INVALID_DRM_FORMAT_MODIFIER_PLANE_LAYOUT_EXT: return "VK_ERROR_INVALID_DRM_FORMAT_MODIFIER_PLANE_LAYOUT_EXT";
-        case VK_ERROR_FRAGMENTATION_EXT: return "VK_ERROR_FRAGMENTATION_EXT";
-        case VK_ERROR_NOT_PERMITTED_EXT: return "VK_ERROR_NOT_PERMITTED_EXT";
-        case VK_ERROR_INVALID_DEVICE_ADDRESS_EXT: return "VK_ERROR_INVALID_DEVICE_ADDRESS_EXT";
-        case VK_ERROR_FULL_SCREEN_EXCLUSIVE_MODE_LOST_EXT: return "VK_ERROR_FULL_SCREEN_EXCLUSIVE_MODE_LOST_EXT";
-        case VK_RESULT_MAX_ENUM: return "VK_RESULT_MAX_ENUM";
-        default:
-            break;
-    }
-    return std::to_string(static_cast<int>(r));
-}
-
-std::string vlk::to_string(VkPhysicalDeviceType dt)
-{
-    switch (dt) {
-        case VK_PHYSICAL_DEVICE_TYPE_OTHER: return "VK_PHYSICAL_DEVICE_TYPE_OTHER";
-        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU";
-        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU";
-        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return "VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU";
-        case VK_PHYSICAL_DEVICE_TYPE_CPU: return "VK_PHYSICAL_DEVICE_TYPE_CPU";
-        default:
-            break;
-    }
-    return std::to_string(static_cast<int>(dt));
-}
-
-std::string vlk::to_string(VkFormat f)
-{
-    switch (f) {
-        case VK_FORMAT_UNDEFINED: return "VK_FORMAT_UNDEFINED";
-        case VK_FORMAT_R4G4_UNORM_PACK8: return "VK_FORMAT_R4G4_UNORM_PACK8";
-        case VK_FORMAT_R4G4B4A4_UNORM_PACK16: return "VK_FORMAT_R4G4B4A4_UNORM_PACK16";
-        case VK_FORMAT_B4G4R4A4_UNORM_PACK16: return "VK_FORMAT_B4G4R4A4_UNORM_PACK16";
-        case VK_FORMAT_R5G6B5_UNORM_PACK16: return "VK_FORMAT_R5G6B5_UNORM_PACK16";
-        case VK_FORMAT_B5G6R5_UNORM_PACK16: return "VK_FORMAT_B5G6R5_UNORM_PACK16";
-        case VK_FORMAT_R5G5B5A1_UNORM_PACK16: return "VK_FORMAT_R5G5B5A1_UNORM_PACK16";
-        case VK_FORMAT_B5G5R5A1_UNORM_PACK16: return "VK_FORMAT_B5G5R5A1_UNORM_PACK16";
-        case VK_FORMAT_A1R5G5B5_UNORM_PACK16: return "VK_FORMAT_A1R5G5B5_UNORM_PACK16";
-        case VK_FORMAT_R8_UNORM: return "VK_FORMAT_R8_UNORM";
-        case VK_FORMAT_R8_SNORM: return "VK_FORMAT_R8_SNORM";
-        case VK_FORMAT_R8_USCALED: return "VK_FORMAT_R8_USCALED";
-        case VK_FORMAT_R8_SSCALED: return "VK_FORMAT_R8_SSCALED";
-        case VK_FORMAT_R8_UINT: return "VK_FORMAT_R8_UINT";
-        case VK_FORMAT_R8_SINT: return "VK_FORMAT_R8_SINT";
-        case VK_FORMAT_R8_SRGB: return "VK_FORMAT_R8_SRGB";
-        case VK_FORMAT_R8G8_UNORM: return "VK_FORMAT_R8G8_UNORM";
-        case VK_FORMAT_R8G8_SNORM: return "VK_FORMAT_R8G8_SNORM";
-        case VK_FORMAT_R8G8_USCALED: return "VK_FORMAT_R8G8_USCALED";
-        case VK_FORMAT_R8G8_SSCALED: return "VK_FORMAT_R8G8_SSCALED";
-        case VK_FORMAT_R8G8_UINT: return "VK_FORMAT_R8G8_UINT";
-        case VK_FORMAT_R8G8_SINT: return "VK_FORMAT_R8G8_SINT";
-        case VK_FORMAT_R8G8_SRGB: return "VK_FORMAT_R8G8_SRGB";
-        case VK_FORMAT_R8G8B8_UNORM: return "VK_FORMAT_R8G8B8_UNORM";
-        case VK_FORMAT_R8G8B8_SNORM: return "VK_FORMAT_R8G8B8_SNORM";
-        case VK_FORMAT_R8G8B8_USCALED: return "VK_FORMAT_R8G8B8_USCALED";
-        case VK_FORMAT_R8G8B8_SSCALED: return "VK_FORMAT_R8G8B8_SSCALED";
-        case VK_FORMAT_R8G8B8_UINT: return "VK_FORMAT_R8G8B8_UINT";
-        case VK_FORMAT_R8G8B8_SINT: return "VK_FORMAT_R8G8B8_SINT";
-        case VK_FORMAT_R8G8B8_SRGB: return "VK_FORMAT_R8G8B8_SRGB";
-        case VK_FORMAT_B8G8R8_UNORM: return "VK_FORMAT_B8G8R8_UNORM";
-        case VK_FORMAT_B8G8R8_SNORM: return "VK_FORMAT_B8G8R8_SNORM";
-        case VK_FORMAT_B8G8R8_USCALED: return "VK_FORMAT_B8G8R8_USCALED";
-        case VK_FORMAT_B8G8R8_SSCALED: return "VK_FORMAT_B8G8R8_SSCALED";
-        case VK_FORMAT_B8G8R8_UINT: return "VK_FORMAT_B8G8R8_UINT";
-        case VK_FORMAT_B8G8R8_SINT: return "VK_FORMAT_B8G8R8_SINT";
-        case VK_FORMAT_B8G8R8_SRGB: return "VK_FORMAT_B8G8R8_SRGB";
-        case VK_FORMAT_R8G8B8A8_UNORM: return "VK_FORMAT_R8G8B8A8_UNORM";
-        case VK_FORMAT_R8G8B8A8_SNORM: return "VK_FORMAT_R8G8B8A8_SNORM";
-        case VK_FORMAT_R8G8B8A8_USCALED: return "VK_FORMAT_R8G8B8A8_USCALED";
-        case VK_FORMAT_R8G8B8A8_SSCALED: return "VK_FORMAT_R8G8B8A8_SSCALED";
-        case VK_FORMAT_R8G8B8A8_UINT: return "VK_FORMAT_R8G8B8A8_UINT";
-        case VK_FORMAT_R8G8B8A8_SINT: return "VK_FORMAT_R8G8B8A8_SINT";
-        case VK_FORMAT_R8G8B8A8_SRGB: return "VK_FORMAT_R8G8B8A8_SRGB";
-        case VK_FORMAT_B8G8R8A8_UNORM: return "VK_FORMAT_B8G8R8A8_UNORM";
-        case VK_FORMAT_B8G8R8A8_SNORM: return "VK_FORMAT_B8G8R8A8_SNORM";
-        case VK_FORMAT_B8G8R8A8_USCALED: return "VK_FORMAT_B8G8R8A8_USCALED";
-        case VK_FORMAT_B8G8R8A8_SSCALED: return "VK_FORMAT_B8G8R8A8_SSCALED";
-        case VK_FORMAT_B8G8R8A8_UINT: return "VK_FORMAT_B8G8R8A8_UINT";
-        case VK_FORMAT_B8G8R8A8_SINT: return "VK_FORMAT_B8G8R8A8_SINT";
-        case VK_FORMAT_B8G8R8A8_SRGB: return "VK_FORMAT_B8G8R8A8_SRGB";
-        case VK_FORMAT_A8B8G8R8_UNORM_PACK32: return "VK_FORMAT_A8B8G8R8_UNORM_PACK32";
-        case VK_FORMAT_A8B8G8R8_SNORM_PACK32: return "VK_FORMAT_A8B8G8R8_SNORM_PACK32";
-        case VK_FORMAT_A8B8G8R8_USCALED_PACK32: return "VK_FORMAT_A8B8G8R8_USCALED_PACK32";
-        case VK_FORMAT_A8B8G8R8_SSCALED_PACK32: return "VK_FORMAT_A8B8G8R8_SSCALED_PACK32";
-        case VK_FORMAT_A8B8G8R8_UINT_PACK32: return "VK_FORMAT_A8B8G8R8_UINT_PACK32";
-        case VK_FORMAT_A8B8G8R8_SINT_PACK32: return "VK_FORMAT_A8B8G8R8_SINT_PACK32";
-        case VK_FORMAT_A8B8G8R8_SRGB_PACK32: return "VK_FORMAT_A8B8G8R8_SRGB_PACK32";
-        case VK_FORMAT_A2R10G10B10_UNORM_PACK32: return "VK_FORMAT_A2R10G10B10_UNORM_PACK32";
-        case VK_FORMAT_A2R10G10B10_SNORM_PACK32: return "VK_FORMAT_A2R10G10B10_SNORM_PACK32";
-        case VK_FORMAT_A2R10G10B10_USCALED_PACK32: return "VK_FORMAT_A2R10G10B10_USCALED_PACK32";
-        case VK_FORMAT_A2R10G10B10_SSCALED_PACK32: return "VK_FORMAT_A2R10G10B10_SSCALED_PACK32";
-        case VK_FORMAT_A2R10G10B10_UINT_PACK32: return "VK_FORMAT_A2R10G10B10_UINT_PACK32";
-        case VK_FORMAT_A2R10G10B10_SINT_PACK32: return "VK_FORMAT_A2R10G10B10_SINT_PACK32";
-        case VK_FORMAT_A2B10G10R10_UNORM_PACK32: return "VK_FORMAT_A2B10G10R10_UNORM_PACK32";
-        case VK_FORMAT_A2B10G10R10_SNORM_PACK32: return "VK_FORMAT_A2B10G10R10_SNORM_PACK32";
-        case VK_FORMAT_A2B10G10R10_USCALED_PACK32: return "VK_FORMAT_A2B10G10R10_USCALED_PACK32";
-        case VK_FORMAT_A2B10G10R10_SSCALED_PACK32: return "VK_FORMAT_A2B10G10R10_SSCALED_PACK32";
-        case VK_FORMAT_A2B10G10R10_UINT_PACK32 : return "VK_FORMAT_A2B10G10R10_UINT_PACK32";
-        case VK_FORMAT_A2B10G10R10_SINT_PACK32 : return "VK_FORMAT_A2B10G10R10_SINT_PACK32";
-        case VK_FORMAT_R16_UNORM : return "VK_FORMAT_R16_UNORM";
-        case VK_FORMAT_R16_SNORM: return "VK_FORMAT_R16_SNORM";
-        case VK_FORMAT_R16_USCALED : return "VK_FORMAT_R16_USCALED";
-        case VK_FORMAT_R16_SSCALED : return "VK_FORMAT_R16_SSCALED";
-        case VK_FORMAT_R16_UINT : return "VK_FORMAT_R16_UINT";
-        case VK_FORMAT_R16_SINT : return "VK_FORMAT_R16_SINT";
-        case VK_FORMAT_R16_SFLOAT : return "VK_FORMAT_R16_SFLOAT";
-        case VK_FORMAT_R16G16_UNORM : return "VK_FORMAT_R16G16_UNORM";
-        case VK_FORMAT_R16G16_SNORM : return "VK_FORMAT_R16G16_SNORM";
-        case VK_FORMAT_R16G16_USCALED : return "VK_FORMAT_R16G16_USCALED";
-        case VK_FORMAT_R16G16_SSCALED: return "VK_FORMAT_R16G16_SSCALED";
-        case VK_FORMAT_R16G16_UINT : return "VK_FORMAT_R16G16_UINT";
-        case VK_FORMAT_R16G16_SINT : return "VK_FORMAT_R16G16_SINT";
-        case VK_FORMAT_R16G16_SFLOAT : return "VK_FORMAT_R16G16_SFLOAT";
-        case VK_FORMAT_R16G16B16_UNORM: return "VK_FORMAT_R16G16B16_UNORM";
-        case VK_FORMAT_R16G16B16_SNORM : return "VK_FORMAT_R16G16B16_SNORM";
-        case VK_FORMAT_R16G16B16_USCALED: return "VK_FORMAT_R16G16B16_USCALED";
-        case VK_FORMAT_R16G16B16_SSCALED: return "VK_FORMAT_R16G16B16_SSCALED";
-        case VK_FORMAT_R16G16B16_UINT: return "VK_FORMAT_R16G16B16_UINT";
-        case VK_FORMAT_R16G16B16_SINT: return "VK_FORMAT_R16G16B16_SINT";
-        case VK_FORMAT_R16G16B16_SFLOAT: return "VK_FORMAT_R16G16B16_SFLOAT";
-        case VK_FORMAT_R16G16B16A16_UNORM: return "VK_FORMAT_R16G16B16A16_UNORM";
-        case VK_FORMAT_R16G16B16A16_SNORM: return "VK_FORMAT_R16G16B16A16_SNORM";
-        case VK_FORMAT_R16G16B16A16_USCALED: return "VK_FORMAT_R16G16B16A16_USCALED";
-        case VK_FORMAT_R16G16B16A16_SSCALED: return "VK_FORMAT_R16G16B16A16_SSCALED";
-        case VK_FORMAT_R16G16B16A16_UINT: return "VK_FORMAT_R16G16B16A16_UINT";
-        case VK_FORMAT_R16G16B16A16_SINT: return "VK_FORMAT_R16G16B16A16_SINT";
-        case VK_FORMAT_R16G16B16A16_SFLOAT: return "VK_FORMAT_R16G16B16A16_SFLOAT";
-        case VK_FORMAT_R32_UINT: return "VK_FORMAT_R32_UINT";
-        case VK_FORMAT_R32_SINT: return "VK_FORMAT_R32_SINT";
-        case VK_FORMAT_R32_SFLOAT: return "VK_FORMAT_R32_SFLOAT";
-        case VK_FORMAT_R32G32_UINT: return "VK_FORMAT_R32G32_UINT";
-        case VK_FORMAT_R32G32_SINT: return "VK_FORMAT_R32G32_SINT";
-        case VK_FORMAT_R32G32_SFLOAT : return "VK_FORMAT_R32G32_SFLOAT";
-        case VK_FORMAT_R32G32B32_UINT : return "VK_FORMAT_R32G32B32_UINT";
-        case VK_FORMAT_R32G32B32_SINT : return "VK_FORMAT_R32G32B32_SINT";
-        case VK_FORMAT_R32G32B32_SFLOAT : return "VK_FORMAT_R32G32B32_SFLOAT";
-        case VK_FORMAT_R32G32B32A32_UINT : return "VK_FORMAT_R32G32B32A32_UINT";
-        case VK_FORMAT_R32G32B32A32_SINT : return "VK_FORMAT_R32G32B32A32_SINT";
-        case VK_FORMAT_R32G32B32A32_SFLOAT: return "VK_FORMAT_R32G32B32A32_SFLOAT";
-        case VK_FORMAT_R64_UINT : return "VK_FORMAT_R64_UINT";
-        case VK_FORMAT_R64_SINT : return "VK_FORMAT_R64_SINT";
-        case VK_FORMAT_R64_SFLOAT : return "VK_FORMAT_R64_SFLOAT";
-        case VK_FORMAT_R64G64_UINT: return "VK_FORMAT_R64G64_UINT";
-        case VK_FORMAT_R64G64_SINT : return "VK_FORMAT_R64G64_SINT";
-        case VK_FORMAT_R64G64_SFLOAT : return "VK_FORMAT_R64G64_SFLOAT";
-        case VK_FORMAT_R64G64B64_UINT: return "VK_FORMAT_R64G64B64_UINT";
-        case VK_FORMAT_R64G64B64_SINT : return "VK_FORMAT_R64G64B64_SINT";
-        case VK_FORMAT_R64G64B64_SFLOAT: return "VK_FORMAT_R64G64B64_SFLOAT";
-        case VK_FORMAT_R64G64B64A64_UINT : return "VK_FORMAT_R64G64B64A64_UINT";
-        case VK_FORMAT_R64G64B64A64_SINT: return "VK_FORMAT_R64G64B64A64_SINT";
-        case VK_FORMAT_R64G64B64A64_SFLOAT: return "VK_FORMAT_R64G64B64A64_SFLOAT";
-        case VK_FORMAT_B10G11R11_UFLOAT_PACK32: return "VK_FORMAT_B10G11R11_UFLOAT_PACK32";
-        case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32 : return "VK_FORMAT_E5B9G9R9_UFLOAT_PACK32";
-        case VK_FORMAT_D16_UNORM : return "VK_FORMAT_D16_UNORM";
-        case VK_FORMAT_X8_D24_UNORM_PACK32 : return "VK_FORMAT_X8_D24_UNORM_PACK32";
-        case VK_FORMAT_D32_SFLOAT : return "VK_FORMAT_D32_SFLOAT";
-        case VK_FORMAT_S8_UINT : return "VK_FORMAT_S8_UINT";
-        case VK_FORMAT_D16_UNORM_S8_UINT: return "VK_FORMAT_D16_UNORM_S8_UINT";
-        case VK_FORMAT_D24_UNORM_S8_UINT: return "VK_FORMAT_D24_UNORM_S8_UINT";
-        case VK_FORMAT_D32_SFLOAT_S8_UINT: return "VK_FORMAT_D32_SFLOAT_S8_UINT";
-        case VK_FORMAT_BC1_RGB_UNORM_BLOCK: return "VK_FORMAT_BC1_RGB_UNORM_BLOCK";
-        case VK_FORMAT_BC1_RGB_SRGB_BLOCK: return "VK_FORMAT_BC1_RGB_SRGB_BLOCK";
-        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: return "VK_FORMAT_BC1_RGBA_UNORM_BLOCK";
-        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK : return "VK_FORMAT_BC1_RGBA_SRGB_BLOCK";
-        case VK_FORMAT_BC2_UNORM_BLOCK : return "VK_FORMAT_BC2_UNORM_BLOCK";
-        case VK_FORMAT_BC2_SRGB_BLOCK: return "VK_FORMAT_BC2_SRGB_BLOCK";
-        case VK_FORMAT_BC3_UNORM_BLOCK: return "VK_FORMAT_BC3_UNORM_BLOCK";
-        case VK_FORMAT_BC3_SRGB_BLOCK : return "VK_FORMAT_BC3_SRGB_BLOCK";
-        case VK_FORMAT_BC4_UNORM_BLOCK : return "VK_FORMAT_BC4_UNORM_BLOCK";
-        case VK_FORMAT_BC4_SNORM_BLOCK : return "VK_FORMAT_BC4_SNORM_BLOCK";
-        case VK_FORMAT_BC5_UNORM_BLOCK : return "VK_FORMAT_BC5_UNORM_BLOCK";
-        case VK_FORMAT_BC5_SNORM_BLOCK : return "VK_FORMAT_BC5_SNORM_BLOCK";
-        case VK_FORMAT_BC6H_UFLOAT_BLOCK : return "VK_FORMAT_BC6H_UFLOAT_BLOCK";
-        case VK_FORMAT_BC6H_SFLOAT_BLOCK: return "VK_FORMAT_BC6H_SFLOAT_BLOCK";
-        case VK_FORMAT_BC7_UNORM_BLOCK: return "VK_FORMAT_BC7_UNORM_BLOCK";
-        case VK_FORMAT_BC7_SRGB_BLOCK: return "VK_FORMAT_BC7_SRGB_BLOCK";
-        case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK: return "VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK";
-        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK: return "VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK";
-        case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK: return "VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK";
-        case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK : return "VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK";
-        case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK: return "VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK";
-        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK : return "VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK";
-        case VK_FORMAT_EAC_R11_UNORM_BLOCK: return "VK_FORMAT_EAC_R11_UNORM_BLOCK";
-        case VK_FORMAT_EAC_R11_SNORM_BLOCK : return "VK_FORMAT_EAC_R11_SNORM_BLOCK";
-        case VK_FORMAT_EAC_R11G11_UNORM_BLOCK : return "VK_FORMAT_EAC_R11G11_UNORM_BLOCK";
-        case VK_FORMAT_EAC_R11G11_SNORM_BLOCK : return "VK_FORMAT_EAC_R11G11_SNORM_BLOCK";
-        case VK_FORMAT_ASTC_4x4_UNORM_BLOCK : return "VK_FORMAT_ASTC_4x4_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_4x4_SRGB_BLOCK : return "VK_FORMAT_ASTC_4x4_SRGB_BLOCK";
-        case VK_FORMAT_ASTC_5x4_UNORM_BLOCK : return "VK_FORMAT_ASTC_5x4_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_5x4_SRGB_BLOCK : return "VK_FORMAT_ASTC_5x4_SRGB_BLOCK";
-        case VK_FORMAT_ASTC_5x5_UNORM_BLOCK : return "VK_FORMAT_ASTC_5x5_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_5x5_SRGB_BLOCK : return "VK_FORMAT_ASTC_5x5_SRGB_BLOCK";
-        case VK_FORMAT_ASTC_6x5_UNORM_BLOCK : return "VK_FORMAT_ASTC_6x5_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_6x5_SRGB_BLOCK: return "VK_FORMAT_ASTC_6x5_SRGB_BLOCK";
-        case VK_FORMAT_ASTC_6x6_UNORM_BLOCK: return "VK_FORMAT_ASTC_6x6_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_6x6_SRGB_BLOCK: return "VK_FORMAT_ASTC_6x6_SRGB_BLOCK";
-        case VK_FORMAT_ASTC_8x5_UNORM_BLOCK: return "VK_FORMAT_ASTC_8x5_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_8x5_SRGB_BLOCK: return "VK_FORMAT_ASTC_8x5_SRGB_BLOCK";
-        case VK_FORMAT_ASTC_8x6_UNORM_BLOCK: return "VK_FORMAT_ASTC_8x6_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_8x6_SRGB_BLOCK: return "VK_FORMAT_ASTC_8x6_SRGB_BLOCK";
-        case VK_FORMAT_ASTC_8x8_UNORM_BLOCK: return "VK_FORMAT_ASTC_8x8_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_8x8_SRGB_BLOCK: return "VK_FORMAT_ASTC_8x8_SRGB_BLOCK";
-        case VK_FORMAT_ASTC_10x5_UNORM_BLOCK: return "VK_FORMAT_ASTC_10x5_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_10x5_SRGB_BLOCK: return "VK_FORMAT_ASTC_10x5_SRGB_BLOCK";
-        case VK_FORMAT_ASTC_10x6_UNORM_BLOCK: return "VK_FORMAT_ASTC_10x6_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_10x6_SRGB_BLOCK: return "VK_FORMAT_ASTC_10x6_SRGB_BLOCK";
-        case VK_FORMAT_ASTC_10x8_UNORM_BLOCK: return "VK_FORMAT_ASTC_10x8_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_10x8_SRGB_BLOCK: return "VK_FORMAT_ASTC_10x8_SRGB_BLOCK";
-        case VK_FORMAT_ASTC_10x10_UNORM_BLOCK : return "VK_FORMAT_ASTC_10x10_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_10x10_SRGB_BLOCK : return "VK_FORMAT_ASTC_10x10_SRGB_BLOCK";
-        case VK_FORMAT_ASTC_12x10_UNORM_BLOCK : return "VK_FORMAT_ASTC_12x10_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_12x10_SRGB_BLOCK : return "VK_FORMAT_ASTC_12x10_SRGB_BLOCK";
-        case VK_FORMAT_ASTC_12x12_UNORM_BLOCK : return "VK_FORMAT_ASTC_12x12_UNORM_BLOCK";
-        case VK_FORMAT_ASTC_12x12_SRGB_BLOCK : return "VK_FORMAT_ASTC_12x12_SRGB_BLOCK";
-        case VK_FORMAT_G8B8G8R8_422_UNORM : return "VK_FORMAT_G8B8G8R8_422_UNORM";
-        case VK_FORMAT_B8G8R8G8_422_UNORM : return "VK_FORMAT_B8G8R8G8_422_UNORM";
-        case VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM : return "VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM";
-        case VK_FORMAT_G8_B8R8_2PLANE_420_UNORM : return "VK_FORMAT_G8_B8R8_2PLANE_420_UNORM";
-        case VK_FORMAT_G8_B8_R8_3PLANE_422_UNORM : return "VK_FORMAT_G8_B8_R8_3PLANE_422_UNORM";
-        case VK_FORMAT_G8_B8R8_2PLANE_422_UNORM : return "VK_FORMAT_G8_B8R8_2PLANE_422_UNORM";
-        case VK_FORMAT_G8_B8_R8_3PLANE_444_UNORM : return "VK_FORMAT_G8_B8_R8_3PLANE_444_UNORM";
-        case VK_FORMAT_R10X6_UNORM_PACK16 : return "VK_FORMAT_R10X6_UNORM_PACK16";
-        case VK_FORMAT_R10X6G10X6_UNORM_2PACK16: return "VK_FORMAT_R10X6G10X6_UNORM_2PACK16";
-        case VK_FORMAT_R10X6G10X6B10X6A10X6_UNORM_4PACK16 : return "VK_FORMAT_R10X6G10X6B10X6A10X6_UNORM_4PACK16";
-        case VK_FORMAT_G10X6B10X6G10X6R10X6_422_UNORM_4PACK16 : return "VK_FORMAT_G10X6B10X6G10X6R10X6_422_UNORM_4PACK16";
-        case VK_FORMAT_B10X6G10X6R10X6G10X6_422_UNORM_4PACK16: return "VK_FORMAT_B10X6G10X6R10X6G10X6_422_UNORM_4PACK16";
-        case VK_FORMAT_G10X6_B10X6_R10X6_3PLANE_420_UNORM_3PACK16 : return "VK_FORMAT_G10X6_B10X6_R10X6_3PLANE_420_UNORM_3PACK16";
-        case VK_FORMAT_G10X6_B10X6R10X6_2PLANE_420_UNORM_3PACK16 : return "VK_FORMAT_G10X6_B10X6R10X6_2PLANE_420_UNORM_3PACK16";
-        case VK_FORMAT_G10X6_B10X6_R10X6_3PLANE_422_UNORM_3PACK16: return "VK_FORMAT_G10X6_B10X6_R10X6_3PLANE_422_UNORM_3PACK16";
-        case VK_FORMAT_G10X6_B10X6R10X6_2PLANE_422_UNORM_3PACK16 : return "VK_FORMAT_G10X6_B10X6R10X6_2PLANE_422_UNORM_3PACK16";
-        case VK_FORMAT_G10X6_B10X6_R10X6_3PLANE_444_UNORM_3PACK16 : return "VK_FORMAT_G10X6_B10X6_R10X6_3PLANE_444_UNORM_3PACK16";
-        case VK_FORMAT_R12X4_UNORM_PACK16 : return "VK_FORMAT_R12X4_UNORM_PACK16";
-        case VK_FORMAT_R12X4G12X4_UNORM_2PACK16: return "VK_FORMAT_R12X4G12X4_UNORM_2PACK16";
-        case VK_FORMAT_R12X4G12X4B12X4A12X4_UNORM_4PACK16: return "VK_FORMAT_R12X4G12X4B12X4A12X4_UNORM_4PACK16";
-        case VK_FORMAT_G12X4B12X4G12X4R12X4_422_UNORM_4PACK16: return "VK_FORMAT_G12X4B12X4G12X4R12X4_422_UNORM_4PACK16";
-        case VK_FORMAT_B12X4G12X4R12X4G12X4_422_UNORM_4PACK16 : return "VK_FORMAT_B12X4G12X4R12X4G12X4_422_UNORM_4PACK16";
-        case VK_FORMAT_G12X4_B12X4_R12X4_3PLANE_420_UNORM_3PACK16 : return "VK_FORMAT_G12X4_B12X4_R12X4_3PLANE_420_UNORM_3PACK16";
-        case VK_FORMAT_G12X4_B12X4R12X4_2PLANE_420_UNORM_3PACK16 : return "VK_FORMAT_G12X4_B12X4R12X4_2PLANE_420_UNORM_3PACK16";
-        case VK_FORMAT_G12X4_B12X4_R12X4_3PLANE_422_UNORM_3PACK16 : return "VK_FORMAT_G12X4_B12X4_R12X4_3PLANE_422_UNORM_3PACK16";
-        case VK_FORMAT_G12X4_B12X4R12X4_2PLANE_422_UNORM_3PACK16 : return "VK_FORMAT_G12X4_B12X4R12X4_2PLANE_422_UNORM_3PACK16";
-        case VK_FORMAT_G12X4_B12X4_R12X4_3PLANE_444_UNORM_3PACK16 : return "VK_FORMAT_G12X4_B12X4_R12X4_3PLANE_444_UNORM_3PACK16";
-        case VK_FORMAT_G16B16G16R16_422_UNORM : return "VK_FORMAT_G16B16G16R16_422_UNORM";
-        case VK_FORMAT_B16G16R16G16_422_UNORM : return "VK_FORMAT_B16G16R16G16_422_UNORM";
-        case VK_FORMAT_G16_B16_R16_3PLANE_420_UNORM : return "VK_FORMAT_G16_B16_R16_3PLANE_420_UNORM";
-        case VK_FORMAT_G16_B16R16_2PLANE_420_UNORM : return "VK_FORMAT_G16_B16R16_2PLANE_420_UNORM";
-        case VK_FORMAT_G16_B16_R16_3PLANE_422_UNORM : return "VK_FORMAT_G16_B16_R16_3PLANE_422_UNORM";
-        case VK_FORMAT_G16_B16R16_2PLANE_422_UNORM : return "VK_FORMAT_G16_B16R16_2PLANE_422_UNORM";
-        case VK_FORMAT_G16_B16_R16_3PLANE_444_UNORM : return "VK_FORMAT_G16_B16_R16_3PLANE_444_UNORM";
-        case VK_FORMAT_PVRTC1_2BPP_UNORM_BLOCK_IMG : return "VK_FORMAT_PVRTC1_2BPP_UNORM_BLOCK_IMG";
-        case VK_FORMAT_PVRTC1_4BPP_UNORM_BLOCK_IMG : return "VK_FORMAT_PVRTC1_4BPP_UNORM_BLOCK_IMG";
-        case VK_FORMAT_PVRTC2_2BPP_UNORM_BLOCK_IMG : return "VK_FORMAT_PVRTC2_2BPP_UNORM_BLOCK_IMG";
-        case VK_FORMAT_PVRTC2_4BPP_UNORM_BLOCK_IMG: return "VK_FORMAT_PVRTC2_4BPP_UNORM_BLOCK_IMG";
-        case VK_FORMAT_PVRTC1_2BPP_SRGB_BLOCK_IMG : return "VK_FORMAT_PVRTC1_2BPP_SRGB_BLOCK_IMG";
-        case VK_FORMAT_PVRTC1_4BPP_SRGB_BLOCK_IMG: return "VK_FORMAT_PVRTC1_4BPP_SRGB_BLOCK_IMG";
-        case VK_FORMAT_PVRTC2_2BPP_SRGB_BLOCK_IMG : return "VK_FORMAT_PVRTC2_2BPP_SRGB_BLOCK_IMG";
-        case VK_FORMAT_PVRTC2_4BPP_SRGB_BLOCK_IMG : return "VK_FORMAT_PVRTC2_4BPP_SRGB_BLOCK_IMG";
-        default:
-            break;
-    }
-    return std::to_string(static_cast<int>(f));
-}
-
-std::string vlk::to_string(VkColorSpaceKHR cs)
-{
-    switch (cs) {
-        case VK_COLOR_SPACE_SRGB_NONLINEAR_KHR: return "VK_COLOR_SPACE_SRGB_NONLINEAR_KHR";
-        case VK_COLOR_SPACE_DISPLAY_P3_NONLINEAR_EXT: return "VK_COLOR_SPACE_DISPLAY_P3_NONLINEAR_EXT";
-        case VK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT: return "VK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT";
-        case VK_COLOR_SPACE_DCI_P3_LINEAR_EXT: return "VK_COLOR_SPACE_DCI_P3_LINEAR_EXT";
-        case VK_COLOR_SPACE_DCI_P3_NONLINEAR_EXT: return "VK_COLOR_SPACE_DCI_P3_NONLINEAR_EXT";
-        case VK_COLOR_SPACE_BT709_LINEAR_EXT: return "VK_COLOR_SPACE_BT709_LINEAR_EXT";
-        case VK_COLOR_SPACE_BT709_NONLINEAR_EXT: return "VK_COLOR_SPACE_BT709_NONLINEAR_EXT";
-        case VK_COLOR_SPACE_BT2020_LINEAR_EXT: return "VK_COLOR_SPACE_BT2020_LINEAR_EXT";
-        case VK_COLOR_SPACE_HDR10_ST2084_EXT: return "VK_COLOR_SPACE_HDR10_ST2084_EXT";
-        case VK_COLOR_SPACE_DOLBYVISION_EXT: return "VK_COLOR_SPACE_DOLBYVISION_EXT";
-        case VK_COLOR_SPACE_HDR10_HLG_EXT: return "VK_COLOR_SPACE_HDR10_HLG_EXT";
-        case VK_COLOR_SPACE_ADOBERGB_LINEAR_EXT: return "VK_COLOR_SPACE_ADOBERGB_LINEAR_EXT";
-        case VK_COLOR_SPACE_ADOBERGB_NONLINEAR_EXT: return "VK_COLOR_SPACE_ADOBERGB_NONLINEAR_EXT";
-        case VK_COLOR_SPACE_PASS_THROUGH_EXT: return "VK_COLOR_SPACE_PASS_THROUGH_EXT";
-        case VK_COLOR_SPACE_EXTENDED_SRGB_NONLINEAR_EXT: return "VK_COLOR_SPACE_EXTENDED_SRGB_NONLINEAR_EXT";
-        case VK_COLOR_SPACE_DISPLAY_NATIVE_AMD: return "VK_COLOR_SPACE_DISPLAY_NATIVE_AMD";
-        default:
-            break;
-    }
-    return std::to_string(static_cast<int>(cs));
-}
-
-std::string vlk::to_string(VkPresentModeKHR pm)
-{
-    switch (pm) {
-        case VK_PRESENT_MODE_IMMEDIATE_KHR: return "VK_PRESENT_MODE_IMMEDIATE_KHR";
-        case VK_PRESENT_MODE_MAILBOX_KHR: return "VK_PRESENT_MODE_MAILBOX_KHR";
-        case VK_PRESENT_MODE_FIFO_KHR: return "VK_PRESENT_MODE_FIFO_KHR";
-        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "VK_PRESENT_MODE_FIFO_RELAXED_KHR";
-        case VK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR: return "VK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR";
-        case VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR: return "VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR";
-        default:
-            break;
-    }
-    return std::to_string(static_cast<int>(pm));
-}
-
-
-void vlk::log_phys_device(vlk::phys_device const& pd, VkSurfaceKHR surface, std::string const& prefix)
+void vlk::log_phys_device(vlk::phys_device const& pd, VkSurfaceKHR surface, std::string const& prefix,
+                          vlk::device_score const* score)
 {
     VLK_LOG_DEBUG() << prefix << pd.properties.deviceName << " (" << pd.device << ") "
                     << to_string(pd.properties.deviceType);
+    if (nullptr != score) {
+        VLK_LOG_DEBUG() << "  " << prefix << "score = " << score->total()
+            << " type: " << score->type
+            << " memory: " << score->memory
+            << " queues: " << score->queues
+            << " limits: " << score->limits
+            << " probe: " << score->probe;
+    }
     uint32_t qf_idx{0};
     for (auto const& qfp : pd.queue_family_properties) {
         VLK_LOG_DEBUG() << "  " << prefix << "queue-family #" << qf_idx
@@ -368,7 +44,7 @@ void vlk::log_phys_device(vlk::phys_device const& pd, VkSurfaceKHR surface, std:
             << " TRA: " << (0 != (qfp.queueFlags & VK_QUEUE_TRANSFER_BIT))
             << " SPA: " << (0 != (qfp.queueFlags & VK_QUEUE_SPARSE_BINDING_BIT))
             << " PRO: " << (0 != (qfp.queueFlags & VK_QUEUE_PROTECTED_BIT))
-            << " Present: " << pd.can_present_on_surface(qf_idx, surface);
+            << " Present: " << (VK_NULL_HANDLE != surface && pd.can_present_on_surface(qf_idx, surface));
         ++qf_idx;
     }
 }
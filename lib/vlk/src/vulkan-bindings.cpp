@@ -22,42 +22,50 @@
 using namespace vlk;
 
 
-VkResult vlk::createDebugReportCallbackEXT(
+VkResult vlk::createDebugUtilsMessengerEXT(
         VkInstance instance,
-        const VkDebugReportCallbackCreateInfoEXT* pCreateInfo,
+        const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
         const VkAllocationCallbacks* pAllocator,
-        VkDebugReportCallbackEXT* pCallback)
+        VkDebugUtilsMessengerEXT* pMessenger)
 {
-    static auto fn = reinterpret_cast<PFN_vkCreateDebugReportCallbackEXT>(vkGetInstanceProcAddr(instance, "vkCreateDebugReportCallbackEXT"));
+    static auto fn = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT"));
     if (fn == nullptr) {
         return VK_ERROR_EXTENSION_NOT_PRESENT;
     }
-    return fn(instance, pCreateInfo, pAllocator, pCallback);
+    return fn(instance, pCreateInfo, pAllocator, pMessenger);
 }
 
-void vlk::destroyDebugReportCallbackEXT(
+void vlk::destroyDebugUtilsMessengerEXT(
         VkInstance instance,
-        VkDebugReportCallbackEXT callback,
+        VkDebugUtilsMessengerEXT messenger,
         const VkAllocationCallbacks* pAllocator)
 {
-    static auto fn = reinterpret_cast<PFN_vkDestroyDebugReportCallbackEXT>(vkGetInstanceProcAddr(instance, "vkDestroyDebugReportCallbackEXT"));
+    static auto fn = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT"));
     if (fn) {
-        fn(instance, callback, pAllocator);
+        fn(instance, messenger, pAllocator);
     }
 }
 
-void vlk::debugReportMessageEXT(
+void vlk::submitDebugUtilsMessageEXT(
         VkInstance instance,
-        VkDebugReportFlagsEXT flags,
-        VkDebugReportObjectTypeEXT objectType,
-        uint64_t object,
-        size_t location,
-        int32_t messageCode,
-        const char* pLayerPrefix,
-        const char* pMessage)
+        VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+        VkDebugUtilsMessageTypeFlagsEXT messageTypes,
+        const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData)
 {
-    static auto fn = reinterpret_cast<PFN_vkDebugReportMessageEXT>(vkGetInstanceProcAddr(instance, "vkDebugReportMessageEXT"));
+    static auto fn = reinterpret_cast<PFN_vkSubmitDebugUtilsMessageEXT>(vkGetInstanceProcAddr(instance, "vkSubmitDebugUtilsMessageEXT"));
     if (fn) {
-        fn(instance, flags, objectType, object, location, messageCode, pLayerPrefix, pMessage);
+        fn(instance, messageSeverity, messageTypes, pCallbackData);
     }
 }
+
+VkResult vlk::setDebugUtilsObjectNameEXT(
+        VkInstance instance,
+        VkDevice device,
+        const VkDebugUtilsObjectNameInfoEXT* pNameInfo)
+{
+    static auto fn = reinterpret_cast<PFN_vkSetDebugUtilsObjectNameEXT>(vkGetInstanceProcAddr(instance, "vkSetDebugUtilsObjectNameEXT"));
+    if (fn == nullptr) {
+        return VK_ERROR_EXTENSION_NOT_PRESENT;
+    }
+    return fn(device, pNameInfo);
+}
@@ -23,25 +23,26 @@
 
 namespace vlk {
 
-    VkResult createDebugReportCallbackEXT(
+    VkResult createDebugUtilsMessengerEXT(
             VkInstance instance,
-            const VkDebugReportCallbackCreateInfoEXT *pCreateInfo,
+            const VkDebugUtilsMessengerCreateInfoEXT *pCreateInfo,
             const VkAllocationCallbacks *pAllocator,
-            VkDebugReportCallbackEXT *pCallback);
+            VkDebugUtilsMessengerEXT *pMessenger);
 
-    void destroyDebugReportCallbackEXT(
+    void destroyDebugUtilsMessengerEXT(
             VkInstance instance,
-            VkDebugReportCallbackEXT callback,
+            VkDebugUtilsMessengerEXT messenger,
             const VkAllocationCallbacks *pAllocator);
 
-    void debugReportMessageEXT(
+    void submitDebugUtilsMessageEXT(
             VkInstance instance,
-            VkDebugReportFlagsEXT flags,
-            VkDebugReportObjectTypeEXT objectType,
-            uint64_t object,
-            size_t location,
-            int32_t messageCode,
-            const char *pLayerPrefix,
-            const char *pMessage);
+            VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+            VkDebugUtilsMessageTypeFlagsEXT messageTypes,
+            const VkDebugUtilsMessengerCallbackDataEXT *pCallbackData);
+
+    VkResult setDebugUtilsObjectNameEXT(
+            VkInstance instance,
+            VkDevice device,
+            const VkDebugUtilsObjectNameInfoEXT *pNameInfo);
 
 } // namespace vlk
@@ -0,0 +1,192 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/barrier_batch.h>
+
+#include <vector>
+
+using namespace vlk;
+
+namespace {
+
+    VkImage fake_image(uintptr_t v) { return reinterpret_cast<VkImage>(v); }
+    VkBuffer fake_buffer(uintptr_t v) { return reinterpret_cast<VkBuffer>(v); }
+
+    VkImageSubresourceRange color_range()
+    {
+        VkImageSubresourceRange r{};
+        r.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        r.levelCount = 1U;
+        r.layerCount = 1U;
+        return r;
+    }
+
+    //! The arguments of the last vkCmdPipelineBarrier recorded by a batch.
+    struct recorded_barrier
+    {
+        VkPipelineStageFlags src_stages{0};
+        VkPipelineStageFlags dst_stages{0};
+        std::vector<VkBufferMemoryBarrier> buffers{};
+        std::vector<VkImageMemoryBarrier> images{};
+        uint32_t calls{0};
+    };
+
+    recorded_barrier recorded{};
+
+    void record_barrier(VkCommandBuffer, VkPipelineStageFlags src_stages, VkPipelineStageFlags dst_stages,
+                        VkDependencyFlags, uint32_t, VkMemoryBarrier const*, uint32_t buffer_count,
+                        VkBufferMemoryBarrier const* buffers, uint32_t image_count, VkImageMemoryBarrier const* images)
+    {
+        recorded.src_stages = src_stages;
+        recorded.dst_stages = dst_stages;
+        recorded.buffers.assign(buffers, buffers + buffer_count);
+        recorded.images.assign(images, images + image_count);
+        ++recorded.calls;
+    }
+
+    VkCommandBuffer fake_cmd() { return reinterpret_cast<VkCommandBuffer>(uintptr_t{0x1}); }
+
+}
+
+// barriers are only collected by the first tests, flush() is not called without a command buffer
+
+TEST(barrier_batch, reads_accumulate)
+{
+    barrier_batch batch{VK_NULL_HANDLE, false};
+    auto const buf = fake_buffer(0x10);
+    batch.track(buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    ASSERT_TRUE(batch.empty());
+
+    batch.buffer(buf, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    ASSERT_FALSE(batch.empty());
+    batch.buffer(buf, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    auto s = batch.buffer_state(buf);
+    ASSERT_EQ(VK_PIPELINE_STAGE_TRANSFER_BIT, s.write_stages);
+    ASSERT_EQ(VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, s.visible_stages);
+    ASSERT_EQ(VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, s.read_stages);
+
+    // a write waits for all reads, afterwards nothing is visible to the former readers
+    batch.buffer(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+    s = batch.buffer_state(buf);
+    ASSERT_EQ(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, s.write_stages);
+    ASSERT_EQ(0U, s.read_stages);
+    ASSERT_EQ(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, s.visible_stages);
+}
+
+TEST(barrier_batch, layout_tracking)
+{
+    barrier_batch batch{VK_NULL_HANDLE, false};
+    auto const img = fake_image(0x20);
+    ASSERT_EQ(VK_IMAGE_LAYOUT_UNDEFINED, batch.image_state(img).layout);
+
+    batch.image(img, color_range(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    auto s = batch.image_state(img);
+    ASSERT_EQ(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, s.layout);
+    ASSERT_EQ(VK_PIPELINE_STAGE_TRANSFER_BIT, s.write_stages);
+    ASSERT_EQ(VK_ACCESS_TRANSFER_WRITE_BIT, s.write_access);
+
+    // the next use after the copy: sampled in the fragment shader
+    batch.image(img, color_range(), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    s = batch.image_state(img);
+    ASSERT_EQ(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, s.layout);
+    ASSERT_EQ(0U, s.write_access);
+    ASSERT_EQ(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, s.read_stages);
+
+    batch.forget(img);
+    ASSERT_EQ(VK_IMAGE_LAYOUT_UNDEFINED, batch.image_state(img).layout);
+}
+
+TEST(barrier_batch, flush_write_after_reads)
+{
+    recorded = recorded_barrier{};
+    barrier_batch batch{record_barrier};
+    auto const buf = fake_buffer(0x30);
+    batch.track(buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    batch.buffer(buf, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    batch.flush(fake_cmd());
+    ASSERT_EQ(1U, recorded.calls);
+    ASSERT_EQ(1U, recorded.buffers.size());
+    ASSERT_EQ(VK_PIPELINE_STAGE_TRANSFER_BIT, recorded.src_stages);
+    ASSERT_EQ(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, recorded.dst_stages);
+    ASSERT_EQ(VK_ACCESS_TRANSFER_WRITE_BIT, recorded.buffers[0].srcAccessMask);
+    ASSERT_EQ(VK_ACCESS_SHADER_READ_BIT, recorded.buffers[0].dstAccessMask);
+    ASSERT_TRUE(batch.empty());
+
+    // the pending compute read is merged with the transfer write, which still has to wait for the fragment read
+    batch.buffer(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    batch.buffer(buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    batch.flush(fake_cmd());
+    ASSERT_EQ(2U, recorded.calls);
+    ASSERT_EQ(1U, recorded.buffers.size());
+    ASSERT_EQ(buf, recorded.buffers[0].buffer);
+    ASSERT_NE(0U, recorded.src_stages & VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    ASSERT_NE(0U, recorded.src_stages & VK_PIPELINE_STAGE_TRANSFER_BIT);
+    ASSERT_EQ(VK_PIPELINE_STAGE_TRANSFER_BIT, recorded.dst_stages);
+    ASSERT_EQ(VK_ACCESS_TRANSFER_WRITE_BIT, recorded.buffers[0].srcAccessMask);
+    ASSERT_EQ(VK_ACCESS_TRANSFER_WRITE_BIT, recorded.buffers[0].dstAccessMask);
+
+    // nothing pending, nothing recorded
+    batch.flush(fake_cmd());
+    ASSERT_EQ(2U, recorded.calls);
+}
+
+TEST(barrier_batch, flush_two_ranges_of_one_image)
+{
+    recorded = recorded_barrier{};
+    barrier_batch batch{record_barrier};
+    auto const img = fake_image(0x40);
+    batch.track(img, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0);
+
+    auto mip0 = color_range();
+    auto mip2 = color_range();
+    mip2.baseMipLevel = 2U;
+    mip2.baseArrayLayer = 1U;
+    batch.image(img, mip0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    batch.image(img, mip2, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true);
+    batch.flush(fake_cmd());
+    ASSERT_EQ(1U, recorded.calls);
+    ASSERT_EQ(1U, recorded.images.size());
+    auto const& b = recorded.images[0];
+    ASSERT_EQ(img, b.image);
+    ASSERT_EQ(0U, b.subresourceRange.baseMipLevel);
+    ASSERT_EQ(3U, b.subresourceRange.levelCount);
+    ASSERT_EQ(0U, b.subresourceRange.baseArrayLayer);
+    ASSERT_EQ(2U, b.subresourceRange.layerCount);
+    // discarding the second range must not discard the first one
+    ASSERT_EQ(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, b.oldLayout);
+    ASSERT_EQ(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, b.newLayout);
+
+    auto all = color_range();
+    all.levelCount = VK_REMAINING_MIP_LEVELS;
+    batch.image(img, mip0, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    batch.image(img, all, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    batch.flush(fake_cmd());
+    ASSERT_EQ(2U, recorded.calls);
+    ASSERT_EQ(1U, recorded.images.size());
+    ASSERT_EQ(0U, recorded.images[0].subresourceRange.baseMipLevel);
+    ASSERT_EQ(VK_REMAINING_MIP_LEVELS, recorded.images[0].subresourceRange.levelCount);
+}
@@ -0,0 +1,82 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/debug_messenger.h>
+
+using namespace vlk;
+
+TEST(debug_message_filter, burst_then_rate_limit)
+{
+    debug_message_filter filter{debug_message_limits{2U, std::chrono::milliseconds{100}}};
+    auto const t0 = debug_message_filter::clock::now();
+    ASSERT_TRUE(filter.filter(7, "id-7", t0).pass);
+    ASSERT_TRUE(filter.filter(7, "id-7", t0).pass);
+    ASSERT_FALSE(filter.filter(7, "id-7", t0 + std::chrono::milliseconds{10}).pass);
+    ASSERT_FALSE(filter.filter(7, "id-7", t0 + std::chrono::milliseconds{50}).pass);
+
+    // after the interval one message passes and reports the ones dropped before it
+    auto const v = filter.filter(7, "id-7", t0 + std::chrono::milliseconds{100});
+    ASSERT_TRUE(v.pass);
+    ASSERT_EQ(2U, v.suppressed);
+    ASSERT_FALSE(filter.filter(7, "id-7", t0 + std::chrono::milliseconds{150}).pass);
+}
+
+TEST(debug_message_filter, first_message_passes_without_burst)
+{
+    debug_message_filter filter{debug_message_limits{0U, std::chrono::milliseconds{100}}};
+    auto const t0 = debug_message_filter::clock::now();
+    ASSERT_TRUE(filter.filter(7, "id-7", t0).pass);
+    ASSERT_FALSE(filter.filter(7, "id-7", t0 + std::chrono::milliseconds{10}).pass);
+    auto const v = filter.filter(7, "id-7", t0 + std::chrono::milliseconds{100});
+    ASSERT_TRUE(v.pass);
+    ASSERT_EQ(1U, v.suppressed);
+}
+
+TEST(debug_message_filter, ids_are_independent)
+{
+    debug_message_filter filter{debug_message_limits{1U, std::chrono::milliseconds{1000}}};
+    auto const t0 = debug_message_filter::clock::now();
+    ASSERT_TRUE(filter.filter(1, "a", t0).pass);
+    ASSERT_FALSE(filter.filter(1, "a", t0).pass);
+    ASSERT_TRUE(filter.filter(2, "b", t0).pass);
+    // id 0 is shared by messages without number, their names tell them apart
+    ASSERT_TRUE(filter.filter(0, "c", t0).pass);
+    ASSERT_TRUE(filter.filter(0, "d", t0).pass);
+    ASSERT_TRUE(filter.filter(0, nullptr, t0).pass);
+    ASSERT_FALSE(filter.filter(0, nullptr, t0).pass);
+}
+
+TEST(debug_message_filter, stats)
+{
+    debug_message_filter filter{debug_message_limits{1U, std::chrono::milliseconds{1000}}};
+    auto const t0 = debug_message_filter::clock::now();
+    for (int i = 0; i < 5; ++i) {
+        filter.filter(3, "frequent", t0);
+    }
+    filter.filter(4, "rare", t0);
+    auto const stats = filter.stats();
+    ASSERT_EQ(2U, stats.size());
+    ASSERT_EQ("frequent", stats[0].name);
+    ASSERT_EQ(3, stats[0].id);
+    ASSERT_EQ(5U, stats[0].count);
+    ASSERT_EQ(4U, stats[0].suppressed);
+    ASSERT_EQ("rare", stats[1].name);
+    ASSERT_EQ(0U, stats[1].suppressed);
+}
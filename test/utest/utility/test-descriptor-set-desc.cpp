@@ -0,0 +1,59 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/descriptor_allocator.h>
+
+using namespace vlk;
+
+namespace {
+
+    VkBuffer fake_buffer(uintptr_t v) { return reinterpret_cast<VkBuffer>(v); }
+    VkImageView fake_view(uintptr_t v) { return reinterpret_cast<VkImageView>(v); }
+
+}
+
+TEST(descriptor_set_desc, binding_order_does_not_matter)
+{
+    descriptor_set_desc a;
+    a.buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, fake_buffer(0x10), 0, 256)
+     .image(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, fake_view(0x20), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    descriptor_set_desc b;
+    b.image(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, fake_view(0x20), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+     .buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, fake_buffer(0x10), 0, 256);
+    ASSERT_EQ(a.hash(), b.hash());
+    ASSERT_TRUE(a == b);
+}
+
+TEST(descriptor_set_desc, contents_differ)
+{
+    descriptor_set_desc a;
+    a.buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, fake_buffer(0x10), 0, 256);
+    descriptor_set_desc b;
+    b.buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, fake_buffer(0x10), 256, 256);
+    ASSERT_FALSE(a == b);
+
+    // rebinding replaces the previous descriptor
+    b.buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, fake_buffer(0x10), 0, 256);
+    ASSERT_TRUE(a == b);
+    ASSERT_EQ(a.hash(), b.hash());
+
+    b.buffer(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, fake_buffer(0x10));
+    ASSERT_FALSE(a == b);
+}
@@ -0,0 +1,100 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/phys_device.h>
+
+#include <vector>
+
+using namespace vlk;
+
+namespace {
+
+    constexpr VkDeviceSize gib{1024ULL * 1024ULL * 1024ULL};
+
+    VkPhysicalDeviceProperties properties(VkPhysicalDeviceType type)
+    {
+        VkPhysicalDeviceProperties p{};
+        p.deviceType = type;
+        p.limits.maxImageDimension2D = 16384U;
+        p.limits.maxComputeSharedMemorySize = 32768U;
+        p.limits.maxPushConstantsSize = 128U;
+        return p;
+    }
+
+    VkPhysicalDeviceMemoryProperties memory(std::vector<std::pair<VkDeviceSize, VkMemoryHeapFlags>> const& heaps)
+    {
+        VkPhysicalDeviceMemoryProperties m{};
+        for (auto const& h : heaps) {
+            m.memoryHeaps[m.memoryHeapCount].size = h.first;
+            m.memoryHeaps[m.memoryHeapCount].flags = h.second;
+            ++m.memoryHeapCount;
+        }
+        return m;
+    }
+
+    VkQueueFamilyProperties family(VkQueueFlags flags, uint32_t count = 1U)
+    {
+        VkQueueFamilyProperties f{};
+        f.queueFlags = flags;
+        f.queueCount = count;
+        return f;
+    }
+
+}
+
+TEST(device_score, discrete_beats_integrated_with_more_memory)
+{
+    auto const discrete = score_device(properties(VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU),
+                                       memory({{4U * gib, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT}, {32U * gib, 0}}),
+                                       {family(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT)});
+    auto const integrated = score_device(properties(VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU),
+                                         memory({{32U * gib, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT}}),
+                                         {family(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT),
+                                          family(VK_QUEUE_COMPUTE_BIT), family(VK_QUEUE_TRANSFER_BIT)});
+    ASSERT_DOUBLE_EQ(100.0, discrete.memory);
+    ASSERT_DOUBLE_EQ(200.0, integrated.memory);
+    ASSERT_DOUBLE_EQ(150.0, integrated.queues);
+    ASSERT_GT(discrete.total(), integrated.total());
+}
+
+TEST(device_score, queue_topology_and_limits)
+{
+    auto const mem = memory({{8U * gib, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT}});
+    auto const plain = score_device(properties(VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU), mem,
+                                    {family(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT)});
+    auto const async = score_device(properties(VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU), mem,
+                                    {family(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT, 16U),
+                                     family(VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT),
+                                     family(VK_QUEUE_TRANSFER_BIT, 0)});
+    ASSERT_DOUBLE_EQ(0.0, plain.queues);
+    // the transfer-only family has no queues
+    ASSERT_DOUBLE_EQ(125.0, async.queues);
+    ASSERT_DOUBLE_EQ(100.0 + 50.0 * 32768.0 / 49152.0 + 25.0, plain.limits);
+}
+
+TEST(device_score, probe_is_capped)
+{
+    auto const p = properties(VK_PHYSICAL_DEVICE_TYPE_CPU);
+    auto const m = memory({});
+    ASSERT_DOUBLE_EQ(0.0, score_device(p, m, {}, -1.0).probe);
+    ASSERT_DOUBLE_EQ(120.0, score_device(p, m, {}, 120.0).probe);
+    ASSERT_DOUBLE_EQ(500.0, score_device(p, m, {}, 2000.0).probe);
+    ASSERT_DOUBLE_EQ(50.0, score_device(p, m, {}).type);
+}
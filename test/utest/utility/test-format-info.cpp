@@ -0,0 +1,113 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/util.h>
+
+using namespace vlk;
+
+namespace {
+
+    VkBufferImageCopy region(uint32_t width, uint32_t height, uint32_t depth = 1U, uint32_t layers = 1U,
+                             VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT)
+    {
+        VkBufferImageCopy r{};
+        r.imageSubresource.aspectMask = aspect;
+        r.imageSubresource.layerCount = layers;
+        r.imageExtent = VkExtent3D{width, height, depth};
+        return r;
+    }
+
+}
+
+TEST(format_info, names)
+{
+    static_assert(to_string(VK_FORMAT_R8G8B8A8_SRGB) == "VK_FORMAT_R8G8B8A8_SRGB");
+    ASSERT_EQ("VK_FORMAT_UNDEFINED", to_string(VK_FORMAT_UNDEFINED));
+    ASSERT_EQ("VK_FORMAT_ASTC_12x12_SRGB_BLOCK", to_string(VK_FORMAT_ASTC_12x12_SRGB_BLOCK));
+    ASSERT_EQ("VK_FORMAT_G16_B16_R16_3PLANE_444_UNORM", to_string(VK_FORMAT_G16_B16_R16_3PLANE_444_UNORM));
+    ASSERT_EQ("VK_FORMAT_PVRTC2_4BPP_SRGB_BLOCK_IMG", to_string(VK_FORMAT_PVRTC2_4BPP_SRGB_BLOCK_IMG));
+    ASSERT_EQ("<unknown VkFormat>", to_string(static_cast<VkFormat>(999999)));
+
+    ASSERT_EQ("VK_SUCCESS", to_string(VK_SUCCESS));
+    ASSERT_EQ("VK_ERROR_OUT_OF_DATE_KHR", to_string(VK_ERROR_OUT_OF_DATE_KHR));
+    ASSERT_EQ("VK_RESULT_MAX_ENUM", to_string(VK_RESULT_MAX_ENUM));
+    ASSERT_EQ("VK_PRESENT_MODE_MAILBOX_KHR", to_string(VK_PRESENT_MODE_MAILBOX_KHR));
+    ASSERT_EQ("VK_COLOR_SPACE_SRGB_NONLINEAR_KHR", to_string(VK_COLOR_SPACE_SRGB_NONLINEAR_KHR));
+    ASSERT_EQ("VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU", to_string(VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU));
+    ASSERT_EQ("<unknown>", to_string(static_cast<VkPresentModeKHR>(4711)));
+}
+
+TEST(format_info, properties)
+{
+    constexpr auto const& rgba = get_format_info(VK_FORMAT_R8G8B8A8_UNORM);
+    static_assert(4U == rgba.block_size && 8U == rgba.alpha_bits && !rgba.compressed());
+    ASSERT_EQ(VkImageAspectFlags{VK_IMAGE_ASPECT_COLOR_BIT}, rgba.aspect);
+
+    auto const& rgb32 = get_format_info(VK_FORMAT_R32G32B32_SFLOAT);
+    ASSERT_EQ(12U, rgb32.block_size);
+    ASSERT_EQ(32U, rgb32.blue_bits);
+
+    auto const& ds = get_format_info(VK_FORMAT_D24_UNORM_S8_UINT);
+    ASSERT_EQ(VkImageAspectFlags{VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT}, ds.aspect);
+    ASSERT_EQ(24U, ds.depth_bits);
+    ASSERT_EQ(8U, ds.stencil_bits);
+
+    auto const& bc1 = get_format_info(VK_FORMAT_BC1_RGB_SRGB_BLOCK);
+    ASSERT_EQ(format_compression::bc, bc1.compression);
+    ASSERT_EQ(8U, bc1.block_size);
+    ASSERT_EQ(4U, bc1.block_width);
+
+    auto const& astc = get_format_info(VK_FORMAT_ASTC_10x6_UNORM_BLOCK);
+    ASSERT_EQ(format_compression::astc, astc.compression);
+    ASSERT_EQ(10U, astc.block_width);
+    ASSERT_EQ(6U, astc.block_height);
+
+    auto const& nv12 = get_format_info(VK_FORMAT_G8_B8R8_2PLANE_420_UNORM);
+    ASSERT_EQ(2U, nv12.planes);
+    ASSERT_EQ(0U, nv12.block_size);
+
+    auto const& yuyv = get_format_info(VK_FORMAT_G8B8G8R8_422_UNORM);
+    ASSERT_EQ(4U, yuyv.block_size);
+    ASSERT_EQ(2U, yuyv.block_width);
+}
+
+TEST(format_info, image_copy_size)
+{
+    ASSERT_EQ(64U * 32U * 4U, image_copy_size(VK_FORMAT_B8G8R8A8_UNORM, region(64U, 32U)));
+    ASSERT_EQ(6U * 64U * 32U * 8U, image_copy_size(VK_FORMAT_R16G16B16A16_SFLOAT, region(64U, 32U, 1U, 6U)));
+
+    // rows of bufferRowLength texels, the last row ends with the copied width
+    auto padded = region(10U, 3U);
+    padded.bufferRowLength = 16U;
+    ASSERT_EQ((2U * 16U + 10U) * 4U, image_copy_size(VK_FORMAT_R8G8B8A8_UNORM, padded));
+
+    // partial blocks at the border count as whole blocks
+    ASSERT_EQ(3U * 2U * 16U, image_copy_size(VK_FORMAT_BC7_UNORM_BLOCK, region(10U, 5U)));
+    ASSERT_EQ(2U * 8U, image_copy_size(VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, region(8U, 4U)));
+
+    // single aspects of depth/stencil formats are tightly packed
+    ASSERT_EQ(16U * 16U * 4U, image_copy_size(VK_FORMAT_D24_UNORM_S8_UINT,
+                                              region(16U, 16U, 1U, 1U, VK_IMAGE_ASPECT_DEPTH_BIT)));
+    ASSERT_EQ(16U * 16U, image_copy_size(VK_FORMAT_D32_SFLOAT_S8_UINT,
+                                         region(16U, 16U, 1U, 1U, VK_IMAGE_ASPECT_STENCIL_BIT)));
+
+    ASSERT_EQ(0U, image_copy_size(VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM, region(16U, 16U)));
+    ASSERT_EQ(0U, image_copy_size(VK_FORMAT_R8_UNORM, region(0U, 16U)));
+}
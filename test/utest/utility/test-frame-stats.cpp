@@ -0,0 +1,106 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/frame_stats.h>
+
+#include <thread>
+#include <vector>
+
+using namespace vlk;
+using namespace std::chrono_literals;
+
+TEST(histogram, empty)
+{
+    histogram h{};
+    ASSERT_EQ(0U, h.count());
+    ASSERT_DOUBLE_EQ(0.0, h.p50_ms());
+    ASSERT_DOUBLE_EQ(0.0, h.max_ms());
+    ASSERT_DOUBLE_EQ(0.0, h.variance_ms2());
+}
+
+TEST(histogram, bucket_bounds)
+{
+    for (uint64_t ns : {0ULL, 1ULL, 7ULL, 8ULL, 9ULL, 1000ULL, 16'666'667ULL, 1'000'000'000ULL}) {
+        auto idx = histogram::bucket_index(ns);
+        ASSERT_LT(idx, histogram::bucket_count);
+        ASSERT_GE(histogram::bucket_upper_bound(idx), ns);
+        if (idx > 0) {
+            ASSERT_LT(histogram::bucket_upper_bound(idx - 1), ns);
+        }
+    }
+    ASSERT_EQ(histogram::bucket_count - 1, histogram::bucket_index(UINT64_MAX));
+}
+
+TEST(histogram, percentiles)
+{
+    histogram h{};
+    for (int i = 1; i <= 100; ++i) {
+        h.record(std::chrono::milliseconds{i});
+    }
+    ASSERT_EQ(100U, h.count());
+    // relative error is bounded by the sub-bucket resolution
+    ASSERT_NEAR(50.0, h.p50_ms(), 50.0 / histogram::sub_bucket_count);
+    ASSERT_NEAR(95.0, h.p95_ms(), 95.0 / histogram::sub_bucket_count);
+    ASSERT_NEAR(99.0, h.p99_ms(), 99.0 / histogram::sub_bucket_count);
+    ASSERT_DOUBLE_EQ(100.0, h.max_ms());
+    ASSERT_DOUBLE_EQ(1.0, h.min_ms());
+    ASSERT_NEAR(50.5, h.mean_ms(), 1e-9);
+    ASSERT_NEAR(841.666, h.variance_ms2(), 1e-2);
+}
+
+TEST(histogram, constant_samples)
+{
+    histogram h{};
+    for (int i = 0; i < 1000; ++i) {
+        h.record(16ms);
+    }
+    ASSERT_DOUBLE_EQ(16.0, h.p99_ms());
+    ASSERT_NEAR(0.0, h.variance_ms2(), 1e-6);
+    h.reset();
+    ASSERT_EQ(0U, h.count());
+}
+
+TEST(histogram, concurrent_record)
+{
+    histogram h{};
+    std::vector<std::thread> threads{};
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&h]() {
+            for (int i = 0; i < 10000; ++i) {
+                h.record(std::chrono::microseconds{i});
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(40000U, h.count());
+}
+
+TEST(frame_stats, jitter)
+{
+    frame_stats fs{};
+    for (int i = 0; i < 10; ++i) {
+        fs.record(frame_phase::frame, (i % 2) ? 20ms : 10ms);
+    }
+    ASSERT_EQ(10U, fs.phase(frame_phase::frame).count());
+    ASSERT_DOUBLE_EQ(10.0, fs.jitter_ms());
+    ASSERT_EQ(0U, fs.phase(frame_phase::acquire).count());
+}
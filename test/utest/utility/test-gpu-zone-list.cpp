@@ -0,0 +1,86 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/gpu_profiler.h>
+
+#include <utility>
+#include <vector>
+
+using namespace vlk;
+
+namespace {
+
+    std::vector<std::pair<uint32_t, uint32_t>> closed_runs(gpu_zone_list const& zl)
+    {
+        std::vector<std::pair<uint32_t, uint32_t>> runs;
+        zl.for_each_closed_run([&runs](uint32_t first, uint32_t count) { runs.emplace_back(first, count); });
+        return runs;
+    }
+
+}
+
+TEST(gpu_zone_list, nesting)
+{
+    gpu_zone_list zl{8U};
+    auto const outer = zl.open("outer");
+    auto const inner = zl.open("inner");
+    ASSERT_EQ(2U, zl.depth());
+    zl.close(inner);
+    auto const second = zl.open("second");
+    zl.close(second);
+    zl.close(outer);
+    ASSERT_EQ(0U, zl.depth());
+    ASSERT_EQ(nullptr, zl.first_open());
+    ASSERT_EQ(3U, zl.zones().size());
+    ASSERT_EQ(0U, zl.zones()[0].depth);
+    ASSERT_EQ(1U, zl.zones()[1].depth);
+    ASSERT_EQ(1U, zl.zones()[2].depth);
+    ASSERT_EQ((std::vector<std::pair<uint32_t, uint32_t>>{{0U, 3U}}), closed_runs(zl));
+}
+
+TEST(gpu_zone_list, open_zones_are_left_out)
+{
+    gpu_zone_list zl{8U};
+    zl.close(zl.open("a"));
+    zl.open("never closed");
+    zl.close(zl.open("b"));
+    zl.close(zl.open("c"));
+    ASSERT_EQ(1U, zl.depth());
+    ASSERT_STREQ("never closed", zl.first_open()->name);
+    ASSERT_EQ((std::vector<std::pair<uint32_t, uint32_t>>{{0U, 1U}, {2U, 2U}}), closed_runs(zl));
+
+    zl.clear();
+    ASSERT_EQ(0U, zl.depth());
+    ASSERT_TRUE(closed_runs(zl).empty());
+}
+
+TEST(gpu_zone_list, limit)
+{
+    gpu_zone_list zl{2U};
+    auto const a = zl.open("a");
+    auto const b = zl.open("b");
+    ASSERT_EQ(gpu_zone_list::invalid_zone, zl.open("dropped"));
+    ASSERT_EQ(2U, zl.depth());
+    zl.close(gpu_zone_list::invalid_zone);
+    zl.close(b);
+    zl.close(a);
+    ASSERT_EQ(0U, zl.depth());
+    ASSERT_EQ((std::vector<std::pair<uint32_t, uint32_t>>{{0U, 2U}}), closed_runs(zl));
+}
@@ -0,0 +1,137 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/job_system.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace vlk;
+
+TEST(job_system, parallel_for)
+{
+    job_system jobs{3U};
+    ASSERT_EQ(4U, jobs.thread_count());
+    std::vector<std::atomic<uint32_t>> visits(10000U);
+    jobs.parallel_for(static_cast<uint32_t>(visits.size()), 16U, [&visits](uint32_t begin, uint32_t end) {
+        for (auto i = begin; i < end; ++i) {
+            ++visits[i];
+        }
+    });
+    for (auto const& v : visits) {
+        ASSERT_EQ(1U, v.load());
+    }
+}
+
+TEST(job_system, counter_and_dependencies)
+{
+    job_system jobs{2U};
+    std::atomic<uint32_t> stage1{0};
+    std::atomic<bool> ordered{true};
+    job_system::counter first{};
+    job_system::counter second{};
+    for (int i = 0; i < 64; ++i) {
+        jobs.run([&stage1]() { ++stage1; }, &first);
+    }
+    for (int i = 0; i < 8; ++i) {
+        jobs.run_after(first, [&stage1, &ordered]() {
+            if (64U != stage1.load()) {
+                ordered = false;
+            }
+        }, &second);
+    }
+    jobs.wait(second);
+    ASSERT_TRUE(first.done());
+    ASSERT_TRUE(second.done());
+    ASSERT_TRUE(ordered);
+
+    // dependency already done
+    job_system::counter third{};
+    bool ran{false};
+    jobs.run_after(first, [&ran]() { ran = true; }, &third);
+    jobs.wait(third);
+    ASSERT_TRUE(ran);
+}
+
+TEST(job_system, nested_jobs)
+{
+    job_system jobs{2U};
+    std::atomic<uint32_t> leaves{0};
+    job_system::counter outer{};
+    for (int i = 0; i < 8; ++i) {
+        jobs.run([&jobs, &leaves]() {
+            // waiting inside a job executes other jobs instead of blocking the worker
+            job_system::counter inner{};
+            for (int j = 0; j < 8; ++j) {
+                jobs.run([&leaves]() { ++leaves; }, &inner);
+            }
+            jobs.wait(inner);
+        }, &outer);
+    }
+    jobs.wait(outer);
+    ASSERT_EQ(64U, leaves.load());
+}
+
+TEST(job_system, main_thread_jobs)
+{
+    job_system jobs{2U};
+    ASSERT_TRUE(jobs.is_main_thread());
+    job_system::counter c{};
+    std::atomic<uint32_t> on_main{0};
+    std::thread other{[&jobs, &c, &on_main]() {
+        ASSERT_EQ(job_system::invalid_thread_index, jobs.thread_index());
+        for (int i = 0; i < 4; ++i) {
+            jobs.run_on_main([&jobs, &on_main]() {
+                if (jobs.is_main_thread()) {
+                    ++on_main;
+                }
+            }, &c);
+        }
+    }};
+    other.join();
+    ASSERT_FALSE(c.done());
+    jobs.run_main_thread_jobs();
+    ASSERT_TRUE(c.done());
+    ASSERT_EQ(4U, on_main.load());
+}
+
+TEST(job_system, exceptions)
+{
+    job_system jobs{2U};
+    job_system::counter c{};
+    std::atomic<uint32_t> finished{0};
+    for (int i = 0; i < 16; ++i) {
+        jobs.run([i, &finished]() {
+            ++finished;
+            if (7 == i) {
+                throw std::runtime_error{"job failed"};
+            }
+        }, &c);
+    }
+    ASSERT_THROW(jobs.wait(c), std::runtime_error);
+    ASSERT_EQ(16U, finished.load());
+    ASSERT_THROW(jobs.parallel_for(100U, 1U, [](uint32_t begin, uint32_t) {
+        if (50U <= begin) {
+            throw std::runtime_error{"chunk failed"};
+        }
+    }), std::runtime_error);
+}
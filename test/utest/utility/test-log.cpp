@@ -20,6 +20,14 @@
 #include <gtest/gtest.h>
 #include <vlk/log.h>
 
+#include <unistd.h>
+#include <array>
+#include <csignal>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
 using namespace vlk;
 
 TEST(log, simple_logging_warn)
@@ -32,3 +40,213 @@ TEST(log, simple_logging_warn)
     VLK_LOG_TRACE() << "trace";
     VLK_LOG_FATAL() << "fatal";
 }
+
+namespace {
+
+    //! Redirects stderr into a temporary file while alive.
+    class stderr_capture
+    {
+    public:
+        stderr_capture()
+            : _file{std::tmpfile()}
+            , _saved{::dup(STDERR_FILENO)}
+        {
+            flush_log();
+            ::dup2(::fileno(_file), STDERR_FILENO);
+        }
+
+        ~stderr_capture()
+        {
+            restore();
+            std::fclose(_file);
+        }
+
+        std::string text()
+        {
+            flush_log();
+            restore();
+            std::string s;
+            std::rewind(_file);
+            std::array<char, 4096> buf{};
+            size_t n{0};
+            while (0 != (n = std::fread(buf.data(), 1U, buf.size(), _file))) {
+                s.append(buf.data(), n);
+            }
+            return s;
+        }
+
+    private:
+        void restore()
+        {
+            if (-1 != _saved) {
+                ::dup2(_saved, STDERR_FILENO);
+                ::close(_saved);
+                _saved = -1;
+            }
+        }
+
+        std::FILE* _file;
+        int _saved;
+    };
+
+}
+
+TEST(log, level_filter)
+{
+    set_global_log_level(log_level::warning);
+    stderr_capture capture;
+    VLK_LOG_INFO() << "filtered";
+    VLK_LOG_WARNING() << "passed";
+    auto const text = capture.text();
+    ASSERT_EQ(std::string::npos, text.find("filtered"));
+    ASSERT_NE(std::string::npos, text.find("[warning] passed"));
+    set_global_log_level(log_level::trace);
+}
+
+TEST(log, format_flags_do_not_leak)
+{
+    set_global_log_level(log_level::trace);
+    stderr_capture capture;
+    VLK_LOG_INFO() << "hex " << std::hex << 255;
+    VLK_LOG_INFO() << "dec " << 255;
+    auto const text = capture.text();
+    ASSERT_NE(std::string::npos, text.find("hex ff\n"));
+    ASSERT_NE(std::string::npos, text.find("dec 255\n"));
+}
+
+TEST(log, threads_keep_their_order)
+{
+    set_global_log_level(log_level::trace);
+    constexpr int threads{4};
+    constexpr int messages{500};
+    stderr_capture capture;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([t]() {
+            for (int i = 0; i < messages; ++i) {
+                VLK_LOG_WARNING() << "thread " << t << " message " << i;
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    auto const text = capture.text();
+    for (int t = 0; t < threads; ++t) {
+        size_t pos{0};
+        for (int i = 0; i < messages; ++i) {
+            auto const msg = "thread " + std::to_string(t) + " message " + std::to_string(i) + "\n";
+            pos = text.find(msg, pos);
+            ASSERT_NE(std::string::npos, pos) << msg;
+        }
+    }
+}
+
+TEST(log, long_messages_are_truncated)
+{
+    set_global_log_level(log_level::trace);
+    stderr_capture capture;
+    VLK_LOG_INFO() << std::string(10000U, 'x');
+    auto const text = capture.text();
+    ASSERT_NE(std::string::npos, text.find("xxx...\n"));
+    ASSERT_LT(text.size(), 4096U);
+}
+
+TEST(log, format_log_args)
+{
+    detail::log_args args;
+    args.add(-3);
+    args.add(42U);
+    args.add(true);
+    args.add("text");
+    args.add(std::string{"surplus"});
+    std::array<char, 128> out{};
+    auto const n = detail::format_log_args(out.data(), out.size(), "{} {} {} [{}]", args.data(), args.size());
+    ASSERT_EQ("-3 42 true [text] surplus", std::string(out.data(), n));
+    // missing arguments keep their placeholder, the output is cut at the capacity
+    ASSERT_EQ(std::string{"a {} b"}, std::string(out.data(), detail::format_log_args(out.data(), out.size(),
+                                                                                       "a {} b", nullptr, 0U)));
+    ASSERT_EQ(4U, detail::format_log_args(out.data(), 4U, "{}", args.data(), args.size()));
+}
+
+TEST(log, format_log_args_arrays)
+{
+    // char buffers end at their terminator or extent, other arrays are logged as pointers
+    char const terminated[8]{'a', 'b', '\0', 'x'};
+    char const unterminated[3]{'c', 'd', 'e'};
+    int const numbers[2]{1, 2};
+    detail::log_args args;
+    args.add(terminated);
+    args.add(unterminated);
+    args.add(numbers);
+    std::array<char, 128> out{};
+    auto const text = std::string(out.data(), detail::format_log_args(out.data(), out.size(), "{} {} {}",
+                                                                      args.data(), args.size()));
+    ASSERT_EQ(0U, text.find("ab cde 0x"));
+}
+
+TEST(log, deferred_formatting)
+{
+    set_global_log_level(log_level::trace);
+    stderr_capture capture;
+    VLK_LOGF_INFO("frame {} took {} ms", 7, 1.5);
+    VLK_LOGF_WARNING("no arguments");
+    auto const text = capture.text();
+    ASSERT_NE(std::string::npos, text.find("[info]    frame 7 took 1.5 ms\n"));
+    ASSERT_NE(std::string::npos, text.find("[warning] no arguments\n"));
+}
+
+TEST(log, stripped_statements_are_not_evaluated)
+{
+    set_global_log_level(log_level::trace);
+    int calls{0};
+    VLK_LOG_TRACE() << ++calls;
+    VLK_LOGF_TRACE("{}", ++calls);
+#if VLK_LOG_LEVEL > VLK_LOG_LEVEL_TRACE
+    ASSERT_EQ(0, calls);
+#else
+    ASSERT_EQ(2, calls);
+#endif
+    // runtime filtering does not evaluate the arguments either
+    auto const before = calls;
+    set_global_log_level(log_level::info);
+    VLK_LOGF_DEBUG("{}", ++calls);
+    ASSERT_EQ(before, calls);
+    set_global_log_level(log_level::trace);
+}
+
+TEST(log, binary_log_stores_formats_once)
+{
+    set_global_log_level(log_level::trace);
+    auto const path = ::testing::TempDir() + "vlk-test-log.vlkl";
+    set_binary_log(path);
+    for (int i = 0; i < 3; ++i) {
+        VLK_LOGF_INFO("binary {} of {}", i, 3);
+    }
+    set_binary_log({});
+    std::string data;
+    if (auto* f = std::fopen(path.c_str(), "rb")) {
+        std::array<char, 4096> buf{};
+        size_t n{0};
+        while (0 != (n = std::fread(buf.data(), 1U, buf.size(), f))) {
+            data.append(buf.data(), n);
+        }
+        std::fclose(f);
+    }
+    std::remove(path.c_str());
+    ASSERT_EQ(0U, data.find("VLKL"));
+    auto const first = data.find("binary {} of {}");
+    ASSERT_NE(std::string::npos, first);
+    ASSERT_EQ(std::string::npos, data.find("binary {} of {}", first + 1U));
+}
+
+TEST(log, crash_handler_flushes_pending_messages)
+{
+    // the forked child has no writer thread, the message is written by the SIGSEGV handler
+    ASSERT_DEATH({
+        install_crash_log_flush();
+        set_global_log_level(log_level::trace);
+        VLK_LOGF_ERROR("crash {} {} {} {}", -42, 18446744073709551615ULL, 0.015625, reinterpret_cast<void*>(0xbeef));
+        raise(SIGSEGV);
+    }, "crash -42 18446744073709551615 0.015625 0xbeef");
+}
@@ -0,0 +1,77 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/memory_allocator.h>
+
+#include <vector>
+
+using namespace vlk;
+
+TEST(memory_heap_stats, empty)
+{
+    memory_heap_stats hs{};
+    ASSERT_DOUBLE_EQ(0.0, hs.fragmentation());
+}
+
+TEST(memory_heap_stats, free_space_of_several_blocks)
+{
+    // each block has one contiguous free range, compacting gains nothing
+    tlsf a{1024U};
+    tlsf b{1024U};
+    ASSERT_TRUE(a.allocate(512U));
+    ASSERT_TRUE(b.allocate(512U));
+    memory_heap_stats hs{};
+    hs.block_bytes = 2048U;
+    hs.used_bytes = 1024U;
+    hs.add_free_ranges(a);
+    hs.add_free_ranges(b);
+    ASSERT_EQ(2U, hs.free_range_count);
+    ASSERT_EQ(512U, hs.largest_free_range);
+    ASSERT_EQ(0U, hs.scattered_free_bytes);
+    ASSERT_DOUBLE_EQ(0.0, hs.fragmentation());
+}
+
+TEST(memory_heap_stats, scattered_free_space)
+{
+    tlsf t{1024U};
+    std::vector<tlsf::handle> handles;
+    for (int i = 0; i < 4; ++i) {
+        auto a = t.allocate(256U);
+        ASSERT_TRUE(a);
+        handles.push_back(a->id);
+    }
+    t.free(handles[0]);
+    t.free(handles[2]);
+    memory_heap_stats hs{};
+    hs.block_bytes = 1024U;
+    hs.used_bytes = 512U;
+    hs.add_free_ranges(t);
+    ASSERT_EQ(2U, hs.free_range_count);
+    ASSERT_EQ(256U, hs.largest_free_range);
+    ASSERT_DOUBLE_EQ(0.5, hs.fragmentation());
+
+    // a full block adds nothing
+    tlsf full{1024U};
+    ASSERT_TRUE(full.allocate(1024U));
+    hs.block_bytes += 1024U;
+    hs.used_bytes += 1024U;
+    hs.add_free_ranges(full);
+    ASSERT_DOUBLE_EQ(0.5, hs.fragmentation());
+}
@@ -0,0 +1,102 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/pipeline_cache.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace vlk;
+
+namespace {
+
+    VkPhysicalDeviceProperties device_props()
+    {
+        VkPhysicalDeviceProperties props{};
+        props.vendorID = 0x10deU;
+        props.deviceID = 0x1234U;
+        props.driverVersion = 42U;
+        for (uint32_t i = 0; i < VK_UUID_SIZE; ++i) {
+            props.pipelineCacheUUID[i] = static_cast<uint8_t>(i);
+        }
+        return props;
+    }
+
+    std::vector<uint8_t> cache_file(VkPhysicalDeviceProperties const& props)
+    {
+        std::vector<uint8_t> file(pipeline_cache::header_size() + 64U);
+        for (size_t i = pipeline_cache::header_size(); i < file.size(); ++i) {
+            file[i] = static_cast<uint8_t>(i * 7U);
+        }
+        pipeline_cache::write_header(file.data(), file.size(), props);
+        return file;
+    }
+
+}
+
+TEST(pipeline_cache, accepts_matching_file)
+{
+    auto const props = device_props();
+    auto const file = cache_file(props);
+    ASSERT_TRUE(pipeline_cache::is_valid(file.data(), file.size(), props));
+
+    // driver without cache data
+    std::vector<uint8_t> empty(pipeline_cache::header_size());
+    pipeline_cache::write_header(empty.data(), empty.size(), props);
+    ASSERT_TRUE(pipeline_cache::is_valid(empty.data(), empty.size(), props));
+}
+
+TEST(pipeline_cache, rejects_bad_header)
+{
+    auto const props = device_props();
+    auto file = cache_file(props);
+    ASSERT_FALSE(pipeline_cache::is_valid(file.data(), pipeline_cache::header_size() - 1U, props));
+    // data size in the header does not match the file
+    ASSERT_FALSE(pipeline_cache::is_valid(file.data(), file.size() - 1U, props));
+    file[0] ^= 0xffU;
+    ASSERT_FALSE(pipeline_cache::is_valid(file.data(), file.size(), props));
+}
+
+TEST(pipeline_cache, rejects_other_device)
+{
+    auto const props = device_props();
+    auto const file = cache_file(props);
+
+    auto other = props;
+    other.vendorID = 0x1002U;
+    ASSERT_FALSE(pipeline_cache::is_valid(file.data(), file.size(), other));
+    other = props;
+    other.deviceID = 0x4321U;
+    ASSERT_FALSE(pipeline_cache::is_valid(file.data(), file.size(), other));
+    other = props;
+    other.driverVersion = 43U;
+    ASSERT_FALSE(pipeline_cache::is_valid(file.data(), file.size(), other));
+    other = props;
+    other.pipelineCacheUUID[VK_UUID_SIZE - 1] ^= 0xffU;
+    ASSERT_FALSE(pipeline_cache::is_valid(file.data(), file.size(), other));
+}
+
+TEST(pipeline_cache, rejects_bad_checksum)
+{
+    auto const props = device_props();
+    auto file = cache_file(props);
+    file.back() ^= 0x01U;
+    ASSERT_FALSE(pipeline_cache::is_valid(file.data(), file.size(), props));
+}
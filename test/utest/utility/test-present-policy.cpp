@@ -0,0 +1,55 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/present_policy.h>
+
+using namespace vlk;
+
+TEST(present_policy, present_mode)
+{
+    std::vector<VkPresentModeKHR> const all{VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+                                            VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR};
+    ASSERT_EQ(VK_PRESENT_MODE_MAILBOX_KHR, select_present_mode(present_policy::balanced, all));
+    ASSERT_EQ(VK_PRESENT_MODE_MAILBOX_KHR, select_present_mode(present_policy::low_latency, all));
+    ASSERT_EQ(VK_PRESENT_MODE_FIFO_KHR, select_present_mode(present_policy::throughput, all));
+    ASSERT_EQ(VK_PRESENT_MODE_FIFO_RELAXED_KHR, select_present_mode(present_policy::power_saver, all));
+
+    std::vector<VkPresentModeKHR> const tearing{VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_KHR};
+    ASSERT_EQ(VK_PRESENT_MODE_FIFO_KHR, select_present_mode(present_policy::balanced, tearing));
+    ASSERT_EQ(VK_PRESENT_MODE_IMMEDIATE_KHR, select_present_mode(present_policy::low_latency, tearing));
+    ASSERT_EQ(VK_PRESENT_MODE_FIFO_KHR, select_present_mode(present_policy::power_saver, tearing));
+
+    std::vector<VkPresentModeKHR> const fifo{VK_PRESENT_MODE_FIFO_KHR};
+    ASSERT_EQ(VK_PRESENT_MODE_FIFO_KHR, select_present_mode(present_policy::low_latency, fifo));
+}
+
+TEST(present_policy, image_count)
+{
+    VkSurfaceCapabilitiesKHR caps{};
+    caps.minImageCount = 2U;
+    caps.maxImageCount = 0U;
+    ASSERT_EQ(3U, select_image_count(present_policy::balanced, caps));
+    ASSERT_EQ(2U, select_image_count(present_policy::low_latency, caps));
+    ASSERT_EQ(4U, select_image_count(present_policy::throughput, caps));
+    ASSERT_EQ(3U, select_image_count(present_policy::power_saver, caps));
+
+    caps.maxImageCount = 3U;
+    ASSERT_EQ(3U, select_image_count(present_policy::throughput, caps));
+}
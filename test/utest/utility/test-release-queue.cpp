@@ -0,0 +1,72 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/release_queue.h>
+
+#include <vector>
+
+using namespace vlk;
+
+TEST(release_queue, recording_releases_wait_for_their_frame)
+{
+    for (uint32_t n = 1U; n <= 3U; ++n) {
+        release_queue q{n};
+        std::vector<uint64_t> released_at;
+        for (uint64_t frame = 0; frame < 10U; ++frame) {
+            // before frame is recorded its slot's fence is waited for: frames up to frame - n are complete
+            q.run(frame);
+            // released while recording frame, so still used by it
+            q.push(frame + 1U, [&released_at, frame]() { released_at.push_back(frame); });
+        }
+        ASSERT_EQ(10U - n, released_at.size()) << "frames in flight " << n;
+        for (uint64_t i = 0; i < released_at.size(); ++i) {
+            ASSERT_EQ(i, released_at[i]);
+        }
+        q.run_all();
+        ASSERT_EQ(10U, released_at.size());
+        ASSERT_EQ(0U, q.size());
+    }
+}
+
+TEST(release_queue, released_exactly_when_last_frame_completes)
+{
+    release_queue q{2U};
+    bool released{false};
+    q.push(6U, [&released]() { released = true; });     // used by frame 5
+    q.run(6U);
+    ASSERT_FALSE(released);
+    q.run(7U);                                          // frame 5 is complete before frame 7 is recorded
+    ASSERT_TRUE(released);
+}
+
+TEST(release_queue, functors_may_queue_releases)
+{
+    release_queue q{1U};
+    int calls{0};
+    q.push(1U, [&q, &calls]() {
+        ++calls;
+        q.push(2U, [&calls]() { ++calls; });
+    });
+    q.run(1U);
+    ASSERT_EQ(1, calls);
+    ASSERT_EQ(1U, q.size());
+    q.run(2U);
+    ASSERT_EQ(2, calls);
+}
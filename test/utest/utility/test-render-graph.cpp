@@ -0,0 +1,152 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/exception.h>
+#include <vlk/memory_allocator.h>
+#include <vlk/render_graph.h>
+
+#include <string>
+#include <vector>
+
+using namespace vlk;
+
+namespace {
+
+    VkDevice fake_device() { return reinterpret_cast<VkDevice>(uintptr_t{0x1}); }
+    VkImage fake_image(uintptr_t v) { return reinterpret_cast<VkImage>(v); }
+    VkImageView fake_view(uintptr_t v) { return reinterpret_cast<VkImageView>(v); }
+    VkBuffer fake_buffer(uintptr_t v) { return reinterpret_cast<VkBuffer>(v); }
+
+    VkImageSubresourceRange color_range()
+    {
+        VkImageSubresourceRange r{};
+        r.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        r.levelCount = 1U;
+        r.layerCount = 1U;
+        return r;
+    }
+
+    //! Graphs of imported resources (and unused transients) create no Vulkan objects in compile().
+    struct graph_fixture : public ::testing::Test
+    {
+        VkPhysicalDeviceProperties properties{};
+        VkPhysicalDeviceMemoryProperties memory_properties{};
+        memory_allocator allocator{fake_device(), properties, memory_properties};
+        render_graph graph{fake_device(), allocator};
+    };
+
+}
+
+TEST_F(graph_fixture, cull_unused_passes)
+{
+    auto const backbuffer = graph.import_image("backbuffer", fake_image(0x10), fake_view(0x11), color_range());
+    auto const data = graph.import_buffer("data", fake_buffer(0x20));
+    render_graph::image_desc desc{};
+    desc.format = VK_FORMAT_R8G8B8A8_UNORM;
+    desc.extent = VkExtent2D{64U, 64U};
+    auto const scratch = graph.create_image("scratch", desc);
+
+    graph.add_pass("upload", nullptr).write(data, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    // its only result is never read
+    graph.add_pass("scratch", nullptr)
+            .read(data, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT)
+            .write(scratch, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                   VK_IMAGE_LAYOUT_GENERAL);
+    graph.add_pass("readback", nullptr)
+            .read(data, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT)
+            .side_effect();
+    graph.add_pass("draw", nullptr)
+            .read(data, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT)
+            .write(backbuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    // nothing reads what it writes, the pass before it is culled as well
+    graph.add_pass("orphan", nullptr).write(scratch, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    graph.compile();
+
+    ASSERT_EQ((std::vector<std::string>{"upload", "readback", "draw"}), graph.execution_order());
+    auto const& s = graph.get_stats();
+    ASSERT_EQ(5U, s.passes);
+    ASSERT_EQ(2U, s.culled_passes);
+    ASSERT_EQ(0U, s.transient_images);
+    ASSERT_EQ(0U, s.allocated_bytes);
+    ASSERT_EQ(VK_NULL_HANDLE, graph.image(scratch));
+}
+
+TEST_F(graph_fixture, dependency_levels)
+{
+    auto const a = graph.import_buffer("a", fake_buffer(0x20));
+    auto const b = graph.import_buffer("b", fake_buffer(0x21));
+    auto const img = graph.import_image("img", fake_image(0x10), fake_view(0x11), color_range());
+
+    graph.add_pass("write a", nullptr).write(a, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    graph.add_pass("read a 1", nullptr)
+            .read(a, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT)
+            .side_effect();
+    graph.add_pass("read a 2", nullptr)
+            .read(a, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT)
+            .side_effect();
+    // write after read waits for both readers
+    graph.add_pass("rewrite a", nullptr).write(a, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    // independent of a, runs with the first pass
+    graph.add_pass("write b", nullptr).write(b, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    // reads in different layouts are a layout transition, i.e. a write
+    graph.add_pass("sample img", nullptr)
+            .read(img, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+            .side_effect();
+    graph.add_pass("copy img", nullptr)
+            .read(img, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+            .side_effect();
+    graph.compile();
+
+    ASSERT_EQ((std::vector<std::string>{"write a", "write b", "sample img", "read a 1", "read a 2", "copy img",
+                                        "rewrite a"}),
+              graph.execution_order());
+    ASSERT_EQ(3U, graph.get_stats().levels);
+    ASSERT_EQ(0U, graph.get_stats().culled_passes);
+}
+
+TEST_F(graph_fixture, declaration_errors)
+{
+    auto const img = graph.import_image("img", fake_image(0x10), fake_view(0x11), color_range());
+    auto const buf = graph.import_buffer("buf", fake_buffer(0x20));
+
+    auto pass = graph.add_pass("conflict", nullptr);
+    pass.read(img, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    ASSERT_THROW(pass.write(img, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL),
+                 vlk::app_exception);
+    // same layout: read-modify-write
+    ASSERT_NO_THROW(pass.write(img, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                               VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+    // buffers have no layout
+    pass.read(buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL);
+    ASSERT_NO_THROW(pass.write(buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+    ASSERT_THROW(pass.read(42U, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT), vlk::app_exception);
+
+    ASSERT_THROW(graph.set_buffer(img, fake_buffer(0x21)), vlk::app_exception);
+    ASSERT_THROW(graph.set_image(buf, fake_image(0x12), fake_view(0x13)), vlk::app_exception);
+    barrier_batch barriers{VK_NULL_HANDLE, false};
+    ASSERT_THROW(graph.execute(VK_NULL_HANDLE, barriers), vlk::app_exception);
+}
@@ -0,0 +1,223 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/exception.h>
+#include <vlk/spirv_reflection.h>
+
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+using namespace vlk;
+
+namespace {
+
+    //! Assembles a SPIR-V module word by word.
+    class spirv_writer
+    {
+    public:
+        explicit spirv_writer(uint32_t bound)
+            : _words{0x07230203U, 0x00010000U, 0, bound, 0}
+        {}
+
+        spirv_writer& op(uint32_t opcode, std::initializer_list<uint32_t> operands)
+        {
+            _words.push_back(static_cast<uint32_t>((operands.size() + 1U) << 16U) | opcode);
+            _words.insert(_words.end(), operands);
+            return *this;
+        }
+
+        std::vector<uint32_t> const& words() const { return _words; }
+
+    private:
+        std::vector<uint32_t> _words;
+    };
+
+    // fragment shader with
+    //   layout(set = 0, binding = 0, rgba8) uniform image2D images[4];
+    //   layout(set = 0, binding = 1) uniform sampler2D tex;
+    //   layout(set = 1, binding = 0) uniform ubo { vec4 color; };
+    //   layout(push_constant) uniform pc { mat4 transform; vec4 tint; };
+    std::vector<uint32_t> fragment_module()
+    {
+        spirv_writer w{30};
+        w.op(15, {4, 1, 0x6E69616DU, 0})            // OpEntryPoint Fragment %1 "main"
+         .op(71, {10, 34, 0})                       // OpDecorate %10 DescriptorSet 0
+         .op(71, {10, 33, 1})                       // OpDecorate %10 Binding 1
+         .op(71, {11, 34, 1})
+         .op(71, {11, 33, 0})
+         .op(71, {12, 34, 0})
+         .op(71, {12, 33, 0})
+         .op(71, {13, 2})                           // OpDecorate %13 Block
+         .op(72, {13, 0, 35, 0})                    // OpMemberDecorate %13 0 Offset 0
+         .op(72, {20, 0, 35, 0})
+         .op(72, {20, 0, 7, 16})                    // OpMemberDecorate %20 0 MatrixStride 16
+         .op(72, {20, 1, 35, 64})
+         .op(22, {2, 32})                           // %2 = OpTypeFloat 32
+         .op(23, {3, 2, 4})                         // %3 = OpTypeVector %2 4
+         .op(24, {4, 3, 4})                         // %4 = OpTypeMatrix %3 4
+         .op(25, {5, 2, 1, 0, 0, 0, 1, 0})          // %5 = OpTypeImage %2 2D sampled
+         .op(27, {6, 5})                            // %6 = OpTypeSampledImage %5
+         .op(32, {7, 0, 6})                         // %7 = OpTypePointer UniformConstant %6
+         .op(59, {7, 10, 0})                        // %10 = OpVariable %7 UniformConstant
+         .op(30, {13, 3})                           // %13 = OpTypeStruct %3
+         .op(32, {14, 2, 13})                       // %14 = OpTypePointer Uniform %13
+         .op(59, {14, 11, 2})
+         .op(25, {15, 2, 1, 0, 0, 0, 2, 4})         // %15 = OpTypeImage %2 2D storage
+         .op(21, {16, 32, 0})                       // %16 = OpTypeInt 32 0
+         .op(43, {16, 17, 4})                       // %17 = OpConstant %16 4
+         .op(28, {18, 15, 17})                      // %18 = OpTypeArray %15 %17
+         .op(32, {19, 0, 18})
+         .op(59, {19, 12, 0})
+         .op(30, {20, 4, 3})                        // %20 = OpTypeStruct %4 %3
+         .op(32, {21, 9, 20})                       // %21 = OpTypePointer PushConstant %20
+         .op(59, {21, 22, 9});
+        return w.words();
+    }
+
+}
+
+TEST(spirv_reflection, descriptors_and_push_constants)
+{
+    auto const code = fragment_module();
+    auto const r = reflect_spirv(code.data(), code.size());
+    ASSERT_EQ(static_cast<VkShaderStageFlags>(VK_SHADER_STAGE_FRAGMENT_BIT), r.stages);
+    ASSERT_EQ("main", r.entry_point);
+
+    ASSERT_EQ(3U, r.bindings.size());
+    ASSERT_EQ(0U, r.bindings[0].set);
+    ASSERT_EQ(0U, r.bindings[0].binding);
+    ASSERT_EQ(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, r.bindings[0].type);
+    ASSERT_EQ(4U, r.bindings[0].count);
+    ASSERT_EQ(0U, r.bindings[1].set);
+    ASSERT_EQ(1U, r.bindings[1].binding);
+    ASSERT_EQ(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, r.bindings[1].type);
+    ASSERT_EQ(1U, r.bindings[1].count);
+    ASSERT_EQ(1U, r.bindings[2].set);
+    ASSERT_EQ(0U, r.bindings[2].binding);
+    ASSERT_EQ(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, r.bindings[2].type);
+
+    ASSERT_EQ(static_cast<VkShaderStageFlags>(VK_SHADER_STAGE_FRAGMENT_BIT), r.push_constants.stageFlags);
+    ASSERT_EQ(0U, r.push_constants.offset);
+    ASSERT_EQ(80U, r.push_constants.size);
+}
+
+TEST(spirv_reflection, buffer_block_is_storage_buffer)
+{
+    spirv_writer w{10};
+    w.op(15, {5, 1, 0x6E69616DU, 0})                // OpEntryPoint GLCompute %1 "main"
+     .op(71, {4, 33, 2})
+     .op(71, {2, 3})                                // OpDecorate %2 BufferBlock
+     .op(21, {6, 32, 0})
+     .op(29, {7, 6})                                // %7 = OpTypeRuntimeArray %6
+     .op(30, {2, 7})
+     .op(32, {3, 2, 2})
+     .op(59, {3, 4, 2});
+    auto const r = reflect_spirv(w.words().data(), w.words().size());
+    ASSERT_EQ(static_cast<VkShaderStageFlags>(VK_SHADER_STAGE_COMPUTE_BIT), r.stages);
+    ASSERT_EQ(1U, r.bindings.size());
+    ASSERT_EQ(2U, r.bindings[0].binding);
+    ASSERT_EQ(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, r.bindings[0].type);
+    ASSERT_EQ(1U, r.bindings[0].count);
+    ASSERT_EQ(0U, r.push_constants.size);
+}
+
+TEST(spirv_reflection, invalid_modules)
+{
+    auto code = fragment_module();
+    ASSERT_THROW(reflect_spirv(code.data(), 3), vlk::app_exception);
+
+    auto truncated = code;
+    truncated.resize(truncated.size() - 1U);
+    ASSERT_THROW(reflect_spirv(truncated.data(), truncated.size()), vlk::app_exception);
+
+    code[0] = 0x03022307U;
+    ASSERT_THROW(reflect_spirv(code.data(), code.size()), vlk::app_exception);
+}
+
+TEST(spirv_reflection, id_bound_exceeds_module)
+{
+    spirv_writer w{0xFFFFFFFFU};
+    w.op(15, {4, 1, 0x6E69616DU, 0});
+    ASSERT_THROW(reflect_spirv(w.words().data(), w.words().size()), vlk::app_exception);
+}
+
+namespace {
+
+    spirv_reflection stage(VkShaderStageFlags stages, std::vector<spirv_binding> bindings,
+                           VkPushConstantRange push = {0, 0, 0})
+    {
+        for (auto& b : bindings) {
+            b.stages = stages;
+        }
+        push.stageFlags = 0 != push.size ? stages : 0;
+        return spirv_reflection{stages, "main", std::move(bindings), push};
+    }
+
+}
+
+TEST(spirv_reflection, merge_shared_bindings)
+{
+    auto const vert = stage(VK_SHADER_STAGE_VERTEX_BIT, {{0, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, 0},
+                                                         {2, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, 0}});
+    auto const frag = stage(VK_SHADER_STAGE_FRAGMENT_BIT, {{2, 3, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 8, 0},
+                                                           {0, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, 0},
+                                                           {2, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4, 0}});
+    auto const l = merge_reflections({&vert, &frag});
+
+    ASSERT_EQ(3U, l.sets.size());
+    ASSERT_EQ(1U, l.sets[0].size());
+    ASSERT_EQ(static_cast<VkShaderStageFlags>(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT),
+              l.sets[0][0].stageFlags);
+    ASSERT_TRUE(l.sets[1].empty());
+    ASSERT_EQ(2U, l.sets[2].size());
+    ASSERT_EQ(1U, l.sets[2][0].binding);
+    ASSERT_EQ(4U, l.sets[2][0].descriptorCount);
+    ASSERT_EQ(static_cast<VkShaderStageFlags>(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT),
+              l.sets[2][0].stageFlags);
+    ASSERT_EQ(3U, l.sets[2][1].binding);
+    ASSERT_EQ(8U, l.sets[2][1].descriptorCount);
+    ASSERT_EQ(static_cast<VkShaderStageFlags>(VK_SHADER_STAGE_FRAGMENT_BIT), l.sets[2][1].stageFlags);
+    ASSERT_EQ(0U, l.push_constants.size);
+}
+
+TEST(spirv_reflection, merge_push_constants)
+{
+    auto const vert = stage(VK_SHADER_STAGE_VERTEX_BIT, {}, {0, 16, 64});
+    auto const geom = stage(VK_SHADER_STAGE_GEOMETRY_BIT, {});
+    auto const frag = stage(VK_SHADER_STAGE_FRAGMENT_BIT, {}, {0, 64, 32});
+    auto const l = merge_reflections({&vert, &geom, &frag});
+
+    ASSERT_TRUE(l.sets.empty());
+    ASSERT_EQ(static_cast<VkShaderStageFlags>(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT),
+              l.push_constants.stageFlags);
+    ASSERT_EQ(16U, l.push_constants.offset);
+    ASSERT_EQ(80U, l.push_constants.size);
+}
+
+TEST(spirv_reflection, merge_conflicts)
+{
+    auto const vert = stage(VK_SHADER_STAGE_VERTEX_BIT, {{0, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, 0}});
+    auto const frag = stage(VK_SHADER_STAGE_FRAGMENT_BIT, {{0, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, 0}});
+    ASSERT_THROW(merge_reflections({&vert, &frag}), vlk::app_exception);
+
+    auto const comp = stage(VK_SHADER_STAGE_COMPUTE_BIT, {{0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, 0}});
+    ASSERT_THROW(merge_reflections({&comp}), vlk::app_exception);
+}
@@ -0,0 +1,120 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+#include <gtest/gtest.h>
+#include <vlk/tlsf.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace vlk;
+
+TEST(tlsf, whole_range)
+{
+    tlsf t{1024U};
+    auto a = t.allocate(1024U);
+    ASSERT_TRUE(a);
+    ASSERT_EQ(0U, a->offset);
+    ASSERT_EQ(1024U, t.used());
+    ASSERT_FALSE(t.allocate(1U));
+    t.free(a->id);
+    ASSERT_TRUE(t.empty());
+    ASSERT_EQ(1024U, t.largest_free());
+    ASSERT_EQ(1U, t.free_block_count());
+}
+
+TEST(tlsf, alignment)
+{
+    tlsf t{1U << 20U};
+    auto a = t.allocate(3U);
+    ASSERT_TRUE(a);
+    for (uint64_t alignment : {4ULL, 256ULL, 4096ULL, 65536ULL}) {
+        auto b = t.allocate(100U, alignment);
+        ASSERT_TRUE(b);
+        ASSERT_EQ(0U, b->offset % alignment);
+        ASSERT_EQ(100U, b->size);
+    }
+}
+
+TEST(tlsf, coalescing)
+{
+    tlsf t{4096U};
+    std::vector<tlsf::handle> handles;
+    for (int i = 0; i < 16; ++i) {
+        auto a = t.allocate(256U);
+        ASSERT_TRUE(a);
+        handles.push_back(a->id);
+    }
+    ASSERT_FALSE(t.allocate(1U));
+    // free every second block - 8 holes, none larger than 256 bytes
+    for (size_t i = 0; i < handles.size(); i += 2) {
+        t.free(handles[i]);
+    }
+    ASSERT_EQ(8U, t.free_block_count());
+    ASSERT_EQ(256U, t.largest_free());
+    ASSERT_FALSE(t.allocate(512U));
+    for (size_t i = 1; i < handles.size(); i += 2) {
+        t.free(handles[i]);
+    }
+    ASSERT_EQ(1U, t.free_block_count());
+    ASSERT_TRUE(t.allocate(4096U));
+}
+
+TEST(tlsf, random_no_overlap)
+{
+    tlsf t{64U * 1024U * 1024U};
+    std::mt19937 rng{42};
+    std::vector<tlsf::allocation> live;
+    for (int i = 0; i < 20000; ++i) {
+        if (live.empty() || rng() % 3 != 0) {
+            auto a = t.allocate(1U + rng() % 100000U, uint64_t{1} << (rng() % 12U));
+            if (a) {
+                live.push_back(*a);
+            }
+        }
+        else {
+            auto idx = rng() % live.size();
+            t.free(live[idx].id);
+            live.erase(live.begin() + static_cast<std::ptrdiff_t>(idx));
+        }
+    }
+    std::sort(live.begin(), live.end(), [](auto const& l, auto const& r) { return l.offset < r.offset; });
+    uint64_t used{0};
+    for (size_t i = 0; i < live.size(); ++i) {
+        used += live[i].size;
+        ASSERT_LE(live[i].offset + live[i].size, t.size());
+        if (i > 0) {
+            ASSERT_LE(live[i - 1].offset + live[i - 1].size, live[i].offset);
+        }
+    }
+    ASSERT_EQ(used, t.used());
+    ASSERT_EQ(live.size(), t.allocation_count());
+
+    uint32_t visited{0};
+    t.for_each_allocation([&](tlsf::handle, uint64_t, uint64_t) { ++visited; });
+    ASSERT_EQ(live.size(), visited);
+
+    for (auto const& a : live) {
+        t.free(a.id);
+    }
+    ASSERT_TRUE(t.empty());
+    ASSERT_EQ(1U, t.free_block_count());
+    ASSERT_EQ(t.size(), t.largest_free());
+}
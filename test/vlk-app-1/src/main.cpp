@@ -1,9 +1,149 @@
-
 #include <vlk/application.h>
+#include <vlk/log.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+    //! Uploads into a buffer in the frame the defragmenter moves it and reads the result back. The upload has to
+    //! land in the moved buffer after the defragmentation's copy of the old content, otherwise it is overwritten.
+    class defrag_upload_app : public vlk::application
+    {
+    public:
+        using vlk::application::application;
+
+        bool passed() const { return _passed; }
+
+    protected:
+        void on_init_run() override
+        {
+            // three quarter block buffers and the target fill the first block, the kept ones need a second block;
+            // releasing the fillers leaves the target alone in the emptiest block, the first one evacuated
+            auto const quarter = vlk::memory_allocator::default_block_size / 4U;
+            std::vector<vlk::allocated_buffer> fillers;
+            for (int i = 0; i < 3; ++i) {
+                fillers.push_back(create(quarter, vlk::memory_usage::gpu_only));
+            }
+            auto ci = buffer_info(64U * 1024U);
+            _target = allocator().create_buffer(ci, vlk::memory_usage::gpu_only);
+            for (int i = 0; i < 2; ++i) {
+                _kept.push_back(create(quarter, vlk::memory_usage::gpu_only));
+            }
+            for (auto& f : fillers) {
+                allocator().destroy(f);
+            }
+            _target_id = defragmenter().register_buffer(_target, ci, [this](vlk::allocated_buffer const& moved) {
+                _target = moved;
+                _moved = true;
+            });
+            _readback = create(sizeof(uint32_t), vlk::memory_usage::gpu_to_cpu);
+        }
+
+        void on_cleanup_run() override
+        {
+            if (_checked) {
+                allocator().invalidate(_readback.memory);
+                uint32_t value{0};
+                std::memcpy(&value, _readback.memory.mapped, sizeof(value));
+                _passed = magic == value;
+                if (!_passed) {
+                    VLK_LOG_ERROR() << "defrag upload: read back " << value << " instead of " << magic;
+                }
+            }
+            else {
+                VLK_LOG_ERROR() << "defrag upload: target buffer wasn't moved";
+            }
+            defragmenter().unregister(_target_id);
+            allocator().destroy(_target);
+            allocator().destroy(_readback);
+            for (auto& k : _kept) {
+                allocator().destroy(k);
+            }
+        }
+
+        void record_frame(VkCommandBuffer cmd, uint32_t) override
+        {
+            if (!_moved || _checked) {
+                return;
+            }
+            // queued in the frame of the move, i.e. executed right after the defragmentation's copies
+            auto const src = uploads().upload(&magic, sizeof(magic));
+            uploads().copy_to_buffer(src, _target.buffer, 0);
+
+            VkBufferCopy region{};
+            region.srcOffset = 0;
+            region.dstOffset = 0;
+            region.size = sizeof(magic);
+            vkCmdCopyBuffer(cmd, _target.buffer, _readback.buffer, 1, &region);
+            VkMemoryBarrier mb{};
+            mb.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            mb.pNext = nullptr;
+            mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            mb.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &mb, 0,
+                                 nullptr, 0, nullptr);
+            _checked = true;
+        }
+
+    private:
+        static constexpr uint32_t magic{0x564c4b21U};
+
+        static VkBufferCreateInfo buffer_info(VkDeviceSize size)
+        {
+            VkBufferCreateInfo ci{};
+            ci.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            ci.pNext = nullptr;
+            ci.size = size;
+            ci.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            return ci;
+        }
+
+        vlk::allocated_buffer create(VkDeviceSize size, vlk::memory_usage usage)
+        {
+            return allocator().create_buffer(buffer_info(size), usage);
+        }
+
+        vlk::allocated_buffer _target{};
+        vlk::memory_defragmenter::resource_id _target_id{0};
+        std::vector<vlk::allocated_buffer> _kept{};
+        vlk::allocated_buffer _readback{};
+        bool _moved{false};
+        bool _checked{false};
+        bool _passed{false};
+    };
+
+}
 
 int main(int argc, char const* argv[])
 {
-    vlk::application app{};
+    vlk::install_crash_log_flush();
+
+    vlk::application_settings settings{};
+    bool defrag_upload{false};
+    for (int i = 1; i < argc; ++i) {
+        if (0 == std::strcmp(argv[i], "--headless")) {
+            // offscreen rendering of a fixed number of frames, e.g. on CI machines without display
+            settings.headless = true;
+            settings.max_frames = 1000U;
+        }
+        else if (0 == std::strcmp(argv[i], "--defrag-upload")) {
+            // a few frames checking uploads into a buffer moved by the defragmenter in the same frame
+            defrag_upload = true;
+            settings.headless = true;
+            settings.max_frames = 4U;
+        }
+    }
+
+    if (defrag_upload) {
+        defrag_upload_app app{settings};
+        app.run();
+        return app.passed() ? 0 : 1;
+    }
+
+    vlk::application app{settings};
 
     app.run();
 
@@ -0,0 +1,175 @@
+// ================================================================================================
+//
+// vlk  Vulkan support library to experiment with VULKAN SDK
+//
+// Copyright (C) 2019 Alexander Seifarth
+//
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation; either version 3 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+// the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with this program;
+// if not, write to the Free Software Foundation,
+//          Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+//
+// ================================================================================================
+// Turns a binary log written after vlk::set_binary_log() into the text stderr would have shown.
+#include <vlk/log.h>
+
+#include <array>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct site
+    {
+        uint8_t level{0};
+        uint32_t line{0};
+        std::string file{};
+        std::string format{};
+    };
+
+    class reader
+    {
+    public:
+        explicit reader(std::istream& in)
+            : _in{in}
+        {}
+
+        template<typename T>
+        bool get(T& v) { return static_cast<bool>(_in.read(reinterpret_cast<char*>(&v), sizeof(T))); }
+
+        bool get_string(std::string& s)
+        {
+            uint16_t n{0};
+            if (!get(n)) {
+                return false;
+            }
+            s.resize(n);
+            return static_cast<bool>(_in.read(s.data(), n));
+        }
+
+    private:
+        std::istream& _in;
+    };
+
+    char const* level_name(uint8_t level)
+    {
+        switch (static_cast<vlk::log_level>(level)) {
+            case vlk::log_level::trace: return "trace";
+            case vlk::log_level::debug: return "debug";
+            case vlk::log_level::info: return "info";
+            case vlk::log_level::warning: return "warning";
+            case vlk::log_level::error: return "error";
+            case vlk::log_level::fatal: return "fatal";
+            default:
+                break;
+        }
+        return "unknown";
+    }
+
+    void print_prefix(int64_t time_ns, uint64_t thread, uint8_t level, int64_t utc_offset_s)
+    {
+        // the local time of the machine that wrote the log
+        auto const t = static_cast<std::time_t>(time_ns / 1000000000LL + utc_offset_s);
+        std::tm tm{};
+        gmtime_r(&t, &tm);
+        std::array<char, 32> date{};
+        std::strftime(date.data(), date.size(), "%Y-%m-%d %H:%M:%S", &tm);
+        std::array<char, 16> tag{};
+        std::snprintf(tag.data(), tag.size(), "[%s]", level_name(level));
+        auto const us = static_cast<int64_t>((time_ns / 1000LL) % 1000000LL);
+        std::printf("[%s.%06" PRId64 "] [0x%016" PRIx64 "] %-10s", date.data(), us, thread, tag.data());
+    }
+
+}
+
+int main(int argc, char const* argv[])
+{
+    if (2 != argc) {
+        std::cerr << "usage: vlk-logdecode <binary log>\n";
+        return 2;
+    }
+    std::ifstream in{argv[1], std::ios::binary};
+    if (!in) {
+        std::cerr << "vlk-logdecode: cannot open " << argv[1] << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    reader r{in};
+    std::array<char, 4> magic{};
+    uint32_t version{0};
+    int64_t utc_offset_s{0};
+    if (!r.get(magic) || 0 != std::memcmp(magic.data(), "VLKL", magic.size()) || !r.get(version) || 1U != version
+        || !r.get(utc_offset_s)) {
+        std::cerr << "vlk-logdecode: " << argv[1] << " is not a vlk binary log (version 1)\n";
+        return 1;
+    }
+
+    std::vector<site> sites;
+    std::array<char, 4096> text{};
+    std::string payload;
+    uint8_t type{0};
+    while (r.get(type)) {
+        int64_t time_ns{0};
+        uint64_t thread{0};
+        bool ok{true};
+        switch (type) {
+            case 1: {
+                uint32_t id{0};
+                site s;
+                ok = r.get(id) && r.get(s.level) && r.get(s.line) && r.get_string(s.file) && r.get_string(s.format);
+                if (ok) {
+                    if (id >= sites.size()) {
+                        sites.resize(id + 1U);
+                    }
+                    sites[id] = std::move(s);
+                }
+                break;
+            }
+            case 2: {
+                uint32_t id{0};
+                ok = r.get(time_ns) && r.get(thread) && r.get(id) && r.get_string(payload);
+                if (ok) {
+                    auto const known = id < sites.size();
+                    print_prefix(time_ns, thread, known ? sites[id].level : 0xFFU, utc_offset_s);
+                    auto const n = vlk::detail::format_log_args(text.data(), text.size(),
+                            known ? sites[id].format.c_str() : "<unknown site>",
+                            reinterpret_cast<uint8_t const*>(payload.data()), payload.size());
+                    std::fwrite(text.data(), 1U, n, stdout);
+                    std::putchar('\n');
+                }
+                break;
+            }
+            case 3: {
+                uint8_t level{0};
+                ok = r.get(time_ns) && r.get(thread) && r.get(level) && r.get_string(payload);
+                if (ok) {
+                    print_prefix(time_ns, thread, level, utc_offset_s);
+                    std::printf("%s\n", payload.c_str());
+                }
+                break;
+            }
+            default:
+                ok = false;
+                break;
+        }
+        if (!ok) {
+            // a crash may have cut the last record
+            std::cerr << "vlk-logdecode: truncated or corrupt record at offset " << in.tellg() << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}